@@ -0,0 +1,415 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "BenchmarkCommandLineHandler.hpp"
+#include "BuildInfo.hpp"
+#include "EventCounters.hpp"
+#include "FatalError.hpp"
+#include "FileLog.hpp"
+#include "FilePaths.hpp"
+#include "Instrument.hpp"
+#include "InstrumentSystem.hpp"
+#include "MicroBenchmarks.hpp"
+#include "MonteCarloSimulation.hpp"
+#include "ParallelFactory.hpp"
+#include "ProcessManager.hpp"
+#include "SchemaDef.hpp"
+#include "SimulationItemRegistry.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+#include "XmlHierarchyCreator.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the allowed options list, in the format consumed by the CommandLineArguments constructor
+    static const char* allowedOptions = "-t* -m* -s* -u* -o* -l";
+
+    // returns the specified text as a quoted JSON string, escaping special characters
+    string jsonString(string text)
+    {
+        string result = "\"";
+        for (char c : text)
+        {
+            switch (c)
+            {
+                case '"': result += "\\\""; break;
+                case '\\': result += "\\\\"; break;
+                case '\n': result += "\\n"; break;
+                case '\t': result += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) >= 0x20) result += c;
+                    break;
+            }
+        }
+        return result + "\"";
+    }
+
+    // returns the specified number as a JSON number with the specified number of significant digits
+    string jsonNumber(double value, int precision = 6)
+    {
+        return std::isfinite(value) ? StringUtils::toString(value, 'g', precision) : "null";
+    }
+
+    // returns the ratio of the specified numbers, or zero if the denominator is not positive
+    double ratio(double numerator, double denominator) { return denominator > 0. ? numerator / denominator : 0.; }
+
+    // returns the total flux column of the specified SED output file, or an empty list if the file cannot be read
+    vector<double> readSpectrum(string filepath)
+    {
+        vector<double> fluxes;
+        std::ifstream in = System::ifstream(filepath);
+        string line;
+        while (std::getline(in, line))
+        {
+            if (line.empty() || line[0] == '#') continue;
+            auto columns = StringUtils::split(StringUtils::squeeze(line), " ");
+            if (columns.size() > 1) fluxes.push_back(StringUtils::toDouble(columns[1]));
+        }
+        return fluxes;
+    }
+
+    // returns the sum of the absolute differences between the specified spectra relative to the sum of the
+    // absolute values of the reference spectrum, or a negative value if the spectra cannot be compared
+    double spectrumDeviation(const vector<double>& fluxes, const vector<double>& reference)
+    {
+        if (fluxes.empty() || fluxes.size() != reference.size()) return -1.;
+        double difference = 0.;
+        double total = 0.;
+        for (size_t i = 0; i != fluxes.size(); ++i)
+        {
+            difference += abs(fluxes[i] - reference[i]);
+            total += abs(reference[i]);
+        }
+        return total > 0. ? difference / total : -1.;
+    }
+
+    // resets the peak resident memory of the process to its current resident memory by writing to the Linux
+    // /proc/self/clear_refs file (supported by Linux 4.0 and later); returns false if the reset is not supported
+    bool resetPeakMemory()
+    {
+        std::ofstream out("/proc/self/clear_refs");
+        if (!out) return false;
+        out << "5";
+        out.close();
+        return static_cast<bool>(out);
+    }
+
+    // returns the peak resident memory of the process since the most recent reset, obtained from the high-water
+    // mark in the Linux /proc/self/status file, or the lifetime peak if that file is not available
+    size_t peakMemorySinceReset()
+    {
+        std::ifstream in("/proc/self/status");
+        string line;
+        while (std::getline(in, line))
+        {
+            if (StringUtils::startsWith(line, "VmHWM:"))
+            {
+                std::istringstream values(line.substr(6));
+                size_t kilobytes = 0;
+                if (values >> kilobytes) return kilobytes * 1024;
+            }
+        }
+        return System::peakMemoryUsage();
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+BenchmarkCommandLineHandler::BenchmarkCommandLineHandler() : _args(System::arguments(), allowedOptions)
+{
+    // issue welcome message
+    _producerInfo = "SKIRT benchmark " + BuildInfo::projectVersion() + " (" + BuildInfo::codeVersion() + " "
+                    + BuildInfo::timestamp() + ")";
+    _console.info("Welcome to " + _producerInfo);
+    _console.info("Running on " + System::hostname() + " for " + System::username());
+}
+
+////////////////////////////////////////////////////////////////////
+
+int BenchmarkCommandLineHandler::perform()
+{
+    // catch and properly report any exceptions
+    try
+    {
+        if (!_args.isValid() || _args.hasFilepaths())
+        {
+            _console.error("Invalid command line arguments", false);
+            printHelp();
+            return EXIT_FAILURE;
+        }
+
+        // list the available models if requested
+        auto allModels = BenchmarkModels::models();
+        if (_args.isPresent("-l"))
+        {
+            for (const auto& model : allModels) _console.info("  " + model.name + " : " + model.description);
+            return EXIT_SUCCESS;
+        }
+
+        // select the models to be run
+        vector<BenchmarkModels::Model> models;
+        if (_args.isPresent("-m"))
+        {
+            for (string name : StringUtils::split(_args.value("-m"), ","))
+            {
+                auto it = std::find_if(allModels.begin(), allModels.end(),
+                                       [name](const BenchmarkModels::Model& model) { return model.name == name; });
+                if (it == allModels.end()) throw FATALERROR("Unknown benchmark model: " + name);
+                models.push_back(*it);
+            }
+        }
+        else
+            models = allModels;
+
+        // create the output directory
+        _outPath = _args.isPresent("-o") ? _args.value("-o") : "bench";
+        if (!System::makeDir(_outPath)) throw FATALERROR("Could not create output directory " + _outPath);
+
+        // run the benchmarks and collect the results
+        vector<int> counts = threadCounts();
+        vector<string> modelResults;
+        for (const auto& model : models) modelResults.push_back(runModel(model, counts));
+
+        // write the results to a JSON file
+        string filepath = StringUtils::joinPaths(_outPath, "bench.json");
+        std::ofstream out = System::ofstream(filepath);
+        if (!out) throw FATALERROR("Could not open benchmark result file " + filepath);
+        out << "{\n";
+        out << "  \"producer\": " << jsonString(_producerInfo) << ",\n";
+        out << "  \"host\": " << jsonString(System::hostname()) << ",\n";
+        out << "  \"timestamp\": " << jsonString(System::timestamp(true)) << ",\n";
+        out << "  \"logicalCores\": " << ParallelFactory::defaultThreadCount() << ",\n";
+        out << "  \"packetScale\": " << jsonNumber(_args.isPresent("-s") ? _args.doubleValue("-s") : 1.) << ",\n";
+        out << "  \"models\": [\n" << StringUtils::join(modelResults, ",\n") << "\n  ]\n";
+        out << "}\n";
+        out.close();
+        _console.success("Benchmark results written to " + filepath);
+        return EXIT_SUCCESS;
+    }
+    catch (FatalError& error)
+    {
+        for (string line : error.message()) _console.error(line, false);
+    }
+    catch (const std::exception& except)
+    {
+        _console.error("Standard Library Exception: " + string(except.what()), false);
+    }
+    return EXIT_FAILURE;
+}
+
+////////////////////////////////////////////////////////////////////
+
+string BenchmarkCommandLineHandler::runModel(const BenchmarkModels::Model& model, const vector<int>& threadCounts)
+{
+    _console.info("Benchmarking model '" + model.name + "': " + model.description);
+
+    // generate the ski file and any input files for the model
+    double scale = _args.isPresent("-s") ? _args.doubleValue("-s") : 1.;
+    double numPackets = max(1., std::round(scale * model.numPackets));
+    BenchmarkModels::writeModel(model, numPackets, StringUtils::joinPaths(_outPath, model.name + ".ski"), _outPath);
+
+    // run the model for each thread count, stopping at the first failure
+    vector<Run> runs;
+    string failure;
+    for (int threads : threadCounts)
+    {
+        try
+        {
+            // restart the peak memory measurement for this run; if this is not supported, the process-wide peak
+            // is meaningful only for the very first run in the benchmark
+            bool peakIsPerRun = resetPeakMemory() || !_hasRun;
+            _hasRun = true;
+
+            // record the memory still held by the process at the start of the run (e.g., from earlier runs)
+            size_t baselineMemory = System::currentMemoryUsage();
+
+            string prefix = model.name + "_t" + std::to_string(threads);
+            auto topitem = createSimulation(model, prefix, threads);
+            auto simulation = dynamic_cast<MonteCarloSimulation*>(topitem.get());
+
+            // count photon packets and path segments for the complete run
+            EventCounters::enable(simulation->instrumentSystem()->instruments().size());
+            simulation->setupAndRun();
+            vector<size_t> counters = EventCounters::collect();
+            EventCounters::disable();
+
+            runs.push_back({threads, simulation->setupWallTime(), simulation->runWallTime(),
+                            static_cast<double>(counters[EventCounters::PhotonPackets]),
+                            static_cast<double>(counters[EventCounters::PathSegments]),
+                            static_cast<double>(counters[EventCounters::Scatterings]),
+                            baselineMemory, peakIsPerRun ? peakMemorySinceReset() : 0});
+
+            // remember the SED output files of the first run for comparison with other models
+            if (runs.size() == 1)
+            {
+                vector<string>& paths = _sedPaths[model.name];
+                for (Instrument* instrument : simulation->instrumentSystem()->instruments())
+                    paths.push_back(
+                        StringUtils::joinPaths(_outPath, prefix + "_" + instrument->instrumentName() + "_sed.dat"));
+            }
+        }
+        catch (FatalError& error)
+        {
+            EventCounters::disable();
+            // keep only the actual message lines, omitting the source code location and the call stack
+            for (string line : error.message())
+            {
+                if (StringUtils::startsWith(line, "On line ")) break;
+                failure += (failure.empty() ? "" : "\n") + line;
+            }
+            _console.error("Model '" + model.name + "' failed: " + error.message().front(), false);
+            break;
+        }
+    }
+
+    // report the runs on the console and compose the JSON text, using the run with the fewest threads
+    // as the reference for the parallel efficiency regardless of the order of the thread counts
+    const Run* ref = runs.empty() ? nullptr
+                                  : &*std::min_element(runs.begin(), runs.end(), [](const Run& a, const Run& b) {
+                                        return a.threads < b.threads;
+                                    });
+    vector<string> runResults;
+    for (const Run& run : runs)
+    {
+        double efficiency = ratio(ref->runTime * ref->threads, run.runTime * run.threads);
+        _console.info("  " + StringUtils::padLeft(std::to_string(run.threads), 3) + " threads: "
+                      + StringUtils::toString(ratio(run.packets, run.runTime), 'e', 3) + " packets/s, "
+                      + StringUtils::toString(ratio(run.segments, run.runTime), 'e', 3) + " segments/s, "
+                      + StringUtils::toString(ratio(run.scatterings, run.runTime), 'e', 3) + " scatterings/s, setup "
+                      + StringUtils::toString(run.setupTime, 'f', 2) + " s, run "
+                      + StringUtils::toString(run.runTime, 'f', 2) + " s, efficiency "
+                      + StringUtils::toString(100. * efficiency, 'f', 1) + "%, peak memory "
+                      + (run.peakMemory ? StringUtils::toMemSizeString(run.peakMemory) : "unavailable")
+                      + " (baseline " + StringUtils::toMemSizeString(run.baselineMemory) + ")");
+        runResults.push_back("        {\"threads\": " + std::to_string(run.threads)
+                             + ", \"setupTime\": " + jsonNumber(run.setupTime)
+                             + ", \"runTime\": " + jsonNumber(run.runTime)
+                             + ", \"packets\": " + jsonNumber(run.packets, 15)
+                             + ", \"segments\": " + jsonNumber(run.segments, 15)
+                             + ", \"scatterings\": " + jsonNumber(run.scatterings, 15)
+                             + ", \"packetsPerSecond\": " + jsonNumber(ratio(run.packets, run.runTime))
+                             + ", \"segmentsPerSecond\": " + jsonNumber(ratio(run.segments, run.runTime))
+                             + ", \"scatteringsPerSecond\": " + jsonNumber(ratio(run.scatterings, run.runTime))
+                             + ", \"parallelEfficiency\": " + jsonNumber(efficiency)
+                             + ", \"baselineMemory\": " + std::to_string(run.baselineMemory)
+                             + ", \"peakMemory\": " + (run.peakMemory ? std::to_string(run.peakMemory) : "null")
+                             + "}");
+    }
+
+    // compare the emergent spectra with those of the reference model if both models ran successfully
+    vector<string> spectrumResults;
+    if (!model.reference.empty() && _sedPaths.count(model.name) && _sedPaths.count(model.reference))
+    {
+        const vector<string>& paths = _sedPaths[model.name];
+        const vector<string>& referencePaths = _sedPaths[model.reference];
+        for (size_t i = 0; i != min(paths.size(), referencePaths.size()); ++i)
+        {
+            double deviation = spectrumDeviation(readSpectrum(paths[i]), readSpectrum(referencePaths[i]));
+            if (deviation < 0.) continue;
+            string filename = StringUtils::split(paths[i], "/").back();
+            _console.info("  spectrum deviation from model '" + model.reference + "' for " + filename + ": "
+                          + StringUtils::toString(100. * deviation, 'f', 2) + "%");
+            spectrumResults.push_back("        {\"file\": " + jsonString(filename)
+                                      + ", \"reference\": " + jsonString(model.reference)
+                                      + ", \"deviation\": " + jsonNumber(deviation) + "}");
+        }
+    }
+
+    // perform the micro-benchmarks in a single thread if the model ran successfully
+    vector<string> microResults;
+    double numOperations = _args.isPresent("-u") ? _args.doubleValue("-u") : 1e6;
+    if (failure.empty() && numOperations > 0)
+    {
+        auto topitem = createSimulation(model, model.name + "_micro", 1);
+        auto simulation = dynamic_cast<MonteCarloSimulation*>(topitem.get());
+        for (const auto& result : MicroBenchmarks::run(simulation, numOperations))
+        {
+            double rate = ratio(result.operations, result.seconds);
+            _console.info("  micro " + result.name + ": " + StringUtils::toString(rate, 'e', 3) + " operations/s");
+            microResults.push_back("        {\"name\": " + jsonString(result.name)
+                                   + ", \"operations\": " + jsonNumber(result.operations, 15)
+                                   + ", \"seconds\": " + jsonNumber(result.seconds)
+                                   + ", \"operationsPerSecond\": " + jsonNumber(rate) + "}");
+        }
+    }
+
+    return "    {\"name\": " + jsonString(model.name) + ", \"description\": " + jsonString(model.description)
+           + ", \"numPackets\": " + jsonNumber(numPackets, 15) + ",\n      \"status\": "
+           + jsonString(failure.empty() ? "ok" : "failed")
+           + (failure.empty() ? "" : ", \"error\": " + jsonString(failure)) + ",\n      \"runs\": [\n"
+           + StringUtils::join(runResults, ",\n") + "\n      ],\n      \"spectra\": [\n"
+           + StringUtils::join(spectrumResults, ",\n") + "\n      ],\n      \"micro\": [\n"
+           + StringUtils::join(microResults, ",\n") + "\n      ]}";
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<Item> BenchmarkCommandLineHandler::createSimulation(const BenchmarkModels::Model& model,
+                                                                    string prefix, int threads)
+{
+    auto schema = SimulationItemRegistry::getSchemaDef();
+    auto topitem = XmlHierarchyCreator::readFile(schema, StringUtils::joinPaths(_outPath, model.name + ".ski"));
+    auto simulation = dynamic_cast<MonteCarloSimulation*>(topitem.get());
+
+    simulation->filePaths()->setOutputPrefix(prefix);
+    simulation->filePaths()->setInputPath(_outPath);
+    simulation->filePaths()->setOutputPath(_outPath);
+    simulation->parallelFactory()->setMaxThreadCount(threads);
+
+    // log to file only, except for errors
+    FileLog* log = new FileLog();
+    simulation->log()->setLinkedLog(log);
+    simulation->log()->setLowestLevel(Log::Level::Error);
+    return topitem;
+}
+
+////////////////////////////////////////////////////////////////////
+
+vector<int> BenchmarkCommandLineHandler::threadCounts()
+{
+    vector<int> result;
+    if (_args.isPresent("-t"))
+    {
+        for (string count : StringUtils::split(_args.value("-t"), ","))
+        {
+            int value = StringUtils::toInt(count);
+            if (value < 1) throw FATALERROR("Invalid thread count: " + count);
+            result.push_back(value);
+        }
+    }
+    else
+    {
+        int maxThreads = ParallelFactory::defaultThreadCount();
+        for (int threads = 1; threads < maxThreads; threads *= 2) result.push_back(threads);
+        result.push_back(maxThreads);
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void BenchmarkCommandLineHandler::printHelp()
+{
+    if (!ProcessManager::isRoot()) return;
+
+    _console.warning("");
+    _console.warning("  skirt-bench [-t <threadcounts>] [-m <models>] [-s <scale>] [-u <operations>]");
+    _console.warning("              [-o <dirpath>] [-l]");
+    _console.warning("");
+    _console.warning("  -t <threadcounts> : comma-separated list of thread counts for each model");
+    _console.warning("  -m <models> : comma-separated list of names of the models to be run");
+    _console.warning("  -s <scale> : scale factor for the number of photon packets in each model");
+    _console.warning("  -u <operations> : number of operations for each micro-benchmark (0 to disable)");
+    _console.warning("  -o <dirpath> : the relative or absolute path for benchmark output files");
+    _console.warning("  -l : list the available models");
+    _console.warning("");
+}
+
+////////////////////////////////////////////////////////////////////
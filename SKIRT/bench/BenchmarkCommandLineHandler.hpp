@@ -0,0 +1,123 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef BENCHMARKCOMMANDLINEHANDLER_HPP
+#define BENCHMARKCOMMANDLINEHANDLER_HPP
+
+#include "BenchmarkModels.hpp"
+#include "CommandLineArguments.hpp"
+#include "ConsoleLog.hpp"
+#include <map>
+class Item;
+
+////////////////////////////////////////////////////////////////////
+
+/**
+This class processes the command line arguments for the skirt-bench performance benchmark and
+runs the requested benchmarks. The benchmark runs each of a curated set of synthetic models (see
+the BenchmarkModels namespace) for a number of parallel thread counts, and reports the photon
+packet, path segment and scattering event throughput, the setup and run wall times, the peak
+memory usage, and the parallel efficiency relative to the smallest thread count. For a model that
+names a reference model, it also reports the relative deviation between the emergent spectra of
+the two models for each instrument, provided that the reference model was run earlier in the same
+benchmark. This deviation includes the Monte Carlo noise of both runs. After the full runs, it
+performs a number of single-threaded micro-benchmarks (see the MicroBenchmarks namespace) on each
+model that could be run successfully. The results are shown on the console and written to a JSON
+file, so that they can be compared across code versions and hardware platforms.
+
+Because all runs share the same process, the peak memory usage is reset before each run by
+writing to the Linux /proc/self/clear_refs file, and is obtained from the high-water mark in the
+/proc/self/status file, so that it reflects the memory reached during that run. The reset level
+includes any memory still held by the process after earlier runs (e.g., memory-mapped resource
+files or heap memory retained by the allocator), so the benchmark also reports this baseline
+memory usage at the start of each run. On platforms that do not support the reset, the
+peak memory usage is reported only for the first run in the benchmark and is shown as
+unavailable (null in the JSON file) for all subsequent runs.
+
+The command line syntax is:
+
+\verbatim
+ skirt-bench [-t <threadcounts>] [-m <models>] [-s <scale>] [-u <operations>] [-o <dirpath>] [-l]
+\endverbatim
+
+- The -t option specifies a comma-separated list of thread counts for which each model is run.
+  The default list includes one, the powers of two smaller than the number of logical cores on
+  the computer, and the number of logical cores.
+
+- The -m option specifies a comma-separated list of names selecting the models to be run. By
+  default, all models are run.
+
+- The -s option specifies a scale factor for the number of photon packets launched by each
+  model. The default value is one. Smaller values allow a quick check of the benchmark setup.
+
+- The -u option specifies the number of operations performed by each micro-benchmark. The
+  default value is one million. A value of zero disables the micro-benchmarks.
+
+- The -o option specifies the absolute or relative path of the directory in which the generated
+  model files, the simulation output files, and the JSON result file "bench.json" are placed.
+  The directory is created if needed. The default is a "bench" directory in the current
+  directory.
+
+- The -l option lists the available models and exits.
+
+Models that cannot be run, for example because they rely on resource files that are not
+installed, are reported as failed with the corresponding error message, and the benchmark
+continues with the next model.
+*/
+class BenchmarkCommandLineHandler final
+{
+public:
+    /** The constructor obtains the program's command line arguments and issues a welcome message
+        to the console log. */
+    BenchmarkCommandLineHandler();
+
+    /** This function processes the command line arguments and runs the requested benchmarks. The
+        function returns an appropriate application exit value. */
+    int perform();
+
+private:
+    /** This structure holds the measurements for a single run of a model. */
+    struct Run
+    {
+        int threads;
+        double setupTime;
+        double runTime;
+        double packets;
+        double segments;
+        double scatterings;
+        size_t baselineMemory;  // memory in use at the start of the run
+        size_t peakMemory;      // peak memory during the run, or zero if unavailable
+    };
+
+    /** This function runs the specified model for each of the specified thread counts, followed
+        by the micro-benchmarks if so requested, and returns the JSON text describing the results.
+        */
+    string runModel(const BenchmarkModels::Model& model, const vector<int>& threadCounts);
+
+    /** This function constructs a simulation from the ski file for the specified model and sets
+        its input and output paths, its output prefix, its number of parallel threads, and its
+        logging mechanisms. */
+    std::unique_ptr<Item> createSimulation(const BenchmarkModels::Model& model, string prefix, int threads);
+
+    /** This function returns the list of thread counts specified by the -t option or the default
+        list if the option is not present. */
+    vector<int> threadCounts();
+
+    /** This function prints a brief help message to the console. */
+    void printHelp();
+
+private:
+    // data members
+    CommandLineArguments _args;
+    ConsoleLog _console;
+    string _producerInfo;
+    string _outPath;
+    std::map<string, vector<string>> _sedPaths;  // the SED output file paths for the first run of each model
+    bool _hasRun{false};                         // becomes true when the first run in the benchmark starts
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,458 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "BenchmarkModels.hpp"
+#include "FatalError.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+#include <random>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // ---- generic ski file fragments ----
+
+    // returns the ski file header up to and including the units, for the given simulation mode and number of packets
+    string header(string simulationMode, double numPackets, string extraAttributes = "")
+    {
+        return "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+               "<skirt-simulation-hierarchy type=\"MonteCarloSimulation\" format=\"9\" producer=\"skirt-bench\">\n"
+               "<MonteCarloSimulation simulationMode=\""
+               + simulationMode + "\" numPackets=\"" + StringUtils::toString(numPackets, 'e', 3) + "\""
+               + extraAttributes
+               + ">\n"
+                 "<units type=\"Units\">\n"
+                 "<ExtragalacticUnits wavelengthOutputStyle=\"Wavelength\" fluxOutputStyle=\"Frequency\"/>\n"
+                 "</units>\n";
+    }
+
+    // returns the ski file trailer
+    string trailer()
+    {
+        return "</MonteCarloSimulation>\n"
+               "</skirt-simulation-hierarchy>\n";
+    }
+
+    // returns a source system with the given wavelength range and sources
+    string sourceSystem(string minWavelength, string maxWavelength, string sources)
+    {
+        return "<sourceSystem type=\"SourceSystem\">\n"
+               "<SourceSystem minWavelength=\""
+               + minWavelength + "\" maxWavelength=\"" + maxWavelength
+               + "\">\n"
+                 "<sources type=\"Source\">\n"
+               + sources
+               + "</sources>\n"
+                 "</SourceSystem>\n"
+                 "</sourceSystem>\n";
+    }
+
+    // returns a black-body SED with integrated luminosity normalization over the optical range
+    string blackBodySED(string temperature)
+    {
+        return "<sed type=\"SED\">\n"
+               "<BlackBodySED temperature=\""
+               + temperature
+               + "\"/>\n"
+                 "</sed>\n"
+                 "<normalization type=\"LuminosityNormalization\">\n"
+                 "<IntegratedLuminosityNormalization minWavelength=\"0.1 micron\" maxWavelength=\"10 micron\" "
+                 "integratedLuminosity=\"1e10 Lsun\"/>\n"
+                 "</normalization>\n";
+    }
+
+    // returns a medium system with the given options, media and spatial grid
+    string mediumSystem(string options, string media, string grid)
+    {
+        return "<mediumSystem type=\"MediumSystem\">\n"
+               "<MediumSystem>\n"
+               + options
+               + "<media type=\"Medium\">\n"
+               + media
+               + "</media>\n"
+                 "<grid type=\"SpatialGrid\">\n"
+               + grid
+               + "</grid>\n"
+                 "</MediumSystem>\n"
+                 "</mediumSystem>\n";
+    }
+
+    // returns the photon packet options with or without forced scattering
+    string photonPacketOptions(bool forceScattering)
+    {
+        return "<photonPacketOptions type=\"PhotonPacketOptions\">\n"
+               "<PhotonPacketOptions forceScattering=\""
+               + string(forceScattering ? "true" : "false")
+               + "\" minWeightReduction=\"1e4\" minScattEvents=\"0\" pathLengthBias=\"0.5\"/>\n"
+                 "</photonPacketOptions>\n";
+    }
+
+    // returns a trivial gas mix with cross sections and anisotropy representative of interstellar dust
+    string greyDustMix()
+    {
+        return "<materialMix type=\"MaterialMix\">\n"
+               "<TrivialGasMix absorptionCrossSection=\"1e-26 m2\" scatteringCrossSection=\"2e-26 m2\" "
+               "asymmetryParameter=\"0.5\"/>\n"
+               "</materialMix>\n";
+    }
+
+    // returns a face-on optical depth normalization
+    string opticalDepthNormalization(string axis, double opticalDepth)
+    {
+        return "<normalization type=\"MaterialNormalization\">\n"
+               "<OpticalDepthMaterialNormalization axis=\""
+               + axis + "\" wavelength=\"0.55 micron\" opticalDepth=\"" + StringUtils::toString(opticalDepth)
+               + "\"/>\n"
+                 "</normalization>\n";
+    }
+
+    // returns the bounding box attributes for a cube with the given half-width
+    string box(string halfWidth)
+    {
+        return "minX=\"-" + halfWidth + "\" maxX=\"" + halfWidth + "\" minY=\"-" + halfWidth + "\" maxY=\"" + halfWidth
+               + "\" minZ=\"-" + halfWidth + "\" maxZ=\"" + halfWidth + "\"";
+    }
+
+    // returns an instrument system with the given default wavelength grid and a face-on and edge-on instrument
+    string instrumentSystem(string wavelengthGrid, string fieldOfView, int numPixels = 100)
+    {
+        string instrument = "distance=\"10 Mpc\" azimuth=\"0 deg\" roll=\"0 deg\" fieldOfViewX=\"" + fieldOfView
+                            + "\" numPixelsX=\"" + std::to_string(numPixels) + "\" centerX=\"0 pc\" fieldOfViewY=\""
+                            + fieldOfView + "\" numPixelsY=\"" + std::to_string(numPixels) + "\" centerY=\"0 pc\"";
+        return "<instrumentSystem type=\"InstrumentSystem\">\n"
+               "<InstrumentSystem>\n"
+               "<defaultWavelengthGrid type=\"WavelengthGrid\">\n"
+               + wavelengthGrid
+               + "</defaultWavelengthGrid>\n"
+                 "<instruments type=\"Instrument\">\n"
+                 "<FullInstrument instrumentName=\"face\" inclination=\"0 deg\" "
+               + instrument
+               + "/>\n"
+                 "<FullInstrument instrumentName=\"edge\" inclination=\"90 deg\" "
+               + instrument
+               + "/>\n"
+                 "</instruments>\n"
+                 "</InstrumentSystem>\n"
+                 "</instrumentSystem>\n";
+    }
+
+    // returns a logarithmic wavelength grid over the optical range
+    string opticalWavelengthGrid()
+    {
+        return "<LogWavelengthGrid minWavelength=\"0.1 micron\" maxWavelength=\"10 micron\" numWavelengths=\"20\"/>\n";
+    }
+
+    // returns the exponential disk geometry used for both stars and dust in the galaxy models
+    string diskGeometry(string scaleHeight)
+    {
+        return "<geometry type=\"Geometry\">\n"
+               "<ExpDiskGeometry scaleLength=\"4 kpc\" scaleHeight=\""
+               + scaleHeight
+               + "\" minRadius=\"0 pc\" maxRadius=\"20 kpc\" maxZ=\"5 kpc\"/>\n"
+                 "</geometry>\n";
+    }
+
+    // returns a geometric source with the given geometry and a stellar black-body SED
+    string geometricSource(string geometry)
+    {
+        return "<GeometricSource>\n" + geometry + blackBodySED("6000 K") + "</GeometricSource>\n";
+    }
+
+    // ---- individual models ----
+
+    // a grey dust slab illuminated from below, discretized on a regular Cartesian grid
+    string slab(double numPackets)
+    {
+        return header("ExtinctionOnly", numPackets)
+               + sourceSystem("0.1 micron", "10 micron",
+                              "<PointSource positionX=\"0 pc\" positionY=\"0 pc\" positionZ=\"-900 pc\">\n"
+                                  + blackBodySED("6000 K") + "</PointSource>\n")
+               + mediumSystem(photonPacketOptions(true),
+                              "<GeometricMedium>\n"
+                              "<geometry type=\"Geometry\">\n"
+                              "<UniformBoxGeometry minX=\"-1 kpc\" maxX=\"1 kpc\" minY=\"-1 kpc\" maxY=\"1 kpc\" "
+                              "minZ=\"-200 pc\" maxZ=\"200 pc\"/>\n"
+                              "</geometry>\n"
+                                  + greyDustMix() + opticalDepthNormalization("Z", 5.)
+                                  + "</GeometricMedium>\n",
+                              "<CartesianSpatialGrid " + box("1 kpc")
+                                  + ">\n"
+                                    "<meshX type=\"Mesh\"><LinMesh numBins=\"64\"/></meshX>\n"
+                                    "<meshY type=\"Mesh\"><LinMesh numBins=\"64\"/></meshY>\n"
+                                    "<meshZ type=\"Mesh\"><LinMesh numBins=\"64\"/></meshZ>\n"
+                                    "</CartesianSpatialGrid>\n")
+               + instrumentSystem(opticalWavelengthGrid(), "2 kpc") + trailer();
+    }
+
+    // a dusty disk galaxy with a stellar disk, discretized on a density-adapted octree
+    string galaxy(double numPackets)
+    {
+        return header("ExtinctionOnly", numPackets)
+               + sourceSystem("0.1 micron", "10 micron", geometricSource(diskGeometry("400 pc")))
+               + mediumSystem(photonPacketOptions(true),
+                              "<GeometricMedium>\n" + diskGeometry("200 pc") + greyDustMix()
+                                  + opticalDepthNormalization("Z", 1.) + "</GeometricMedium>\n",
+                              "<PolicyTreeSpatialGrid " + box("20 kpc")
+                                  + " treeType=\"OctTree\">\n"
+                                    "<policy type=\"TreePolicy\">\n"
+                                    "<DensityTreePolicy minLevel=\"3\" maxLevel=\"8\" maxDustFraction=\"1e-6\" "
+                                    "maxGasFraction=\"1e-6\"/>\n"
+                                    "</policy>\n"
+                                    "</PolicyTreeSpatialGrid>\n")
+               + instrumentSystem(opticalWavelengthGrid(), "40 kpc") + trailer();
+    }
+
+    // an imported SPH particle distribution, discretized on a Voronoi mesh with a site for each particle
+    string voronoi(double numPackets, string particleFilename)
+    {
+        return header("ExtinctionOnly", numPackets)
+               + sourceSystem("0.1 micron", "10 micron", geometricSource(diskGeometry("400 pc")))
+               + mediumSystem(photonPacketOptions(true),
+                              "<ParticleMedium filename=\"" + particleFilename
+                                  + "\" massFraction=\"1\" massType=\"Mass\">\n"
+                                    "<smoothingKernel type=\"SmoothingKernel\">\n"
+                                    "<CubicSplineSmoothingKernel/>\n"
+                                    "</smoothingKernel>\n"
+                                  + greyDustMix() + "</ParticleMedium>\n",
+                              "<VoronoiMeshSpatialGrid " + box("20 kpc") + " policy=\"ImportedSites\"/>\n")
+               + instrumentSystem(opticalWavelengthGrid(), "40 kpc") + trailer();
+    }
+
+    // a dusty disk galaxy discretized on a tetrahedral mesh with vertices sampled from the density
+    string tetra(double numPackets)
+    {
+        return header("ExtinctionOnly", numPackets)
+               + sourceSystem("0.1 micron", "10 micron", geometricSource(diskGeometry("400 pc")))
+               + mediumSystem(photonPacketOptions(true),
+                              "<GeometricMedium>\n" + diskGeometry("200 pc") + greyDustMix()
+                                  + opticalDepthNormalization("Z", 1.) + "</GeometricMedium>\n",
+                              "<TetraMeshSpatialGrid " + box("20 kpc")
+                                  + " policy=\"GasDensity\" numSamples=\"20000\" refine=\"false\"/>\n")
+               + instrumentSystem(opticalWavelengthGrid(), "40 kpc") + trailer();
+    }
+
+    // a Lyman-alpha source in the center of an optically thick uniform sphere of neutral hydrogen,
+    // sampling atom velocities through rejection or from precomputed tables
+    string lya(double numPackets, bool tabulate)
+    {
+        return header("LyaExtinctionOnly", numPackets)
+               + sourceSystem("0.1205 micron", "0.1227 micron",
+                              "<PointSource positionX=\"0 pc\" positionY=\"0 pc\" positionZ=\"0 pc\">\n"
+                              "<sed type=\"SED\">\n"
+                              "<LyaGaussianSED dispersion=\"20 km/s\"/>\n"
+                              "</sed>\n"
+                              "<normalization type=\"LuminosityNormalization\">\n"
+                              "<IntegratedLuminosityNormalization minWavelength=\"0.1205 micron\" "
+                              "maxWavelength=\"0.1227 micron\" integratedLuminosity=\"1 Lsun\"/>\n"
+                              "</normalization>\n"
+                              "</PointSource>\n")
+               + mediumSystem(photonPacketOptions(false)
+                                  + "<lyaOptions type=\"LyaOptions\">\n"
+                                    "<LyaOptions lyaAccelerationScheme=\"Variable\" lyaAccelerationStrength=\"1\" "
+                                    "tabulateAtomVelocities=\""
+                                  + string(tabulate ? "true" : "false")
+                                  + "\" includeHubbleFlow=\"false\"/>\n"
+                                    "</lyaOptions>\n",
+                              "<GeometricMedium>\n"
+                              "<geometry type=\"Geometry\">\n"
+                              "<ShellGeometry minRadius=\"1 pc\" maxRadius=\"1 kpc\" exponent=\"0\"/>\n"
+                              "</geometry>\n"
+                              "<materialMix type=\"MaterialMix\">\n"
+                              "<LyaNeutralHydrogenGasMix defaultTemperature=\"1e4 K\"/>\n"
+                              "</materialMix>\n"
+                              "<normalization type=\"MaterialNormalization\">\n"
+                              "<NumberColumnMaterialNormalization axis=\"X\" numberColumnDensity=\"2e16 1/cm2\"/>\n"
+                              "</normalization>\n"
+                              "</GeometricMedium>\n",
+                              "<Sphere1DSpatialGrid minRadius=\"0 pc\" maxRadius=\"1 kpc\">\n"
+                              "<meshRadial type=\"Mesh\"><LinMesh numBins=\"100\"/></meshRadial>\n"
+                              "</Sphere1DSpatialGrid>\n")
+               + instrumentSystem("<LinWavelengthGrid minWavelength=\"0.1210 micron\" maxWavelength=\"0.1222 micron\" "
+                                  "numWavelengths=\"200\"/>\n",
+                                  "2 kpc", 50)
+               + trailer();
+    }
+
+    // a molecular cloud with non-LTE carbon monoxide line transfer, iterating over secondary emission
+    string nonlte(double numPackets)
+    {
+        return header("GasEmission", numPackets, " iterateSecondaryEmission=\"true\"")
+               + sourceSystem("2500 micron", "2700 micron",
+                              "<PointSource positionX=\"0 pc\" positionY=\"0 pc\" positionZ=\"0 pc\">\n"
+                              "<sed type=\"SED\">\n"
+                              "<BlackBodySED temperature=\"30 K\"/>\n"
+                              "</sed>\n"
+                              "<normalization type=\"LuminosityNormalization\">\n"
+                              "<IntegratedLuminosityNormalization minWavelength=\"2500 micron\" "
+                              "maxWavelength=\"2700 micron\" integratedLuminosity=\"1 Lsun\"/>\n"
+                              "</normalization>\n"
+                              "</PointSource>\n")
+               + mediumSystem("<radiationFieldOptions type=\"RadiationFieldOptions\">\n"
+                              "<RadiationFieldOptions storeRadiationField=\"true\">\n"
+                              "<radiationFieldWLG type=\"DisjointWavelengthGrid\">\n"
+                              "<LinWavelengthGrid minWavelength=\"2600.60 micron\" maxWavelength=\"2600.92 micron\" "
+                              "numWavelengths=\"100\"/>\n"
+                              "</radiationFieldWLG>\n"
+                              "</RadiationFieldOptions>\n"
+                              "</radiationFieldOptions>\n"
+                              "<iterationOptions type=\"IterationOptions\">\n"
+                              "<IterationOptions minSecondaryIterations=\"1\" maxSecondaryIterations=\"5\"/>\n"
+                              "</iterationOptions>\n",
+                              "<GeometricMedium>\n"
+                              "<geometry type=\"Geometry\">\n"
+                              "<PlummerGeometry scaleLength=\"1 pc\"/>\n"
+                              "</geometry>\n"
+                              "<materialMix type=\"MaterialMix\">\n"
+                              "<NonLTELineGasMix species=\"CarbonMonoxide\" numEnergyLevels=\"5\" "
+                              "defaultTemperature=\"20 K\" defaultCollisionPartnerRatios=\"1\" "
+                              "defaultTurbulenceVelocity=\"1 km/s\" maxChangeInLevelPopulations=\"0.05\" "
+                              "maxFractionNotConvergedCells=\"0.001\" maxChangeInGlobalLevelPopulations=\"0.05\" "
+                              "storeMeanIntensities=\"false\"/>\n"
+                              "</materialMix>\n"
+                              "<normalization type=\"MaterialNormalization\">\n"
+                              "<MassMaterialNormalization mass=\"1e4 Msun\"/>\n"
+                              "</normalization>\n"
+                              "</GeometricMedium>\n",
+                              "<PolicyTreeSpatialGrid " + box("5 pc")
+                                  + " treeType=\"OctTree\">\n"
+                                    "<policy type=\"TreePolicy\">\n"
+                                    "<DensityTreePolicy minLevel=\"3\" maxLevel=\"6\" maxGasFraction=\"1e-4\"/>\n"
+                                    "</policy>\n"
+                                    "</PolicyTreeSpatialGrid>\n")
+               + instrumentSystem("<LinWavelengthGrid minWavelength=\"2600.60 micron\" "
+                                  "maxWavelength=\"2600.92 micron\" numWavelengths=\"50\"/>\n",
+                                  "10 pc", 50)
+               + trailer();
+    }
+
+    // an ionizing point source in a uniform hydrogen cloud, iterating over primary emission to converge the
+    // ionization state of the gas
+    string photoion(double numPackets)
+    {
+        return header("GasEmission", numPackets, " iteratePrimaryEmission=\"true\"")
+               + sourceSystem("0.01 micron", "10 micron",
+                              "<PointSource positionX=\"0 pc\" positionY=\"0 pc\" positionZ=\"0 pc\">\n"
+                              "<sed type=\"SED\">\n"
+                              "<BlackBodySED temperature=\"40000 K\"/>\n"
+                              "</sed>\n"
+                              "<normalization type=\"LuminosityNormalization\">\n"
+                              "<IntegratedLuminosityNormalization minWavelength=\"0.01 micron\" "
+                              "maxWavelength=\"10 micron\" integratedLuminosity=\"1e5 Lsun\"/>\n"
+                              "</normalization>\n"
+                              "</PointSource>\n")
+               + mediumSystem("<radiationFieldOptions type=\"RadiationFieldOptions\">\n"
+                              "<RadiationFieldOptions storeRadiationField=\"true\">\n"
+                              "<radiationFieldWLG type=\"DisjointWavelengthGrid\">\n"
+                              "<LogWavelengthGrid minWavelength=\"0.01 micron\" maxWavelength=\"10 micron\" "
+                              "numWavelengths=\"100\"/>\n"
+                              "</radiationFieldWLG>\n"
+                              "</RadiationFieldOptions>\n"
+                              "</radiationFieldOptions>\n"
+                              "<iterationOptions type=\"IterationOptions\">\n"
+                              "<IterationOptions minPrimaryIterations=\"1\" maxPrimaryIterations=\"5\"/>\n"
+                              "</iterationOptions>\n",
+                              "<GeometricMedium>\n"
+                              "<geometry type=\"Geometry\">\n"
+                              "<ShellGeometry minRadius=\"1 pc\" maxRadius=\"10 pc\" exponent=\"0\"/>\n"
+                              "</geometry>\n"
+                              "<materialMix type=\"MaterialMix\">\n"
+                              "<DiffuseIonizedGasMix defaultMetallicity=\"0.02\" defaultTemperature=\"1e4 K\"/>\n"
+                              "</materialMix>\n"
+                              "<normalization type=\"MaterialNormalization\">\n"
+                              "<MassMaterialNormalization mass=\"1e3 Msun\"/>\n"
+                              "</normalization>\n"
+                              "</GeometricMedium>\n",
+                              "<Sphere1DSpatialGrid minRadius=\"0 pc\" maxRadius=\"10 pc\">\n"
+                              "<meshRadial type=\"Mesh\"><LinMesh numBins=\"100\"/></meshRadial>\n"
+                              "</Sphere1DSpatialGrid>\n")
+               + instrumentSystem("<LogWavelengthGrid minWavelength=\"0.01 micron\" maxWavelength=\"10 micron\" "
+                                  "numWavelengths=\"50\"/>\n",
+                                  "20 pc", 50)
+               + trailer();
+    }
+
+    // writes a particle file sampling an exponential disk with a fixed random seed, so that the file is reproducible
+    void writeParticles(string filepath, int numParticles)
+    {
+        std::mt19937 engine(12345);
+        std::uniform_real_distribution<double> uniform(0., 1.);
+        std::exponential_distribution<double> radial(1. / 4000.);  // scale length in pc
+        std::exponential_distribution<double> vertical(1. / 200.);  // scale height in pc
+        const double totalMass = 1e8;                               // in Msun
+
+        std::ofstream out = System::ofstream(filepath);
+        if (!out) throw FATALERROR("Could not open benchmark particle file " + filepath);
+        out << "# SPH particles for skirt-bench\n";
+        out << "# column 1: position x (pc)\n";
+        out << "# column 2: position y (pc)\n";
+        out << "# column 3: position z (pc)\n";
+        out << "# column 4: smoothing length (pc)\n";
+        out << "# column 5: mass (Msun)\n";
+        for (int i = 0; i != numParticles; ++i)
+        {
+            // the sum of two exponential deviates has the radial distribution of an exponential disk
+            double R = min(radial(engine) + radial(engine), 19000.);
+            double phi = 2. * M_PI * uniform(engine);
+            double z = vertical(engine) * (uniform(engine) < 0.5 ? -1. : 1.);
+            z = max(min(z, 4000.), -4000.);
+            double h = 100. + 0.05 * R;
+            out << StringUtils::toString(R * cos(phi), 'f', 2) << ' ' << StringUtils::toString(R * sin(phi), 'f', 2)
+                << ' ' << StringUtils::toString(z, 'f', 2) << ' ' << StringUtils::toString(h, 'f', 2) << ' '
+                << StringUtils::toString(totalMass / numParticles, 'e', 4) << '\n';
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+vector<BenchmarkModels::Model> BenchmarkModels::models()
+{
+    return {
+        {"slab", "grey dust slab on a 64^3 Cartesian grid, point source, forced scattering", 2e5, ""},
+        {"galaxy", "dusty exponential disk galaxy on a density-adapted octree", 2e5, ""},
+        {"voronoi", "imported SPH particles on a Voronoi mesh with one site per particle", 1e5, ""},
+        {"tetra", "dusty exponential disk galaxy on a tetrahedral mesh", 1e5, ""},
+        {"lya", "Lyman-alpha point source in an optically thick neutral hydrogen sphere", 1e4, ""},
+        {"lyatab", "Lyman-alpha sphere as above with tabulated atom velocity sampling", 1e4, "lya"},
+        {"nonlte", "non-LTE carbon monoxide line transfer in a molecular cloud", 2e4, ""},
+        {"photoion", "ionizing point source in a hydrogen cloud with primary emission iteration", 2e4, ""},
+    };
+}
+
+////////////////////////////////////////////////////////////////////
+
+void BenchmarkModels::writeModel(const Model& model, double numPackets, string skiFilePath, string inputDirPath)
+{
+    string contents;
+    if (model.name == "slab")
+        contents = slab(numPackets);
+    else if (model.name == "galaxy")
+        contents = galaxy(numPackets);
+    else if (model.name == "voronoi")
+    {
+        string particleFilename = "bench_particles.txt";
+        writeParticles(StringUtils::joinPaths(inputDirPath, particleFilename), 20000);
+        contents = voronoi(numPackets, particleFilename);
+    }
+    else if (model.name == "tetra")
+        contents = tetra(numPackets);
+    else if (model.name == "lya")
+        contents = lya(numPackets, false);
+    else if (model.name == "lyatab")
+        contents = lya(numPackets, true);
+    else if (model.name == "nonlte")
+        contents = nonlte(numPackets);
+    else if (model.name == "photoion")
+        contents = photoion(numPackets);
+    else
+        throw FATALERROR("Unknown benchmark model: " + model.name);
+
+    std::ofstream out = System::ofstream(skiFilePath);
+    if (!out) throw FATALERROR("Could not open benchmark ski file " + skiFilePath);
+    out << contents;
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,50 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef BENCHMARKMODELS_HPP
+#define BENCHMARKMODELS_HPP
+
+#include "Basics.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+/** The BenchmarkModels namespace offers the curated set of synthetic models used by the skirt-bench
+    performance benchmark. Each model is fully specified by a generated ski file and, where
+    needed, generated input data files, so that the benchmark results do not depend on external
+    input data. Wherever possible, the models use material mixes that do not require resource
+    files; the models that do require resources (e.g., atomic data for non-LTE line transfer or
+    photoionization tables) are reported as failed, with the corresponding error message, if
+    these resources are not installed.
+
+    A model may name another model as its reference. The two models then differ only in the value
+    of an option that trades accuracy for speed, so that comparing their emergent spectra
+    quantifies the accuracy of the faster method.
+
+    The models are designed to exercise a representative range of code paths: the various spatial
+    grid types and their path segment generators, the medium state and opacity calculations for
+    different material types, and photon packet detection by instruments. */
+namespace BenchmarkModels
+{
+    /** This structure describes a benchmark model. */
+    struct Model
+    {
+        string name;         // a short identifier used on the command line and in the output files
+        string description;  // a brief human-readable description
+        double numPackets;   // the number of photon packets per segment for a packet scale factor of one
+        string reference;    // the name of a model producing reference spectra for this model, or empty
+    };
+
+    /** This function returns the list of all available benchmark models. */
+    vector<Model> models();
+
+    /** This function writes the ski file for the specified model to the specified file path, using
+        the specified number of photon packets per segment, and writes any input data files needed
+        by the model to the specified input directory. */
+    void writeModel(const Model& model, double numPackets, string skiFilePath, string inputDirPath);
+}
+
+////////////////////////////////////////////////////////////////////
+
+#endif
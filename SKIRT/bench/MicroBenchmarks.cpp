@@ -0,0 +1,135 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "MicroBenchmarks.hpp"
+#include "Configuration.hpp"
+#include "Instrument.hpp"
+#include "InstrumentSystem.hpp"
+#include "MediumSystem.hpp"
+#include "MonteCarloSimulation.hpp"
+#include "ParallelFactory.hpp"
+#include "PathSegmentGenerator.hpp"
+#include "PhotonPacket.hpp"
+#include "Random.hpp"
+#include "SpatialGrid.hpp"
+#include "VoigtProfile.hpp"
+#include "VoigtSamplingTable.hpp"
+#include <chrono>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // returns the number of seconds elapsed since the specified time point
+    double secondsSince(std::chrono::steady_clock::time_point started)
+    {
+        using namespace std::chrono;
+        return duration_cast<duration<double>>(steady_clock::now() - started).count();
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+vector<MicroBenchmarks::Result> MicroBenchmarks::run(MonteCarloSimulation* simulation, double numOperations)
+{
+    // set up the simulation without running it
+    simulation->parallelFactory()->setup();
+    simulation->log()->setup();
+    simulation->config()->setup();
+    simulation->setup();
+
+    vector<Result> results;
+    Random* random = simulation->random();
+    Range range = simulation->config()->sourceWavelengthRange();
+    auto randomWavelength = [random, range]() { return range.min() + random->uniform() * range.width(); };
+    size_t n = static_cast<size_t>(max(1., numOperations));
+    double sink = 0.;  // accumulates results so that the compiler cannot optimize the benchmarked calls away
+
+    MediumSystem* ms = simulation->mediumSystem();
+    if (ms && ms->numCells() > 0)
+    {
+        // trace random rays through the spatial grid, counting the operations as generated path segments
+        {
+            const SpatialGrid* grid = ms->grid();
+            Box box = grid->boundingBox();
+            auto generator = grid->createPathSegmentGenerator();
+            size_t numSegments = 0;
+            auto started = std::chrono::steady_clock::now();
+            for (size_t i = 0; i != n; ++i)
+            {
+                generator->start(random->position(box), random->direction());
+                while (generator->next())
+                {
+                    sink += generator->ds();
+                    numSegments++;
+                }
+            }
+            results.push_back({"pathsegments", static_cast<double>(numSegments), secondsSince(started)});
+        }
+
+        // look up extinction opacities for random cells, media and wavelengths
+        {
+            int numCells = ms->numCells();
+            int numMedia = ms->numMedia();
+            auto started = std::chrono::steady_clock::now();
+            for (size_t i = 0; i != n; ++i)
+            {
+                double lambda = randomWavelength();
+                int m = min(static_cast<int>(random->uniform() * numCells), numCells - 1);
+                int h = min(static_cast<int>(random->uniform() * numMedia), numMedia - 1);
+                sink += ms->opacityExt(lambda, m, h);
+            }
+            results.push_back({"opacity", static_cast<double>(n), secondsSince(started)});
+        }
+    }
+
+    // launch peel-off photon packets towards each instrument and detect them
+    const auto& instruments = simulation->instrumentSystem()->instruments();
+    if (!instruments.empty())
+    {
+        Box box = ms ? ms->grid()->boundingBox() : Box();
+        PhotonPacket pp, ppp;
+        auto started = std::chrono::steady_clock::now();
+        for (size_t i = 0; i != n; ++i)
+        {
+            double lambda = randomWavelength();
+            Position bfr = random->position(box);
+            pp.launch(i, lambda, 1., bfr, random->direction());
+            pp.setPrimaryOrigin(0);
+            for (Instrument* instrument : instruments)
+            {
+                ppp.launchEmissionPeelOff(&pp, instrument->bfkobs(bfr));
+                instrument->detect(&ppp);
+            }
+        }
+        results.push_back({"detect", static_cast<double>(n * instruments.size()), secondsSince(started)});
+    }
+
+    // sample the parallel component of Lyman-alpha atom velocities through rejection and from precomputed tables,
+    // for the Voigt parameter corresponding to a gas temperature of 10^4 K and frequencies in the core and inner wings
+    if (simulation->config()->hasLymanAlpha())
+    {
+        const double a = 4.7e-4;
+        auto randomFrequency = [random]() { return 10. * random->uniform() - 5.; };
+        {
+            auto started = std::chrono::steady_clock::now();
+            for (size_t i = 0; i != n; ++i) sink += VoigtProfile::sample(a, randomFrequency(), random);
+            results.push_back({"voigtrejection", static_cast<double>(n), secondsSince(started)});
+        }
+        {
+            VoigtSamplingTable table;
+            table.initialize();
+            auto started = std::chrono::steady_clock::now();
+            for (size_t i = 0; i != n; ++i) sink += table.sample(a, randomFrequency(), random);
+            results.push_back({"voigttabulated", static_cast<double>(n), secondsSince(started)});
+        }
+    }
+
+    // use the accumulated value in a way that has no visible effect
+    if (sink < 0.) results.clear();
+    return results;
+}
+
+////////////////////////////////////////////////////////////////////
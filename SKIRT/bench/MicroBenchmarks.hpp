@@ -0,0 +1,47 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef MICROBENCHMARKS_HPP
+#define MICROBENCHMARKS_HPP
+
+#include "Basics.hpp"
+class MonteCarloSimulation;
+
+////////////////////////////////////////////////////////////////////
+
+/** The MicroBenchmarks namespace offers functions for measuring the performance of isolated hot
+    code paths in a simulation that has been set up but not run: the generation of path segments by
+    the spatial grid, the lookup of extinction opacities in the medium system, and the detection
+    of peel-off photon packets by the instruments. Each micro-benchmark executes a given number of
+    operations in the calling thread and measures the elapsed wall time. Comparing these isolated
+    rates with the overall photon packet rates of full simulation runs helps to determine which
+    part of the photon packet life cycle dominates the run time for a given model. */
+namespace MicroBenchmarks
+{
+    /** This structure holds the result of a single micro-benchmark. */
+    struct Result
+    {
+        string name;        // a short identifier for the benchmarked operation
+        double operations;  // the number of operations performed
+        double seconds;     // the elapsed wall time in seconds
+    };
+
+    /** This function sets up the specified simulation without running it and performs the
+        micro-benchmarks that are meaningful for the simulation's configuration, executing the
+        specified number of operations for each. A path segment generation benchmark traces random
+        rays through the spatial grid and is performed only if the simulation has a medium system.
+        An opacity lookup benchmark retrieves the extinction opacity for random cells, media and
+        wavelengths, and is also performed only if the simulation has a medium system. A detection
+        benchmark launches peel-off photon packets from random positions inside the source
+        wavelength range towards each instrument, and is performed only if the simulation has
+        instruments. Finally, for simulations with Lyman-alpha line transfer, two benchmarks sample
+        the parallel component of the atom velocity for random frequencies, through the rejection
+        technique and from precomputed tables, respectively. */
+    vector<Result> run(MonteCarloSimulation* simulation, double numOperations);
+}
+
+////////////////////////////////////////////////////////////////////
+
+#endif
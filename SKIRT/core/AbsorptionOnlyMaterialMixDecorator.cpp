@@ -79,6 +79,13 @@ void AbsorptionOnlyMaterialMixDecorator::initializeSpecificState(MaterialState*
 
 ////////////////////////////////////////////////////////////////////
 
+void AbsorptionOnlyMaterialMixDecorator::beginSpecificStateUpdate() const
+{
+    materialMix()->beginSpecificStateUpdate();
+}
+
+////////////////////////////////////////////////////////////////////
+
 UpdateStatus AbsorptionOnlyMaterialMixDecorator::updateSpecificState(MaterialState* state, const Array& Jv) const
 {
     return materialMix()->updateSpecificState(state, Jv);
@@ -96,6 +103,13 @@ bool AbsorptionOnlyMaterialMixDecorator::isSpecificStateConverged(int numCells,
 
 ////////////////////////////////////////////////////////////////////
 
+vector<int> AbsorptionOnlyMaterialMixDecorator::acceleratedSpecificStateVariables() const
+{
+    return materialMix()->acceleratedSpecificStateVariables();
+}
+
+////////////////////////////////////////////////////////////////////
+
 double AbsorptionOnlyMaterialMixDecorator::mass() const
 {
     return materialMix()->mass();
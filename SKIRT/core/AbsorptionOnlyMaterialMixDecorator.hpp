@@ -112,6 +112,12 @@ public:
     //======== Medium state updates =======
 
 public:
+    /** If the decorated material mix has a dynamic medium state, i.e. if the
+        hasDynamicMediumState() function returns anything other than \c None, this function is
+        invoked (once) at the start of each update cycle, \em before updateSpecificState() is
+        called for the spatial cells. */
+    virtual void beginSpecificStateUpdate() const override;
+
     /** If the decorated material mix has a dynamic medium state, i.e. if the
         hasDynamicMediumState() function returns anything other than \c None, this function is
         invoked for each spatial cell at the end of each relevant primary or secondary emission
@@ -136,6 +142,10 @@ public:
                                           MaterialState* currentAggregate,
                                           MaterialState* previousAggregate) const override;
 
+    /** This function returns the indices of the custom specific state variables of the decorated
+        material mix that may be extrapolated by the Ng acceleration scheme. */
+    virtual vector<int> acceleratedSpecificStateVariables() const override;
+
     //======== Low-level material properties =======
 
 public:
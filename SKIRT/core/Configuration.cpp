@@ -105,6 +105,7 @@ void Configuration::setupSelfBefore()
     _minWeightReduction = ms->photonPacketOptions()->minWeightReduction();
     _minScattEvents = ms->photonPacketOptions()->minScattEvents();
     _pathLengthBias = ms->photonPacketOptions()->pathLengthBias();
+    _numWavelengthsPerPacket = ms->photonPacketOptions()->numWavelengthsPerPacket();
 
     // check for negative extinction, which requires explicit absorption
     for (auto medium : ms->media())
@@ -128,6 +129,9 @@ void Configuration::setupSelfBefore()
                 _lyaAccelerationStrength = ms->lyaOptions()->lyaAccelerationStrength();
                 break;
         }
+        _lyaTabulateAtomVelocities = ms->lyaOptions()->tabulateAtomVelocities();
+        _hasLyaDiffusion = ms->lyaOptions()->lyaDiffusionAcceleration();
+        _lyaDiffusionThreshold = ms->lyaOptions()->lyaDiffusionThreshold();
         if (ms->lyaOptions()->includeHubbleFlow()) _hubbleExpansionRate = sim->cosmology()->relativeExpansionRate();
     }
 
@@ -238,6 +242,27 @@ void Configuration::setupSelfBefore()
         _hasSecondaryDynamicState = _hasSecondaryDynamicStateMedia;
     }
 
+    // retrieve the update and acceleration options for dynamic state media
+    if ((_hasPrimaryDynamicStateMedia && _hasPrimaryIterations) || _hasMergedIterations
+        || (_hasSecondaryDynamicStateMedia && _hasSecondaryIterations))
+    {
+        _dynamicStateUpdateTolerance = ms->iterationOptions()->dynamicStateUpdateTolerance();
+        _accelerateDynamicState = ms->iterationOptions()->accelerateDynamicState();
+    }
+
+    // retrieve the checkpoint and re-observation options
+    if (_hasPrimaryIterations || _hasSecondaryEmission)
+    {
+        _writeCheckpoints = ms->iterationOptions()->writeCheckpoints();
+        _restartFilename = StringUtils::squeeze(ms->iterationOptions()->restartFilename());
+        if (!_restartFilename.empty())
+        {
+            auto mode = ms->iterationOptions()->reobservationMode();
+            _hasReobservation = mode != IterationOptions::ReobservationMode::None;
+            _hasDirectReobservation = mode == IterationOptions::ReobservationMode::DirectOnly;
+        }
+    }
+
     // retrieve radiation field options
     _hasRadiationField =
         _hasPrimaryIterations || _hasSecondaryEmission || ms->radiationFieldOptions()->storeRadiationField();
@@ -383,6 +408,28 @@ void Configuration::setupSelfAfter()
     // in case emulation mode has been set before our setup() was called, perform the emulation overrides again
     if (emulationMode()) setEmulationMode();
 
+    // perform the prediction mode overrides now that the configured packet numbers and iteration limits are known
+    if (predictionMode())
+    {
+        _predictionMinPrimaryIterations = _minPrimaryIterations;
+        _predictionMaxPrimaryIterations = _maxPrimaryIterations;
+        _predictionMinSecondaryIterations = _minSecondaryIterations;
+        _predictionMaxSecondaryIterations = _maxSecondaryIterations;
+        _minPrimaryIterations = min(_minPrimaryIterations, 1);
+        _maxPrimaryIterations = min(_maxPrimaryIterations, 1);
+        _minSecondaryIterations = min(_minSecondaryIterations, 1);
+        _maxSecondaryIterations = min(_maxSecondaryIterations, 1);
+        if (_numPrimaryPackets > _numPilotPackets)
+        {
+            _predictionPacketsFactor = _numPrimaryPackets / _numPilotPackets;
+            for (double* numPackets : {&_numPrimaryPackets, &_numPrimaryIterationPackets, &_numSecondaryPackets,
+                                       &_numSecondaryIterationPackets})
+                if (*numPackets) *numPackets = max(1., *numPackets / _predictionPacketsFactor);
+        }
+        log->info("  Prediction mode with packet numbers divided by "
+                  + StringUtils::toString(_predictionPacketsFactor, 'g', 4));
+    }
+
     // --- log wavelength regime, simulation mode, and media characteristics  ---
 
     string regime = _oligochromatic ? "Oligo" : "Pan";
@@ -391,6 +438,17 @@ void Configuration::setupSelfAfter()
     log->info("  " + medium + " transfer medium");
     if (_hasLymanAlpha) log->info("  Including Lyman-alpha line transfer");
 
+    // disable Lyman-alpha diffusion steps when we have a radiation field because
+    // the diffusion steps do not register the radiation field inside the diffusion sphere
+    if (_hasLymanAlpha && _hasLyaDiffusion && _hasRadiationField)
+    {
+        log->warning("  Disabling Lyman-alpha diffusion steps to allow storing the radiation field");
+        _hasLyaDiffusion = false;
+    }
+    if (_hasLymanAlpha && _hasLyaDiffusion)
+        log->info("  Using Lyman-alpha diffusion steps for a*tau0 above "
+                  + StringUtils::toString(_lyaDiffusionThreshold, 'g', 4));
+
     if (_hasStochasticDustEmission)
         log->info("  Including dust emission with stochastic heating");
     else if (_hasDustEmission)
@@ -495,6 +553,28 @@ void Configuration::setupSelfAfter()
         _pathLengthBias = 0.;
     }
 
+    // disable polychromatic photon packets if the photon cycle, the media or the sources do not support them
+    if (_numWavelengthsPerPacket > 1)
+    {
+        bool supported = _forceScattering && !_explicitAbsorption && !_oligochromatic && !_hasLymanAlpha
+                         && !_hasPolarization && !_needIndividualPeelOff && !_hasMovingSources
+                         && (_hasSingleConstantSectionMedium || _hasMultipleConstantSectionMedia);
+        for (auto medium : find<MediumSystem>()->media())
+            if (!medium->mix()->isDust()) supported = false;
+        for (auto source : find<SourceSystem>()->sources())
+            if (!source->supportsPolychromaticPackets()) supported = false;
+        if (supported)
+        {
+            log->info("  Launching primary photon packets with " + std::to_string(_numWavelengthsPerPacket)
+                      + " wavelengths each");
+        }
+        else
+        {
+            log->warning("  Disabling polychromatic photon packets because the configuration does not support them");
+            _numWavelengthsPerPacket = 1;
+        }
+    }
+
     // --- log magnetic field issues ---
 
     // if there is a magnetic field, there usually should be spheroidal particles
@@ -527,6 +607,21 @@ void Configuration::setEmulationMode()
 
 ////////////////////////////////////////////////////////////////////
 
+void Configuration::setPredictionMode(double numPilotPackets)
+{
+    _predictionMode = true;
+    _numPilotPackets = max(1., numPilotPackets);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Configuration::setEventCountingMode()
+{
+    _eventCountingMode = true;
+}
+
+////////////////////////////////////////////////////////////////////
+
 namespace
 {
     // This function extends the specified wavelength range with the range of the specified wavelength grid
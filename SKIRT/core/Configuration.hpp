@@ -58,6 +58,22 @@ public:
         disables iteration over primary and/or secondary emisson. */
     void setEmulationMode();
 
+    /** This function puts the simulation in prediction mode. Specifically, it sets a flag that can
+        be queried by other simulation items, it scales all photon packet numbers so that the
+        primary emission segment launches the specified number of pilot packets, and it limits the
+        number of primary and/or secondary emission iterations to one. The scaling factor and the
+        original iteration limits remain available through the corresponding getters so that the
+        resource usage of the full run can be extrapolated from the pilot run. If the configured
+        number of primary packets is already smaller than the specified number of pilot packets,
+        the packet numbers are left unchanged. */
+    void setPredictionMode(double numPilotPackets);
+
+    /** This function puts the simulation in event counting mode. Specifically, it sets a flag that
+        can be queried by other simulation items. In this mode, the simulation counts events in the
+        photon packet life cycle for each segment and writes the resulting statistics to a text
+        file (see the EventCounters class). */
+    void setEventCountingMode();
+
     //=========== Getters for configuration properties ============
 
 public:
@@ -66,6 +82,36 @@ public:
     /** Returns true if the simulation has been put in emulation mode. */
     bool emulationMode() const { return _emulationMode; }
 
+    // ----> prediction mode
+
+    /** Returns true if the simulation has been put in prediction mode. */
+    bool predictionMode() const { return _predictionMode; }
+
+    /** Returns the factor by which the photon packet numbers configured by the user have been
+        divided in prediction mode, or 1 if the simulation is not in prediction mode. */
+    double predictionPacketsFactor() const { return _predictionPacketsFactor; }
+
+    /** Returns the minimum number of primary emission iterations configured by the user, before
+        any limits imposed by prediction mode. */
+    int predictionMinPrimaryIterations() const { return _predictionMinPrimaryIterations; }
+
+    /** Returns the maximum number of primary emission iterations configured by the user, before
+        any limits imposed by prediction mode. */
+    int predictionMaxPrimaryIterations() const { return _predictionMaxPrimaryIterations; }
+
+    /** Returns the minimum number of secondary emission iterations configured by the user, before
+        any limits imposed by prediction mode. */
+    int predictionMinSecondaryIterations() const { return _predictionMinSecondaryIterations; }
+
+    /** Returns the maximum number of secondary emission iterations configured by the user, before
+        any limits imposed by prediction mode. */
+    int predictionMaxSecondaryIterations() const { return _predictionMaxSecondaryIterations; }
+
+    // ----> event counting mode
+
+    /** Returns true if the simulation has been put in event counting mode. */
+    bool eventCountingMode() const { return _eventCountingMode; }
+
     // ----> symmetry
 
     /** Returns the symmetry dimension of the input model, including sources and media, if present.
@@ -328,6 +374,34 @@ public:
         false otherwise. */
     bool hasDynamicState() const { return _hasPrimaryDynamicState || _hasSecondaryDynamicState; }
 
+    /** Returns true if the convergence of the dynamic medium state for media that perform primary
+        or secondary dynamic medium state updates should be accelerated by Ng extrapolation, and
+        false otherwise. */
+    bool accelerateDynamicState() const { return _accelerateDynamicState; }
+
+    /** Returns the relative change in the radiation field below which the dynamic medium state of
+        a spatial cell is not updated, or zero if all cells should be updated in every iteration. */
+    double dynamicStateUpdateTolerance() const { return _dynamicStateUpdateTolerance; }
+
+    /** Returns true if the simulation should write a checkpoint file at the end of each primary,
+        secondary, or merged iteration and after the final primary emission segment, and false
+        otherwise. */
+    bool writeCheckpoints() const { return _writeCheckpoints; }
+
+    /** Returns the name of the checkpoint file from which the simulation should resume its
+        iterations, or the empty string if the simulation should start from scratch. */
+    string restartFilename() const { return _restartFilename; }
+
+    /** Returns true if the simulation should skip all iterations and perform only the final
+        emission segments for the medium state and radiation field restored from the checkpoint
+        file, and false otherwise. */
+    bool hasReobservation() const { return _hasReobservation; }
+
+    /** Returns true if the re-observation segments should not trace photon packets through the
+        media, so that the instruments record only the direct emission, and false otherwise. The
+        function always returns false if hasReobservation() returns false. */
+    bool hasDirectReobservation() const { return _hasDirectReobservation; }
+
     // ----> photon cycle
 
     /** Returns true if the extinction cross section (the sum of the absorption and scattering
@@ -353,6 +427,15 @@ public:
         distribution. */
     double pathLengthBias() const { return _pathLengthBias; }
 
+    /** Returns the number of wavelengths carried by each photon packet launched by a primary
+        source, including the reference wavelength. A value larger than one means that primary
+        sources launch polychromatic photon packets. */
+    int numWavelengthsPerPacket() const { return _numWavelengthsPerPacket; }
+
+    /** Returns true if the simulation includes Lyman-alpha line transfer, i.e. if the simulation
+        mode is LyaExtinctionOnly. */
+    bool hasLymanAlpha() const { return _hasLymanAlpha; }
+
     /** This enumeration lists the supported Lyman-alpha acceleration schemes. */
     enum class LyaAccelerationScheme { None, Constant, Variable };
 
@@ -366,6 +449,22 @@ public:
         lyaAccelerationScheme() returns \c Constant or \c Variable. */
     double lyaAccelerationStrength() const { return _lyaAccelerationStrength; }
 
+    /** Returns true if the atom velocities for Lyman-alpha line scattering should be sampled from
+        precomputed tables, and false if they should be sampled through the rejection technique.
+        The value is relevant only if Lyman-alpha line treatment is enabled in the simulation. */
+    bool lyaTabulateAtomVelocities() const { return _lyaTabulateAtomVelocities; }
+
+    /** Returns true if random walks of Lyman-alpha photon packets in optically thick cells should
+        be replaced by diffusion steps. The value is relevant only if Lyman-alpha line treatment is
+        enabled in the simulation. Diffusion steps are disabled if the simulation stores the
+        radiation field. */
+    bool hasLyaDiffusion() const { return _hasLyaDiffusion; }
+
+    /** Returns the minimum value of the product of the Voigt parameter and the line-center optical
+        depth of the diffusion sphere for performing a Lyman-alpha diffusion step. The value is
+        relevant only if hasLyaDiffusion() returns true. */
+    double lyaDiffusionThreshold() const { return _lyaDiffusionThreshold; }
+
     /** If inclusion of the Hubble flow is enabled, this function returns the relative expansion
         rate of the universe in which the model resides. If inclusion of the Hubble flow is
         disabled, or if the simulation does not include Lyman-alpha treatment, this function
@@ -447,6 +546,18 @@ private:
     // emulation mode
     bool _emulationMode{false};
 
+    // prediction mode
+    bool _predictionMode{false};
+    double _numPilotPackets{0.};
+    double _predictionPacketsFactor{1.};
+    int _predictionMinPrimaryIterations{0};
+    int _predictionMaxPrimaryIterations{0};
+    int _predictionMinSecondaryIterations{0};
+    int _predictionMaxSecondaryIterations{0};
+
+    // event counting mode
+    bool _eventCountingMode{false};
+
     // symmetry
     int _modelDimension{0};
     int _gridDimension{0};
@@ -509,6 +620,12 @@ private:
     bool _hasSecondaryDynamicStateMedia{false};
     bool _hasPrimaryDynamicState{false};
     bool _hasSecondaryDynamicState{false};
+    bool _accelerateDynamicState{false};
+    double _dynamicStateUpdateTolerance{0.};
+    bool _writeCheckpoints{false};
+    string _restartFilename;
+    bool _hasReobservation{false};
+    bool _hasDirectReobservation{false};
 
     // photon cycle
     bool _hasNegativeExtinction{false};
@@ -517,9 +634,13 @@ private:
     double _minWeightReduction{1e4};
     int _minScattEvents{0};
     double _pathLengthBias{0.5};
+    int _numWavelengthsPerPacket{1};
     bool _hasLymanAlpha{false};
     LyaAccelerationScheme _lyaAccelerationScheme{LyaAccelerationScheme::Variable};
     double _lyaAccelerationStrength{1.};
+    bool _lyaTabulateAtomVelocities{false};
+    bool _hasLyaDiffusion{false};
+    double _lyaDiffusionThreshold{1000.};
     double _hubbleExpansionRate{0.};
 
     // radiation field
@@ -9,6 +9,7 @@
 #include "EmittingGasMix.hpp"
 #include "Log.hpp"
 #include "MediumSystem.hpp"
+#include "MemoryLedger.hpp"
 #include "NR.hpp"
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
@@ -113,6 +114,10 @@ namespace
         Range _wavelengthRange;               // the range of the emission wavelength grid
         int _numWavelengths{0};               // the number of wavelengths in the emission wavelength grid
 
+        // memory accounting, updated when the gas mix changes
+        MediumSystem* _ms{nullptr};  // the medium system for which the memory has been registered
+        size_t _registeredBytes{0};  // the number of bytes registered with the memory ledger for this medium system
+
         // information on a particular spatial cell, initialized by calculateIfNeeded()
         int _m{-1};                // spatial cell index
         Array _lambdav, _pv, _Pv;  // normalized emission spectrum
@@ -128,7 +133,9 @@ namespace
         //   h:  medium component index
         //   mix: material mix for the medium component
         //   ms: medium system
-        void calculateIfNeeded(int m, int h, const EmittingGasMix* mix, MediumSystem* ms)
+        //   source: the secondary source launching the photon packet
+        void calculateIfNeeded(int m, int h, const EmittingGasMix* mix, MediumSystem* ms,
+                               const ContGasSecondarySource* source)
         {
             // when called for the first time for a given gas mix, cache info on the emission wavelength grid
             if (_mix != mix)
@@ -139,6 +146,21 @@ namespace
                 _wavelengthGrid = wavelengthGrid->lambdav();
                 _wavelengthRange = wavelengthGrid->wavelengthRange();
                 _numWavelengths = _wavelengthGrid.size();
+
+                // register any growth of the memory for the wavelength grid and the emission spectra, which is
+                // allocated by this thread during the run; the thread may alternate between multiple gas mixes
+                if (_ms != ms)
+                {
+                    _ms = ms;
+                    _registeredBytes = 0;
+                }
+                size_t bytes = 4 * _numWavelengths * sizeof(double);
+                if (bytes > _registeredBytes)
+                {
+                    if (!_registeredBytes) source->registerCache([this]() { return release(); });
+                    ms->find<MemoryLedger>()->record("per-thread caches", bytes - _registeredBytes);
+                    _registeredBytes = bytes;
+                }
             }
 
             // if this photon packet is launched from the same cell as the previous one, we don't need to do anything
@@ -157,6 +179,22 @@ namespace
             _bfv = ms->bulkVelocity(m);
         }
 
+        // frees the memory held by this cache and returns the number of bytes registered with the memory ledger;
+        // the cache is initialized and registered again if it is used after being released
+        size_t release()
+        {
+            size_t bytes = _registeredBytes;
+            _mix = nullptr;
+            _ms = nullptr;
+            _registeredBytes = 0;
+            _m = -1;
+            _wavelengthGrid = Array();
+            _lambdav = Array();
+            _pv = Array();
+            _Pv = Array();
+            return bytes;
+        }
+
     public:
         // returns a random wavelength generated from the spectral distribution
         double generateWavelength(Random* random) const { return random->cdfLogLog(_lambdav, _pv, _Pv); }
@@ -185,7 +223,7 @@ void ContGasSecondarySource::launch(PhotonPacket* pp, size_t historyIndex, doubl
     double ws = _Lv[m] / _Wv[m];
 
     // calculate the emission spectrum and bulk velocity for this cell, if not already available
-    t_gascell.calculateIfNeeded(m, _h, _mix, _ms);
+    t_gascell.calculateIfNeeded(m, _h, _mix, _ms, this);
 
     // generate a random wavelength from the emission spectrum for the cell and/or from the bias distribution
     double lambda, w;
@@ -11,6 +11,7 @@
 #include "Log.hpp"
 #include "MaterialState.hpp"
 #include "MediumSystem.hpp"
+#include "MemoryLedger.hpp"
 #include "NebularContinuumEmission.hpp"
 #include "NebularLineEmission.hpp"
 #include "PhotonPacket.hpp"
@@ -343,6 +344,12 @@ void DiffuseIonizedGasMix::setupSelfBefore()
         rfDlambdav = rfWavelengthGrid->dlambdav();
         _emissionSolver.initialize(rfLambdav, rfDlambdav);
 
+        // the rate coefficient table dominates the solver's memory usage
+        size_t solverBytes = _emissionSolver.allocatedBytes();
+        log->info(type() + " uses " + StringUtils::toMemSizeString(solverBytes)
+                  + " of memory for photoionization solver tables");
+        find<MemoryLedger>()->record("photoionization solver tables", solverBytes);
+
         // Set up line emission data from NebularLineEmission
         _numLines = NebularLineEmission::numLines;
         _lineCenters.resize(_numLines);
@@ -360,6 +367,18 @@ void DiffuseIonizedGasMix::setupSelfBefore()
         _maxNH_m3 = maxHydrogenDensity() * 1e6;  // cm^-3 -> m^-3
         log->info("Hydrogen density ceiling: " + StringUtils::toString(maxHydrogenDensity(), 'e', 3) + " cm^-3");
     }
+
+    // Create the cell library if enabled; the parameter names must match buildCellLibraryParameters()
+    if (cellLibraryResolution() > 0.)
+    {
+        vector<string> names{"logU", "lognH", "logZ", "logR2", "logR3", "logR4", "logR5", "logyHe"};
+        if (!useCloudyTemperature()) names.push_back("logT");
+        if (abundanceMode() == AbundanceMode::PerCell)
+            for (string element : {"C", "N", "O", "Ne", "Mg", "Si", "S", "Fe"}) names.push_back("log" + element);
+        _cellLibrary.reset(new PhotoIonizationCellLibrary(cellLibraryResolution(), names, find<MemoryLedger>()));
+        log->info("Cell library enabled with a bin width of " + StringUtils::toString(cellLibraryResolution())
+                  + " dex in " + std::to_string(names.size()) + " parameters");
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -655,6 +674,13 @@ void DiffuseIonizedGasMix::initializeSpecificState(MaterialState* state, double
 
 ////////////////////////////////////////////////////////////////////
 
+void DiffuseIonizedGasMix::beginSpecificStateUpdate() const
+{
+    if (_cellLibrary) _cellLibrary->clear();
+}
+
+////////////////////////////////////////////////////////////////////
+
 UpdateStatus DiffuseIonizedGasMix::updateSpecificState(MaterialState* state, const Array& Jv) const
 {
     UpdateStatus status;
@@ -681,57 +707,28 @@ UpdateStatus DiffuseIonizedGasMix::updateSpecificState(MaterialState* state, con
         state->setLogR4(logR4_val);
         state->setLogR5(logR5_val);
 
-        // Update temperature from STAB before ionization balance (PIO solver needs T)
-        if (useCloudyTemperature())
+        // If the cell library is enabled, copy the state from a representative cell with similar conditions if one
+        // has already been calculated in this update cycle; otherwise perform the full calculation for this cell
+        // and make it the representative for its library bin
+        thread_local Array t_parameters;
+        thread_local PhotoIonizationCellLibrary::Key t_key;
+        std::shared_ptr<const PhotoIonizationCellLibrary::Entry> entry;
+        if (_cellLibrary)
         {
-            updateTemperatureFromStab(state);
+            buildCellLibraryParameters(state, n_H, t_parameters);
+            _cellLibrary->quantize(t_parameters, t_key);
+            entry = _cellLibrary->find(t_key, t_parameters);
         }
-
-        // Full ionization balance via PIO solver (replaces standalone H/He solver).
-        // Uses converged Jv and current T to compute all ion fractions self-consistently.
-        constexpr double cm3PerM3 = 1e6;
-        double nH_cgs = n_H / cm3PerM3;  // m^-3 -> cm^-3
-        double T = state->temperature();
-
-        if (T > 0.)
+        if (entry)
         {
-            double metalAbundances[8];
-            buildPerCellAbundances(state, metalAbundances);
-
-            auto result =
-                _emissionSolver.solveIonizationAtFixedT(Jv, nH_cgs, He_abundance, metalAbundances, T, nullptr);
-
-            // H/He neutral fractions from the full solver
-            double h0 = std::max(minNeutralFraction, std::min(result.ionFracs[0], maxNeutralFraction));
-            double he0 = std::max(minNeutralFraction, std::min(result.ionFracs[2], maxNeutralFraction));
-            state->setHNeutralFraction(h0);
-            state->setHeNeutralFraction(he0);
-
-            // Store diagnostic ion fractions
-            for (int i = 0; i < numIonFracDiags; ++i)
-            {
-                if (ionFracDiagTable[i].ionFracsIndex >= 0)
-                    state->setIonFracDiag(i, result.ionFracs[ionFracDiagTable[i].ionFracsIndex]);
-                else
-                    state->setIonFracDiag(i, result.ne);
-            }
-
-            // Store n_HII-weighted ion fraction aggregates: x_ion * n_HII [m^-3]
-            double nHII = n_H * (1.0 - h0);
-            for (int i = 0; i < numIonFracAggs; ++i)
-                state->setIonFracAgg(i, result.ionFracs[ionFracAggTable[i].ionFracsIndex] * nHII);
+            applyCellLibraryEntry(state, n_H, *entry);
         }
         else
         {
-            state->setHNeutralFraction(1.0);
-            state->setHeNeutralFraction(1.0);
-            for (int i = 0; i < numIonFracDiags; ++i) state->setIonFracDiag(i, 0.0);
-            for (int i = 0; i < numIonFracAggs; ++i) state->setIonFracAgg(i, 0.0);
+            updateIonizationState(state, Jv, n_H);
+            if (_cellLibrary) _cellLibrary->insert(t_key, createCellLibraryEntry(state, n_H, t_parameters));
         }
 
-        // Pre-compute opacity arrays
-        precomputeOpacityArrays(state, Jv);
-
         // Update ionized H density for global convergence criterion
         state->setNHIonized(n_H * (1.0 - state->hNeutralFraction()));
 
@@ -755,6 +752,63 @@ UpdateStatus DiffuseIonizedGasMix::updateSpecificState(MaterialState* state, con
 
 ////////////////////////////////////////////////////////////////////
 
+void DiffuseIonizedGasMix::updateIonizationState(MaterialState* state, const Array& Jv, double n_H) const
+{
+    double He_abundance = state->heliumAbundance();
+
+    // Update temperature from STAB before ionization balance (PIO solver needs T)
+    if (useCloudyTemperature())
+    {
+        updateTemperatureFromStab(state);
+    }
+
+    // Full ionization balance via PIO solver (replaces standalone H/He solver).
+    // Uses converged Jv and current T to compute all ion fractions self-consistently.
+    constexpr double cm3PerM3 = 1e6;
+    double nH_cgs = n_H / cm3PerM3;  // m^-3 -> cm^-3
+    double T = state->temperature();
+
+    if (T > 0.)
+    {
+        double metalAbundances[8];
+        buildPerCellAbundances(state, metalAbundances);
+
+        auto result = _emissionSolver.solveIonizationAtFixedT(Jv, nH_cgs, He_abundance, metalAbundances, T, nullptr);
+
+        // H/He neutral fractions from the full solver
+        double h0 = std::max(minNeutralFraction, std::min(result.ionFracs[0], maxNeutralFraction));
+        double he0 = std::max(minNeutralFraction, std::min(result.ionFracs[2], maxNeutralFraction));
+        state->setHNeutralFraction(h0);
+        state->setHeNeutralFraction(he0);
+
+        // Store diagnostic ion fractions
+        for (int i = 0; i < numIonFracDiags; ++i)
+        {
+            if (ionFracDiagTable[i].ionFracsIndex >= 0)
+                state->setIonFracDiag(i, result.ionFracs[ionFracDiagTable[i].ionFracsIndex]);
+            else
+                state->setIonFracDiag(i, result.ne);
+        }
+
+        // Store n_HII-weighted ion fraction aggregates: x_ion * n_HII [m^-3]
+        double nHII = n_H * (1.0 - h0);
+        for (int i = 0; i < numIonFracAggs; ++i)
+            state->setIonFracAgg(i, result.ionFracs[ionFracAggTable[i].ionFracsIndex] * nHII);
+    }
+    else
+    {
+        state->setHNeutralFraction(1.0);
+        state->setHeNeutralFraction(1.0);
+        for (int i = 0; i < numIonFracDiags; ++i) state->setIonFracDiag(i, 0.0);
+        for (int i = 0; i < numIonFracAggs; ++i) state->setIonFracAgg(i, 0.0);
+    }
+
+    // Pre-compute opacity arrays
+    precomputeOpacityArrays(state, Jv);
+}
+
+////////////////////////////////////////////////////////////////////
+
 bool DiffuseIonizedGasMix::isSpecificStateConverged(int /*numCells*/, int numUpdated, int numNotConverged,
                                                     MaterialState* currentAggregate,
                                                     MaterialState* previousAggregate) const
@@ -855,6 +909,13 @@ bool DiffuseIonizedGasMix::isSpecificStateConverged(int /*numCells*/, int numUpd
               + StringUtils::toString(maxChangeInGlobalIonizedH() * 100., 'f', 2) + "% "
               + std::string(globalConverged ? "PASS" : "FAIL"));
 
+    // Log the cell library statistics for this update cycle, and clear the library to free its memory
+    if (_cellLibrary)
+    {
+        log->info("  Cell library: " + _cellLibrary->statistics());
+        _cellLibrary->clear();
+    }
+
     // Log n_HII-weighted mean ion fractions: <x_ion> = sum(x_ion * n_HII * V) / sum(n_HII * V)
     if (currentTotalIonizedH > 0.)
     {
@@ -1092,6 +1153,107 @@ DisjointWavelengthGrid* DiffuseIonizedGasMix::emissionWavelengthGrid() const
 
 ////////////////////////////////////////////////////////////////////
 
+void DiffuseIonizedGasMix::buildCellLibraryParameters(const MaterialState* state, double n_H, Array& parameters) const
+{
+    size_t n = 8;
+    if (!useCloudyTemperature()) n++;
+    if (abundanceMode() == AbundanceMode::PerCell) n += 8;
+    parameters.resize(n);
+
+    size_t k = 0;
+    parameters[k++] = state->ionizationParameter();
+    parameters[k++] = std::log10(n_H / 1e6);  // m^-3 -> cm^-3
+    parameters[k++] = std::log10(state->metallicity());
+    parameters[k++] = state->logR2();
+    parameters[k++] = state->logR3();
+    parameters[k++] = state->logR4();
+    parameters[k++] = state->logR5();
+    parameters[k++] = std::log10(state->heliumAbundance());
+    if (!useCloudyTemperature()) parameters[k++] = std::log10(state->temperature());
+    if (abundanceMode() == AbundanceMode::PerCell)
+        for (int i = 0; i < 8; ++i) parameters[k++] = std::log10(state->custom(_indexFirstMetalAbund + i));
+}
+
+////////////////////////////////////////////////////////////////////
+
+void DiffuseIonizedGasMix::applyCellLibraryEntry(MaterialState* state, double n_H,
+                                                 const PhotoIonizationCellLibrary::Entry& entry) const
+{
+    // the temperature is part of the library parameters unless it is obtained from the STAB tables
+    if (useCloudyTemperature()) state->setTemperature(entry.T);
+    state->setHNeutralFraction(entry.h0);
+    state->setHeNeutralFraction(entry.he0);
+
+    // ion fractions are copied as is, except for the electron density, which scales with the hydrogen density
+    double densityRatio = n_H / entry.nH;
+    for (int i = 0; i < numIonFracDiags; ++i)
+    {
+        if (ionFracDiagTable[i].ionFracsIndex >= 0)
+            state->setIonFracDiag(i, entry.ionFracDiags[i]);
+        else
+            state->setIonFracDiag(i, entry.ionFracDiags[i] * densityRatio);
+    }
+
+    // the entry holds the aggregated ion fractions per unit n_HII
+    double nHII = n_H * (1.0 - entry.h0);
+    for (int i = 0; i < numIonFracAggs; ++i) state->setIonFracAgg(i, entry.ionFracAggs[i] * nHII);
+
+    // opacities are rescaled to the member's hydrogen density
+    double opacityRatio = opacityDensityFactor(n_H) / opacityDensityFactor(entry.nH);
+    int numWavelengths = _opacityWavelengthGrid.size();
+    for (int i = 0; i < numWavelengths; i++)
+    {
+        state->setOpacityAbsAtIndex(i, entry.opacityAbs[i] * opacityRatio);
+        state->setOpacityScaAtIndex(i, entry.opacitySca[i] * opacityRatio);
+        state->setOpacityExtAtIndex(i, entry.opacityExt[i] * opacityRatio);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const PhotoIonizationCellLibrary::Entry>
+DiffuseIonizedGasMix::createCellLibraryEntry(const MaterialState* state, double n_H, const Array& parameters) const
+{
+    auto entry = std::make_shared<PhotoIonizationCellLibrary::Entry>();
+    entry->parameters = parameters;
+    entry->nH = n_H;
+    entry->T = state->temperature();
+    entry->h0 = state->hNeutralFraction();
+    entry->he0 = state->heNeutralFraction();
+
+    entry->ionFracDiags.resize(numIonFracDiags);
+    for (int i = 0; i < numIonFracDiags; ++i) entry->ionFracDiags[i] = state->ionFracDiag(i);
+
+    double nHII = n_H * (1.0 - entry->h0);
+    entry->ionFracAggs.resize(numIonFracAggs);
+    if (nHII > 0.)
+        for (int i = 0; i < numIonFracAggs; ++i) entry->ionFracAggs[i] = state->ionFracAgg(i) / nHII;
+
+    int numWavelengths = _opacityWavelengthGrid.size();
+    entry->opacityAbs.resize(numWavelengths);
+    entry->opacitySca.resize(numWavelengths);
+    entry->opacityExt.resize(numWavelengths);
+    for (int i = 0; i < numWavelengths; i++)
+    {
+        entry->opacityAbs[i] = state->opacityAbsAtIndex(i);
+        entry->opacitySca[i] = state->opacityScaAtIndex(i);
+        entry->opacityExt[i] = state->opacityExtAtIndex(i);
+    }
+    return entry;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double DiffuseIonizedGasMix::opacityDensityFactor(double n_H) const
+{
+    // analytical opacities are proportional to n_H; STAB opacities are held flat above the table's minimum
+    // density and scaled linearly below it (see precomputeOpacityArrays)
+    if (useCloudyOpacity()) return std::min(n_H, _nHMinOpacity);
+    return n_H;
+}
+
+////////////////////////////////////////////////////////////////////
+
 DiffuseIonizedGasMix::TableSelection DiffuseIonizedGasMix::selectTable(double logU) const
 {
     // Transition-table logU edges were cached in setupSelfBefore.
@@ -7,6 +7,7 @@
 #define DIFFUSEIONIZEDGASMIX_HPP
 
 #include "EmittingGasMix.hpp"
+#include "PhotoIonizationCellLibrary.hpp"
 #include "PhotoIonizationSolver.hpp"
 #include "StoredTable.hpp"
 
@@ -126,6 +127,28 @@
     For opacity, cells below the minimum STAB table density are linearly scaled
     (opacity proportional to n). Cells above the maximum table density use StoredTable clamping.
 
+    <b>Cell library</b>
+
+    If cellLibraryResolution is set to a positive value, spatial cells with similar physical
+    conditions share the outcome of a single calculation during each dynamic medium state update.
+    The conditions of a cell are described by the decimal logarithms of the ionization parameter
+    U, the hydrogen number density n_H (in cm^-3), the metallicity Z, the shape ratios R2-R5, and
+    the helium abundance; the logarithm of the gas temperature is added when useCloudyTemperature
+    is turned off, and the logarithms of the 8 metal abundances are added in PerCell mode. These
+    parameters are quantized with the specified bin width (in dex). The first cell handled in a
+    bin serves as its representative: its temperature, ionization balance and opacities are
+    calculated in full. The other cells in the bin copy the representative's temperature (if
+    taken from the STAB tables), neutral fractions and ion fractions, while the electron density
+    and the opacities are rescaled to the cell's own hydrogen density.
+
+    The library is rebuilt for each update cycle and is private to each process. Because the
+    representative of a bin is the first cell processed by any of the parallel threads, results
+    depend on the thread scheduling and on the number of processes, within the accuracy implied by
+    the bin width. As a result, simulations using the library are not bit-for-bit reproducible
+    when running with multiple threads or processes. After each update cycle, the log reports the
+    number of representative and member cells and the mean and maximum deviation (in dex) of each
+    member parameter from its representative. The default value of zero disables the library.
+
     <b>Abundances and gas-phase depletion</b>
 
     The metallicity and per-cell element abundances supplied to this mix are
@@ -250,6 +273,12 @@ class DiffuseIonizedGasMix : public EmittingGasMix
         ATTRIBUTE_MIN_VALUE(maxHydrogenDensity, "[0")
         ATTRIBUTE_DEFAULT_VALUE(maxHydrogenDensity, "100000")
 
+        PROPERTY_DOUBLE(cellLibraryResolution, "bin width in dex for sharing solutions between similar cells (0 = off)")
+        ATTRIBUTE_MIN_VALUE(cellLibraryResolution, "[0")
+        ATTRIBUTE_MAX_VALUE(cellLibraryResolution, "1]")
+        ATTRIBUTE_DEFAULT_VALUE(cellLibraryResolution, "0")
+        ATTRIBUTE_DISPLAYED_IF(cellLibraryResolution, "Level3")
+
     ITEM_END()
 
     //============= Construction - Setup - Destruction =============
@@ -300,7 +329,11 @@ public:
 
     //======== Medium state updates =======
 
-    /** Updates ionization fractions, ionization parameter and 4-bin parameters based on the radiation field. */
+    /** Clears the cell library, if enabled, at the start of each update cycle. */
+    void beginSpecificStateUpdate() const override;
+
+    /** Updates ionization fractions, ionization parameter and 4-bin parameters based on the radiation field.
+        If the cell library is enabled, the state may be copied from a similar cell instead. */
     UpdateStatus updateSpecificState(MaterialState* state, const Array& Jv) const override;
 
     /** Determines if the medium state has converged based on ionization fractions and parameters. */
@@ -458,6 +491,25 @@ private:
     void bracketDeltaAxis(double value, const std::vector<double>& axis_values, const std::vector<int>& axis_deltaIds,
                           int& deltaIdLo, int& deltaIdHi, double& w) const;
 
+    // Calculate the temperature (if taken from the STAB tables), the ionization balance and the opacity arrays
+    // for a cell from the radiation field; n_H is the hydrogen number density in m^-3
+    void updateIonizationState(MaterialState* state, const Array& Jv, double n_H) const;
+
+    // Fill the cell library parameters describing the physical conditions in a cell (see the class
+    // docstring section "Cell library"); n_H is the hydrogen number density in m^-3
+    void buildCellLibraryParameters(const MaterialState* state, double n_H, Array& parameters) const;
+
+    // Copy the state stored in a cell library entry to a member cell, rescaling density-dependent
+    // quantities to the member's hydrogen number density n_H (in m^-3)
+    void applyCellLibraryEntry(MaterialState* state, double n_H, const PhotoIonizationCellLibrary::Entry& entry) const;
+
+    // Create a cell library entry from the fully calculated state of a representative cell
+    std::shared_ptr<const PhotoIonizationCellLibrary::Entry>
+    createCellLibraryEntry(const MaterialState* state, double n_H, const Array& parameters) const;
+
+    // Return the density-dependent factor by which the opacity arrays scale with n_H (in m^-3)
+    double opacityDensityFactor(double n_H) const;
+
     // Dual-table system helpers
     enum class TableSelection { Standard, Transition, Blend };
     TableSelection selectTable(double logU) const;  // Selects which table to use based on logU
@@ -536,6 +588,9 @@ private:
     // PIO-style emission: solver for computing ion fractions from Jv + T
     PhotoIonizationSolver _emissionSolver;
 
+    // Library for sharing solutions between similar cells (only when cellLibraryResolution > 0)
+    std::unique_ptr<PhotoIonizationCellLibrary> _cellLibrary;
+
     // Line emission data (initialized in setupSelfBefore)
     int _numLines = 0;
     Array _lineCenters;
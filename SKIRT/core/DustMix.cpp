@@ -7,6 +7,7 @@
 #include "Configuration.hpp"
 #include "Log.hpp"
 #include "MaterialState.hpp"
+#include "MemoryLedger.hpp"
 #include "NR.hpp"
 #include "PhotonPacket.hpp"
 #include "Random.hpp"
@@ -166,10 +167,12 @@ void DustMix::setupSelfAfter()
         || mode == ScatteringMode::SpheroidalPolarization)
     {
         // create a table with the normalized cumulative distribution of theta for each wavelength
-        _thetaXvv.resize(numLambda, 0);
+        _thetaCdf.initialize(_thetav, numLambda);
         for (int ell = 0; ell != numLambda; ++ell)
         {
-            NR::cdf(_thetaXvv[ell], maxTheta, [this, ell](int t) { return _S11vv(ell, t + 1) * sin(_thetav[t + 1]); });
+            Array thetaXv;
+            NR::cdf(thetaXv, maxTheta, [this, ell](int t) { return _S11vv(ell, t + 1) * sin(_thetav[t + 1]); });
+            _thetaCdf.setRow(ell, thetaXv);
         }
 
         // create a table with the phase function normalization factor for each wavelength
@@ -232,7 +235,6 @@ void DustMix::setupSelfAfter()
     allocatedSize += _S12vv.size();
     allocatedSize += _S33vv.size();
     allocatedSize += _S34vv.size();
-    allocatedSize += _thetaXvv.size();
     allocatedSize += _pfnormv.size();
     allocatedSize += _phiv.size();
     allocatedSize += _phi1v.size();
@@ -241,8 +243,12 @@ void DustMix::setupSelfAfter()
     allocatedSize += _sigmaabsvv.size();
     allocatedSize += _sigmaabspolvv.size();
 
-    allocatedBytes += allocatedSize * sizeof(double) + _calc.allocatedBytes();
+    allocatedBytes += allocatedSize * sizeof(double) + _thetaCdf.allocatedBytes() + _calc.allocatedBytes();
     find<Log>()->info(type() + " allocated " + StringUtils::toMemSizeString(allocatedBytes) + " of memory");
+
+    // register the scattering angle table and the emission calculator with the memory ledger, each in its own category
+    find<MemoryLedger>()->record("scattering angle tables", _thetaCdf.allocatedBytes());
+    find<MemoryLedger>()->record("dust emission calculators", _calc.allocatedBytes());
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -563,7 +569,7 @@ double DustMix::phaseFunctionValueForCosine(double lambda, double costheta) cons
 
 double DustMix::generateCosineFromPhaseFunction(double lambda) const
 {
-    return cos(random()->cdfLinLin(_thetav, _thetaXvv[indexForLambda(lambda)]));
+    return cos(_thetaCdf.generate(indexForLambda(lambda), random()->uniform()));
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -584,16 +590,32 @@ std::pair<double, double> DustMix::generateAnglesFromPhaseFunction(double lambda
     int ell = indexForLambda(lambda);
 
     // sample from the normalized cumulative distribution of theta for this wavelength
-    double theta = random()->cdfLinLin(_thetav, _thetaXvv[ell]);
+    double theta = _thetaCdf.generate(ell, random()->uniform());
     int t = indexForTheta(theta);
 
-    // construct and sample from the normalized cumulative distribution of phi for this wavelength and theta angle
+    // sample from the normalized cumulative distribution of phi for this wavelength and theta angle,
+    // which is a linear combination of three fixed tabulated functions; to avoid constructing a temporary array
+    // for each scattering event, we evaluate the combination only at the points probed by the binary search
     double polDegree = sv->linearPolarizationDegree();
     double polAngle = sv->polarizationAngle();
     double PF = polDegree * _S12vv(ell, t) / _S11vv(ell, t) / (4 * M_PI);
     double cos2polAngle = cos(2 * polAngle) * PF;
     double sin2polAngle = sin(2 * polAngle) * PF;
-    double phi = random()->cdfLinLin(_phiv, _phi1v + cos2polAngle * _phisv + sin2polAngle * _phicv);
+    auto cdf = [this, cos2polAngle, sin2polAngle](int f) {
+        return _phi1v[f] + cos2polAngle * _phisv[f] + sin2polAngle * _phicv[f];
+    };
+    double X = random()->uniform();
+    int fl = 0;
+    int fu = maxPhi;
+    while (fu - fl > 1)
+    {
+        int fm = (fu + fl) >> 1;
+        if (X < cdf(fm))
+            fu = fm;
+        else
+            fl = fm;
+    }
+    double phi = NR::interpolateLinLin(X, cdf(fl), cdf(fl + 1), _phiv[fl], _phiv[fl + 1]);
 
     // return the result
     return std::make_pair(theta, phi);
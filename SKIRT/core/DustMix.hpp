@@ -8,6 +8,7 @@
 
 #include "ArrayTable.hpp"
 #include "EquilibriumDustEmissionCalculator.hpp"
+#include "InverseCdfTable.hpp"
 #include "MaterialMix.hpp"
 #include "Range.hpp"
 #include "Table.hpp"
@@ -408,7 +409,10 @@ private:
         this distribution through numerical inversion, that is to say, by solving the equation
         \f[\label{eq:numInvTheta} {\cal{X}} =\frac{\int_0^\theta
         S_{11}\sin\theta'\,\text{d}\theta'}{\int_0^\pi S_{11}\sin\theta'\, \text{d}\theta'} \f] for
-        \f$\theta\f$, where \f${\cal{X}}\f$ is a uniform deviate.
+        \f$\theta\f$, where \f${\cal{X}}\f$ is a uniform deviate. The cumulative distributions for
+        all wavelengths are precalculated during setup and held in an InverseCdfTable instance, so
+        that a random value can be obtained at a cost that is independent of the resolution of the
+        scattering angle grid.
 
         Once we have selected a random scattering angle \f$\theta\f$, we sample a random azimuthal
         angle \f$\phi\f$ from the normalized conditional distribution, \f[ \Phi_\theta(\phi)
@@ -420,7 +424,11 @@ private:
         This can again be done through numerical inversion, by solving the equation \f[ {\cal{X}}
         =\int_{0}^{\phi}\Phi_{\theta}(\phi')\,\text{d}\phi' =\frac{1}{2\pi} \left( \phi +
         P_{\text{L}}\,\frac{S_{12}}{S_{11}} \sin\phi \cos(\phi - 2\gamma)\right) \f] for
-        \f$\phi\f$, with \f${\cal{X}}\f$ being a new uniform deviate. */
+        \f$\phi\f$, with \f${\cal{X}}\f$ being a new uniform deviate. Because the right-hand
+        side is a linear combination of three fixed functions of \f$\phi\f$, tabulated during setup,
+        the equation is solved by a binary search that evaluates this linear combination only at
+        the grid points being probed, avoiding the construction of a discretized cumulative
+        distribution for each scattering event. */
     std::pair<double, double> generateAnglesFromPhaseFunction(double lambda, const StokesVector* sv) const;
 
     /** This function is used with the SphericalPolarization scattering mode. It applies the
@@ -533,12 +541,12 @@ private:
     Table<2> _S34vv;  // indexed on ell,t
 
     // precalculated discretizations of (functions of) the scattering angles
-    ArrayTable<2> _thetaXvv;  // indexed on ell and t
-    Array _pfnormv;           // indexed on ell
-    Array _phiv;              // indexed on f
-    Array _phi1v;             // indexed on f
-    Array _phisv;             // indexed on f
-    Array _phicv;             // indexed on f
+    InverseCdfTable _thetaCdf;  // indexed on ell and t
+    Array _pfnormv;             // indexed on ell
+    Array _phiv;                // indexed on f
+    Array _phi1v;               // indexed on f
+    Array _phisv;               // indexed on f
+    Array _phicv;               // indexed on f
 
     // precalculated discretizations for spheroidal grains as a function of the emission angle
     ArrayTable<2> _sigmaabsvv;     // indexed on ell and t
@@ -9,6 +9,7 @@
 #include "DisjointWavelengthGrid.hpp"
 #include "Log.hpp"
 #include "MediumSystem.hpp"
+#include "MemoryLedger.hpp"
 #include "NR.hpp"
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
@@ -165,6 +166,7 @@ namespace
         vector<int> _hv;             // a list of the media indices for the media containing dust
         int _numMedia{0};            // the number of dust media in the system (and thus the size of hv)
         int _numCells{0};            // the number of cells in the spatial grid (and thus the size of mv and nv)
+        size_t _registeredBytes{0};  // the number of bytes registered with the memory ledger
 
         // information on a particular spatial cell, initialized by calculateIfNeeded()
         int _p{-1};                // spatial cell launch-order index
@@ -184,8 +186,9 @@ namespace
         //   nv: map from regular cell index m to library entry index n
         //   ms: medium system
         //   config: configuration object
+        //   source: the secondary source launching the photon packet
         void calculateIfNeeded(int p, const vector<int>& mv, const vector<int>& nv, MediumSystem* ms,
-                               Configuration* config)
+                               Configuration* config, const DustSecondarySource* source)
         {
             // when called for the first time for a given simulation, cache some info
             if (_ms != ms)
@@ -201,6 +204,13 @@ namespace
                 _numMedia = _hv.size();
                 _numCells = ms->numCells();
                 _evv.resize(ms->numMedia());
+
+                // register the memory for the wavelength grid, the emission spectra and (at most) the emissivity
+                // spectrum for each dust medium component, which is allocated by this thread during the run
+                size_t numArrays = 4 + (_numMedia > 1 ? _numMedia : 0);
+                _registeredBytes = numArrays * _numWavelengths * sizeof(double);
+                source->registerCache([this]() { return release(); });
+                ms->find<MemoryLedger>()->record("per-thread caches", _registeredBytes);
             }
 
             // if this photon packet is launched from the same cell as the previous one, we don't need to do anything
@@ -272,6 +282,24 @@ namespace
             _bfv = ms->bulkVelocity(m);
         }
 
+        // frees the memory held by this cache and returns the number of bytes registered with the memory ledger;
+        // the cache is initialized and registered again if it is used after being released
+        size_t release()
+        {
+            size_t bytes = _registeredBytes;
+            _ms = nullptr;
+            _registeredBytes = 0;
+            _p = -1;
+            _n = -1;
+            _wavelengthGrid = Array();
+            _hv.clear();
+            _evv.clear();
+            _lambdav = Array();
+            _pv = Array();
+            _Pv = Array();
+            return bytes;
+        }
+
     private:
         // calculate the emission spectrum for the dust mixes of the specified cell,
         // and store the result in the data members _lambdav, _pv, _Pv
@@ -518,7 +546,7 @@ void DustSecondarySource::launch(PhotonPacket* pp, size_t historyIndex, double L
     double ws = _Lv[m] / _Wv[m];
 
     // calculate the emission spectrum and bulk velocity for this cell, if not already available
-    t_dustcell.calculateIfNeeded(p, _mv, _nv, _ms, _config);
+    t_dustcell.calculateIfNeeded(p, _mv, _nv, _ms, _config, this);
 
     // generate a random wavelength from the emission spectrum for the cell and/or from the bias distribution
     double lambda, w;
@@ -0,0 +1,133 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "EntitySEDCache.hpp"
+#include "SEDFamily.hpp"
+#include "StringUtils.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+EntitySEDCache::EntitySEDCache(const SEDFamily* family, Range wavelengthRange, double resolution, size_t capacity)
+    : _family(family), _range(wavelengthRange), _logStep(std::log1p(resolution)), _capacity(max(capacity, size_t(1)))
+{
+    for (const auto& info : family->parameterInfo())
+    {
+        auto id = info.identifier();
+        _ignore.push_back(id == SnapshotParameter::Identifier::InitialMass
+                          || id == SnapshotParameter::Identifier::CurrentMass);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void EntitySEDCache::quantize(const Array& parameters, Key& key) const
+{
+    // each parameter is represented by two numbers: its sign and its logarithmic bin index
+    size_t n = parameters.size();
+    key.assign(2 * n, 0);
+    for (size_t i = 0; i != n; ++i)
+    {
+        double value = parameters[i];
+        if (_ignore[i] || !value) continue;
+        key[2 * i] = value > 0 ? 1 : -1;
+        key[2 * i + 1] = static_cast<int64_t>(std::floor(std::log(std::abs(value)) / _logStep));
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // returns the number of bytes occupied by the arrays in the given entry, or zero if there is no entry
+    size_t entryBytes(const EntitySEDCache::Entry* entry)
+    {
+        return entry ? (entry->lambdav.size() + entry->pv.size() + entry->Pv.size()) * sizeof(double) : 0;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const EntitySEDCache::Entry> EntitySEDCache::entry(const Key& key)
+{
+    // look for an existing entry, and if found, move it to the front of the LRU list
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        auto it = _entries.find(key);
+        if (it != _entries.end())
+        {
+            _lru.splice(_lru.begin(), _lru, it->second.second);
+            _numSharedHits++;
+            return it->second.first;
+        }
+    }
+
+    // construct the parameter values at the center of the bin, using unity for ignored parameters
+    size_t n = key.size() / 2;
+    Array parameters(n);
+    for (size_t i = 0; i != n; ++i)
+    {
+        if (_ignore[i])
+            parameters[i] = 1.;
+        else
+            parameters[i] = key[2 * i] * std::exp((key[2 * i + 1] + 0.5) * _logStep);
+    }
+
+    // calculate the normalized distributions outside of the lock; because the result depends only on the key,
+    // it does not matter if another thread happens to be calculating the same entry at the same time
+    auto calculated = std::make_shared<Entry>();
+    std::shared_ptr<const Entry> entry = calculated;
+    _numMisses++;
+    if (!_family->cdf(calculated->lambdav, calculated->pv, calculated->Pv, _range, parameters))
+    {
+        // remember that the bin has zero luminosity so that we don't need to calculate it again
+        _numVanishing++;
+        entry.reset();
+    }
+
+    // add the entry to the cache unless another thread beat us to it, and evict old entries if needed
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto it = _entries.find(key);
+    if (it != _entries.end()) return it->second.first;
+    _lru.push_front(key);
+    _entries.emplace(key, std::make_pair(entry, _lru.begin()));
+    _allocatedBytes += entryBytes(entry.get());
+    while (_entries.size() > _capacity)
+    {
+        auto last = _entries.find(_lru.back());
+        _allocatedBytes -= entryBytes(last->second.first.get());
+        _entries.erase(last);
+        _lru.pop_back();
+    }
+    return entry;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void EntitySEDCache::recordLocalHit()
+{
+    _numLocalHits++;
+}
+
+////////////////////////////////////////////////////////////////////
+
+string EntitySEDCache::statistics()
+{
+    size_t numLocalHits = _numLocalHits.exchange(0);
+    size_t numSharedHits = _numSharedHits.exchange(0);
+    size_t numMisses = _numMisses.exchange(0);
+    size_t numVanishing = _numVanishing.exchange(0);
+    size_t numLookups = numLocalHits + numSharedHits + numMisses;
+
+    auto percentage = [numLookups](size_t count) {
+        return StringUtils::toString(numLookups ? 100. * count / numLookups : 0., 'f', 1) + "%";
+    };
+
+    return StringUtils::toString(static_cast<double>(numLookups)) + " lookups, " + percentage(numLocalHits)
+           + " thread-local hits, " + percentage(numSharedHits) + " shared hits, " + percentage(numMisses)
+           + " misses (" + std::to_string(numVanishing) + " with zero luminosity); " + std::to_string(_entries.size())
+           + " SEDs cached in " + StringUtils::toMemSizeString(_allocatedBytes);
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,101 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef ENTITYSEDCACHE_HPP
+#define ENTITYSEDCACHE_HPP
+
+#include "Array.hpp"
+#include "Range.hpp"
+#include <atomic>
+#include <list>
+#include <map>
+#include <mutex>
+class SEDFamily;
+
+////////////////////////////////////////////////////////////////////
+
+/** EntitySEDCache is a helper class for ImportedSource that caches the normalized spectral
+    distributions obtained from an SEDFamily for the entities (particles or cells) imported from a
+    snapshot. A single cache instance is shared between all parallel execution threads.
+
+    Constructing the normalized probability and cumulative distributions for an entity through the
+    SEDFamily::cdf() function can be time-consuming, especially for %SED families that interpolate
+    in multi-dimensional tables. Imported sources with many entities spend a significant portion of
+    their launch time rebuilding these distributions. To avoid this, the cache quantizes the
+    parameter values of each entity on a logarithmic grid with a given relative bin width, and
+    stores the normalized distributions corresponding to the central parameter values of each bin.
+    All entities with parameters in the same bin share the same cached distributions. Parameters
+    that represent a mass (i.e. initial or current mass) are assumed to merely scale the
+    luminosity; they do not affect the normalized distributions and are thus ignored for the
+    purpose of binning. The cached distributions depend only on the bin, so that the results
+    are reproducible regardless of the order in which entities are handled by the various threads.
+
+    The number of cached distributions is bounded by a user-configured capacity. When the cache is
+    full, the least recently used entry is discarded. The cache keeps track of the number of
+    lookups, hits and misses, and of the memory occupied by the cached distributions. */
+class EntitySEDCache
+{
+public:
+    /** An instance of this structure holds the normalized regular and cumulative spectral
+        distributions for a particular parameter bin, as returned by the SEDFamily::cdf()
+        function. */
+    struct Entry
+    {
+        Array lambdav, pv, Pv;
+    };
+
+    /** The type of the key identifying a parameter bin. */
+    using Key = vector<int64_t>;
+
+    /** The constructor initializes a cache for the specified %SED family and wavelength range,
+        using the specified relative bin width for quantizing parameter values, and holding at most
+        the specified number of entries. */
+    EntitySEDCache(const SEDFamily* family, Range wavelengthRange, double resolution, size_t capacity);
+
+    /** This function quantizes the specified entity parameter values and stores the resulting
+        bin key into \em key. */
+    void quantize(const Array& parameters, Key& key) const;
+
+    /** This function returns the cached distributions for the parameter bin with the specified
+        key, constructing and storing them first if needed. If the %SED for the bin's central
+        parameter values has zero luminosity, the function returns a null pointer, indicating that
+        the caller should construct the distributions for the actual entity parameters instead.
+        This function is thread-safe. */
+    std::shared_ptr<const Entry> entry(const Key& key);
+
+    /** This function records a lookup that was satisfied by the thread-local distributions held
+        by the caller without consulting the shared cache. This function is thread-safe. */
+    void recordLocalHit();
+
+    /** This function returns a human-readable summary of the cache statistics gathered since the
+        previous invocation of this function, and resets the statistics. It should be called in
+        serial mode. */
+    string statistics();
+
+private:
+    // configuration
+    const SEDFamily* _family;
+    Range _range;
+    double _logStep;
+    size_t _capacity;
+    vector<bool> _ignore;  // true for parameters that are ignored for the purpose of binning
+
+    // the cache itself, with the LRU list holding the most recently used key at the front
+    using KeyList = std::list<Key>;
+    std::mutex _mutex;
+    KeyList _lru;
+    std::map<Key, std::pair<std::shared_ptr<const Entry>, KeyList::iterator>> _entries;
+    size_t _allocatedBytes{0};
+
+    // statistics
+    std::atomic<size_t> _numLocalHits{0};
+    std::atomic<size_t> _numSharedHits{0};
+    std::atomic<size_t> _numMisses{0};
+    std::atomic<size_t> _numVanishing{0};
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -9,6 +9,7 @@
 #include "LockFree.hpp"
 #include "Log.hpp"
 #include "MediumSystem.hpp"
+#include "MemoryLedger.hpp"
 #include "NR.hpp"
 #include "PhotonPacket.hpp"
 #include "ProcessManager.hpp"
@@ -286,7 +287,7 @@ void FluxRecorder::finalizeConfiguration()
         for (auto& array : _wifu) array.resize(lenIFU);
     }
 
-    // calculate and log allocated memory size
+    // calculate, register and log allocated memory size
     size_t allocatedSize = 0;
     for (const auto& array : _sed) allocatedSize += array.size();
     for (const auto& array : _ifu) allocatedSize += array.size();
@@ -295,6 +296,8 @@ void FluxRecorder::finalizeConfiguration()
     for (const auto& array : _stm) allocatedSize += array.size();
     for (const auto& array : _wsed) allocatedSize += array.size();
     for (const auto& array : _wifu) allocatedSize += array.size();
+    _ledger = _parentItem->find<MemoryLedger>();
+    _ledger->record("instruments", allocatedSize * sizeof(double));
     _parentItem->find<Log>()->info(_parentItem->typeAndName() + " allocated "
                                    + StringUtils::toMemSizeString(allocatedSize * sizeof(double)) + " of memory");
 }
@@ -306,15 +309,29 @@ void FluxRecorder::detect(PhotonPacket* pp, int l, double distance)
     // abort if we're not recording integrated fluxes and the photon packet arrives outside of the frame
     if (!_includeFluxDensity && l < 0) return;
 
-    // get the photon packet's redshifted wavelength
-    double wavelength = pp->wavelength() * (1. + _redshift);
+    // for a polychromatic photon packet, calculate the optical depths for all wavelengths in a single grid traversal
+    int numCompanions = pp->numCompanions();
+    if (numCompanions && _hasMedium && !pp->hasObservedOpticalDepth()) _ms->setObservedOpticalDepths(pp, distance);
+
+    // record the reference wavelength and the companion wavelengths, if any
+    detectWavelength(pp, l, distance, -1);
+    for (int k = 0; k != numCompanions; ++k) detectWavelength(pp, l, distance, k);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void FluxRecorder::detectWavelength(PhotonPacket* pp, int l, double distance, int k)
+{
+    // get the photon packet's redshifted wavelength and its luminosity at that wavelength
+    double wavelength = (k < 0 ? pp->wavelength() : pp->companionWavelength(k)) * (1. + _redshift);
+    double luminosity = k < 0 ? pp->luminosity() : pp->companionLuminosity(k);
 
     // get the wavelength bin indices that overlap the photon packet wavelength and perform recording for each
     for (int ell : _lambdagrid->bins(wavelength))
     {
         // get the luminosity contribution from the photon packet,
         // taking into account the transmission for the detector bin at this wavelength
-        double L = pp->luminosity() * _lambdagrid->transmission(ell, wavelength);
+        double L = luminosity * _lambdagrid->transmission(ell, wavelength);
 
         // adjust the luminosity for near distance if needed
         if (_local) L /= distance * distance;
@@ -327,7 +344,11 @@ void FluxRecorder::detect(PhotonPacket* pp, int l, double distance)
             // position and viewing direction, simply recover the stored optical depth from the photon packet;
             // otherwise calculate the optical depth and store it in the photon packet for the next instrument
             double tau;
-            if (pp->hasObservedOpticalDepth())
+            if (k >= 0)
+            {
+                tau = pp->companionObservedOpticalDepth(k);
+            }
+            else if (pp->hasObservedOpticalDepth())
             {
                 tau = pp->observedOpticalDepth();
             }
@@ -462,7 +483,10 @@ void FluxRecorder::detect(PhotonPacket* pp, int l, double distance)
                 recordContributions(contributionList);
                 contributionList->reset(pp->historyIndex());
             }
+            size_t bytesBefore = contributionList->allocatedBytes();
             contributionList->addContribution(ell, l, Lext);
+            size_t bytesAfter = contributionList->allocatedBytes();
+            if (bytesAfter != bytesBefore) _ledger->record("instrument buffers", bytesAfter - bytesBefore);
         }
     }
 }
@@ -471,26 +495,30 @@ void FluxRecorder::detect(PhotonPacket* pp, int l, double distance)
 
 void FluxRecorder::flush()
 {
-    // record the dangling contributions from all threads
+    // record the dangling contributions from all threads and release the memory held by the lists
+    size_t releasedBytes = 0;
     for (ContributionList* contributionList : _contributionLists.all())
     {
         recordContributions(contributionList);
-        contributionList->reset();
+        releasedBytes += contributionList->allocatedBytes();
+        contributionList->release();
     }
+    if (releasedBytes) _ledger->release("instrument buffers", releasedBytes);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 void FluxRecorder::calibrateAndWrite()
 {
-    // collect recorded data from all processes
-    for (auto& array : _sed) ProcessManager::sumToRoot(array);
-    for (auto& array : _ifu) ProcessManager::sumToRoot(array);
-    for (auto& array : _lc) ProcessManager::sumToRoot(array);
-    for (auto& array : _lcw) ProcessManager::sumToRoot(array);
-    for (auto& array : _stm) ProcessManager::sumToRoot(array);
-    for (auto& array : _wsed) ProcessManager::sumToRoot(array);
-    for (auto& array : _wifu) ProcessManager::sumToRoot(array);
+    // collect recorded data from all processes in a single pipelined reduction
+    if (ProcessManager::isMultiProc())
+    {
+        vector<Array*> arrays;
+        for (auto recorded : {&_sed, &_ifu, &_lc, &_lcw, &_stm, &_wsed, &_wifu})
+            for (auto& array : *recorded)
+                if (array.size()) arrays.push_back(&array);
+        ProcessManager::sumToRoot(arrays);
+    }
 
     // calibrate and write only in the root process
     if (!ProcessManager::isRoot()) return;
@@ -10,6 +10,7 @@
 #include "ThreadLocalMember.hpp"
 #include <tuple>
 class MediumSystem;
+class MemoryLedger;
 class PhotonPacket;
 class SimulationItem;
 class TimeGrid;
@@ -279,13 +280,18 @@ public:
         All other information is obtained directly or indirectly from the photon packet. If there
         is an obscuring medium, the optical depth from the photon packet's last interaction site to
         the instrument is determined and the corresponding extincton is applied to the packet's
-        contribution before detection. */
+        contribution before detection.
+
+        For a polychromatic photon packet, the function records the contribution of the reference
+        wavelength and of each of the companion wavelengths. The optical depths to the instrument
+        for all of these wavelengths are determined in a single traversal of the spatial grid. */
     void detect(PhotonPacket* pp, int l, double distance = std::numeric_limits<double>::infinity());
 
     /** This function processes and clears any information that may have been buffered by the
-        detect() function in thread-local storage. It is not thread-safe. After parallel threads
-        have completed the work on a series of photon packets, and before the parallel threads are
-        actually destructed, the flush() function should be called from a single thread. */
+        detect() function in thread-local storage, and releases the memory held by these buffers.
+        It is not thread-safe. After parallel threads have completed the work on a series of
+        photon packets, and before the parallel threads are actually destructed, the flush()
+        function should be called from a single thread. */
     void flush();
 
     /** This function calibrates and outputs the instrument data. The calibration includes dividing
@@ -330,6 +336,8 @@ private:
         bool hasHistoryIndex(size_t historyIndex) const { return _historyIndex == historyIndex; }
         void addContribution(int ell, int l, double w) { _contributions.emplace_back(ell, l, w); }
         void reset(size_t historyIndex = 0) { _historyIndex = historyIndex, _contributions.clear(); }
+        void release() { reset(), _contributions.shrink_to_fit(); }
+        size_t allocatedBytes() const { return _contributions.capacity() * sizeof(Contribution); }
         void sort() { std::sort(_contributions.begin(), _contributions.end()); }
         const vector<Contribution>& contributions() const { return _contributions; }
 
@@ -338,6 +346,11 @@ private:
         vector<Contribution> _contributions;
     };
 
+    /** This private helper function records the contribution of the specified photon packet at
+        the reference wavelength (if \em k is negative) or at the companion wavelength with index
+        \em k. The other arguments are the same as for the detect() function. */
+    void detectWavelength(PhotonPacket* pp, int l, double distance, int k);
+
     /** This private helper function records the photon packet history contributions in the
         specified list into the statistics arrays. */
     void recordContributions(ContributionList* contributionList);
@@ -387,10 +400,11 @@ private:
     string _quantityXY;
 
     // cached info, initialized when configuration is finalized
-    MediumSystem* _ms{nullptr};   // pointer to medium system, if present (used only if hasMedium is true)
-    bool _recordTotalOnly{true};  // becomes false if recordComponents and hasMedium are both true
-    size_t _numPixelsInFrame{0};  // number of pixels in a single IFU frame
-    int _numWavelengths{0};       // number of wavelengths in wavelength grid
+    MediumSystem* _ms{nullptr};      // pointer to medium system, if present (used only if hasMedium is true)
+    MemoryLedger* _ledger{nullptr};  // pointer to the simulation's memory ledger
+    bool _recordTotalOnly{true};     // becomes false if recordComponents and hasMedium are both true
+    size_t _numPixelsInFrame{0};     // number of pixels in a single IFU frame
+    int _numWavelengths{0};          // number of wavelengths in wavelength grid
 
     // detector arrays that need to be calibrated, initialized when configuration is finalized
     vector<Array> _sed;
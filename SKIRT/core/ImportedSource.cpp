@@ -6,8 +6,10 @@
 #include "ImportedSource.hpp"
 #include "Band.hpp"
 #include "Configuration.hpp"
+#include "EntitySEDCache.hpp"
 #include "FatalError.hpp"
 #include "Log.hpp"
+#include "MemoryLedger.hpp"
 #include "NR.hpp"
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
@@ -35,6 +37,7 @@ void ImportedSource::setupSelfAfter()
 
     auto config = find<Configuration>();
     _oligochromatic = config->oligochromatic();
+    _numWavelengths = config->numWavelengthsPerPacket();
 
     // warn the user if this source's intrinsic wavelength range does not fully cover the configured wavelength range
     informAvailableWavelengthRange(_sedFamily->intrinsicWavelengthRange(), _sedFamily->type());
@@ -123,6 +126,33 @@ void ImportedSource::setupSelfAfter()
         _L = _Lv.sum();
         if (_L) _Lv /= _L;
     }
+
+    // create the shared SED cache if enabled
+    if (_sedCacheResolution > 0.)
+    {
+        // estimate the maximum cache size from the size of the distributions for the first entity
+        size_t cacheBytes = 0;
+        if (M)
+        {
+            Array lambdav, pv, Pv;
+            Array params;
+            _snapshot->parameters(0, params);
+            _sedFamily->cdf(lambdav, pv, Pv, _wavelengthRange, params);
+            cacheBytes = (lambdav.size() + pv.size() + Pv.size()) * sizeof(double) * _sedCacheSize;
+        }
+
+        // disable the cache if it might not fit within the memory budget
+        auto ledger = find<MemoryLedger>();
+        if (ledger->fits(cacheBytes))
+        {
+            ledger->reserve("SED caches", cacheBytes);
+            _sedCache = new EntitySEDCache(_sedFamily, _wavelengthRange, _sedCacheResolution, _sedCacheSize);
+        }
+        else
+        {
+            find<Log>()->warning(typeAndName() + " disables its SED cache to remain within the memory budget");
+        }
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -130,6 +160,7 @@ void ImportedSource::setupSelfAfter()
 ImportedSource::~ImportedSource()
 {
     delete _snapshot;
+    delete _sedCache;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -155,6 +186,13 @@ bool ImportedSource::hasVelocity() const
 
 ////////////////////////////////////////////////////////////////////
 
+bool ImportedSource::supportsPolychromaticPackets() const
+{
+    return !hasVelocity();
+}
+
+////////////////////////////////////////////////////////////////////
+
 Range ImportedSource::wavelengthRange() const
 {
     // don't rely on the cached _wavelengthRange because this function may be called during setup
@@ -259,38 +297,69 @@ void ImportedSource::prepareForLaunch(double sourceBias, size_t firstIndex, size
 namespace
 {
     // an instance of this class holds the normalized regular and cumulative spectral distributions for a single entity
-    // which can be used to generate wavelengths and to calculate bias weights
+    // which can be used to generate wavelengths and to calculate bias weights; if an SED cache is provided, the
+    // distributions are shared with the cache rather than held by the object itself
     class EntitySED
     {
     private:
         // these two variables unambiguously identify a particular entity, even with multiple imported sources
         int _m{-1};                          // entity index
         const Snapshot* _snapshot{nullptr};  // snapshot
-        Array _lambdav, _pv, _Pv;            // normalized distributions
+        Array _lambdav, _pv, _Pv;            // normalized distributions if not cached
+
+        // these variables identify and refer to the cached distributions, if applicable
+        const EntitySEDCache* _cache{nullptr};
+        EntitySEDCache::Key _key;
+        std::shared_ptr<const EntitySEDCache::Entry> _entry;
 
     public:
         EntitySED() {}
 
-        // sets the normalized distributions from the SED family if this is a different entity or snapshot
-        void setIfNeeded(int m, const Snapshot* snapshot, const SEDFamily* family, Range range)
+        // sets the normalized distributions from the SED family or from the cache (if provided)
+        // if this is a different entity or snapshot
+        void setIfNeeded(int m, const Snapshot* snapshot, const SEDFamily* family, Range range, EntitySEDCache* cache)
         {
             if (m != _m || snapshot != _snapshot)
             {
                 Array params;
                 snapshot->parameters(m, params);
-                family->cdf(_lambdav, _pv, _Pv, range, params);
+                if (cache)
+                {
+                    // reuse the distributions from the previous entity if it resides in the same parameter bin
+                    EntitySEDCache::Key key;
+                    cache->quantize(params, key);
+                    if (_entry && cache == _cache && key == _key)
+                        cache->recordLocalHit();
+                    else
+                        _entry = cache->entry(key);
+                    _cache = cache;
+                    _key = std::move(key);
+                }
+                else
+                {
+                    _entry.reset();
+                    _cache = nullptr;
+                }
+
+                // calculate the distributions for the entity itself if there is no cached version
+                if (!_entry) family->cdf(_lambdav, _pv, _Pv, range, params);
                 _snapshot = snapshot;
                 _m = m;
             }
         }
 
         // returns a random wavelength generated from the distribution
-        double generateWavelength(Random* random) const { return random->cdfLogLog(_lambdav, _pv, _Pv); }
+        double generateWavelength(Random* random) const
+        {
+            return _entry ? random->cdfLogLog(_entry->lambdav, _entry->pv, _entry->Pv)
+                          : random->cdfLogLog(_lambdav, _pv, _Pv);
+        }
 
         // returns the normalized specific luminosity for the given wavelength
         double specificLuminosity(double lambda) const
         {
-            return NR::value<NR::interpolateLogLog>(lambda, _lambdav, _pv);
+            return _entry ? NR::value<NR::interpolateLogLog>(lambda, _entry->lambdav, _entry->pv)
+                          : NR::value<NR::interpolateLogLog>(lambda, _lambdav, _pv);
         }
     };
 
@@ -338,18 +407,18 @@ void ImportedSource::launch(PhotonPacket* pp, size_t historyIndex, double L) con
     double ws = _Lv[m] / _Wv[m];
 
     // get the normalized regular and cumulative distributions for this entity, if not already available
-    t_sed.setIfNeeded(m, _snapshot, _sedFamily, _wavelengthRange);
+    t_sed.setIfNeeded(m, _snapshot, _sedFamily, _wavelengthRange, _sedCache);
 
-    // generate a random wavelength from the SED and/or from the bias distribution
-    double lambda, w;
-    if (!_xi)
-    {
+    // generate a random wavelength from the SED and/or from the bias distribution,
+    // and return the compensating weight factor
+    auto generateWavelength = [this](double& lambda) {
         // no biasing -- simply use the intrinsic spectral distribution
-        lambda = t_sed.generateWavelength(random());
-        w = 1.;
-    }
-    else
-    {
+        if (!_xi)
+        {
+            lambda = t_sed.generateWavelength(random());
+            return 1.;
+        }
+
         // biasing -- use one or the other distribution
         if (random()->uniform() > _xi)
             lambda = t_sed.generateWavelength(random());
@@ -358,20 +427,18 @@ void ImportedSource::launch(PhotonPacket* pp, size_t historyIndex, double L) con
 
         // calculate the compensating weight factor
         double s = t_sed.specificLuminosity(lambda);
-        if (!s)
-        {
-            // if the wavelength can't occur in the intrinsic distribution,
-            // the weight factor is zero regardless of the probability in the bias distribution
-            // (handling this separately also avoids NaNs in the pathological case s=b=0)
-            w = 0.;
-        }
-        else
-        {
-            // regular composite bias weight
-            double b = _biasDistribution->probability(lambda);
-            w = s / ((1 - _xi) * s + _xi * b);
-        }
-    }
+
+        // if the wavelength can't occur in the intrinsic distribution,
+        // the weight factor is zero regardless of the probability in the bias distribution
+        // (handling this separately also avoids NaNs in the pathological case s=b=0)
+        if (!s) return 0.;
+
+        // regular composite bias weight
+        double b = _biasDistribution->probability(lambda);
+        return s / ((1 - _xi) * s + _xi * b);
+    };
+    double lambda;
+    double w = generateWavelength(lambda);
 
     // generate a random position for this entity
     Position bfr = _snapshot->generatePosition(m);
@@ -385,8 +452,23 @@ void ImportedSource::launch(PhotonPacket* pp, size_t historyIndex, double L) con
         bvi = &t_velocity;
     }
 
-    // launch the photon packet with isotropic direction
-    pp->launch(historyIndex, lambda, L * w * ws, bfr, random()->direction(), bvi);
+    // launch the photon packet with isotropic direction,
+    // dividing the luminosity contribution over all wavelengths carried by the packet
+    pp->launch(historyIndex, lambda, L * w * ws / _numWavelengths, bfr, random()->direction(), bvi);
+
+    // add the companion wavelengths for a polychromatic photon packet
+    for (int k = 1; k < _numWavelengths; ++k)
+    {
+        w = generateWavelength(lambda);
+        pp->addCompanion(lambda, L * w * ws / _numWavelengths);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void ImportedSource::finishLaunch()
+{
+    if (_sedCache) find<Log>()->info(typeAndName() + " SED cache: " + _sedCache->statistics());
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -11,6 +11,7 @@
 #include "SEDFamily.hpp"
 #include "Source.hpp"
 class Band;
+class EntitySEDCache;
 class Snapshot;
 
 //////////////////////////////////////////////////////////////////////
@@ -66,7 +67,25 @@ class Snapshot;
 
     where \f$L\f$ is the total luminosity for this source and \f$M\f$ is the total number of
     entities in this source. In all cases, the value of \f$\xi\f$ shifts between luminosity-weighted
-    (\f$\xi=0\f$) and entity-weighted (\f$\xi=1\f$) or any combination thereof. */
+    (\f$\xi=0\f$) and entity-weighted (\f$\xi=1\f$) or any combination thereof.
+
+    <em>%SED caching</em>
+
+    When launching a photon packet, the spectral distribution for the corresponding entity must be
+    obtained from the %SED family. Each execution thread remembers the distribution for the most
+    recently launched entity, but switching to another entity requires the distribution to be
+    rebuilt, which can be time-consuming for %SED families that interpolate in multi-dimensional
+    tables. For snapshots with many entities, the \em sedCacheResolution option enables a cache
+    that is shared between all threads. This cache quantizes the %SED parameters (other than mass)
+    on a logarithmic grid with the specified relative bin width, so that all entities with
+    parameters in the same bin share the same normalized spectral distribution. The \em
+    sedCacheSize option limits the number of distributions held in the cache; when the cache is
+    full, the least recently used distribution is discarded. The luminosity of each entity is
+    still calculated from its actual parameter values, so that the quantization affects only the
+    spectral shape of the emitted radiation. The cache hit rates and memory usage are logged after
+    each segment of photon packet launches. By default, caching is disabled. If a per-process
+    memory budget has been specified and the cache at its maximum size might not fit within the
+    budget, the cache is disabled with a warning. */
 class ImportedSource : public Source
 {
     ITEM_ABSTRACT(ImportedSource, Source, "a primary source imported from snapshot data")
@@ -104,6 +123,20 @@ class ImportedSource : public Source
         PROPERTY_ITEM(sedFamily, SEDFamily, "the SED family for assigning spectra to the imported sources")
         ATTRIBUTE_DEFAULT_VALUE(sedFamily, "BlackBodySEDFamily")
 
+        PROPERTY_DOUBLE(sedCacheResolution,
+                        "the relative parameter bin width for sharing cached SEDs between entities, or 0 to disable")
+        ATTRIBUTE_MIN_VALUE(sedCacheResolution, "[0")
+        ATTRIBUTE_MAX_VALUE(sedCacheResolution, "1]")
+        ATTRIBUTE_DEFAULT_VALUE(sedCacheResolution, "0")
+        ATTRIBUTE_DISPLAYED_IF(sedCacheResolution, "Level3")
+
+        PROPERTY_INT(sedCacheSize, "the maximum number of SEDs held in the shared SED cache")
+        ATTRIBUTE_MIN_VALUE(sedCacheSize, "1")
+        ATTRIBUTE_MAX_VALUE(sedCacheSize, "10000000")
+        ATTRIBUTE_DEFAULT_VALUE(sedCacheSize, "2000")
+        ATTRIBUTE_RELEVANT_IF(sedCacheSize, "sedCacheResolution")
+        ATTRIBUTE_DISPLAYED_IF(sedCacheSize, "Level3")
+
     ITEM_END()
 
     //============= Construction - Setup - Destruction =============
@@ -138,6 +171,10 @@ public:
     /** This function returns true if the \em importVelocity flag is enabled for the source. */
     bool hasVelocity() const override;
 
+    /** This function returns true if the source has no velocity, because the companion
+        wavelengths of polychromatic photon packets are not Doppler-shifted. */
+    bool supportsPolychromaticPackets() const override;
+
     /** This function returns the wavelength range for this source. Outside this range, all
         luminosities are zero. This source's wavelength range is determined as the intersection of the
         simulation's source wavelength range (obtained from the simulation configuration) and the
@@ -213,6 +250,10 @@ public:
          launch() function. This works even if there are multiple sources of this type because each
          thread handles a single photon packet at a time.
 
+         If the %SED cache is enabled, the distributions are obtained from the cache, and the
+         thread-local object simply refers to the cached distributions. See the class header for
+         more information.
+
          Subsequently, the function samples a wavelength from the entity's SED, properly handling
          the configured wavelength biasing, and asks the Snapshot object to generate a random
          launch position for the entity. If the importVelocity flag is enabled, the function also
@@ -221,9 +262,16 @@ public:
          after being handed to the photon packet.
 
          Finally, the function causes the photon packet to be launched with the information
-         described above and an isotropic launch direction. */
+         described above and an isotropic launch direction. When launching polychromatic photon
+         packets, the function samples the companion wavelengths independently from the same
+         distribution as the reference wavelength, and divides the luminosity contribution evenly
+         over all wavelengths. */
     void launch(PhotonPacket* pp, size_t historyIndex, double L) const override;
 
+    /** If the %SED cache is enabled, this function logs the cache statistics gathered during the
+        segment of photon packet launches that just finished. */
+    void finishLaunch() override;
+
     /** This function returns (a pointer to) the snapshot object associated with this imported
         source. It is intended to provide InputModelProbe instances with direct access to the
         snapshot for probing imported information that is not otherwise made available to the
@@ -236,6 +284,7 @@ public:
 private:
     // wavelength information initialized during setup
     bool _oligochromatic{false};                         // true if the simulation is oligochromatic
+    int _numWavelengths{1};                              // the number of wavelengths per photon packet
     Range _wavelengthRange;                              // the wavelength range configured for all primary sources
     double _arbitaryWavelength{0.};                      // an arbitarily chosen wavelength within the source range
     double _xi{0.};                                      // the wavelength bias fraction
@@ -246,6 +295,9 @@ private:
     double _L{0};  // the total bolometric luminosity of all entities (absolute number)
     Array _Lv;     // the relative bolometric luminosity of each entity (normalized to unity)
 
+    // SED cache initialized during setup if enabled
+    EntitySEDCache* _sedCache{nullptr};
+
     // intialized by prepareForLaunch()
     Array _Wv;           // the relative launch weight for each entity (normalized to unity)
     Array _bv;           // the bias for each entity (normalized to unity)
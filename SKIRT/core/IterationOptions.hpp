@@ -11,10 +11,65 @@
 ////////////////////////////////////////////////////////////////////
 
 /** The IterationOptions class simply offers a number of options for configuring iterations during
-    primary and/or secondary emission. These options are relevant only when the simulation has a
-    dynamic medium state and/or a dynamic secondary emission. */
+    primary and/or secondary emission. Most of these options are relevant only when the simulation
+    has a dynamic medium state and/or a dynamic secondary emission. The checkpoint options are also
+    relevant for simulations that include secondary emission without iterating.
+
+    If the \em dynamicStateUpdateTolerance option is nonzero, the dynamic medium state of a
+    spatial cell is updated only if the radiation field in that cell has changed significantly
+    since the most recent update of the cell. The change is measured by comparing the radiation
+    field integrated over a few broad wavelength bands; if none of these band integrals has changed
+    by more than the specified fraction of the total, the update is skipped and the cell is
+    considered to be converged. A value of zero (the default) disables this mechanism so that all
+    cells are updated in every iteration.
+
+    If the \em accelerateDynamicState option is enabled, the convergence of the dynamic medium
+    state for media that support it (such as the level populations calculated by the
+    NonLTELineGasMix class) is accelerated by periodically extrapolating the state of each spatial
+    cell from the most recent iterations using the Ng scheme. See the NgAccelerator class for more
+    information.
+
+    If the \em writeCheckpoints option is enabled, the simulation writes a binary checkpoint file
+    named <tt>prefix_checkpoint.dat</tt> at the end of each primary, secondary, or merged
+    iteration, overwriting the checkpoint of the previous iteration. For simulations with secondary
+    emission, a checkpoint is also written after the final primary emission segment, i.e. just
+    before the secondary emission iterations or the final secondary emission segment. The
+    checkpoint contains the complete medium state, the radiation field, the iteration counters and
+    convergence information, and the state of the random number generator for the parent thread. If
+    the \em restartFilename option specifies the name of such a checkpoint file, the simulation
+    resumes from that checkpoint, provided that it has been written for the same spatial grid and
+    medium configuration; otherwise the simulation issues a warning and starts from scratch. Any
+    iterations recorded as completed in the checkpoint are skipped, so that an interrupted run
+    continues with the next iteration, and a run that changes only the instruments proceeds
+    immediately to the final emission segments. The run-time configuration, such as the number of
+    photon packets or the instruments, may differ from the run that wrote the checkpoint. Because
+    the history used for Ng extrapolation is not included in the checkpoint, acceleration restarts
+    after resuming.
+
+    The \em reobservationMode option allows re-observing a model for which the medium state and
+    the radiation field have already converged, for example with additional instruments, viewing
+    angles or wavelength grids. In this mode, the simulation restores the checkpoint specified by
+    \em restartFilename, which must match the spatial grid and medium configuration, skips all
+    iterations regardless of the progress recorded in the checkpoint, and performs only the final
+    primary and secondary emission segments with peel-off to the instruments. These segments do
+    not store the radiation field; instead, the secondary emission spectra and any radiation field
+    probes use the radiation field restored from the checkpoint. With the \c WithScattering mode,
+    photon packets are traced through the media as usual, so that the instruments record both
+    direct and scattered radiation. With the \c DirectOnly mode, photon packets are not traced
+    through the media at all, so that the instruments record only the direct emission, attenuated
+    along the line of sight to each instrument. This ray-traced mode is much faster, but it is
+    appropriate only when scattering does not contribute significantly to the observables of
+    interest. */
 class IterationOptions : public SimulationItem
 {
+    /** The enumeration type indicating whether and how to re-observe a converged medium state
+        restored from a checkpoint file. */
+    ENUM_DEF(ReobservationMode, None, WithScattering, DirectOnly)
+        ENUM_VAL(ReobservationMode, None, "no re-observation: resume any remaining iterations")
+        ENUM_VAL(ReobservationMode, WithScattering, "skip all iterations and re-observe including scattering")
+        ENUM_VAL(ReobservationMode, DirectOnly, "skip all iterations and re-observe direct emission only")
+    ENUM_END()
+
     ITEM_CONCRETE(IterationOptions, SimulationItem,
                   "a set of options for configuring iterations during primary and/or secondary emission")
 
@@ -79,6 +134,37 @@ class IterationOptions : public SimulationItem
         ATTRIBUTE_RELEVANT_IF(secondaryIterationPacketsMultiplier, "IterateSecondary")
         ATTRIBUTE_DISPLAYED_IF(secondaryIterationPacketsMultiplier, "Level3")
 
+        PROPERTY_DOUBLE(dynamicStateUpdateTolerance,
+                        "the relative change in the radiation field below which a cell's dynamic state is not updated")
+        ATTRIBUTE_MIN_VALUE(dynamicStateUpdateTolerance, "[0")
+        ATTRIBUTE_MAX_VALUE(dynamicStateUpdateTolerance, "0.5]")
+        ATTRIBUTE_DEFAULT_VALUE(dynamicStateUpdateTolerance, "0")
+        ATTRIBUTE_RELEVANT_IF(dynamicStateUpdateTolerance, "IteratePrimary|IterateSecondary")
+        ATTRIBUTE_DISPLAYED_IF(dynamicStateUpdateTolerance, "Level3")
+
+        PROPERTY_BOOL(accelerateDynamicState,
+                      "accelerate convergence of the dynamic medium state through Ng extrapolation")
+        ATTRIBUTE_DEFAULT_VALUE(accelerateDynamicState, "false")
+        ATTRIBUTE_RELEVANT_IF(accelerateDynamicState, "IteratePrimary|IterateSecondary")
+        ATTRIBUTE_DISPLAYED_IF(accelerateDynamicState, "Level3")
+
+        PROPERTY_BOOL(writeCheckpoints, "write a checkpoint file at the end of each iteration")
+        ATTRIBUTE_DEFAULT_VALUE(writeCheckpoints, "false")
+        ATTRIBUTE_RELEVANT_IF(writeCheckpoints, "IteratePrimary|Emission")
+        ATTRIBUTE_DISPLAYED_IF(writeCheckpoints, "Level3")
+
+        PROPERTY_STRING(restartFilename, "the name of the checkpoint file to resume from, or empty to start afresh")
+        ATTRIBUTE_DEFAULT_VALUE(restartFilename, "")
+        ATTRIBUTE_REQUIRED_IF(restartFilename, "false")
+        ATTRIBUTE_RELEVANT_IF(restartFilename, "IteratePrimary|Emission")
+        ATTRIBUTE_DISPLAYED_IF(restartFilename, "Level3")
+
+        PROPERTY_ENUM(reobservationMode, ReobservationMode,
+                      "re-observe the converged medium restored from the checkpoint without iterating")
+        ATTRIBUTE_DEFAULT_VALUE(reobservationMode, "None")
+        ATTRIBUTE_RELEVANT_IF(reobservationMode, "(IteratePrimary|Emission)&restartFilename")
+        ATTRIBUTE_DISPLAYED_IF(reobservationMode, "Level3")
+
     ITEM_END()
 };
 
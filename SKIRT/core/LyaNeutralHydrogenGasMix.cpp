@@ -6,10 +6,13 @@
 #include "LyaNeutralHydrogenGasMix.hpp"
 #include "Configuration.hpp"
 #include "Constants.hpp"
+#include "Log.hpp"
 #include "LyaUtils.hpp"
 #include "MaterialState.hpp"
+#include "MemoryLedger.hpp"
 #include "PhotonPacket.hpp"
 #include "Random.hpp"
+#include "StringUtils.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
@@ -18,6 +21,15 @@ void LyaNeutralHydrogenGasMix::setupSelfBefore()
     MaterialMix::setupSelfBefore();
 
     _dpf.initialize(random(), includePolarization());
+
+    if (config()->lyaTabulateAtomVelocities())
+    {
+        // the tables are shared between all medium components, so register them only once for each simulation
+        _vst = &VoigtSamplingTable::shared();
+        if (find<MemoryLedger>()->recordShared("atom velocity sampling tables", _vst, _vst->allocatedBytes()))
+            find<Log>()->info(type() + " uses " + StringUtils::toMemSizeString(_vst->allocatedBytes())
+                              + " of memory for shared atom velocity sampling tables");
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -142,7 +154,7 @@ bool LyaNeutralHydrogenGasMix::peeloffScattering(double& I, double& Q, double& U
     {
         scatinfo->valid = true;
         std::tie(scatinfo->velocity, scatinfo->dipole) = LyaUtils::sampleAtomVelocity(
-            lambda, state->temperature(), state->numberDensity(), pp->direction(), config(), random());
+            lambda, state->temperature(), state->numberDensity(), pp->direction(), config(), random(), _vst);
     }
 
     // add the contribution to the Stokes vector components depending on scattering type
@@ -173,7 +185,7 @@ void LyaNeutralHydrogenGasMix::performScattering(double lambda, const MaterialSt
     {
         scatinfo->valid = true;
         std::tie(scatinfo->velocity, scatinfo->dipole) = LyaUtils::sampleAtomVelocity(
-            lambda, state->temperature(), state->numberDensity(), pp->direction(), config(), random());
+            lambda, state->temperature(), state->numberDensity(), pp->direction(), config(), random(), _vst);
     }
 
     // draw the outgoing direction from the dipole or the isotropic phase function
@@ -8,6 +8,7 @@
 
 #include "DipolePhaseFunction.hpp"
 #include "MaterialMix.hpp"
+#include "VoigtSamplingTable.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
@@ -52,7 +53,8 @@ class LyaNeutralHydrogenGasMix : public MaterialMix
     //============= Construction - Setup - Destruction =============
 
 protected:
-    /** This function initializes the DipolePhaseFunction instance held by this class. */
+    /** This function initializes the DipolePhaseFunction instance held by this class and, if
+        requested by the configuration, the tables for sampling atom velocities. */
     void setupSelfBefore() override;
 
     //======== Capabilities =======
@@ -171,6 +173,10 @@ public:
 private:
     // the dipole phase function helper instance - initialized during setup
     DipolePhaseFunction _dpf;
+
+    // the atom velocity sampling tables shared by all medium components in the process
+    // - initialized during setup if requested by the configuration
+    const VoigtSamplingTable* _vst{nullptr};
 };
 
 ////////////////////////////////////////////////////////////////////
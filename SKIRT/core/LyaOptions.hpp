@@ -11,7 +11,45 @@
 ////////////////////////////////////////////////////////////////////
 
 /** The LyaOptions class simply offers a number of configuration options related to the treatment
-    of Lyman-alpha line transfer, if this is enabled in the simulation. */
+    of Lyman-alpha line transfer, if this is enabled in the simulation.
+
+    The \em tabulateAtomVelocities option determines how the component of the interacting atom's
+    velocity parallel to the incoming photon packet direction is sampled for each scattering event.
+    By default, the value is sampled through the rejection technique described for the
+    VoigtProfile::sample() function. The number of attempts required by this technique increases
+    substantially for photon packets in the wings of the line. If the option is enabled, the value
+    is instead sampled from precomputed tables with a cost that does not depend on the photon
+    packet frequency, as described for the VoigtSamplingTable class. The tables introduce small
+    interpolation errors and require about 38 MB of memory, shared by all Lyman-alpha medium
+    components.
+
+    <b>Diffusion acceleration</b>
+
+    Core-skipping cannot prevent photon packets from scattering millions of times in extremely
+    optically thick media (e.g., with neutral hydrogen column densities above \f$10^{21}\,
+    \mathrm{cm}^{-2}\f$). If the \em lyaDiffusionAcceleration option is enabled, the random walk of
+    a photon packet inside such a medium is replaced by a single diffusion step whenever possible.
+    Consider a scattering event in a spatial cell that contains only Lyman-alpha material, for a
+    photon packet with a dimensionless frequency \f$|x|\le3\f$ (i.e. in the core of the line)
+    in the gas frame. The diffusion sphere is the largest sphere centered on the scattering
+    location that fits inside the cell, and \f$a\tau_0\f$ is the product of the Voigt parameter
+    and the line-center optical depth from the center to the surface of that sphere. If
+    \f$a\tau_0\f$ exceeds the user-configured threshold, the photon packet is moved to a random
+    position on the surface of the sphere, and its wavelength and direction are drawn from the
+    analytical solution for the radiation escaping a static uniform sphere with a central source
+    (Dijkstra et al. 2006, ApJ, 649, 14-36). The solution is valid for \f$a\tau_0\gtrsim10^3\f$,
+    which is the default threshold. Because the sphere radius is estimated by tracing rays from
+    the scattering location along a fixed set of directions, the sphere may slightly extend beyond
+    the boundaries of cells that are not cuboidal. At the end of the primary emission segment, the
+    simulation logs the number of diffusion steps and writes a text file listing the number of
+    steps and the mean value of \f$a\tau_0\f$ for each cell in which steps were performed.
+
+    A diffusion step does not register the contribution to the radiation field of the path
+    travelled inside the diffusion sphere. As a result, the mean intensity would be underestimated
+    in precisely those cells in which diffusion steps are performed. Therefore, diffusion steps are
+    disabled (and a warning is issued) if the simulation stores the radiation field, for example
+    because the \em storeRadiationField option is enabled or because the simulation iterates over
+    primary emission. */
 class LyaOptions : public SimulationItem
 {
     /** The enumeration type indicating the supported Lyman-alpha acceleration schemes.
@@ -91,6 +129,21 @@ class LyaOptions : public SimulationItem
         ATTRIBUTE_RELEVANT_IF(lyaAccelerationStrength, "lyaAccelerationSchemeConstant|lyaAccelerationSchemeVariable")
         ATTRIBUTE_DISPLAYED_IF(lyaAccelerationStrength, "Level2")
 
+        PROPERTY_BOOL(tabulateAtomVelocities, "sample atom velocities from precomputed tables rather than by rejection")
+        ATTRIBUTE_DEFAULT_VALUE(tabulateAtomVelocities, "false")
+        ATTRIBUTE_DISPLAYED_IF(tabulateAtomVelocities, "Level3")
+
+        PROPERTY_BOOL(lyaDiffusionAcceleration, "replace random walks in optically thick cells by diffusion steps")
+        ATTRIBUTE_DEFAULT_VALUE(lyaDiffusionAcceleration, "false")
+        ATTRIBUTE_DISPLAYED_IF(lyaDiffusionAcceleration, "Level2")
+
+        PROPERTY_DOUBLE(lyaDiffusionThreshold, "the minimum value of a*tau0 for performing a diffusion step")
+        ATTRIBUTE_MIN_VALUE(lyaDiffusionThreshold, "[10")
+        ATTRIBUTE_MAX_VALUE(lyaDiffusionThreshold, "1e10]")
+        ATTRIBUTE_DEFAULT_VALUE(lyaDiffusionThreshold, "1000")
+        ATTRIBUTE_RELEVANT_IF(lyaDiffusionThreshold, "lyaDiffusionAcceleration")
+        ATTRIBUTE_DISPLAYED_IF(lyaDiffusionThreshold, "Level2")
+
         PROPERTY_BOOL(includeHubbleFlow, "include the Doppler shift caused by the expansion of the universe")
         ATTRIBUTE_DEFAULT_VALUE(includeHubbleFlow, "false")
         ATTRIBUTE_DISPLAYED_IF(includeHubbleFlow, "Level2")
@@ -8,6 +8,7 @@
 #include "Constants.hpp"
 #include "Random.hpp"
 #include "VoigtProfile.hpp"
+#include "VoigtSamplingTable.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
@@ -34,7 +35,8 @@ double LyaUtils::section(double lambda, double T)
 ////////////////////////////////////////////////////////////////////
 
 std::pair<Vec, bool> LyaUtils::sampleAtomVelocity(double lambda, double T, double nH, Direction kin,
-                                                  Configuration* config, Random* random)
+                                                  Configuration* config, Random* random,
+                                                  const VoigtSamplingTable* table)
 {
     double vth = sqrt(2. * kB / mp * T);          // thermal velocity for T
     double a = Aa * la / 4. / M_PI / vth;         // Voigt parameter
@@ -67,7 +69,7 @@ std::pair<Vec, bool> LyaUtils::sampleAtomVelocity(double lambda, double T, doubl
 
     // draw values for the components of the dimensionless atom velocity
     // parallel and orthogonal to the incoming photon packet
-    double upar = VoigtProfile::sample(a, x, random);
+    double upar = table ? table->sample(a, x, random) : VoigtProfile::sample(a, x, random);
     double radius = sqrt(xcrit * xcrit - std::log(random->uniform()));
     double angle = 2. * M_PI * random->uniform();
     double u1 = radius * cos(angle);
@@ -93,6 +95,34 @@ std::pair<Vec, bool> LyaUtils::sampleAtomVelocity(double lambda, double T, doubl
 
 ////////////////////////////////////////////////////////////////////
 
+double LyaUtils::diffusionOpacity(double lambda, double T, double nH)
+{
+    double vth = sqrt(2. * kB / mp * T);          // thermal velocity for T
+    double a = Aa * la / 4. / M_PI / vth;         // Voigt parameter
+    double x = (la - lambda) / lambda * c / vth;  // dimensionless frequency
+    if (abs(x) > 3.) return 0.;
+
+    double sigma0 = 3. * la * la * M_2_SQRTPI / 4. * a;  // cross section at line center
+    return a * nH * sigma0;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double LyaUtils::sampleDiffusionWavelength(double T, double aTau0, Random* random)
+{
+    double vth = sqrt(2. * kB / mp * T);  // thermal velocity for T
+
+    // draw the scaled frequency from its cumulative distribution tanh(y/2), which can be inverted analytically
+    double y = 2. * atanh(random->uniform());
+    double x = cbrt(y * aTau0 / sqrt(2. * M_PI * M_PI * M_PI / 27.));
+    if (random->uniform() < 0.5) x = -x;
+
+    // convert the dimensionless frequency to wavelength
+    return la / (1. + x * vth / c);
+}
+
+////////////////////////////////////////////////////////////////////
+
 double LyaUtils::shiftWavelength(double lambda, const Vec& vatom, const Direction& kin, const Direction& kout)
 {
     return lambda / (1 - Vec::dot(kin, vatom) / c) * (1 - Vec::dot(kout, vatom) / c);
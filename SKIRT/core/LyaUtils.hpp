@@ -10,6 +10,7 @@
 #include "Range.hpp"
 class Configuration;
 class Random;
+class VoigtSamplingTable;
 
 ////////////////////////////////////////////////////////////////////
 
@@ -116,7 +117,9 @@ namespace LyaUtils
 
         The function arguments include the photon packet wavelength as it is perceived in the local
         gas frame and the hydrogen temperature and number density in the current spatial cell. The
-        latter two values are used in the variable acceleration scheme. The return value is a pair:
+        latter two values are used in the variable acceleration scheme. If the last argument is
+        not null, the parallel component of the atom velocity is drawn from the specified
+        precomputed tables rather than through the rejection technique. The return value is a pair:
         the first item is the atom velocity and the second item is true for the dipole phase
         function and false for isotropic scattering.
 
@@ -142,7 +145,30 @@ namespace LyaUtils
 
         */
     std::pair<Vec, bool> sampleAtomVelocity(double lambda, double T, double nH, Direction kin, Configuration* config,
-                                            Random* random);
+                                            Random* random, const VoigtSamplingTable* table);
+
+    /** This function returns the product \f$a\,k_0\f$ of the Voigt parameter and the
+        line-center extinction opacity for the given hydrogen temperature and number density, if
+        the dimensionless frequency corresponding to the given photon packet wavelength (perceived
+        in the local gas frame) lies in the core of the line, i.e. \f$|x|\le3\f$. Otherwise, the
+        function returns zero. Multiplying the returned value by the radius of a uniform sphere
+        yields the product \f$a\tau_0\f$ for that sphere, where \f$\tau_0\f$ is the line-center
+        optical depth from the center to the surface. */
+    double diffusionOpacity(double lambda, double T, double nH);
+
+    /** This function draws a random wavelength, in the local gas frame, for a photon packet
+        escaping from a static uniform sphere of neutral hydrogen with temperature \f$T\f$ after
+        being emitted near the line center at the center of the sphere. The analytical solution
+        for the spectrum of the escaping radiation derived by Dijkstra et al. 2006 (ApJ, 649,
+        14-36) can be written as \f[ J(x) \propto \frac{x^2}{1+\cosh\left(\sqrt{2\pi^3/27}\,
+        |x|^3/(a\tau_0)\right)}, \f] where \f$a\tau_0\f$ is specified as an argument. With the
+        substitution \f$y=\sqrt{2\pi^3/27}\,|x|^3/(a\tau_0)\f$, the probability distribution for
+        \f$y\ge0\f$ becomes proportional to \f$1/(1+\cosh y)\f$, which has the cumulative
+        distribution \f$\tanh(y/2)\f$. Hence the function generates \f$y=2\,\mathrm{artanh}\,
+        {\cal{X}}\f$ for a uniform deviate \f$\cal{X}\f$, selects the red or blue side of the line
+        with equal probability, and converts the resulting dimensionless frequency to a
+        wavelength. */
+    double sampleDiffusionWavelength(double T, double aTau0, Random* random);
 
     /** This function returns the Doppler-shifted wavelength in the gas bulk rest frame after a
         Lyman-alpha scattering event, given the incoming wavelength in the gas bulk rest frame, the
@@ -117,6 +117,10 @@ void MaterialMix::initializeSpecificState(MaterialState* /*state*/, double /*met
 
 ////////////////////////////////////////////////////////////////////
 
+void MaterialMix::beginSpecificStateUpdate() const {}
+
+////////////////////////////////////////////////////////////////////
+
 UpdateStatus MaterialMix::updateSpecificState(MaterialState* /*state*/, const Array& /*Jv*/) const
 {
     throw FATALERROR("This function implementation should never be called");
@@ -133,6 +137,13 @@ bool MaterialMix::isSpecificStateConverged(int /*numCells*/, int /*numUpdated*/,
 
 ////////////////////////////////////////////////////////////////////
 
+vector<int> MaterialMix::acceleratedSpecificStateVariables() const
+{
+    return vector<int>();
+}
+
+////////////////////////////////////////////////////////////////////
+
 double MaterialMix::asymmpar(double /*lambda*/) const
 {
     return 0.;
@@ -371,6 +371,13 @@ public:
 
     //======== Medium state updates =======
 
+    /** If this material mix has a dynamic medium state, i.e. if the hasDynamicMediumState()
+        function returns anything other than \c None, this function is invoked (once) at the start
+        of each update cycle, \em before updateSpecificState() is called for the spatial cells. It
+        allows the material mix to reset any information shared between cells during an update
+        cycle. The default implementation in this base class does nothing. */
+    virtual void beginSpecificStateUpdate() const;
+
     /** If this material mix has a dynamic medium state, i.e. if the hasDynamicMediumState()
         function returns anything other than \c None, this function is invoked for each spatial
         cell at the end of each relevant primary or secondary emission segment. Based on the
@@ -400,6 +407,16 @@ public:
     virtual bool isSpecificStateConverged(int numCells, int numUpdated, int numNotConverged,
                                           MaterialState* currentAggregate, MaterialState* previousAggregate) const;
 
+    /** If this material mix has a dynamic medium state, this function returns the indices of the
+        custom specific state variables (in the range of indices returned by
+        specificStateVariableInfo() for variables of type \c Custom) that converge through a fixed
+        point iteration and that may thus be extrapolated by the Ng acceleration scheme implemented
+        in the NgAccelerator class, if so requested by the user. The material mix should list only
+        variables whose values are fully determined by the most recent update, and must accept an
+        extrapolated specific state. The default implementation in this base class returns an empty
+        list, indicating that the specific state of this material mix should not be extrapolated. */
+    virtual vector<int> acceleratedSpecificStateVariables() const;
+
     //======== Low-level material properties =======
 
 public:
@@ -6,6 +6,8 @@
 #include "MediumState.hpp"
 #include "FatalError.hpp"
 #include "ProcessManager.hpp"
+#include <istream>
+#include <ostream>
 
 //////////////////////////////////////////////////////////////////////
 
@@ -193,6 +195,47 @@ void MediumState::pushAggregate()
 
 //////////////////////////////////////////////////////////////////////
 
+void MediumState::write(std::ostream& out) const
+{
+    // the configuration
+    uint64_t config[4] = {static_cast<uint64_t>(_numCells), static_cast<uint64_t>(_numMedia),
+                          static_cast<uint64_t>(_numAggregateCells), _numVars};
+    out.write(reinterpret_cast<const char*>(config), sizeof(config));
+
+    // the cell volumes, so that the spatial grid can be verified before overwriting any data
+    Array volumev(_numCells);
+    for (int m = 0; m != _numCells; ++m) volumev[m] = volume(m);
+    out.write(reinterpret_cast<const char*>(begin(volumev)), volumev.size() * sizeof(double));
+
+    // the state variables
+    out.write(reinterpret_cast<const char*>(begin(_data)), _data.size() * sizeof(double));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+bool MediumState::read(std::istream& in)
+{
+    // verify the configuration
+    uint64_t config[4] = {0, 0, 0, 0};
+    in.read(reinterpret_cast<char*>(config), sizeof(config));
+    if (!in || config[0] != static_cast<uint64_t>(_numCells) || config[1] != static_cast<uint64_t>(_numMedia)
+        || config[2] != static_cast<uint64_t>(_numAggregateCells) || config[3] != _numVars)
+        return false;
+
+    // verify the cell volumes
+    Array volumev(_numCells);
+    in.read(reinterpret_cast<char*>(begin(volumev)), volumev.size() * sizeof(double));
+    if (!in) return false;
+    for (int m = 0; m != _numCells; ++m)
+        if (abs(volumev[m] - volume(m)) > 1e-9 * max(abs(volumev[m]), abs(volume(m)))) return false;
+
+    // read the state variables
+    in.read(reinterpret_cast<char*>(begin(_data)), _data.size() * sizeof(double));
+    return static_cast<bool>(in);
+}
+
+//////////////////////////////////////////////////////////////////////
+
 void MediumState::setVolume(int m, double value)
 {
     _data[_numVars * m + _off_volu] = value;
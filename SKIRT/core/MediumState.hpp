@@ -10,6 +10,7 @@
 #include "StateVariable.hpp"
 #include "UpdateStatus.hpp"
 #include "Vec.hpp"
+#include <iosfwd>
 
 //////////////////////////////////////////////////////////////////////
 
@@ -185,6 +186,27 @@ public:
         more information, see the description of aggregation in the class header. */
     void pushAggregate();
 
+    //============= Checkpointing =============
+
+public:
+    /** This function writes the configuration, the cell volumes, and the values of all state
+        variables (including any aggregate states) to the specified output stream, which must have
+        been opened in binary mode, so that the state can be restored by a subsequent simulation
+        run. */
+    void write(std::ostream& out) const;
+
+    /** This function reads the medium state from the specified input stream, which must have been
+        opened in binary mode, in the format written by the write() function. The stored
+        configuration must be identical to the configuration of this medium state, and the stored
+        volume of each spatial cell must equal the current volume to within a small relative
+        tolerance. Because equal cell volumes do not guarantee that the state was written for the
+        same spatial grid (for example, a translated or mirrored regular grid has the same cell
+        volumes), the caller should verify the grid geometry before calling this function. If
+        these conditions are not met, the function returns false without changing the medium
+        state. If the stream cannot be read after the verification succeeded, the function returns
+        false and the medium state is undefined. Otherwise, the function returns true. */
+    bool read(std::istream& in);
+
     //============= Setting =============
 
 public:
@@ -7,6 +7,7 @@
 #include "Configuration.hpp"
 #include "DensityInCellInterface.hpp"
 #include "DisjointWavelengthGrid.hpp"
+#include "EventCounters.hpp"
 #include "FatalError.hpp"
 #include "LockFree.hpp"
 #include "Log.hpp"
@@ -21,7 +22,14 @@
 #include "ProcessManager.hpp"
 #include "Random.hpp"
 #include "ShortArray.hpp"
+#include "SourceSystem.hpp"
+#include "SpecialFunctions.hpp"
 #include "StringUtils.hpp"
+#include "TextOutFile.hpp"
+#include "Tracer.hpp"
+#include <atomic>
+#include <istream>
+#include <ostream>
 
 ////////////////////////////////////////////////////////////////////
 
@@ -29,6 +37,9 @@ namespace
 {
     // maximum number of cell densities calculated between two invocations of infoIfElapsed()
     const size_t logProgressChunkSize = 10000;
+
+    // the serial number assigned to the most recently set up medium system in this process
+    std::atomic<size_t> _lastSerial{0};
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -182,12 +193,28 @@ namespace
 
 ////////////////////////////////////////////////////////////////////
 
+void MediumSystem::setupSelfBefore()
+{
+    SimulationItem::setupSelfBefore();
+
+    // remember the memory usage before the media and the spatial grid are set up
+    _memoryMark = find<MemoryLedger>()->mark();
+}
+
+////////////////////////////////////////////////////////////////////
+
 void MediumSystem::setupSelfAfter()
 {
     SimulationItem::setupSelfAfter();
     auto log = find<Log>();
     auto parfac = find<ParallelFactory>();
+    auto ledger = find<MemoryLedger>();
     _config = find<Configuration>();
+    _serial = ++_lastSerial;
+
+    // measure the memory allocated by the media (e.g., for imported snapshots) and by the spatial grid;
+    // these are measured together because the grid may cause the media to be set up and vice versa
+    ledger->recordSince("media and spatial grid", _memoryMark);
 
     _numCells = _grid->numCells();
     if (_numCells < 1) throw FATALERROR("The spatial grid must have at least one cell");
@@ -210,21 +237,34 @@ void MediumSystem::setupSelfAfter()
     for (auto medium : _media) _state.initSpecificStateVariables(medium->mix()->specificStateVariableInfo());
 
     // finalize
-    allocatedBytes += _state.initAllocate() * sizeof(double);
+    size_t stateBytes = _state.initAllocate() * sizeof(double);
+    ledger->record("medium state", stateBytes);
+    allocatedBytes += stateBytes;
 
     // ----- allocate memory for the radiation field -----
 
     if (_config->hasRadiationField())
     {
         _wavelengthGrid = _config->radiationFieldWLG();
-        _rf1.resize(_numCells, _wavelengthGrid->numBins());
-        allocatedBytes += _rf1.size() * sizeof(double);
-
-        if (_config->hasSecondaryRadiationField())
+        int numBins = _wavelengthGrid->numBins();
+        int numTables = _config->hasSecondaryRadiationField() ? 3 : 1;
+
+        // switch to single precision if the tables in double precision would exceed the memory budget
+        bool singlePrecision = !ledger->fits(numTables * RadiationFieldTable::requiredBytes(_numCells, numBins, false));
+        if (singlePrecision)
+            log->warning("Storing the radiation field in single precision to remain within the memory budget");
+        size_t rfBytes = numTables * RadiationFieldTable::requiredBytes(_numCells, numBins, singlePrecision);
+        ledger->reserve("radiation field", rfBytes);
+        allocatedBytes += rfBytes;
+
+        // in single precision, store the values relative to the primary luminosity times the grid diagonal,
+        // because the accumulated L*ds values in SI units would otherwise overflow the single-precision range
+        double scale = singlePrecision ? find<SourceSystem>()->luminosity() * _grid->boundingBox().diagonal() : 1.;
+        _rf1.resize(_numCells, numBins, singlePrecision, scale);
+        if (numTables > 1)
         {
-            _rf2.resize(_numCells, _wavelengthGrid->numBins());
-            _rf2c.resize(_numCells, _wavelengthGrid->numBins());
-            allocatedBytes += 2 * _rf2.size() * sizeof(double);
+            _rf2.resize(_numCells, numBins, singlePrecision, scale);
+            _rf2c.resize(_numCells, numBins, singlePrecision, scale);
         }
     }
 
@@ -254,7 +294,7 @@ void MediumSystem::setupSelfAfter()
         _mixv.resize(_numMedia);
         for (int h = 0; h != _numMedia; ++h) _mixv[h] = _media[h]->mix();
     }
-    allocatedBytes += _mixv.size() * sizeof(MaterialMix*);
+    size_t otherBytes = _mixv.size() * sizeof(MaterialMix*);
 
     // cache a list of medium component indices for each material type
     for (int h = 0; h != _numMedia; ++h)
@@ -279,6 +319,48 @@ void MediumSystem::setupSelfAfter()
         }
     }
 
+    // create accelerators for the dynamic medium state media that support extrapolation, if requested
+    if (_config->accelerateDynamicState())
+    {
+        auto createAccelerator = [this](const vector<int>& dms_hv) -> NgAccelerator* {
+            vector<int> hv;
+            vector<vector<int>> iv;
+            for (int h : dms_hv)
+            {
+                auto indices = mix(0, h)->acceleratedSpecificStateVariables();
+                if (!indices.empty())
+                {
+                    hv.push_back(h);
+                    iv.push_back(indices);
+                }
+            }
+            return hv.empty() ? nullptr : new NgAccelerator(_numCells, hv, iv);
+        };
+        _pdmsAccelerator.reset(createAccelerator(_pdms_hv));
+        _sdmsAccelerator.reset(createAccelerator(_sdms_hv));
+        if (_pdmsAccelerator) otherBytes += _pdmsAccelerator->allocatedBytes();
+        if (_sdmsAccelerator) otherBytes += _sdmsAccelerator->allocatedBytes();
+    }
+
+    // allocate radiation field fingerprints for skipping updates of cells with an unchanged radiation field
+    if (_config->dynamicStateUpdateTolerance() > 0.)
+    {
+        size_t numFingerprintValues = static_cast<size_t>(_numCells) * numFingerprintBands();
+        if (!_pdms_hv.empty()) _pdmsFingerprints.resize(numFingerprintValues);
+        if (!_sdms_hv.empty()) _sdmsFingerprints.resize(numFingerprintValues);
+        otherBytes += (_pdmsFingerprints.size() + _sdmsFingerprints.size()) * sizeof(double);
+    }
+    // allocate statistics and the maximum sphere radius for Lyman-alpha diffusion steps
+    if (_config->hasLyaDiffusion())
+    {
+        _lyaDiffusionStepv.resize(_numCells);
+        _lyaDiffusionProductv.resize(_numCells);
+        _lyaMaxRadiusv.resize(_numCells);
+        otherBytes += 3 * _numCells * sizeof(double);
+    }
+    ledger->record("medium system", otherBytes);
+    allocatedBytes += otherBytes;
+
     // ----- inform user about allocated memory -----
 
     log->info(typeAndName() + " allocated " + StringUtils::toMemSizeString(allocatedBytes) + " of memory");
@@ -392,6 +474,11 @@ void MediumSystem::setupSelfAfter()
     // communicate the calculated states across multiple processes, if needed
     _state.initCommunicate();
 
+    // cache the radius of a sphere with the same volume as each cell, which is an upper limit
+    // for the radius of a sphere fitting inside the cell, to quickly reject Lyman-alpha diffusion steps
+    if (_config->hasLyaDiffusion())
+        for (int m = 0; m != _numCells; ++m) _lyaMaxRadiusv[m] = cbrt(3. / (4. * M_PI) * _state.volume(m));
+
     // calculate the initial aggregate state, if needed
     _state.calculateAggregate();
 
@@ -764,6 +851,10 @@ void MediumSystem::peelOffScattering(const ShortArray& wv, double lambda, Direct
         // so the reference direction is no longer used and can be left unspecified
         ppp->setPolarized(I, Q, U, V);
     }
+
+    // apply the phase function for each companion wavelength of a polychromatic photon packet
+    for (int k = 0; k != pp->numCompanions(); ++k)
+        ppp->applyCompanionBias(k, weightedPhaseFunctionValue(pp->companionWavelength(k), m, bfkobs, pp));
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -817,27 +908,82 @@ void MediumSystem::simulateScattering(Random* random, PhotonPacket* pp) const
     }
 
     // actually perform the scattering event for this cell and medium component
+    Direction bfk = pp->direction();
     MaterialState mst(_state, m, h);
     pp->setScatteringComponent(h);
     mix(m, h)->performScattering(lambda, &mst, pp);
+
+    // for a polychromatic photon packet, compensate the companion weights for sampling the scattering angle
+    // at the reference wavelength; because the phase function depends only on the scattering angle,
+    // we can evaluate it from the outgoing direction into the incoming direction
+    int numCompanions = pp->numCompanions();
+    if (numCompanions)
+    {
+        double reference = weightedPhaseFunctionValue(lambda, m, bfk, pp);
+        for (int k = 0; k != numCompanions; ++k)
+        {
+            double companion = weightedPhaseFunctionValue(pp->companionWavelength(k), m, bfk, pp);
+            pp->applyCompanionBias(k, reference > 0. ? companion / reference : 0.);
+        }
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
 
 namespace
 {
+    // This path segment generator forwards to the generator for a spatial grid and counts the paths and
+    // the generated path segments. It is used only if event counting is enabled, so that regular runs
+    // do not suffer the overhead of the additional virtual function call for each path segment.
+    class CountingPathSegmentGenerator : public PathSegmentGenerator
+    {
+    public:
+        explicit CountingPathSegmentGenerator(std::unique_ptr<PathSegmentGenerator> generator)
+            : _generator(std::move(generator))
+        {}
+
+        void startPath(const SpatialGridPath* path)
+        {
+            _generator->start(path);
+            EventCounters::count(EventCounters::Paths);
+        }
+
+        bool next() override
+        {
+            if (!_generator->next()) return false;
+            setSegment(_generator->m(), _generator->ds());
+            EventCounters::count(EventCounters::PathSegments);
+            return true;
+        }
+
+    private:
+        std::unique_ptr<PathSegmentGenerator> _generator;
+    };
+
     // This function returns a thread-local instance of the path segment generator for the specified grid
     // that is initialized to the starting position and direction of the specified path.
     // Providing a thread-local instance avoids creating a new generator for each use.
-    PathSegmentGenerator* getPathSegmentGenerator(SpatialGrid* grid, const SpatialGridPath* path)
+    // The cached instance is identified by the serial number of the medium system owning the grid rather than
+    // by the grid address, because a grid in a subsequent simulation performed by the same process (and thus
+    // possibly by the same thread) may be allocated at the address of a grid that has since been destroyed.
+    PathSegmentGenerator* getPathSegmentGenerator(SpatialGrid* grid, size_t serial, const SpatialGridPath* path)
     {
-        thread_local SpatialGrid* t_grid{nullptr};
+        thread_local size_t t_serial{0};
         thread_local std::unique_ptr<PathSegmentGenerator> t_generator;
+        thread_local std::unique_ptr<CountingPathSegmentGenerator> t_countingGenerator;
 
-        if (grid != t_grid)
+        if (serial != t_serial)
         {
-            t_grid = grid;
+            t_serial = serial;
             t_generator = grid->createPathSegmentGenerator();
+            t_countingGenerator.reset();
+        }
+        if (EventCounters::isEnabled())
+        {
+            if (!t_countingGenerator)
+                t_countingGenerator.reset(new CountingPathSegmentGenerator(grid->createPathSegmentGenerator()));
+            t_countingGenerator->startPath(path);
+            return t_countingGenerator.get();
         }
         t_generator->start(path);
         return t_generator.get();
@@ -849,7 +995,7 @@ namespace
 void MediumSystem::setExtinctionOpticalDepths(PhotonPacket* pp) const
 {
     // determine and store the path segments in the photon packet
-    auto generator = getPathSegmentGenerator(_grid, pp);
+    auto generator = getPathSegmentGenerator(_grid, _serial, pp);
     pp->clear();
     while (generator->next())
     {
@@ -905,7 +1051,7 @@ void MediumSystem::setExtinctionOpticalDepths(PhotonPacket* pp) const
 void MediumSystem::setScatteringAndAbsorptionOpticalDepths(PhotonPacket* pp) const
 {
     // determine and store the path segments in the photon packet
-    auto generator = getPathSegmentGenerator(_grid, pp);
+    auto generator = getPathSegmentGenerator(_grid, _serial, pp);
     pp->clear();
     while (generator->next())
     {
@@ -977,7 +1123,7 @@ void MediumSystem::setScatteringAndAbsorptionOpticalDepths(PhotonPacket* pp) con
 
 bool MediumSystem::setInteractionPointUsingExtinction(PhotonPacket* pp, double tauinteract) const
 {
-    auto generator = getPathSegmentGenerator(_grid, pp);
+    auto generator = getPathSegmentGenerator(_grid, _serial, pp);
     double tau = 0.;
     double s = 0.;
 
@@ -1074,7 +1220,7 @@ bool MediumSystem::setInteractionPointUsingExtinction(PhotonPacket* pp, double t
 
 bool MediumSystem::setInteractionPointUsingScatteringAndAbsorption(PhotonPacket* pp, double tauinteract) const
 {
-    auto generator = getPathSegmentGenerator(_grid, pp);
+    auto generator = getPathSegmentGenerator(_grid, _serial, pp);
     double tauSca = 0.;
     double tauAbs = 0.;
     double s = 0.;
@@ -1191,15 +1337,21 @@ bool MediumSystem::setInteractionPointUsingScatteringAndAbsorption(PhotonPacket*
 
 double MediumSystem::getExtinctionOpticalDepth(const PhotonPacket* pp, double distance) const
 {
+    EventCounters::count(EventCounters::ExtinctionCalls);
+
     // abort if the packet's contribution is zero to begin with
     double L = pp->luminosity();
-    if (L <= 0) return std::numeric_limits<double>::infinity();
+    if (L <= 0)
+    {
+        EventCounters::count(EventCounters::ExtinctionEarlyOuts);
+        return std::numeric_limits<double>::infinity();
+    }
 
     // if extinction is always positive, determine the optical depth at which the packet's contribution becomes zero
     double taumax = _config->hasNegativeExtinction() ? std::numeric_limits<double>::infinity() : std::log(L) + 745;
 
     // determine the geometric details of the path and calculate the optical depth at the same time
-    auto generator = getPathSegmentGenerator(_grid, pp);
+    auto generator = getPathSegmentGenerator(_grid, _serial, pp);
     double tau = 0.;
     double s = 0.;
 
@@ -1212,7 +1364,11 @@ double MediumSystem::getExtinctionOpticalDepth(const PhotonPacket* pp, double di
             if (generator->m() >= 0)
             {
                 tau += section * _state.numberDensity(generator->m(), 0) * generator->ds();
-                if (tau >= taumax) return std::numeric_limits<double>::infinity();
+                if (tau >= taumax)
+                {
+                    EventCounters::count(EventCounters::ExtinctionEarlyOuts);
+                    return std::numeric_limits<double>::infinity();
+                }
             }
             s += generator->ds();
             if (s > distance) break;
@@ -1231,7 +1387,11 @@ double MediumSystem::getExtinctionOpticalDepth(const PhotonPacket* pp, double di
             if (m >= 0)
             {
                 for (int h = 0; h != _numMedia; ++h) tau += sectionv[h] * _state.numberDensity(m, h) * ds;
-                if (tau >= taumax) return std::numeric_limits<double>::infinity();
+                if (tau >= taumax)
+                {
+                    EventCounters::count(EventCounters::ExtinctionEarlyOuts);
+                    return std::numeric_limits<double>::infinity();
+                }
             }
             s += ds;
             if (s > distance) break;
@@ -1249,7 +1409,11 @@ double MediumSystem::getExtinctionOpticalDepth(const PhotonPacket* pp, double di
             {
                 double lambda = pp->perceivedWavelength(_state.bulkVelocity(m), _config->hubbleExpansionRate() * s);
                 tau += opacityExt(lambda, m, pp) * ds;
-                if (tau >= taumax) return std::numeric_limits<double>::infinity();
+                if (tau >= taumax)
+                {
+                    EventCounters::count(EventCounters::ExtinctionEarlyOuts);
+                    return std::numeric_limits<double>::infinity();
+                }
             }
             s += ds;
             if (s > distance) break;
@@ -1265,7 +1429,7 @@ double MediumSystem::getExtinctionOpticalDepth(const SpatialGridPath* path, doub
                                                MaterialMix::MaterialType type) const
 {
     // determine the geometric details of the path and calculate the optical depth at the same time
-    auto generator = getPathSegmentGenerator(_grid, path);
+    auto generator = getPathSegmentGenerator(_grid, _serial, path);
     double tau = 0.;
     while (generator->next())
     {
@@ -1276,6 +1440,233 @@ double MediumSystem::getExtinctionOpticalDepth(const SpatialGridPath* path, doub
 
 ////////////////////////////////////////////////////////////////////
 
+void MediumSystem::biasCompanionsForInteraction(PhotonPacket* pp, double density) const
+{
+    // get the extinction opacity at the reference wavelength in the interaction cell
+    int m = pp->interactionCellIndex();
+    double kext = 0.;
+    for (int h = 0; h != _numMedia; ++h) kext += mix(0, h)->sectionExt(pp->wavelength()) * _state.numberDensity(m, h);
+    if (kext <= 0. || density <= 0.)
+    {
+        for (int k = 0; k != pp->numCompanions(); ++k) pp->applyCompanionBias(k, 0.);
+        return;
+    }
+
+    // calculate the column density of each medium component from the start of the path to the interaction point
+    ShortArray columnv(_numMedia);
+    double distance = pp->interactionDistance();
+    for (const auto& segment : pp->segments())
+    {
+        double ds = min(segment.ds(), distance - (segment.s() - segment.ds()));
+        if (ds <= 0.) break;
+        if (segment.m() >= 0)
+            for (int h = 0; h != _numMedia; ++h) columnv[h] += _state.numberDensity(segment.m(), h) * ds;
+    }
+
+    // adjust the weight of each companion by the ratio of the actual and sampled probability densities
+    for (int k = 0; k != pp->numCompanions(); ++k)
+    {
+        double lambda = pp->companionWavelength(k);
+        double ksca = 0.;
+        double tau = 0.;
+        for (int h = 0; h != _numMedia; ++h)
+        {
+            ksca += mix(0, h)->sectionSca(lambda) * _state.numberDensity(m, h);
+            tau += mix(0, h)->sectionExt(lambda) * columnv[h];
+        }
+        pp->applyCompanionBias(k, ksca * exp(-tau) / (density * kext));
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MediumSystem::setObservedOpticalDepths(PhotonPacket* pp, double distance) const
+{
+    EventCounters::count(EventCounters::ExtinctionCalls);
+
+    // determine the column density of each medium component along the path
+    ShortArray columnv(_numMedia);
+    auto generator = getPathSegmentGenerator(_grid, _serial, pp);
+    double s = 0.;
+    while (generator->next())
+    {
+        double ds = generator->ds();
+        int m = generator->m();
+        if (m >= 0)
+            for (int h = 0; h != _numMedia; ++h) columnv[h] += _state.numberDensity(m, h) * ds;
+        s += ds;
+        if (s > distance) break;
+    }
+
+    // calculate the optical depth for each wavelength
+    auto opticalDepth = [this, &columnv](double lambda) {
+        double tau = 0.;
+        for (int h = 0; h != _numMedia; ++h) tau += mix(0, h)->sectionExt(lambda) * columnv[h];
+        return tau;
+    };
+    for (int k = 0; k != pp->numCompanions(); ++k)
+        pp->setCompanionObservedOpticalDepth(k, opticalDepth(pp->companionWavelength(k)));
+    pp->setObservedOpticalDepth(opticalDepth(pp->wavelength()));
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MediumSystem::storeCompanionRadiationField(bool primary, const PhotonPacket* pp)
+{
+    ShortArray sectionv(_numMedia);
+    for (int k = 0; k != pp->numCompanions(); ++k)
+    {
+        // skip companions that fall outside of the radiation field wavelength grid or that carry no luminosity
+        double lambda = pp->companionWavelength(k);
+        int ell = _wavelengthGrid->bin(lambda);
+        double luminosity = pp->companionLuminosity(k);
+        if (ell < 0 || luminosity <= 0.) continue;
+
+        // accumulate the optical depth along the path and store the contribution for each segment
+        for (int h = 0; h != _numMedia; ++h) sectionv[h] = mix(0, h)->sectionExt(lambda);
+        double tau = 0.;
+        double lnExtBeg = 0.;  // extinction factor and its logarithm at begin of current segment
+        double extBeg = 1.;
+        for (const auto& segment : pp->segments())
+        {
+            int m = segment.m();
+            if (m >= 0)
+            {
+                for (int h = 0; h != _numMedia; ++h) tau += sectionv[h] * _state.numberDensity(m, h) * segment.ds();
+                double lnExtEnd = -tau;  // extinction factor and its logarithm at end of current segment
+                double extEnd = exp(lnExtEnd);
+                double extMean = SpecialFunctions::lnmean(extEnd, extBeg, lnExtEnd, lnExtBeg);
+                storeRadiationField(primary, m, ell, luminosity * extMean * segment.ds());
+                lnExtBeg = lnExtEnd;
+                extBeg = extEnd;
+            }
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+double MediumSystem::weightedPhaseFunctionValue(double lambda, int m, Direction bfkobs, PhotonPacket* pp) const
+{
+    double sum = 0.;
+    double ksca = 0.;
+    for (int h = 0; h != _numMedia; ++h)
+    {
+        double k = mix(0, h)->sectionSca(lambda) * _state.numberDensity(m, h);
+        if (k > 0.)
+        {
+            double I = 0., Q = 0., U = 0., V = 0.;
+            MaterialState mst(_state, m, h);
+            pp->setScatteringComponent(h);
+            mix(m, h)->peeloffScattering(I, Q, U, V, lambda, bfkobs, Direction(), &mst, pp);
+            sum += k * I;
+            ksca += k;
+        }
+    }
+    return ksca > 0. ? sum / ksca : 0.;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool MediumSystem::simulateLyaDiffusion(Random* random, PhotonPacket* pp, Direction& bfn, Vec& bfv)
+{
+    // verify that the cell hosting the interaction point contains only Lyman-alpha material
+    int m = pp->interactionCellIndex();
+    if (m < 0) return false;
+    int hLya = -1;
+    for (int h = 0; h != _numMedia; ++h)
+    {
+        if (_state.numberDensity(m, h) > 0.)
+        {
+            if (hLya >= 0 || !mix(m, h)->hasResonantScattering()) return false;
+            hLya = h;
+        }
+    }
+    if (hLya < 0) return false;
+
+    // determine the minimum sphere radius for reaching the threshold; the opacity is zero outside of the line core
+    double T = _state.temperature(m, hLya);
+    double nH = _state.numberDensity(m, hLya);
+    double opacity = LyaUtils::diffusionOpacity(perceivedWavelengthForScattering(pp), T, nH);
+    if (opacity <= 0.) return false;
+    double minRadius = _config->lyaDiffusionThreshold() / opacity;
+
+    // reject cells in which even a sphere with the same volume as the cell would not reach the threshold
+    if (_lyaMaxRadiusv[m] < minRadius) return false;
+
+    // estimate the radius of the largest sphere around the interaction point that fits inside the cell,
+    // giving up as soon as the estimate drops below the minimum radius
+    static const double d = 1. / sqrt(3.);
+    static const Direction directions[] = {
+        Direction(1., 0., 0., false), Direction(-1., 0., 0., false), Direction(0., 1., 0., false),
+        Direction(0., -1., 0., false), Direction(0., 0., 1., false), Direction(0., 0., -1., false),
+        Direction(d, d, d, false),     Direction(d, d, -d, false),   Direction(d, -d, d, false),
+        Direction(d, -d, -d, false),   Direction(-d, d, d, false),   Direction(-d, d, -d, false),
+        Direction(-d, -d, d, false),   Direction(-d, -d, -d, false)};
+    double radius = std::numeric_limits<double>::infinity();
+    for (const Direction& bfk : directions)
+    {
+        SpatialGridPath path(pp->position(), bfk);
+        auto generator = getPathSegmentGenerator(_grid, _serial, &path);
+        if (!generator->next() || generator->m() != m) return false;
+        radius = min(radius, 0.8 * generator->ds());
+        if (radius < minRadius) return false;
+    }
+
+    // move the photon packet to a random position on the surface of the sphere
+    bfn = random->direction();
+    bfv = _state.bulkVelocity(m);
+    pp->setDirection(bfn);
+    pp->propagate(radius);
+
+    // draw the new wavelength and direction from the analytical solution
+    double aTau0 = opacity * radius;
+    double lambda = LyaUtils::sampleDiffusionWavelength(T, aTau0, random);
+    pp->scatter(random->direction(bfn, sqrt(random->uniform())), bfv, lambda);
+    pp->setUnpolarized();
+
+    // update the statistics for the cell
+    LockFree::add(_lyaDiffusionStepv[m], 1.);
+    LockFree::add(_lyaDiffusionProductv[m], aTau0);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MediumSystem::logLyaDiffusionStatistics() const
+{
+    // sum the statistics over all processes
+    Array stepv = _lyaDiffusionStepv;
+    Array productv = _lyaDiffusionProductv;
+    ProcessManager::sumToAll(stepv);
+    ProcessManager::sumToAll(productv);
+
+    // log a summary
+    auto log = find<Log>();
+    double numSteps = stepv.sum();
+    int numCells = std::count_if(begin(stepv), end(stepv), [](double steps) { return steps > 0.; });
+    log->info("Lyman-alpha diffusion: " + StringUtils::toString(numSteps, 'g', 9) + " steps in "
+              + std::to_string(numCells) + " out of " + std::to_string(_numCells) + " cells");
+    if (numSteps > 0.)
+    {
+        int mmax = std::max_element(begin(stepv), end(stepv)) - begin(stepv);
+        log->info("  Mean a*tau0 per step: " + StringUtils::toString(productv.sum() / numSteps, 'g', 4));
+        log->info("  Largest number of steps in a single cell: " + StringUtils::toString(stepv[mmax], 'g', 9)
+                  + " in cell " + std::to_string(mmax));
+
+        // write the statistics for each cell with at least one step
+        TextOutFile file(this, "lyadiffusion", "Lyman-alpha diffusion statistics");
+        file.writeLine("# Lyman-alpha diffusion steps per spatial cell");
+        file.addColumn("spatial cell index", "", 'd');
+        file.addColumn("number of diffusion steps", "", 'd');
+        file.addColumn("mean a*tau0 per step", "", 'g', 4);
+        for (int m = 0; m != _numCells; ++m)
+            if (stepv[m] > 0.) file.writeRow(static_cast<double>(m), stepv[m], productv[m] / stepv[m]);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 void MediumSystem::clearRadiationField(bool primary)
 {
     if (primary)
@@ -1294,26 +1685,38 @@ void MediumSystem::clearRadiationField(bool primary)
 void MediumSystem::storeRadiationField(bool primary, int m, int ell, double Lds)
 {
     if (primary)
-        LockFree::add(_rf1(m, ell), Lds);
+        _rf1.add(m, ell, Lds);
     else
-        LockFree::add(_rf2c(m, ell), Lds);
+        _rf2c.add(m, ell, Lds);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 void MediumSystem::communicateRadiationField(bool primary)
 {
+    Tracer trace("communicate radiation field");
     if (primary)
-        ProcessManager::sumToAll(_rf1.data());
+        _rf1.sumToAll();
     else
     {
-        ProcessManager::sumToAll(_rf2c.data());
+        _rf2c.sumToAll();
         _rf2 = _rf2c;
     }
 }
 
 ////////////////////////////////////////////////////////////////////
 
+void MediumSystem::releaseRadiationField()
+{
+    size_t rfBytes = _rf1.allocatedBytes() + _rf2.allocatedBytes() + _rf2c.allocatedBytes();
+    _rf1 = RadiationFieldTable();
+    _rf2 = RadiationFieldTable();
+    _rf2c = RadiationFieldTable();
+    find<MemoryLedger>()->release("radiation field", rfBytes);
+}
+
+////////////////////////////////////////////////////////////////////
+
 std::pair<double, double> MediumSystem::totalDustAbsorbedLuminosity() const
 {
     auto log = find<Log>();
@@ -1381,6 +1784,112 @@ Array MediumSystem::meanIntensity(int m) const
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // returns a pseudo-random weight in the range [1,2) that depends only on the specified cell index
+    double cellWeight(int m)
+    {
+        uint64_t h = static_cast<uint64_t>(m) + 0x9E3779B97F4A7C15;
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EB;
+        h ^= h >> 31;
+        return 1. + static_cast<double>(h >> 11) / 9007199254740992.;
+    }
+
+    // number of values in the spatial grid signature
+    constexpr size_t gridSignatureSize = 10;
+
+    // returns a signature of the geometry of the specified spatial grid, consisting of the six coordinates of the
+    // bounding box, three sums over all cells of the cell centroid coordinates relative to the center of the
+    // bounding box (in units of its diagonal), each multiplied by a weight depending on the cell index, and the sum
+    // of these weights; because of the weights, a grid with mirrored or reordered cells produces a different
+    // signature even if the bounding box and the cell volumes are the same
+    Array gridSignature(const SpatialGrid* grid, int numCells)
+    {
+        Box box = grid->boundingBox();
+        Vec center = box.center();
+        double scale = box.widths().norm();
+        Array signature(gridSignatureSize);
+        signature[0] = box.xmin();
+        signature[1] = box.ymin();
+        signature[2] = box.zmin();
+        signature[3] = box.xmax();
+        signature[4] = box.ymax();
+        signature[5] = box.zmax();
+        for (int m = 0; m != numCells; ++m)
+        {
+            double w = cellWeight(m);
+            Vec r = grid->centralPositionInCell(m) - center;
+            signature[6] += w * r.x() / scale;
+            signature[7] += w * r.y() / scale;
+            signature[8] += w * r.z() / scale;
+            signature[9] += w;
+        }
+        return signature;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MediumSystem::writeCheckpoint(std::ostream& out) const
+{
+    // the sizes of the tables, so that they can be verified before overwriting any data
+    uint64_t sizes[4] = {_rf1.size(), _rf2.size(), _pdmsFingerprints.size(), _sdmsFingerprints.size()};
+    out.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+
+    // the signature of the spatial grid geometry, for the same reason
+    Array signature = gridSignature(_grid, _numCells);
+    out.write(reinterpret_cast<const char*>(begin(signature)), signature.size() * sizeof(double));
+
+    // the medium state, radiation field, and fingerprints
+    _state.write(out);
+    _rf1.write(out);
+    _rf2.write(out);
+    out.write(reinterpret_cast<const char*>(begin(_pdmsFingerprints)), _pdmsFingerprints.size() * sizeof(double));
+    out.write(reinterpret_cast<const char*>(begin(_sdmsFingerprints)), _sdmsFingerprints.size() * sizeof(double));
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool MediumSystem::readCheckpoint(std::istream& in)
+{
+    // verify the sizes of the tables and the medium state configuration
+    uint64_t sizes[4] = {0, 0, 0, 0};
+    in.read(reinterpret_cast<char*>(sizes), sizeof(sizes));
+    if (!in || sizes[0] != _rf1.size() || sizes[1] != _rf2.size() || sizes[2] != _pdmsFingerprints.size()
+        || sizes[3] != _sdmsFingerprints.size())
+        return false;
+
+    // verify the geometry of the spatial grid; the bounding box must match to within a small relative tolerance
+    // of its extent, and the weighted centroid sums to within a small relative tolerance of the sum of the weights
+    Array stored(gridSignatureSize);
+    in.read(reinterpret_cast<char*>(begin(stored)), stored.size() * sizeof(double));
+    if (!in) return false;
+    Array current = gridSignature(_grid, _numCells);
+    double boxScale = _grid->boundingBox().widths().norm();
+    for (size_t i = 0; i != 6; ++i)
+        if (abs(stored[i] - current[i]) > 1e-9 * boxScale) return false;
+    for (size_t i = 6; i != gridSignatureSize; ++i)
+        if (abs(stored[i] - current[i]) > 1e-9 * current[9]) return false;
+
+    // verify the medium state configuration and cell volumes, and read the medium state
+    if (!_state.read(in)) return false;
+
+    // the medium state has been verified and at least partially overwritten, so any further failure is fatal
+    if (!in || !_rf1.read(in) || !_rf2.read(in)) throw FATALERROR("Checkpoint file is corrupt or truncated");
+    in.read(reinterpret_cast<char*>(begin(_pdmsFingerprints)), _pdmsFingerprints.size() * sizeof(double));
+    in.read(reinterpret_cast<char*>(begin(_sdmsFingerprints)), _sdmsFingerprints.size() * sizeof(double));
+    if (!in) throw FATALERROR("Checkpoint file is corrupt or truncated");
+
+    // initialize the derived information
+    if (_rf2c.size()) _rf2c = _rf2;
+    if (_pdmsAccelerator) _pdmsAccelerator->reset();
+    if (_sdmsAccelerator) _sdmsAccelerator->reset();
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
 double MediumSystem::indicativeTemperature(int m, int h) const
 {
     // get the radiation field, if available
@@ -1497,6 +2006,7 @@ Array MediumSystem::lineEmissionSpectrum(int m, int h) const
 
 bool MediumSystem::updateDynamicStateRecipes()
 {
+    Tracer trace("update dynamic state recipes");
     auto log = find<Log>();
     auto parfac = find<ParallelFactory>();
     auto& recipes = dynamicStateOptions()->recipes();
@@ -1561,27 +2071,68 @@ bool MediumSystem::updateDynamicStateRecipes()
 
 bool MediumSystem::updateDynamicStateMedia(bool primary)
 {
+    Tracer trace(primary ? "update primary dynamic state media" : "update secondary dynamic state media");
     auto log = find<Log>();
     auto parfac = find<ParallelFactory>();
 
     // update status for each cell
     std::vector<UpdateStatus> flags(_numCells);
 
+    // determine whether the updated state should be extrapolated during this update cycle
+    NgAccelerator* accelerator = primary ? _pdmsAccelerator.get() : _sdmsAccelerator.get();
+    bool extrapolate = accelerator && accelerator->canExtrapolate();
+    std::atomic<int> numAccepted{0};
+    std::atomic<int> numRejected{0};
+
+    // determine whether to skip cells with an unchanged radiation field; the fingerprints for the cells
+    // updated during this cycle are collected in a separate array so that they can be combined across processes
+    Array& fingerprints = primary ? _pdmsFingerprints : _sdmsFingerprints;
+    bool skipUnchanged = fingerprints.size() > 0;
+    size_t numBands = skipUnchanged ? numFingerprintBands() : 0;
+    Array newFingerprints(fingerprints.size());
+    std::atomic<int> numSkipped{0};
+
+    // tell the material mixes that a new update cycle starts
+    for (int h : (primary ? _pdms_hv : _sdms_hv)) mix(0, h)->beginSpecificStateUpdate();
+
     // loop over the spatial cells in parallel
     log->info("Updating medium state for " + std::to_string(_numCells) + " cells...");
     log->infoSetElapsed(_numCells);
-    parfac->parallelDistributed()->call(_numCells, [this, primary, log, &flags](size_t firstIndex, size_t numIndices) {
+    parfac->parallelDistributed()->call(_numCells, [this, primary, log, &flags, accelerator, extrapolate, &numAccepted,
+                                                    &numRejected, &fingerprints, skipUnchanged, numBands,
+                                                    &newFingerprints,
+                                                    &numSkipped](size_t firstIndex, size_t numIndices) {
         while (numIndices)
         {
             size_t currentChunkSize = min(logProgressChunkSize, numIndices);
             for (size_t m = firstIndex; m != firstIndex + currentChunkSize; ++m)
             {
+                // skip the cell if its radiation field did not change significantly since its most recent update;
+                // the cell remains marked as not updated, which counts as converged
+                if (skipUnchanged)
+                {
+                    storeRadiationFieldFingerprint(m, newFingerprints, m * numBands);
+                    if (isFingerprintUnchanged(fingerprints, newFingerprints, m * numBands))
+                    {
+                        for (size_t b = 0; b != numBands; ++b) newFingerprints[m * numBands + b] = 0.;
+                        numSkipped++;
+                        continue;
+                    }
+                }
+
                 const Array& Jv = meanIntensity(m);
                 for (int h : (primary ? _pdms_hv : _sdms_hv))
                 {
                     MaterialState mst(_state, m, h);
                     flags[m].update(mix(m, h)->updateSpecificState(&mst, Jv));
                 }
+                if (extrapolate && flags[m].isUpdated())
+                {
+                    if (accelerator->extrapolate(_state, m))
+                        numAccepted++;
+                    else
+                        numRejected++;
+                }
             }
             log->infoIfElapsed("Updated medium state: ", currentChunkSize);
             firstIndex += currentChunkSize;
@@ -1593,13 +2144,55 @@ bool MediumSystem::updateDynamicStateMedia(bool primary)
     int numUpdated, numNotConverged;
     std::tie(numUpdated, numNotConverged) = _state.synchronize(flags);
 
+    // combine the fingerprints for the cells updated during this cycle across processes,
+    // and remember them as the reference for those cells
+    if (skipUnchanged)
+    {
+        ProcessManager::sumToAll(newFingerprints);
+        for (int m = 0; m != _numCells; ++m)
+        {
+            size_t offset = m * numBands;
+            bool stored = false;
+            for (size_t b = 0; b != numBands; ++b) stored |= newFingerprints[offset + b] > 0.;
+            if (stored)
+                for (size_t b = 0; b != numBands; ++b) fingerprints[offset + b] = newFingerprints[offset + b];
+        }
+    }
+
     // log statistics
+    if (skipUnchanged)
+    {
+        Array counts(1);
+        counts[0] = numSkipped;
+        ProcessManager::sumToAll(counts);
+        int numSkippedAll = static_cast<int>(counts[0]);
+        log->info("  Skipped cells: " + std::to_string(numSkippedAll) + " out of " + std::to_string(_numCells) + " ("
+                  + StringUtils::toString(100. * numSkippedAll / _numCells, 'f', 2)
+                  + " %) with unchanged radiation field");
+    }
     log->info("  Updated cells: " + std::to_string(numUpdated) + " out of " + std::to_string(_numCells) + " ("
               + StringUtils::toString(100. * numUpdated / _numCells, 'f', 2) + " %)");
     if (numNotConverged)
         log->info("  Not converged: " + std::to_string(numNotConverged) + " out of " + std::to_string(_numCells) + " ("
                   + StringUtils::toString(100. * numNotConverged / _numCells, 'f', 2) + " %)");
 
+    // record the synchronized state for future extrapolation and log acceleration statistics
+    if (accelerator)
+    {
+        if (extrapolate)
+        {
+            Array counts({static_cast<double>(numAccepted), static_cast<double>(numRejected)});
+            ProcessManager::sumToAll(counts);
+            log->info("  Extrapolated cells: " + std::to_string(static_cast<int>(counts[0])) + " out of "
+                      + std::to_string(numUpdated) + " updated cells (" + std::to_string(static_cast<int>(counts[1]))
+                      + " rejected)");
+        }
+        double change = accelerator->record(_state, extrapolate);
+        if (change > 0.)
+            log->info("  Mean relative change of accelerated state variables: "
+                      + StringUtils::toString(100. * change, 'f', 3) + " %");
+    }
+
     // calculate the new current aggregate state
     _state.calculateAggregate();
 
@@ -1616,6 +2209,45 @@ bool MediumSystem::updateDynamicStateMedia(bool primary)
 
 ////////////////////////////////////////////////////////////////////
 
+size_t MediumSystem::numFingerprintBands() const
+{
+    return min(static_cast<size_t>(4), static_cast<size_t>(_wavelengthGrid->numBins()));
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MediumSystem::storeRadiationFieldFingerprint(int m, Array& fingerprints, size_t offset) const
+{
+    // integrate the radiation field over bands with an equal number of wavelength bins;
+    // the constant conversion factor to mean intensity is omitted because only relative changes matter
+    size_t numWavelengths = _wavelengthGrid->numBins();
+    size_t numBands = numFingerprintBands();
+    for (size_t b = 0; b != numBands; ++b)
+    {
+        double sum = 0.;
+        for (size_t ell = b * numWavelengths / numBands; ell != (b + 1) * numWavelengths / numBands; ++ell)
+            sum += radiationField(m, ell);
+        fingerprints[offset + b] = sum;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool MediumSystem::isFingerprintUnchanged(const Array& previous, const Array& current, size_t offset) const
+{
+    size_t numBands = numFingerprintBands();
+    double total = 0.;
+    for (size_t b = 0; b != numBands; ++b) total += previous[offset + b];
+    if (total <= 0.) return false;
+
+    double tolerance = _config->dynamicStateUpdateTolerance() * total;
+    for (size_t b = 0; b != numBands; ++b)
+        if (std::abs(current[offset + b] - previous[offset + b]) > tolerance) return false;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
 void MediumSystem::beginDynamicMediumStateIteration()
 {
     _state.pushAggregate();
@@ -14,8 +14,11 @@
 #include "MaterialMix.hpp"
 #include "Medium.hpp"
 #include "MediumState.hpp"
+#include "MemoryLedger.hpp"
+#include "NgAccelerator.hpp"
 #include "PhotonPacketOptions.hpp"
 #include "RadiationFieldOptions.hpp"
+#include "RadiationFieldTable.hpp"
 #include "SamplingOptions.hpp"
 #include "SecondaryEmissionOptions.hpp"
 #include "SimulationItem.hpp"
@@ -123,7 +126,7 @@ class MediumSystem : public SimulationItem
 
         PROPERTY_ITEM(iterationOptions, IterationOptions, "the primary and/or secondary emission iteration options")
         ATTRIBUTE_DEFAULT_VALUE(iterationOptions, "IterationOptions")
-        ATTRIBUTE_RELEVANT_IF(iterationOptions, "IteratePrimary|IterateSecondary")
+        ATTRIBUTE_RELEVANT_IF(iterationOptions, "IteratePrimary|Emission")
 
         PROPERTY_ITEM(dustEmissionOptions, DustEmissionOptions, "the dust emission options")
         ATTRIBUTE_DEFAULT_VALUE(dustEmissionOptions, "DustEmissionOptions")
@@ -145,11 +148,20 @@ class MediumSystem : public SimulationItem
     //============= Construction - Setup - Destruction =============
 
 protected:
+    /** This function remembers the memory usage of the process before the media and the spatial
+        grid are set up, so that the memory allocated by them can be registered with the
+        simulation's MemoryLedger in setupSelfAfter(). */
+    void setupSelfBefore() override;
+
     /** This function calculates and stores initial state information for each spatial cell,
         including the cell volume and the number density for each medium as defined by the input
         model. If needed for the simulation's configuration, it also allocates one or two radiation
         field data tables that have a bin for each spatial cell in the simulation and for each bin
-        in the wavelength grid returned by the Configuration::radiationFieldWLG() function. */
+        in the wavelength grid returned by the Configuration::radiationFieldWLG() function.
+
+        The major allocations are registered with the simulation's MemoryLedger. If the radiation
+        field tables in double precision do not fit within the per-process memory budget, they are
+        allocated in single precision instead. */
     void setupSelfAfter() override;
 
     //=============== Overall medium configuration ===================
@@ -401,7 +413,9 @@ public:
         This function should be called only when scattering events cannot change the wavelength,
         i.e. the hasScatteringDispersion() function returns false for all material mixes in the
         simulation. In this case, a single consolidated peel-off photon packet can be sent to each
-        intrument. */
+        intrument. For a polychromatic photon packet, the weight of each companion wavelength in
+        the peel-off photon packet is multiplied by the opacity-weighted phase function value at
+        that wavelength. */
     void peelOffScattering(const ShortArray& wv, double lambda, Direction bfkobs, Direction bfky, PhotonPacket* pp,
                            PhotonPacket* ppp) const;
 
@@ -437,7 +451,12 @@ public:
 
         Performing the actual scattering event is delegated to the material mix corresponding to
         the selected medium component in the interaction cell. Refer to the
-        MaterialMix::performScattering() function for more information. */
+        MaterialMix::performScattering() function for more information.
+
+        For a polychromatic photon packet, the scattering direction is sampled at the reference
+        wavelength. The weight of each companion wavelength is subsequently multiplied by the ratio
+        of the opacity-weighted phase function values at the companion and reference wavelengths
+        for the sampled scattering angle. */
     void simulateScattering(Random* random, PhotonPacket* pp) const;
 
     /** This function calculates the cumulative extinction optical depth at the end of each path
@@ -605,6 +624,101 @@ public:
         any other photon packet properties such as polarization. */
     double getExtinctionOpticalDepth(const SpatialGridPath* path, double lambda, MaterialMix::MaterialType type) const;
 
+    //=============== Polychromatic photon packets ===================
+
+public:
+    /** This function adjusts the weights of the companion wavelengths of a polychromatic photon
+        packet that has just been forced to interact at the interaction point determined for its
+        reference wavelength (see PhotonPacketOptions). The photon packet must hold the path
+        segments and the interaction point, and the second argument specifies the probability
+        density per unit of reference optical depth with which the interaction point was sampled.
+
+        For a companion wavelength \f$\lambda_k\f$, the probability density per unit of distance
+        for scattering at the interaction point \f$s\f$ is given by \f$k_k^\text{sca}(s)\,
+        \mathrm{e}^{-\tau_k(s)}\f$, where \f$k_k^\text{sca}\f$ is the scattering opacity in the
+        interaction cell and \f$\tau_k(s)\f$ is the optical depth from the start of the path to
+        the interaction point at that wavelength. The interaction point has been sampled with a
+        probability density per unit of distance equal to \f$p_\text{ref}\,k_\text{ref}^\text{ext}\f$,
+        where \f$p_\text{ref}\f$ is the specified probability density per unit of reference
+        optical depth and \f$k_\text{ref}^\text{ext}\f$ is the extinction opacity at the reference
+        wavelength in the interaction cell. The weight of each companion is multiplied by the
+        ratio of these two probability densities. The optical depths \f$\tau_k(s)\f$ are
+        calculated from the column densities of the medium components along the path segments
+        stored in the photon packet, so that no further traversal of the spatial grid is needed.
+
+        This function assumes that all media have spatially constant cross sections and that
+        there are no kinematics. */
+    void biasCompanionsForInteraction(PhotonPacket* pp, double density) const;
+
+    /** This function calculates the extinction optical depth from the current position of the
+        specified polychromatic photon packet to the specified distance along its current
+        direction, both for the reference wavelength and for each of the companion wavelengths, and
+        stores the results in the photon packet as the "observed" optical depths. It is intended
+        for use by instruments to avoid traversing the spatial grid separately for each
+        wavelength.
+
+        The function determines the column density \f$N_h\f$ of each medium component along the
+        path through a single traversal of the spatial grid, and calculates the optical depth at
+        each wavelength as \f$\tau_k=\sum_h \varsigma_h^\text{ext}(\lambda_k)\,N_h\f$, where
+        \f$\varsigma_h^\text{ext}\f$ is the spatially constant extinction cross section of medium
+        component \f$h\f$. As for the getExtinctionOpticalDepth() function, the calculation
+        includes the complete path segment crossing the specified distance. */
+    void setObservedOpticalDepths(PhotonPacket* pp, double distance) const;
+
+    /** This function stores the contribution of the companion wavelengths of the specified
+        polychromatic photon packet to the radiation field in each of the spatial cells crossed by
+        its current path, which must have been calculated previously, in the same way as done for
+        the reference wavelength by the MonteCarloSimulation::storeRadiationField() function. The
+        optical depths at the companion wavelengths are calculated from the column densities of
+        the medium components along the path segments stored in the photon packet. */
+    void storeCompanionRadiationField(bool primary, const PhotonPacket* pp);
+
+private:
+    /** This function returns the value of the scattering phase function at wavelength
+        \f$\lambda\f$ for scattering from the current direction of the specified photon packet
+        into the specified direction in the spatial cell with index \f$m\f$, averaged over the
+        medium components with the scattering opacity of each component as weight. The phase
+        function is assumed to depend only on the scattering angle. The function returns zero if
+        none of the media scatter at the specified wavelength. */
+    double weightedPhaseFunctionValue(double lambda, int m, Direction bfkobs, PhotonPacket* pp) const;
+
+    //=============== Lyman-alpha diffusion ===================
+
+public:
+    /** This function attempts to replace the random walk of a Lyman-alpha photon packet inside an
+        optically thick spatial cell by a single diffusion step, as described for the LyaOptions
+        class. It should be called instead of simulateScattering() for each scattering event if
+        Lyman-alpha diffusion acceleration is enabled.
+
+        The function returns false without changing the photon packet if a diffusion step is not
+        appropriate, i.e. if the cell hosting the interaction point contains material other than
+        Lyman-alpha gas, if the photon packet wavelength perceived in the cell lies outside of the
+        line core, or if the product \f$a\tau_0\f$ for the largest sphere around the interaction
+        point that fits inside the cell is below the configured threshold. To reject cells that
+        cannot reach the threshold at constant cost, the function first evaluates \f$a\tau_0\f$
+        for a sphere with the same volume as the cell, whose radius (cached for each cell during
+        setup) is an upper limit for the radius of any sphere fitting inside the cell. If this
+        test passes, the radius of the sphere is estimated from the distances to the cell boundary
+        along the coordinate axes and the diagonals; for a planar boundary, the perpendicular
+        distance is at least 0.8 times the smallest of these distances.
+
+        Otherwise, the function moves the photon packet to a random position on the surface of
+        the sphere, assigns a new wavelength drawn from the analytical solution for a uniform
+        sphere (see LyaUtils::sampleDiffusionWavelength()), and assigns a new propagation
+        direction drawn from a distribution proportional to \f$\mu\f$, where \f$\mu\f$ is the
+        cosine of the angle with the outward surface normal. The photon packet becomes
+        unpolarized. The function stores the outward surface normal and the bulk velocity of the
+        cell in the \em bfn and \em bfv arguments, respectively, updates the diffusion statistics
+        for the cell, and returns true. */
+    bool simulateLyaDiffusion(Random* random, PhotonPacket* pp, Direction& bfn, Vec& bfv);
+
+    /** This function logs statistics on the Lyman-alpha diffusion steps performed so far, summed
+        over all processes, and writes a text file listing the number of diffusion steps and the
+        mean value of \f$a\tau_0\f$ for each spatial cell in which at least one diffusion step was
+        performed. The function should be called by all processes at the same time, and only if
+        Lyman-alpha diffusion acceleration is enabled. */
+    void logLyaDiffusionStatistics() const;
+
     //=============== Radiation field ===================
 
 public:
@@ -637,6 +751,13 @@ public:
         synchronized and its contents is copied into the stable secondary table. */
     void communicateRadiationField(bool primary);
 
+    /** This function releases the memory held by the radiation field tables and deregisters it
+        from the simulation's MemoryLedger. It should be called in serial code after the last
+        simulation segment and after the probes have been notified, when the radiation field is no
+        longer needed, so that the memory becomes available for writing the instrument output.
+        After this function has been called, the radiation field can no longer be queried. */
+    void releaseRadiationField();
+
     /** This function returns a pair of values specifying the bolometric luminosity absorbed by
         dust media across the complete domain of the spatial grid, respectively using the partial
         radiation field stored in the primary table and the stable secondary table. The bolometric
@@ -665,6 +786,30 @@ public:
         area, per unit of wavelength, and per unit of solid angle. */
     Array meanIntensity(int m) const;
 
+    //=============== Checkpointing ===================
+
+public:
+    /** This function writes the information needed to resume a simulation from the current point
+        to the specified output stream, which must have been opened in binary mode. This includes
+        the complete medium state, the primary and stable secondary radiation field tables, and the
+        radiation field fingerprints used to skip dynamic medium state updates for unchanged cells.
+        The history kept for accelerating the convergence of the dynamic medium state is not
+        included. */
+    void writeCheckpoint(std::ostream& out) const;
+
+    /** This function restores the information written by the writeCheckpoint() function from the
+        specified input stream, which must have been opened in binary mode. The stored information
+        must have been written for a simulation with the same spatial grid, media configuration,
+        and radiation field wavelength grid. The spatial grid is verified by comparing its bounding
+        box, a checksum of the cell centroids weighted by a pseudo-random function of the cell
+        index, and the volume of each cell. If any of this information does not match, the
+        function returns false without changing the medium state. If the stream cannot be read after the verification
+        succeeded, the function throws a fatal error. Otherwise, the function returns true. The
+        radiation field accumulated for the current secondary emission segment is set to the stable
+        secondary radiation field, and the history kept for accelerating the convergence of the
+        dynamic medium state is restarted. */
+    bool readCheckpoint(std::istream& in);
+
     //=============== Indicative temperature ===================
 
 public:
@@ -804,6 +949,23 @@ private:
         type. */
     bool updateDynamicStateMedia(bool primary);
 
+    /** This function stores a compact fingerprint of the radiation field in the spatial cell with
+        index \em m into the specified array, starting at the specified offset. The fingerprint
+        consists of the radiation field integrated over a small number of broad wavelength bands
+        (see numFingerprintBands()). */
+    void storeRadiationFieldFingerprint(int m, Array& fingerprints, size_t offset) const;
+
+    /** This function returns true if none of the band integrals in the current radiation field
+        fingerprint differs from the corresponding value in the previous fingerprint by more than
+        the configured tolerance times the total of the previous fingerprint, and false otherwise.
+        Both fingerprints are stored in the specified arrays at the specified offset. The function
+        returns false if the previous fingerprint is empty, i.e. if the cell has not yet been
+        updated. */
+    bool isFingerprintUnchanged(const Array& previous, const Array& current, size_t offset) const;
+
+    /** This function returns the number of wavelength bands in a radiation field fingerprint. */
+    size_t numFingerprintBands() const;
+
 public:
     /** This function shifts the current aggregate medium state to the previous aggregate medium
         state. It should be called at the start of each iteration step. */
@@ -840,6 +1002,8 @@ public:
 
 private:
     Configuration* _config{nullptr};
+    size_t _serial{0};               // a number identifying this medium system among those set up in this process
+    MemoryLedger::Mark _memoryMark;  // the memory usage before setting up the media (for memory accounting)
 
     // relevant for any simulation mode that includes a medium
     int _numCells{0};  // index m
@@ -855,15 +1019,30 @@ private:
     vector<int> _pdms_hv;  // a list of indices for media components with a primary dynamic medium state
     vector<int> _sdms_hv;  // a list of indices for media components with a secondary dynamic medium state
 
+    // relevant only if convergence of the dynamic medium state is accelerated (null pointer otherwise)
+    std::unique_ptr<NgAccelerator> _pdmsAccelerator;  // accelerator for primary dynamic medium state media
+    std::unique_ptr<NgAccelerator> _sdmsAccelerator;  // accelerator for secondary dynamic medium state media
+
+    // relevant only if dynamic medium state updates are skipped for cells with an unchanged radiation field
+    // - each array holds a radiation field fingerprint for each cell (indexed on m and band)
+    // - the fingerprint reflects the radiation field at the time of the most recent update of the cell
+    Array _pdmsFingerprints;  // fingerprints for primary dynamic medium state media
+    Array _sdmsFingerprints;  // fingerprints for secondary dynamic medium state media
+
+    // relevant only if Lyman-alpha diffusion acceleration is enabled (indexed on m)
+    Array _lyaDiffusionStepv;     // the number of diffusion steps performed in each cell
+    Array _lyaDiffusionProductv;  // the sum of a*tau0 over the diffusion steps performed in each cell
+    Array _lyaMaxRadiusv;         // the radius of a sphere with the same volume as each cell
+
     // relevant for any simulation mode that stores the radiation field
     WavelengthGrid* _wavelengthGrid{0};  // index ell
     // each radiation field table has an entry for each cell and each wavelength (indexed on m,ell)
     // - the sum of rf1 and rf2 represents the stable radiation field to be used as input for regular calculations
     // - rf2c serves as a target for storing the secondary radiation field so that rf1+rf2 remain available for
     //   calculating secondary emission spectra while already shooting photons through the grid
-    Table<2> _rf1;   // radiation field from primary sources
-    Table<2> _rf2;   // radiation field from secondary sources (copied from _rf2c at the appropriate time)
-    Table<2> _rf2c;  // radiation field currently being accumulated from secondary sources
+    RadiationFieldTable _rf1;   // radiation field from primary sources
+    RadiationFieldTable _rf2;   // radiation field from secondary sources (copied from _rf2c at the appropriate time)
+    RadiationFieldTable _rf2c;  // radiation field currently being accumulated from secondary sources
 
     // relevant for any simulation mode that includes dust emission
     int _numDustEmissionWavelengths{0};
@@ -0,0 +1,212 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "MemoryLedger.hpp"
+#include "FatalError.hpp"
+#include "Log.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////
+
+MemoryLedger::MemoryLedger(SimulationItem* parent)
+{
+    parent->addChild(this);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MemoryLedger::setBudget(size_t bytes)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _budget = bytes;
+}
+
+////////////////////////////////////////////////////////////////////
+
+size_t MemoryLedger::budget() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _budget;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool MemoryLedger::fits(size_t bytes) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return !_budget || System::currentMemoryUsage() + bytes <= _budget;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MemoryLedger::reserve(string category, size_t bytes)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    size_t resident = 0;
+    if (exceeds(bytes, resident))
+        fail("when allocating " + StringUtils::toMemSizeString(bytes) + " for " + category, resident);
+    add(category, bytes);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MemoryLedger::record(string category, size_t bytes)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    add(category, bytes);
+    size_t resident = 0;
+    if (exceeds(0, resident))
+        fail("after allocating " + StringUtils::toMemSizeString(bytes) + " for " + category, resident);
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool MemoryLedger::recordShared(string category, const void* object, size_t bytes)
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (!_shared.insert(object).second) return false;
+    }
+    record(category, bytes);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+MemoryLedger::Mark MemoryLedger::mark() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    Mark mark;
+    mark.resident = System::currentMemoryUsage();
+    mark.registered = _total;
+    return mark;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MemoryLedger::recordSince(string category, const Mark& mark)
+{
+    Mark now = this->mark();
+    size_t increase = now.resident > mark.resident ? now.resident - mark.resident : 0;
+    size_t registered = now.registered > mark.registered ? now.registered - mark.registered : 0;
+    record(category, increase > registered ? increase - registered : 0);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MemoryLedger::release(string category, size_t bytes)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    size_t& registered = _breakdown[category];
+    bytes = min(bytes, registered);
+    registered -= bytes;
+    _total -= bytes;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MemoryLedger::logBreakdown(string phrase) const
+{
+    auto log = find<Log>();
+    std::unique_lock<std::mutex> lock(_mutex);
+    log->info("Memory breakdown " + phrase + ":");
+    for (const string& line : describe(_breakdown, System::currentMemoryUsage(), "resident")) log->info(line);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MemoryLedger::logPeak() const
+{
+    auto log = find<Log>();
+    std::unique_lock<std::mutex> lock(_mutex);
+    log->info("Memory breakdown at peak registered usage:");
+    for (const string& line : describe(_peak, System::peakMemoryUsage(), "peak resident")) log->info(line);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MemoryLedger::verify(string phrase) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    size_t resident = 0;
+    if (exceeds(0, resident)) fail(phrase, resident);
+}
+
+////////////////////////////////////////////////////////////////////
+
+vector<string> MemoryLedger::describe(const std::map<string, size_t>& breakdown, size_t resident,
+                                      string resLabel) const
+{
+    // sort the categories in order of decreasing size, skipping empty categories
+    vector<std::pair<string, size_t>> categories;
+    size_t total = 0;
+    for (const auto& entry : breakdown)
+    {
+        if (entry.second)
+        {
+            categories.push_back(entry);
+            total += entry.second;
+        }
+    }
+    std::stable_sort(categories.begin(), categories.end(),
+                     [](const std::pair<string, size_t>& a, const std::pair<string, size_t>& b) {
+                         return a.second > b.second;
+                     });
+
+    // compose the lines
+    vector<string> lines;
+    for (const auto& category : categories)
+        lines.push_back("  " + category.first + ": " + StringUtils::toMemSizeString(category.second));
+    lines.push_back("  Total registered: " + StringUtils::toMemSizeString(total));
+    if (resident)
+    {
+        lines.push_back("  Total " + resLabel + ": " + StringUtils::toMemSizeString(resident)
+                        + " (not registered: " + StringUtils::toMemSizeString(resident > total ? resident - total : 0)
+                        + ")");
+    }
+    if (_budget)
+    {
+        lines.push_back("  Budget per process: " + StringUtils::toMemSizeString(_budget) + " ("
+                        + StringUtils::toString(100. * resident / _budget, 'f', 1) + "% used)");
+    }
+    return lines;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool MemoryLedger::exceeds(size_t bytes, size_t& resident) const
+{
+    // avoid querying the operating system when no budget is enforced, because this function is called on run-time paths
+    if (!_budget) return false;
+    resident = System::currentMemoryUsage();
+    return resident + bytes > _budget;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MemoryLedger::fail(string phrase, size_t resident) const
+{
+    string message = "Memory budget of " + StringUtils::toMemSizeString(_budget) + " per process exceeded " + phrase
+                     + "\nMemory breakdown at this point:";
+    for (const string& line : describe(_breakdown, resident, "resident")) message += "\n" + line;
+    throw FATALERROR(message);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MemoryLedger::add(string category, size_t bytes)
+{
+    _breakdown[category] += bytes;
+    _total += bytes;
+    if (_total > _peakTotal)
+    {
+        _peakTotal = _total;
+        _peak = _breakdown;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,176 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef MEMORYLEDGER_HPP
+#define MEMORYLEDGER_HPP
+
+#include "SimulationItem.hpp"
+#include <map>
+#include <mutex>
+#include <set>
+
+////////////////////////////////////////////////////////////////////
+
+/** A MemoryLedger object keeps track of the memory allocated by the major data structures in a
+    simulation, and optionally enforces a per-process memory budget. There is a single MemoryLedger
+    instance per simulation, held by the Simulation object and accessible to other simulation items
+    through the find<MemoryLedger>() function.
+
+    <b>Accounting</b>
+
+    Simulation items register their major allocations with the ledger, specifying a category name
+    (e.g. "medium state" or "instruments") and the number of bytes. Allocations with the same
+    category name are added together. Items for which the allocated memory cannot easily be
+    determined from the data structures (e.g., the spatial grid or imported snapshots) can instead
+    measure the increase in the resident memory of the process while they are being set up, from
+    which the allocations registered separately in the meantime are subtracted.
+    Allocations made during the run (e.g., growing thread-local buffers or caches filled while
+    updating the medium state) are registered when they happen, and data structures that are
+    freed or shrunk before the end of the simulation (e.g., the radiation field after the last
+    segment) release their registered memory. The ledger logs a breakdown of the registered
+    allocations per category at the end of setup and, at the end of the run, the breakdown at the
+    point where the registered total reached its maximum, which may thus differ from the former
+    both in total and in composition. The breakdown also lists the actual resident memory of the
+    process, so that the memory not accounted for by any of the registered categories (e.g., code,
+    small data structures, and heap fragmentation) can be estimated.
+
+    <b>Budget</b>
+
+    If a budget has been set by the user (usually through a command line option), the ledger
+    verifies that the resident memory of the process does not exceed the budget. The verification
+    is based on the actual resident memory rather than on the registered total, because the
+    registered allocations do not cover all memory used by the process. Simulation items that
+    offer more compact operating modes can call the fits() function before allocating a data
+    structure to determine whether a compact mode should be selected. The reserve() function,
+    called just before an allocation, and the record() function, called just after an
+    allocation, abort the simulation with a fatal error listing the breakdown if the allocation
+    would exceed or has exceeded the budget. This offers a clear diagnostic early in the
+    simulation rather than an out-of-memory condition halfway through the run.
+
+    All functions of this class are thread-safe. */
+class MemoryLedger : public SimulationItem
+{
+    //============= Construction - Setup - Destruction =============
+
+public:
+    /** This constructor creates a memory ledger that is hooked up as a child to the specified
+        parent in the simulation hierarchy, so that it will automatically be deleted. The setup()
+        function is \em not called by this constructor. Initially, no budget is set. */
+    explicit MemoryLedger(SimulationItem* parent);
+
+    //====================== Other Functions =======================
+
+public:
+    /** This function sets the per-process memory budget in bytes. A value of zero means that no
+        budget is enforced. */
+    void setBudget(size_t bytes);
+
+    /** This function returns the per-process memory budget in bytes, or zero if no budget is
+        enforced. */
+    size_t budget() const;
+
+    /** This function returns true if allocating the specified number of additional bytes would
+        keep the resident memory of the process within the budget, or if no budget is enforced,
+        and false otherwise. */
+    bool fits(size_t bytes) const;
+
+    /** This function should be called just before allocating the specified number of bytes for a
+        data structure in the specified category. If the allocation would cause the resident
+        memory of the process to exceed the budget, the function throws a fatal error. Otherwise,
+        it adds the allocation to the ledger. */
+    void reserve(string category, size_t bytes);
+
+    /** This function should be called just after allocating the specified number of bytes for a
+        data structure in the specified category. It adds the allocation to the ledger, and throws
+        a fatal error if the resident memory of the process now exceeds the budget. */
+    void record(string category, size_t bytes);
+
+    /** This function is similar to the record() function, but is intended for a data structure
+        that is shared between multiple simulation items (and possibly between simulations), and
+        that is identified by the specified address. The allocation is recorded only the first time
+        the function is called for a given address, in which case the function returns true.
+        Otherwise, the function does nothing and returns false. */
+    bool recordShared(string category, const void* object, size_t bytes);
+
+    /** An instance of this structure holds the resident memory of the process and the registered
+        total at a given point, as returned by the mark() function. */
+    struct Mark
+    {
+        size_t resident{0};
+        size_t registered{0};
+    };
+
+    /** This function returns the current resident memory of the process and the current
+        registered total, for later use with the recordSince() function. */
+    Mark mark() const;
+
+    /** This function records the increase in resident memory of the process since the specified
+        mark was obtained, using the record() function for the specified category. Allocations
+        registered with the ledger since the mark was obtained (e.g., by material mixes while the
+        media are being set up) are subtracted, so that they are not counted twice. The function is
+        intended for data structures for which the allocated memory cannot easily be determined
+        otherwise. Because memory may be allocated concurrently by other threads, the measurement
+        is approximate. */
+    void recordSince(string category, const Mark& mark);
+
+    /** This function subtracts the specified number of bytes from the allocations registered for
+        the specified category. It should be called when a registered data structure is released
+        before the end of the simulation. */
+    void release(string category, size_t bytes);
+
+    /** This function logs the current breakdown of the registered allocations per category, the
+        resident memory of the process, and the budget (if any). The specified phrase is included
+        in the heading (e.g. "at the end of setup"). */
+    void logBreakdown(string phrase) const;
+
+    /** This function logs the breakdown of the registered allocations at the point where the
+        registered total reached its maximum, in addition to the peak resident memory of the
+        process. */
+    void logPeak() const;
+
+    /** This function throws a fatal error if the current resident memory of the process exceeds
+        the budget. The specified phrase is included in the error message (e.g. "before primary
+        emission"). It can be called at convenient points in the simulation run, when no
+        allocations are being registered, to abort the simulation cleanly rather than risking
+        an out-of-memory condition at an unpredictable point. */
+    void verify(string phrase) const;
+
+private:
+    /** This function returns a list of text lines describing the specified breakdown, followed by
+        the specified resident memory and the budget (if any). */
+    vector<string> describe(const std::map<string, size_t>& breakdown, size_t resident, string resLabel) const;
+
+    /** This function returns true if a budget is enforced and allocating the specified number of
+        additional bytes would cause the current resident memory of the process to exceed the
+        budget, and false otherwise. If a budget is enforced, the current resident memory is stored
+        in the \em resident argument. The resident memory is not determined if no budget is
+        enforced, so that the function is inexpensive in that case. This function assumes that the
+        mutex is locked by the caller. */
+    bool exceeds(size_t bytes, size_t& resident) const;
+
+    /** This function throws a fatal error including the specified phrase, the specified resident
+        memory and the current breakdown in the error message. This function assumes that the mutex
+        is locked by the caller. */
+    void fail(string phrase, size_t resident) const;
+
+    /** This function adds the specified number of bytes to the specified category and updates the
+        peak breakdown if needed. This function assumes that the mutex is locked by the caller. */
+    void add(string category, size_t bytes);
+
+    //======================== Data Members ========================
+
+private:
+    size_t _budget{0};                    // the per-process budget in bytes, or zero if none
+    size_t _total{0};                     // the currently registered total in bytes
+    size_t _peakTotal{0};                 // the maximum registered total so far
+    std::map<string, size_t> _breakdown;  // the currently registered bytes per category
+    std::map<string, size_t> _peak;       // the registered bytes per category at the peak
+    std::set<const void*> _shared;        // the addresses of the shared data structures recorded so far
+    mutable std::mutex _mutex;            // the mutex guarding the data members
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
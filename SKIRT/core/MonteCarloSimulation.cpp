@@ -4,6 +4,9 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "MonteCarloSimulation.hpp"
+#include "EventCounters.hpp"
+#include "FatalError.hpp"
+#include "FilePaths.hpp"
 #include "Log.hpp"
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
@@ -13,19 +16,29 @@
 #include "ShortArray.hpp"
 #include "SpecialFunctions.hpp"
 #include "StringUtils.hpp"
+#include "System.hpp"
+#include "TextOutFile.hpp"
 #include "TimeLogger.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 
 ////////////////////////////////////////////////////////////////////
 
 void MonteCarloSimulation::setupSimulation()
 {
+    // construct the run predictor if needed
+    if (_config->predictionMode()) _predictor.reset(new RunPredictor);
+
     // perform regular setup for the hierarchy and wait for all processes to finish
+    startPredictionPhase();
     {
         TimeLogger logger(log(), "setup");
         _config->setup();  // first of all perform setup for the configuration object
         SimulationItem::setup();
         wait("setup");
     }
+    memoryLedger()->logBreakdown("at the end of setup");
 
     // write setup output
     {
@@ -34,6 +47,7 @@ void MonteCarloSimulation::setupSimulation()
         // notify the probe system
         probeSystem()->probeSetup();
     }
+    recordPredictionPhase("setup", 1., 1.);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -57,46 +71,95 @@ Configuration* MonteCarloSimulation::config() const
 
 void MonteCarloSimulation::runSimulation()
 {
+    // start counting events if requested, discarding any events counted during setup
+    if (_config->eventCountingMode()) EventCounters::enable(_instrumentSystem->instruments().size());
+
     // run the simulation
     {
         TimeLogger logger(log(), "the run");
 
+        // resume from a checkpoint if requested; re-observation cannot proceed without the restored medium state
+        if (!_config->restartFilename().empty() && !readCheckpoint(true) && _config->hasReobservation())
+            throw FATALERROR("Re-observation requires a checkpoint file that matches the simulation configuration");
+
         bool hasPrimaryLuminosity = sourceSystem()->luminosity() > 0.;
 
+        // special case of re-observing a converged medium state without iterating
+        if (_config->hasReobservation())
+        {
+            if (!hasConvergedCheckpoint())
+                log()->warning("The checkpoint was written before all iterations completed; "
+                               "the re-observed medium state may not have converged");
+            log()->info(string("Re-observing the restored medium state ")
+                        + (_config->hasDirectReobservation() ? "for direct emission only" : "including scattering"));
+            runPrimaryEmission();
+            if (_config->hasSecondaryEmission()) runSecondaryEmission();
+        }
+
         // special case of merged primary and secondary iterations
-        if (_config->hasMergedIterations() && hasPrimaryLuminosity)
+        else if (_config->hasMergedIterations() && hasPrimaryLuminosity)
         {
-            if (_config->hasPrimaryIterations()) runPrimaryEmissionIterations();
-            runMergedEmissionIterations();
+            if (_config->hasPrimaryIterations() && !hasCompletedIterations(IterationPhase::Primary))
+                runPrimaryEmissionIterations();
+            if (!hasCompletedIterations(IterationPhase::Merged)) runMergedEmissionIterations();
             runPrimaryEmission();
+            if (_config->writeCheckpoints()) writeCheckpoint(IterationPhase::PrimaryEmission, 0, true, 0.);
             runSecondaryEmission();
         }
         else
         {
             // primary emission phase, possibly with dynamic medium state iterations
-            if (_config->hasPrimaryIterations() && hasPrimaryLuminosity) runPrimaryEmissionIterations();
+            if (_config->hasPrimaryIterations() && hasPrimaryLuminosity
+                && !hasCompletedIterations(IterationPhase::Primary))
+                runPrimaryEmissionIterations();
             runPrimaryEmission();
 
             // optional secondary emission phase, possibly with dynamic secondary emission iterations
             if (_config->hasSecondaryEmission())
             {
-                if (_config->hasSecondaryIterations()) runSecondaryEmissionIterations();
+                // the primary emission segment has replaced the radiation field and the secondary dynamic medium state,
+                // so restore them again when resuming from a checkpoint written during the secondary iterations;
+                // otherwise record them so that the secondary emission can be re-observed later on
+                if (_restartPhase == IterationPhase::Secondary)
+                    readCheckpoint(false);
+                else if (_config->writeCheckpoints())
+                    writeCheckpoint(IterationPhase::PrimaryEmission, 0, true, 0.);
+
+                if (_config->hasSecondaryIterations() && !hasCompletedIterations(IterationPhase::Secondary))
+                    runSecondaryEmissionIterations();
                 runSecondaryEmission();
             }
         }
     }
 
     // write final output
+    startPredictionPhase();
     {
         TimeLogger logger(log(), "final output");
 
         // notify the probe system
         probeSystem()->probeRun();
 
+        // release the radiation field, which is no longer needed, before writing instrument output
+        if (_config->hasRadiationField()) mediumSystem()->releaseRadiationField();
+
+        // release the per-thread caches used for launching secondary photon packets
+        if (_secondarySourceSystem) _secondarySourceSystem->releaseCaches();
+
         // write instrument output
         instrumentSystem()->flush();
         instrumentSystem()->write();
     }
+    recordPredictionPhase("final output", 1., 1.);
+
+    // write the run prediction
+    if (_predictor) _predictor->write(this);
+
+    // write the event statistics
+    writeEventCounters();
+
+    // log the memory breakdown at peak usage
+    memoryLedger()->logPeak();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -104,10 +167,13 @@ void MonteCarloSimulation::runSimulation()
 void MonteCarloSimulation::runPrimaryEmission()
 {
     string segment = "primary emission";
+    memoryLedger()->verify("before " + segment);
     TimeLogger logger(log(), segment);
+    startPredictionPhase();
 
-    // clear the radiation field
-    if (_config->hasRadiationField()) mediumSystem()->clearRadiationField(true);
+    // clear the radiation field, unless we re-observe the radiation field restored from a checkpoint
+    bool storeRF = _config->hasRadiationField() && !_config->hasReobservation();
+    if (storeRF) mediumSystem()->clearRadiationField(true);
 
     // shoot photons from primary sources, if needed
     size_t Npp = _config->numPrimaryPackets();
@@ -124,17 +190,26 @@ void MonteCarloSimulation::runPrimaryEmission()
         initProgress(segment, Npp);
         sourceSystem()->prepareForLaunch(Npp);
         auto parallel = find<ParallelFactory>()->parallelDistributed();
-        parallel->call(
-            Npp, [this](size_t i, size_t n) { performLifeCycle(i, n, true, true, _config->hasRadiationField()); });
+        parallel->call(Npp, [this, storeRF](size_t i, size_t n) { performLifeCycle(i, n, true, true, storeRF); });
         instrumentSystem()->flush();
+        sourceSystem()->finishLaunch();
     }
 
     // wait for all processes to finish and synchronize the radiation field
     wait(segment);
-    if (_config->hasRadiationField()) mediumSystem()->communicateRadiationField(true);
+    recordEventCounters(segment);
+    if (_config->hasLyaDiffusion()) mediumSystem()->logLyaDiffusionStatistics();
+    if (storeRF) mediumSystem()->communicateRadiationField(true);
+    double factor = _config->predictionPacketsFactor();
+    recordPredictionPhase(segment, factor, factor, storeRF);
 
     // update secondary dynamic medium state if applicable (in which case we have a medium system)
-    if (_config->hasSecondaryDynamicState()) mediumSystem()->updateSecondaryDynamicMediumState();
+    if (_config->hasSecondaryDynamicState())
+    {
+        startPredictionPhase();
+        mediumSystem()->updateSecondaryDynamicMediumState();
+        recordPredictionPhase("secondary dynamic medium state update", 1., 1.);
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -142,11 +217,14 @@ void MonteCarloSimulation::runPrimaryEmission()
 void MonteCarloSimulation::runSecondaryEmission()
 {
     string segment = "secondary emission";
+    memoryLedger()->verify("before " + segment);
     TimeLogger logger(log(), segment);
+    startPredictionPhase();
 
     // determine whether we need to store the radiation field during secondary emission
+    // (never when re-observing the radiation field restored from a checkpoint)
     // if so, clear the secondary radiation field
-    bool storeRF = _config->storeEmissionRadiationField();
+    bool storeRF = _config->storeEmissionRadiationField() && !_config->hasReobservation();
     if (storeRF) mediumSystem()->clearRadiationField(false);
 
     // shoot photons from secondary sources, if needed
@@ -169,7 +247,10 @@ void MonteCarloSimulation::runSecondaryEmission()
 
     // wait for all processes to finish and synchronize the radiation field if needed
     wait(segment);
+    recordEventCounters(segment);
     if (storeRF) mediumSystem()->communicateRadiationField(false);
+    double factor = _config->predictionPacketsFactor();
+    recordPredictionPhase(segment, factor, factor, storeRF);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -182,6 +263,12 @@ namespace
         double _prevLabsseco{0.};  // remembers the absorbed luminosity in the previous iteration
 
     public:
+        // the constructor optionally receives the absorbed luminosity in the previous iteration
+        explicit DustAbsorptionConvergence(double prevLabsseco = 0.) : _prevLabsseco{prevLabsseco} {}
+
+        // returns the absorbed luminosity in the most recent iteration
+        double previousLuminosity() const { return _prevLabsseco; }
+
         // this function determines and logs the total absorbed luminosity and related percentages
         // it returns true if secondary emission can be considered to be converged, false otherwise
         bool logConvergenceInfo(Log* log, Units* units, MediumSystem* mediumSystem, int iter, double fractionOfPrimary,
@@ -282,8 +369,17 @@ void MonteCarloSimulation::runPrimaryEmissionIterations()
     // track the previous iteration packet count to avoid redundant prepareForLaunch calls
     size_t prevNpp = 0;
 
-    // loop over the dynamic state iterations
-    int iter = 0;
+    // in prediction mode, this function returns the factor for extrapolating the packet segment of a single pilot
+    // iteration to the specified number of iterations in the full run, taking into account the packet ramp
+    auto predictionFactor = [this, minNpp, maxNpp, ramp](int numIters) {
+        double factor = _config->predictionPacketsFactor();
+        double numTotal = 0.;
+        for (int i = 1; i <= numIters; ++i) numTotal += min(factor * maxNpp, factor * minNpp * std::pow(ramp, i - 1));
+        return numTotal / min(maxNpp, minNpp);
+    };
+
+    // loop over the dynamic state iterations, possibly resuming from a checkpoint
+    int iter = _restartPhase == IterationPhase::Primary ? _restartIteration : 0;
     while (true)
     {
         ++iter;
@@ -305,6 +401,7 @@ void MonteCarloSimulation::runPrimaryEmissionIterations()
             TimeLogger logger(log(), segment);
 
             mediumSystem()->beginDynamicMediumStateIteration();
+            startPredictionPhase();
 
             // clear the radiation field
             mediumSystem()->clearRadiationField(true);
@@ -313,20 +410,30 @@ void MonteCarloSimulation::runPrimaryEmissionIterations()
             initProgress(segment, Npp);
             parallel->call(Npp, [this](size_t i, size_t n) { performLifeCycle(i, n, true, false, true); });
             instrumentSystem()->flush();
+            sourceSystem()->finishLaunch();
 
             // wait for all processes to finish and synchronize the radiation field
             wait(segment);
+            recordEventCounters(segment);
             mediumSystem()->communicateRadiationField(true);
+            recordPredictionPhase("primary emission iterations",
+                                  predictionFactor(_config->predictionMinPrimaryIterations()),
+                                  predictionFactor(_config->predictionMaxPrimaryIterations()), true);
 
             // update the primary dynamic medium state and log convergence info
+            startPredictionPhase();
             converged = mediumSystem()->updatePrimaryDynamicMediumState();
+            recordPredictionPhase("primary dynamic medium state updates", _config->predictionMinPrimaryIterations(),
+                                  _config->predictionMaxPrimaryIterations());
         }
 
         // notify the probe system
         probeSystem()->probePrimary(iter);
 
-        // verify and log loop convergence
-        if (logLoopConvergence(log(), converged, iter, minIters, maxIters)) break;
+        // verify and log loop convergence, and write a checkpoint if requested
+        bool finished = logLoopConvergence(log(), converged, iter, minIters, maxIters);
+        if (_config->writeCheckpoints()) writeCheckpoint(IterationPhase::Primary, iter, finished, 0.);
+        if (finished) break;
     }
 }
 
@@ -349,11 +456,17 @@ void MonteCarloSimulation::runSecondaryEmissionIterations()
     double fractionOfPrimary = _config->maxFractionOfPrimary();
     double fractionOfPrevious = _config->maxFractionOfPrevious();
 
-    // helper object to verify convergence of secondary emission
-    DustAbsorptionConvergence dustConvergence;
+    // in prediction mode, the factors for extrapolating a single pilot iteration to the full run
+    double minIterFactor = _config->predictionMinSecondaryIterations();
+    double maxIterFactor = _config->predictionMaxSecondaryIterations();
+    double packetsFactor = _config->predictionPacketsFactor();
+
+    // helper object to verify convergence of secondary emission, and iteration counter, possibly from a checkpoint
+    bool resume = _restartPhase == IterationPhase::Secondary;
+    DustAbsorptionConvergence dustConvergence(resume ? _restartLabsseco : 0.);
+    int iter = resume ? _restartIteration : 0;
 
     // loop over the secondary emission iterations
-    int iter = 0;
     while (true)
     {
         ++iter;
@@ -364,6 +477,7 @@ void MonteCarloSimulation::runSecondaryEmissionIterations()
             TimeLogger logger(log(), segment);
 
             mediumSystem()->beginDynamicMediumStateIteration();
+            startPredictionPhase();
 
             // clear the secondary radiation field
             mediumSystem()->clearRadiationField(false);
@@ -383,22 +497,30 @@ void MonteCarloSimulation::runSecondaryEmissionIterations()
 
             // wait for all processes to finish and synchronize the radiation field
             wait(segment);
+            recordEventCounters(segment);
             mediumSystem()->communicateRadiationField(false);
+            recordPredictionPhase("secondary emission iterations", packetsFactor * minIterFactor,
+                                  packetsFactor * maxIterFactor, true);
 
             // update secondary dynamic medium state and log convergence info
+            startPredictionPhase();
             converged &= mediumSystem()->updateSecondaryDynamicMediumState();
 
             // log dust emission convergence info
             if (mediumSystem()->hasDust())
                 converged &= dustConvergence.logConvergenceInfo(log(), units(), mediumSystem(), iter, fractionOfPrimary,
                                                                 fractionOfPrevious);
+            recordPredictionPhase("secondary dynamic medium state updates", minIterFactor, maxIterFactor);
         }
 
         // notify the probe system
         probeSystem()->probeSecondary(iter);
 
-        // verify and log loop convergence
-        if (logLoopConvergence(log(), converged, iter, minIters, maxIters)) break;
+        // verify and log loop convergence, and write a checkpoint if requested
+        bool finished = logLoopConvergence(log(), converged, iter, minIters, maxIters);
+        if (_config->writeCheckpoints())
+            writeCheckpoint(IterationPhase::Secondary, iter, finished, dustConvergence.previousLuminosity());
+        if (finished) break;
     }
 }
 
@@ -422,14 +544,20 @@ void MonteCarloSimulation::runMergedEmissionIterations()
     double fractionOfPrimary = _config->maxFractionOfPrimary();
     double fractionOfPrevious = _config->maxFractionOfPrevious();
 
+    // in prediction mode, the factors for extrapolating a single pilot iteration to the full run
+    double minIterFactor = _config->predictionMinSecondaryIterations();
+    double maxIterFactor = _config->predictionMaxSecondaryIterations();
+    double packetsFactor = _config->predictionPacketsFactor();
+
     // prepare the primary source system for the appropriate number of packets
     sourceSystem()->prepareForLaunch(Npp1);
 
-    // helper object to verify convergence of secondary emission
-    DustAbsorptionConvergence dustConvergence;
+    // helper object to verify convergence of secondary emission, and iteration counter, possibly from a checkpoint
+    bool resume = _restartPhase == IterationPhase::Merged;
+    DustAbsorptionConvergence dustConvergence(resume ? _restartLabsseco : 0.);
+    int iter = resume ? _restartIteration : 0;
 
     // loop over the merged iterations
-    int iter = 0;
     while (true)
     {
         ++iter;
@@ -442,6 +570,7 @@ void MonteCarloSimulation::runMergedEmissionIterations()
             TimeLogger logger(log(), segment);
 
             mediumSystem()->beginDynamicMediumStateIteration();
+            startPredictionPhase();
 
             // clear the radiation field
             mediumSystem()->clearRadiationField(true);
@@ -450,13 +579,20 @@ void MonteCarloSimulation::runMergedEmissionIterations()
             initProgress(segment1, Npp1);
             parallel->call(Npp1, [this](size_t i, size_t n) { performLifeCycle(i, n, true, false, true); });
             instrumentSystem()->flush();
+            sourceSystem()->finishLaunch();
 
             // wait for all processes to finish and synchronize the radiation field
             wait(segment1);
+            recordEventCounters(segment1);
             mediumSystem()->communicateRadiationField(true);
+            recordPredictionPhase("merged primary emission iterations", packetsFactor * minIterFactor,
+                                  packetsFactor * maxIterFactor, true);
 
             // update secondary dynamic medium state and log convergence info
+            startPredictionPhase();
             converged &= mediumSystem()->updateSecondaryDynamicMediumState();
+            recordPredictionPhase("secondary dynamic medium state updates", minIterFactor, maxIterFactor);
+            startPredictionPhase();
 
             // clear the secondary radiation field
             mediumSystem()->clearRadiationField(false);
@@ -476,27 +612,183 @@ void MonteCarloSimulation::runMergedEmissionIterations()
 
             // wait for all processes to finish and synchronize the radiation field
             wait(segment2);
+            recordEventCounters(segment2);
             mediumSystem()->communicateRadiationField(false);
+            recordPredictionPhase("merged secondary emission iterations", packetsFactor * minIterFactor,
+                                  packetsFactor * maxIterFactor, true);
 
             // update the primary dynamic medium state and log convergence info
+            startPredictionPhase();
             converged &= mediumSystem()->updatePrimaryDynamicMediumState();
 
             // log dust emission convergence info
             if (mediumSystem()->hasDust())
                 converged &= dustConvergence.logConvergenceInfo(log(), units(), mediumSystem(), iter, fractionOfPrimary,
                                                                 fractionOfPrevious);
+            recordPredictionPhase("primary dynamic medium state updates", minIterFactor, maxIterFactor);
         }
 
         // notify the probe system
         probeSystem()->probeSecondary(iter);
 
-        // verify and log loop convergence
-        if (logLoopConvergence(log(), converged, iter, minIters, maxIters)) break;
+        // verify and log loop convergence, and write a checkpoint if requested
+        bool finished = logLoopConvergence(log(), converged, iter, minIters, maxIters);
+        if (_config->writeCheckpoints())
+            writeCheckpoint(IterationPhase::Merged, iter, finished, dustConvergence.previousLuminosity());
+        if (finished) break;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the identifying header and the format version of a checkpoint file
+    const char checkpointTag[] = "SKIRT-CHECKPOINT";
+    const size_t checkpointTagLength = sizeof(checkpointTag) - 1;
+    const uint64_t checkpointVersion = 2;
+
+    // the maximum length of the random generator state representation accepted from a checkpoint file
+    const uint64_t maxGeneratorStateLength = 1 << 16;
+
+    // returns a human-readable name for the specified iteration phase
+    string phaseName(int phase)
+    {
+        switch (phase)
+        {
+            case 1: return "primary emission";
+            case 2: return "secondary emission";
+            case 3: return "merged primary and secondary emission";
+            case 4: return "final primary emission";
+        }
+        return "unknown";
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MonteCarloSimulation::writeCheckpoint(IterationPhase phase, int iter, bool finished, double Labsseco)
+{
+    // all processes share the same medium state and radiation field, so only the root process writes the checkpoint
+    if (!ProcessManager::isRoot()) return;
+
+    // write the checkpoint to a temporary file, so that the previous checkpoint survives an interrupted write
+    string filepath = filePaths()->output("checkpoint.dat");
+    string temppath = filepath + ".tmp";
+    string progress = phase == IterationPhase::PrimaryEmission ? " segment" : " iteration " + std::to_string(iter);
+    log()->info("Writing checkpoint after " + phaseName(static_cast<int>(phase)) + progress + " to " + filepath
+                + "...");
+    {
+        std::ofstream out = System::ofstream(temppath, false, true);
+        if (!out) throw FATALERROR("Could not open the checkpoint file " + temppath);
+
+        // the header with the iteration progress and the state of the random generator for this thread
+        uint64_t header[4] = {checkpointVersion, static_cast<uint64_t>(phase), static_cast<uint64_t>(iter),
+                              static_cast<uint64_t>(finished)};
+        string state = random()->generatorState();
+        uint64_t stateLength = state.size();
+        out.write(checkpointTag, checkpointTagLength);
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(&Labsseco), sizeof(Labsseco));
+        out.write(reinterpret_cast<const char*>(&stateLength), sizeof(stateLength));
+        out.write(state.data(), stateLength);
+
+        // the medium state and the radiation field
+        mediumSystem()->writeCheckpoint(out);
+        if (!out) throw FATALERROR("Could not write the checkpoint file " + temppath);
+    }
+
+    // replace the previous checkpoint
+    if (std::rename(temppath.c_str(), filepath.c_str()))
+    {
+        System::removeFile(filepath);
+        if (std::rename(temppath.c_str(), filepath.c_str()))
+            throw FATALERROR("Could not rename the checkpoint file " + temppath + " to " + filepath);
     }
 }
 
 ////////////////////////////////////////////////////////////////////
 
+bool MonteCarloSimulation::readCheckpoint(bool restoreRandom)
+{
+    // re-observation cannot start from scratch, so the caller reports a fatal error instead
+    string fallback = _config->hasReobservation() ? "" : "; starting from scratch";
+    string filepath = filePaths()->input(_config->restartFilename());
+    if (!System::isFile(filepath))
+    {
+        log()->warning("Checkpoint file " + filepath + " does not exist" + fallback);
+        return false;
+    }
+    log()->info("Reading checkpoint from " + filepath + "...");
+    std::ifstream in = System::ifstream(filepath, true);
+
+    // read and verify the header
+    char tag[checkpointTagLength];
+    uint64_t header[4] = {0, 0, 0, 0};
+    double Labsseco = 0.;
+    uint64_t stateLength = 0;
+    in.read(tag, checkpointTagLength);
+    in.read(reinterpret_cast<char*>(header), sizeof(header));
+    in.read(reinterpret_cast<char*>(&Labsseco), sizeof(Labsseco));
+    in.read(reinterpret_cast<char*>(&stateLength), sizeof(stateLength));
+    if (!in || std::memcmp(tag, checkpointTag, checkpointTagLength) || header[0] != checkpointVersion
+        || header[1] < 1 || header[1] > 4 || stateLength > maxGeneratorStateLength)
+    {
+        log()->warning("File " + filepath + " is not a valid checkpoint file" + fallback);
+        return false;
+    }
+    string state(stateLength, ' ');
+    in.read(&state[0], stateLength);
+
+    // restore the medium state and the radiation field
+    if (!in || !mediumSystem()->readCheckpoint(in))
+    {
+        log()->warning("Checkpoint file " + filepath + " does not match the spatial grid or medium configuration"
+                       + fallback);
+        return false;
+    }
+
+    // restore the random generator state and the iteration progress
+    if (restoreRandom && !random()->setGeneratorState(state))
+        log()->warning("Could not restore the random generator state from the checkpoint");
+    _restartPhase = static_cast<IterationPhase>(header[1]);
+    _restartIteration = static_cast<int>(header[2]);
+    _restartFinished = header[3] != 0;
+    _restartLabsseco = Labsseco;
+    if (_restartPhase == IterationPhase::PrimaryEmission)
+        log()->info("Resuming after the final primary emission segment (iterations completed)");
+    else
+        log()->info("Resuming " + phaseName(static_cast<int>(header[1])) + " iterations after iteration "
+                    + std::to_string(_restartIteration) + (_restartFinished ? " (iterations completed)" : ""));
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool MonteCarloSimulation::hasCompletedIterations(IterationPhase phase) const
+{
+    if (_restartPhase == IterationPhase::None) return false;
+    if (_restartPhase == phase) return _restartFinished;
+
+    // the final primary emission segment follows the primary and merged iterations but precedes secondary iterations
+    if (_restartPhase == IterationPhase::PrimaryEmission) return phase != IterationPhase::Secondary;
+
+    // primary emission iterations always precede the other iteration phases
+    return phase == IterationPhase::Primary;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool MonteCarloSimulation::hasConvergedCheckpoint() const
+{
+    if (_config->hasPrimaryIterations() && !hasCompletedIterations(IterationPhase::Primary)) return false;
+    if (_config->hasMergedIterations()) return hasCompletedIterations(IterationPhase::Merged);
+    if (_config->hasSecondaryIterations()) return hasCompletedIterations(IterationPhase::Secondary);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
 void MonteCarloSimulation::wait(std::string scope)
 {
     if (ProcessManager::isMultiProc())
@@ -508,6 +800,94 @@ void MonteCarloSimulation::wait(std::string scope)
 
 ////////////////////////////////////////////////////////////////////
 
+void MonteCarloSimulation::startPredictionPhase()
+{
+    if (_predictor) _predictor->start();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MonteCarloSimulation::recordPredictionPhase(string phase, double minFactor, double maxFactor, bool communicated)
+{
+    if (_predictor)
+    {
+        double bytes = communicated ? static_cast<double>(mediumSystem()->numCells())
+                                          * _config->radiationFieldWLG()->numBins() * sizeof(double)
+                                    : 0.;
+        _predictor->record(phase, minFactor, maxFactor, bytes);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MonteCarloSimulation::recordEventCounters(string segment)
+{
+    if (_config->eventCountingMode())
+    {
+        // sum the counters over all threads and processes
+        vector<size_t> counters = EventCounters::collect();
+        Array counts(counters.size());
+        for (size_t i = 0; i != counters.size(); ++i) counts[i] = counters[i];
+        ProcessManager::sumToAll(counts);
+        _eventCounts.emplace_back(segment, counts);
+
+        // log a summary
+        double numPackets = counts[EventCounters::PhotonPackets];
+        double numPaths = counts[EventCounters::Paths];
+        log()->info("Counted " + StringUtils::toString(numPackets) + " " + segment + " photon packets with "
+                    + StringUtils::toString(numPackets ? counts[EventCounters::Scatterings] / numPackets : 0., 'f', 2)
+                    + " scattering events per packet and "
+                    + StringUtils::toString(numPaths ? counts[EventCounters::PathSegments] / numPaths : 0., 'f', 1)
+                    + " segments per path");
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MonteCarloSimulation::writeEventCounters()
+{
+    if (_config->eventCountingMode())
+    {
+        EventCounters::disable();
+
+        TextOutFile out(this, "eventcounts", "event statistics");
+        if (_config->hasMedium())
+            out.writeLine("# Spatial grid type: " + mediumSystem()->grid()->type());
+        for (size_t k = 0; k != _eventCounts.size(); ++k)
+            out.writeLine("# Segment " + std::to_string(k + 1) + ": " + _eventCounts[k].first);
+        out.addColumn("segment index", "", 'd');
+        out.addColumn("photon packets launched", "", 'd');
+        out.addColumn("paths through the spatial grid", "", 'd');
+        out.addColumn("path segments", "", 'd');
+        out.addColumn("mean number of segments per path", "", 'f', 2);
+        out.addColumn("scattering events", "", 'd');
+        out.addColumn("mean number of scattering events per packet", "", 'f', 3);
+        out.addColumn("photon packet extinction calculations", "", 'd');
+        out.addColumn("photon packet extinction calculations ending early", "", 'd');
+        out.addColumn("photon packets terminated by weight", "", 'd');
+        out.addColumn("lock-free addition retries", "", 'd');
+        for (Instrument* instrument : _instrumentSystem->instruments())
+            out.addColumn("peel-offs to instrument " + instrument->instrumentName(), "", 'd');
+
+        for (size_t k = 0; k != _eventCounts.size(); ++k)
+        {
+            const Array& counts = _eventCounts[k].second;
+            double numPackets = counts[EventCounters::PhotonPackets];
+            double numPaths = counts[EventCounters::Paths];
+            vector<double> row({static_cast<double>(k + 1), numPackets, numPaths, counts[EventCounters::PathSegments],
+                                numPaths ? counts[EventCounters::PathSegments] / numPaths : 0.,
+                                counts[EventCounters::Scatterings],
+                                numPackets ? counts[EventCounters::Scatterings] / numPackets : 0.,
+                                counts[EventCounters::ExtinctionCalls], counts[EventCounters::ExtinctionEarlyOuts],
+                                counts[EventCounters::TerminatedByWeight], counts[EventCounters::LockFreeRetries]});
+            for (size_t i = EventCounters::NumCounters; i != counts.size(); ++i) row.push_back(counts[i]);
+            out.writeRow(row);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 void MonteCarloSimulation::initProgress(string segment, size_t numTotal)
 {
     _segment = segment;
@@ -552,15 +932,16 @@ void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices
                 _secondarySourceSystem->launch(&pp, historyIndex);
             if (pp.luminosity() > 0)
             {
+                EventCounters::count(EventCounters::PhotonPackets);
                 if (peel) peelOffEmission(&pp, &ppp);
 
-                // trace the packet through the media, if any
-                if (_config->hasMedium())
+                // trace the packet through the media, if any, unless we re-observe the direct emission only
+                if (_config->hasMedium() && !_config->hasDirectReobservation())
                 {
                     // --- forced scattering ---
                     if (_config->forceScattering())
                     {
-                        double Lthreshold = pp.luminosity() / _config->minWeightReduction();
+                        double Lthreshold = pp.totalLuminosity() / _config->minWeightReduction();
                         int minScattEvents = _config->minScattEvents();
                         while (true)
                         {
@@ -575,13 +956,15 @@ void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices
                             simulateForcedPropagation(&pp);
 
                             // if the packet's weight drops below the threshold, terminate it
-                            if (pp.luminosity() <= 0
-                                || (pp.luminosity() <= Lthreshold && pp.numScatt() >= minScattEvents))
+                            if (pp.totalLuminosity() <= 0
+                                || (pp.totalLuminosity() <= Lthreshold && pp.numScatt() >= minScattEvents))
+                            {
+                                EventCounters::count(EventCounters::TerminatedByWeight);
                                 break;
+                            }
 
                             // process the scattering event
-                            if (peel) peelOffScattering(&pp, &ppp);
-                            mediumSystem()->simulateScattering(random(), &pp);
+                            simulateScattering(&pp, &ppp, peel);
                         }
                     }
                     // --- non-forced scattering ---
@@ -594,11 +977,14 @@ void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices
                             if (!simulateNonForcedPropagation(&pp)) break;
 
                             // if the packet's weight drops to zero, terminate it
-                            if (pp.luminosity() <= 0) break;
+                            if (pp.luminosity() <= 0)
+                            {
+                                EventCounters::count(EventCounters::TerminatedByWeight);
+                                break;
+                            }
 
                             // process the scattering event
-                            if (peel) peelOffScattering(&pp, &ppp);
-                            mediumSystem()->simulateScattering(random(), &pp);
+                            simulateScattering(&pp, &ppp, peel);
                         }
                     }
                 }
@@ -616,6 +1002,7 @@ void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices
 
 void MonteCarloSimulation::peelOffEmission(const PhotonPacket* pp, PhotonPacket* ppp)
 {
+    int instrumentIndex = 0;
     for (Instrument* instrument : _instrumentSystem->instruments())
     {
         if (!instrument->isSameObserverAsPreceding())
@@ -630,6 +1017,7 @@ void MonteCarloSimulation::peelOffEmission(const PhotonPacket* pp, PhotonPacket*
             }
         }
         instrument->detect(ppp);
+        EventCounters::countPeelOff(instrumentIndex++);
     }
 }
 
@@ -662,6 +1050,9 @@ void MonteCarloSimulation::storeRadiationField(bool primary, const PhotonPacket*
                 extBeg = extEnd;
             }
         }
+
+        // store the contribution of the companion wavelengths of a polychromatic photon packet, if any
+        if (pp->numCompanions()) mediumSystem()->storeCompanionRadiationField(primary, pp);
     }
     else
     {
@@ -702,6 +1093,7 @@ void MonteCarloSimulation::simulateForcedPropagation(PhotonPacket* pp)
     if (taupath <= 0.)
     {
         pp->applyBias(0.);
+        for (int k = 0; k != pp->numCompanions(); ++k) pp->applyCompanionBias(k, 0.);
         return;
     }
 
@@ -724,6 +1116,15 @@ void MonteCarloSimulation::simulateForcedPropagation(PhotonPacket* pp)
     // determine the physical position of the interaction point
     pp->findInteractionPoint(tau);
 
+    // adjust the weights of the companion wavelengths of a polychromatic photon packet, if any,
+    // with the ratio of their interaction probability at this point and the sampling probability
+    if (pp->numCompanions())
+    {
+        double density = -exp(-tau) / expm1(-taupath);
+        if (xi != 0.) density = (1.0 - xi) * density + xi / taupath;
+        mediumSystem()->biasCompanionsForInteraction(pp, density);
+    }
+
     // adjust the photon packet weight with the escape fraction and, depending on the type of photon cycle,
     // with either the scattered fraction or the cumulative absorption optical depth at the interaction point
     if (_config->explicitAbsorption())
@@ -781,6 +1182,49 @@ bool MonteCarloSimulation::simulateNonForcedPropagation(PhotonPacket* pp)
 
 ////////////////////////////////////////////////////////////////////
 
+void MonteCarloSimulation::simulateScattering(PhotonPacket* pp, PhotonPacket* ppp, bool peel)
+{
+    // attempt to replace the random walk inside an optically thick cell by a Lyman-alpha diffusion step
+    Direction bfn;
+    Vec bfv;
+    if (_config->hasLyaDiffusion() && mediumSystem()->simulateLyaDiffusion(random(), pp, bfn, bfv))
+    {
+        if (peel) peelOffLyaDiffusion(pp, ppp, bfn, bfv);
+    }
+    else
+    {
+        if (peel) peelOffScattering(pp, ppp);
+        mediumSystem()->simulateScattering(random(), pp);
+    }
+    EventCounters::count(EventCounters::Scatterings);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MonteCarloSimulation::peelOffLyaDiffusion(const PhotonPacket* pp, PhotonPacket* ppp, Direction bfn, Vec bfv)
+{
+    // determine the wavelength of the escaping photon packet in the frame of the cell
+    double lambda = pp->perceivedWavelength(bfv, 0.);
+
+    // send a peel-off photon packet to each instrument, weighted by the emergent direction distribution
+    int instrumentIndex = 0;
+    for (Instrument* instr : _instrumentSystem->instruments())
+    {
+        if (!instr->isSameObserverAsPreceding())
+        {
+            Direction bfkobs = instr->bfkobs(pp->position());
+            double mu = Vec::dot(bfn, bfkobs);
+            ppp->launchScatteringPeelOff(pp, bfkobs, bfv, lambda, mu > 0. ? 4. * mu : 0.);
+        }
+
+        // have the peel-off photon packet detected
+        instr->detect(ppp);
+        EventCounters::countPeelOff(instrumentIndex++);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 void MonteCarloSimulation::peelOffScattering(PhotonPacket* pp, PhotonPacket* ppp)
 {
     // determine the perceived wavelength at the scattering location
@@ -801,6 +1245,7 @@ void MonteCarloSimulation::peelOffScattering(PhotonPacket* pp, PhotonPacket* ppp
             // skip media that don't scatter this photon packet
             if (wv[h] > 0.)
             {
+                int instrumentIndex = 0;
                 for (Instrument* instr : _instrumentSystem->instruments())
                 {
                     if (!instr->isSameObserverAsPreceding())
@@ -815,6 +1260,7 @@ void MonteCarloSimulation::peelOffScattering(PhotonPacket* pp, PhotonPacket* ppp
 
                     // have the peel-off photon packet detected
                     instr->detect(ppp);
+                    EventCounters::countPeelOff(instrumentIndex++);
                 }
             }
         }
@@ -822,6 +1268,7 @@ void MonteCarloSimulation::peelOffScattering(PhotonPacket* pp, PhotonPacket* ppp
     else
     {
         // if wavelengths cannot change, send a consolidated peel-off photon packet to each instrument
+        int instrumentIndex = 0;
         for (Instrument* instr : _instrumentSystem->instruments())
         {
             if (!instr->isSameObserverAsPreceding())
@@ -837,6 +1284,7 @@ void MonteCarloSimulation::peelOffScattering(PhotonPacket* pp, PhotonPacket* ppp
 
             // have the peel-off photon packet detected
             instr->detect(ppp);
+            EventCounters::countPeelOff(instrumentIndex++);
         }
     }
 }
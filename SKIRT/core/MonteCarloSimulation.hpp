@@ -11,6 +11,7 @@
 #include "InstrumentSystem.hpp"
 #include "MediumSystem.hpp"
 #include "ProbeSystem.hpp"
+#include "RunPredictor.hpp"
 #include "Simulation.hpp"
 #include "SourceSystem.hpp"
 class SecondarySourceSystem;
@@ -166,6 +167,13 @@ class SecondarySourceSystem;
     segments. It is meaningful to update an SDMS at the end of a segment that performs peel-off to
     the instruments because the update does not affect the outcome of a primary emission segment.
 
+    When the IterationOptions request re-observation of a medium state restored from a checkpoint
+    file, all iterations are skipped, and the final segments reduce to \f$\mathbf{P}^p_{(s)}\f$
+    and \f$\mathbf{S}^p\f$. These segments do not register the RF; instead, the secondary emission
+    spectrum is calculated from the RF restored from the checkpoint. Optionally, photon packets
+    are not traced through the media at all, so that these segments record just the attenuated
+    direct emission in the instruments.
+
     <b>Photon life cycle</b>
 
     As mentioned above, each segment processes the life cycles for a set of photon packets,
@@ -412,12 +420,75 @@ private:
         */
     void runMergedEmissionIterations();
 
+    /** This enumeration identifies the iteration phase recorded in a checkpoint file. The value
+        None indicates that the simulation did not resume from a checkpoint. The value
+        PrimaryEmission indicates a checkpoint written after the final primary emission segment. */
+    enum class IterationPhase : int { None = 0, Primary = 1, Secondary = 2, Merged = 3, PrimaryEmission = 4 };
+
+    /** This function writes a checkpoint file at the end of an iteration, recording the specified
+        iteration phase, the number of completed iterations in that phase, whether the iterations
+        in that phase have finished (because of convergence or because the maximum number of
+        iterations has been reached), and the dust-absorbed secondary luminosity in the most recent
+        iteration (used for verifying convergence of secondary emission iterations). In addition,
+        the checkpoint file contains the state of the random number generator for the parent
+        thread, and the medium state and radiation field as written by the
+        MediumSystem::writeCheckpoint() function. The file is written by the root process only,
+        first to a temporary file that subsequently replaces any previous checkpoint file. */
+    void writeCheckpoint(IterationPhase phase, int iter, bool finished, double Labsseco);
+
+    /** This function reads the checkpoint file specified in the configuration, restores the medium
+        state and radiation field, and stores the iteration progress in data members so that the
+        iteration functions can resume from the appropriate point. If the \em restoreRandom flag is
+        true, the function also restores the state of the random number generator for the calling
+        thread. If the file does not exist, is not a valid checkpoint file, or does not match the
+        configuration of the current simulation, the function logs a warning and returns false,
+        so that the simulation starts from scratch (or, in re-observation mode, so that the caller
+        can report a fatal error). Otherwise, the function returns true. */
+    bool readCheckpoint(bool restoreRandom);
+
+    /** This function returns true if the simulation resumed from a checkpoint indicating that all
+        iterations in the specified phase have been completed, and false otherwise. Primary
+        emission iterations are considered completed if the checkpoint was written during a later
+        phase. Similarly, primary and merged iterations are considered completed if the checkpoint
+        was written after the final primary emission segment. */
+    bool hasCompletedIterations(IterationPhase phase) const;
+
+    /** This function returns true if the simulation resumed from a checkpoint indicating that all
+        iteration phases configured for the simulation have been completed, and false otherwise.
+        It is used to warn the user when re-observing a medium state that may not have converged.
+        */
+    bool hasConvergedCheckpoint() const;
+
     /** In a multi-processing environment, this function logs a message and waits for all processes
         to finish the work (i.e. it places a barrier). The string argument is included in the log
         message to indicate the scope of work that is being finished. If there is only a single
         process, the function does nothing. */
     void wait(string scope);
 
+    /** In prediction mode, this function marks the start of a new phase for the run predictor. If
+        the simulation is not in prediction mode, the function does nothing. */
+    void startPredictionPhase();
+
+    /** In prediction mode, this function records the phase started by the most recent call to
+        startPredictionPhase() with the run predictor, using the specified name and multiplication
+        factors for the minimum and maximum number of iterations (see the RunPredictor class). If
+        \em communicated is true, the phase includes a reduction of the specified radiation field
+        across processes. If the simulation is not in prediction mode, the function does nothing.
+        */
+    void recordPredictionPhase(string phase, double minFactor, double maxFactor, bool communicated = false);
+
+    /** In event counting mode, this function collects the event counters accumulated by all
+        execution threads in all processes since the previous call, records them as the statistics
+        for the specified photon packet segment, and logs a brief summary. It must be called by all
+        processes after the segment has completed. If the simulation is not in event counting mode,
+        the function does nothing. */
+    void recordEventCounters(string segment);
+
+    /** In event counting mode, this function writes a text file with the event statistics recorded
+        for each photon packet segment by the recordEventCounters() function. If the simulation is
+        not in event counting mode, the function does nothing. */
+    void writeEventCounters();
+
     /** This function initializes the progress counter used in logprogress() for the specified
         segment and logs the number of photon packets to be processed. */
     void initProgress(string segment, size_t numTotal);
@@ -526,7 +597,11 @@ private:
         index, \f$V_m\f$ is the volume of the cell, and \f$(L\Delta s)_{\ell,m}\f$ has been
         accumulated over all photon packets contributing to the bin. The resulting mean intensity
         \f$J_\lambda\f$ is expressed as an amount of energy per unit of time, per unit of area, per
-        unit of wavelength, and per unit of solid angle. */
+        unit of wavelength, and per unit of solid angle.
+
+        For a polychromatic photon packet without kinematics, the function also stores the
+        contribution of each of the companion wavelengths, using the corresponding wavelength bin
+        and optical depths (see MediumSystem::storeCompanionRadiationField()). */
     void storeRadiationField(bool primary, const PhotonPacket* pp);
 
     /** This function determines the next scattering location of a photon packet in a photon life
@@ -591,6 +666,12 @@ private:
         where \f$\tau^\text{abs}_\text{int}\f$ is the absorption optical depth at the interaction
         point.
 
+        For a polychromatic photon packet, the weight of each companion wavelength is adjusted by
+        the ratio of the probability for scattering at the interaction point at that wavelength
+        and the probability density with which the interaction point has been sampled (see
+        MediumSystem::biasCompanionsForInteraction()). This happens before the path information is
+        invalidated in the next step.
+
         <b>Advance position</b>
 
         Finally we advance the initial position of the photon packet to the interaction point. This
@@ -647,6 +728,23 @@ private:
         information). The packet is now ready to be scattered into a new direction. */
     bool simulateNonForcedPropagation(PhotonPacket* pp);
 
+    /** This function processes a scattering event for the specified photon packet, including the
+        corresponding peel-off if the \em peel flag is true. If Lyman-alpha diffusion acceleration
+        is enabled and the medium system decides to perform a diffusion step for the photon packet
+        (see MediumSystem::simulateLyaDiffusion()), the peel-off is handled by the
+        peelOffLyaDiffusion() function. Otherwise, the function calls peelOffScattering() and
+        MediumSystem::simulateScattering(). In both cases, the event is counted as a scattering. */
+    void simulateScattering(PhotonPacket* pp, PhotonPacket* ppp, bool peel);
+
+    /** This function simulates the peel-off of a photon packet that has just escaped from a
+        Lyman-alpha diffusion sphere. The photon packet has been moved to the surface of the
+        sphere, with outward surface normal \f${\bf{n}}\f$, and its wavelength has been updated in
+        the frame of the cell, which has bulk velocity \f${\bf{v}}\f$. Because the emergent
+        intensity is proportional to \f$\mu={\bf{k}}\cdot{\bf{n}}\f$ for directions on the outward
+        hemisphere, each peel-off photon packet is weighted by a bias factor \f$4\mu\f$ for
+        \f$\mu>0\f$ and zero otherwise. The peel-off photon packets are unpolarized. */
+    void peelOffLyaDiffusion(const PhotonPacket* pp, PhotonPacket* ppp, Direction bfn, Vec bfv);
+
     /** This function simulates the peel-off of a photon packet before a scattering event. This
         means that, just before a scattering event, we create one or more peel-off photon packets
         for every instrument in the instrument system, which are forced to propagate in the
@@ -682,6 +780,18 @@ private:
     Configuration* _config{new Configuration(this)};
     SecondarySourceSystem* _secondarySourceSystem{nullptr};  // constructed only when there is secondary emission
 
+    // helper object constructed only in prediction mode
+    std::unique_ptr<RunPredictor> _predictor;
+
+    // event statistics recorded for each photon packet segment in event counting mode
+    vector<std::pair<string, Array>> _eventCounts;
+
+    // iteration progress restored from a checkpoint file, if any
+    IterationPhase _restartPhase{IterationPhase::None};
+    int _restartIteration{0};      // the number of completed iterations in the recorded phase
+    bool _restartFinished{false};  // true if the iterations in the recorded phase have finished
+    double _restartLabsseco{0.};   // the dust-absorbed secondary luminosity in the most recent iteration
+
     // data members used by the XXXprogress() functions in this class
     string _segment;  // a string identifying the photon shooting segment for use in the log message
 };
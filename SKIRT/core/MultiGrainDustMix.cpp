@@ -10,6 +10,7 @@
 #include "GrainComposition.hpp"
 #include "GrainSizeDistribution.hpp"
 #include "Log.hpp"
+#include "MemoryLedger.hpp"
 #include "NR.hpp"
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
@@ -454,6 +455,9 @@ size_t MultiGrainDustMix::initializeExtraProperties(const Array& lambdav)
     allocatedBytes += _normv.size() * sizeof(_normv[0]);
     allocatedBytes += _calcEq.allocatedBytes();
     allocatedBytes += _calcSt.allocatedBytes();
+
+    // register the memory allocated by the emission calculators under their own category
+    find<MemoryLedger>()->record("dust emission calculators", _calcEq.allocatedBytes() + _calcSt.allocatedBytes());
     return allocatedBytes;
 }
 
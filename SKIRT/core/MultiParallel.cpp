@@ -5,6 +5,7 @@
 
 #include "MultiParallel.hpp"
 #include "FatalError.hpp"
+#include "Tracer.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
@@ -102,6 +103,7 @@ void MultiParallel::run(int threadIndex)
         // Do work as long as some is available for this cycle, and handle exceptions
         try
         {
+            Tracer trace("parallel work");
             while (!_terminate && doSomeWork())
 
                 ;
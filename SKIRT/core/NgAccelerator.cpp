@@ -0,0 +1,116 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "NgAccelerator.hpp"
+#include "MediumState.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+NgAccelerator::NgAccelerator(int numCells, const vector<int>& mediumIndices,
+                             const vector<vector<int>>& variableIndices)
+    : _numCells(numCells)
+{
+    for (size_t k = 0; k != mediumIndices.size(); ++k)
+    {
+        for (int i : variableIndices[k])
+        {
+            _hv.push_back(mediumIndices[k]);
+            _iv.push_back(i);
+        }
+    }
+    _numVars = _hv.size();
+    _history.resize(numHistory);
+    for (auto& entry : _history) entry.resize(_numCells * _numVars);
+}
+
+////////////////////////////////////////////////////////////////////
+
+size_t NgAccelerator::allocatedBytes() const
+{
+    return numHistory * _numCells * _numVars * sizeof(double);
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool NgAccelerator::extrapolate(MediumState& state, int m) const
+{
+    // get the stored iterates for this cell, from oldest to newest
+    const double* x0 = begin(_history[(_newest + 1) % numHistory]) + m * _numVars;
+    const double* x1 = begin(_history[(_newest + 2) % numHistory]) + m * _numVars;
+    const double* x2 = begin(_history[_newest]) + m * _numVars;
+
+    // accumulate the weighted inner products of the differences between the iterates
+    double A1 = 0., A2 = 0., B2 = 0., C1 = 0., C2 = 0.;
+    for (size_t k = 0; k != _numVars; ++k)
+    {
+        double x3 = state.custom(m, _hv[k], _iv[k]);
+        if (!x3) continue;
+        double w = 1. / (x3 * x3);
+        double Q1 = x3 - 2. * x2[k] + x1[k];
+        double Q2 = x3 - x2[k] - x1[k] + x0[k];
+        double Q3 = x3 - x2[k];
+        A1 += w * Q1 * Q1;
+        A2 += w * Q1 * Q2;
+        B2 += w * Q2 * Q2;
+        C1 += w * Q1 * Q3;
+        C2 += w * Q2 * Q3;
+    }
+
+    // solve for the extrapolation coefficients, rejecting degenerate configurations
+    double det = A1 * B2 - A2 * A2;
+    if (!(std::abs(det) > 1e-12 * A1 * B2)) return false;
+    double a = (C1 * B2 - C2 * A2) / det;
+    double b = (C2 * A1 - C1 * A2) / det;
+    if (!std::isfinite(a) || !std::isfinite(b)) return false;
+
+    // calculate the extrapolated values and verify that they are acceptable before storing any of them
+    thread_local vector<double> t_extrapolated;
+    t_extrapolated.resize(_numVars);
+    for (size_t k = 0; k != _numVars; ++k)
+    {
+        double x3 = state.custom(m, _hv[k], _iv[k]);
+        double x = (1. - a - b) * x3 + a * x2[k] + b * x1[k];
+        if (!std::isfinite(x) || (x3 > 0. && x <= 0.) || (x3 < 0. && x >= 0.)) return false;
+        t_extrapolated[k] = x3 ? x : 0.;
+    }
+    for (size_t k = 0; k != _numVars; ++k) state.setCustom(m, _hv[k], _iv[k], t_extrapolated[k]);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double NgAccelerator::record(const MediumState& state, bool extrapolated)
+{
+    // advance the ring buffer and copy the current state into the newest entry
+    int previous = _newest;
+    _newest = (_newest + 1) % numHistory;
+    Array& current = _history[_newest];
+    for (int m = 0; m != _numCells; ++m)
+        for (size_t k = 0; k != _numVars; ++k) current[m * _numVars + k] = state.custom(m, _hv[k], _iv[k]);
+
+    // calculate the mean relative change compared to the previous entry
+    double meanChange = 0.;
+    if (_numStored > 0)
+    {
+        const Array& before = _history[previous];
+        double sum = 0.;
+        size_t count = 0;
+        for (size_t j = 0; j != current.size(); ++j)
+        {
+            if (current[j])
+            {
+                sum += std::abs((current[j] - before[j]) / current[j]);
+                count++;
+            }
+        }
+        if (count) meanChange = sum / count;
+    }
+
+    // update the number of stored entries, restarting the history after an extrapolation cycle
+    _numStored = extrapolated ? 1 : min(_numStored + 1, numHistory);
+    return meanChange;
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,98 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef NGACCELERATOR_HPP
+#define NGACCELERATOR_HPP
+
+#include "Array.hpp"
+class MediumState;
+
+////////////////////////////////////////////////////////////////////
+
+/** NgAccelerator is a helper class for MediumSystem that accelerates the convergence of the
+    iterative process used to calculate a self-consistent dynamic medium state. It applies Ng
+    extrapolation (Ng 1974, J. Chem. Phys. 61, 2680; see also Olson, Auer & Buchler 1986, JQSRT
+    35, 431) independently to the specific state of each spatial cell.
+
+    The material mix associated with a medium component opts into this mechanism by listing the
+    indices of the custom specific state variables that may be extrapolated through the
+    MaterialMix::acceleratedSpecificStateVariables() function. For each spatial cell, the values of
+    these variables for all participating medium components are concatenated into a single state
+    vector \f$\mathbf{x}\f$.
+
+    After each update cycle, the record() function stores the synchronized state vectors for all
+    cells. Once three such state vectors \f$\mathbf{x}_0, \mathbf{x}_1, \mathbf{x}_2\f$ are
+    available, the extrapolate() function can combine them with the freshly updated state vector
+    \f$\mathbf{x}_3\f$ into an improved estimate \f[ \mathbf{x}^* = (1-a-b)\,\mathbf{x}_3 +
+    a\,\mathbf{x}_2 + b\,\mathbf{x}_1, \f] where the coefficients \f$a\f$ and \f$b\f$ minimize the
+    weighted residual of the extrapolated sequence, using weights \f$1/x_3^2\f$ so that all
+    variables contribute in proportion to their relative change. Because the coefficients sum to
+    unity, any linear constraints satisfied by all iterates (such as the normalization of level
+    populations) are preserved. The extrapolated state is rejected, and the plain iterate is kept,
+    if any of the extrapolated values is not finite or has a sign different from the corresponding
+    plain value. After an extrapolation cycle, the history is restarted so that the next
+    extrapolation occurs three update cycles later.
+
+    The record() function also calculates the mean relative change of the state variables between
+    consecutive update cycles, which can be used as a convergence diagnostic. */
+class NgAccelerator
+{
+public:
+    /** The constructor initializes the accelerator for the specified number of spatial cells and
+        for the specified lists of medium component indices and corresponding custom specific state
+        variable indices. It allocates the memory needed to store the state history. */
+    NgAccelerator(int numCells, const vector<int>& mediumIndices, const vector<vector<int>>& variableIndices);
+
+    /** This function returns the number of bytes allocated by the accelerator, for logging
+        purposes. */
+    size_t allocatedBytes() const;
+
+    /** This function returns true if sufficient history is available to perform extrapolation
+        during the current update cycle. */
+    bool canExtrapolate() const { return _numStored == numHistory; }
+
+    /** This function extrapolates the state vector for spatial cell \em m in the specified medium
+        state, replacing the freshly updated values by the extrapolated ones. It returns true if the
+        extrapolated state was accepted, and false if the plain iterate was kept. The function
+        should be called only if canExtrapolate() returns true. It may be called in parallel for
+        different cells. */
+    bool extrapolate(MediumState& state, int m) const;
+
+    /** This function stores the state vectors for all cells in the specified medium state, which
+        should have been synchronized between processes, into the history, and returns the mean
+        relative change of the state variables compared to the previously stored state, or zero if
+        there is no previous state. If the \em extrapolated flag is true, the history is restarted
+        with the current state as its first entry. The function should be called in serial mode
+        after each update cycle. */
+    double record(const MediumState& state, bool extrapolated);
+
+    /** This function discards the stored history, so that the next extrapolation occurs after
+        sufficient update cycles have been recorded anew. It is intended for use after the medium
+        state has been replaced, for example when restoring a checkpoint. */
+    void reset()
+    {
+        _newest = -1;
+        _numStored = 0;
+    }
+
+private:
+    // the number of stored history entries needed for extrapolation
+    static constexpr int numHistory = 3;
+
+    // configuration
+    int _numCells{0};
+    vector<int> _hv;     // medium component index for each state vector component
+    vector<int> _iv;     // custom variable index for each state vector component
+    size_t _numVars{0};  // number of components in the state vector for each cell
+
+    // history, stored in a ring buffer with the most recent entry at index _newest
+    vector<Array> _history;
+    int _newest{-1};
+    int _numStored{0};
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -10,6 +10,7 @@
 #include "FatalError.hpp"
 #include "Log.hpp"
 #include "MaterialState.hpp"
+#include "MemoryLedger.hpp"
 #include "NR.hpp"
 #include "StringUtils.hpp"
 #include "TextInFile.hpp"
@@ -138,6 +139,25 @@ void NonLTELineGasMix::setupSelfBefore()
             }
         }
         partner.numColTrans = partner.indexUpCol.size();
+
+        // precalculate the logarithmic ratios used for interpolating the coefficients in the temperature grid,
+        // and the weight ratio and energy difference used for converting Kul to Klu for each transition
+        int numIntervals = partner.T.size() - 1;
+        partner.logTRatio.resize(max(numIntervals, 0));
+        for (int i = 0; i < numIntervals; ++i) partner.logTRatio[i] = log(partner.T[i + 1] / partner.T[i]);
+        for (int t = 0; t != partner.numColTrans; ++t)
+        {
+            const Array& Kul = partner.Kul[t];
+            Array logKulRatio(max(numIntervals, 0));
+            for (int i = 0; i < numIntervals; ++i)
+                if (Kul[i] > 0 && Kul[i + 1] > 0) logKulRatio[i] = log(Kul[i + 1] / Kul[i]);
+            partner.logKulRatio.emplace_back(logKulRatio);
+
+            int up = partner.indexUpCol[t];
+            int low = partner.indexLowCol[t];
+            partner.weightRatio.push_back(_weight[up] / _weight[low]);
+            partner.energyDiffOnK.push_back((_energy[up] - _energy[low]) / Constants::k());
+        }
     }
     _numColPartners = colNames.size();
 
@@ -171,6 +191,11 @@ void NonLTELineGasMix::setupSelfBefore()
         _numWavelengths = rfwlg->numBins();
         _lambdav = rfwlg->lambdav();
         _dlambdav = rfwlg->dlambdav();
+
+        // remember the wavelength index of each line center as a starting point for the line profile integration
+        _ellCenter.resize(_numLines);
+        for (int k = 0; k != _numLines; ++k)
+            _ellCenter[k] = std::lower_bound(begin(_lambdav), end(_lambdav), _center[k]) - begin(_lambdav);
     }
 
     // load the initial relative level populations if the user provided a filename
@@ -328,46 +353,52 @@ void NonLTELineGasMix::initializeSpecificState(MaterialState* state, double /*me
 namespace
 {
     // solve the square set of linear equations represented by the given matrix using LU decomposition
-    // the matrix should have N rows and N+1 columns; its contents is overwritten and
-    // the solution is returned as an array of size N
-    Array solveMatrixEquation(vector<vector<double>>& matrix)
+    // the matrix should have N rows and N+1 columns stored contiguously in row-major order;
+    // its contents is overwritten and the solution is stored in the given array, which must have size N
+    void solveMatrixEquation(vector<double>& matrix, Array& solution)
     {
-        size_t size = matrix.size();
-        Array solution(size);
+        size_t size = solution.size();
+        size_t stride = size + 1;
+        double* m = matrix.data();
 
         // forwarding elimination
-        for (size_t i = 0; i < size; i++) solution[i] = matrix[i][size];
+        for (size_t i = 0; i < size; i++) solution[i] = m[i * stride + size];
 
         // decomposition
         for (size_t k = 0; k < size - 1; ++k)
         {
-            if (matrix[k][k] == 0.0)
+            double* rowk = m + k * stride;
+            if (rowk[k] == 0.0)
             {
-                std::swap(matrix[k], matrix[k + 1]);
+                std::swap_ranges(rowk, rowk + stride, rowk + stride);
                 std::swap(solution[k], solution[k + 1]);
             }
             for (size_t i = k + 1; i < size; ++i)
             {
-                double inverse = matrix[i][k] / matrix[k][k];
-                for (size_t j = k + 1; j < size; ++j) matrix[i][j] -= inverse * matrix[k][j];
-                matrix[i][k] = inverse;
+                double* rowi = m + i * stride;
+                double inverse = rowi[k] / rowk[k];
+                for (size_t j = k + 1; j < size; ++j) rowi[j] -= inverse * rowk[j];
+                rowi[k] = inverse;
             }
         }
 
         // forwarding elimination
         for (size_t i = 0; i < size; ++i)
-            for (size_t j = 0; j < i; ++j) solution[i] -= matrix[i][j] * solution[j];
+            for (size_t j = 0; j < i; ++j) solution[i] -= m[i * stride + j] * solution[j];
 
         // backward substitution
         for (int i = static_cast<int>(size) - 1; i >= 0; --i)
         {
-            for (size_t j = i + 1; j < size; ++j) solution[i] -= matrix[i][j] * solution[j];
-            solution[i] /= matrix[i][i];
+            for (size_t j = i + 1; j < size; ++j) solution[i] -= m[i * stride + j] * solution[j];
+            solution[i] /= m[i * stride + i];
         }
-
-        // return the solution
-        return solution;
     }
+
+    // per-thread workspace for the statistical equilibrium matrix and its solution, so that the memory
+    // does not need to be reallocated for each cell; this works even if there are multiple material mixes
+    // of this type because each thread updates a single cell at a time
+    thread_local vector<double> t_matrix;
+    thread_local Array t_solution;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -410,8 +441,15 @@ UpdateStatus NonLTELineGasMix::updateSpecificState(MaterialState* state, const A
     // if the cell does not contain any material for this component, leave all properties untouched
     if (state->numberDensity() > 0)
     {
-        // allocate the statistical equilibrium matrix for the level populations
-        vector<vector<double>> matrix(_numLevels, vector<double>(_numLevels + 1));
+        // initialize the statistical equilibrium matrix for the level populations in the per-thread workspace;
+        // register any growth of the matrix, which dominates the size of the workspace, with the memory ledger
+        size_t stride = _numLevels + 1;
+        size_t capacity = t_matrix.capacity();
+        t_matrix.assign(_numLevels * stride, 0.);
+        if (t_matrix.capacity() > capacity)
+            find<MemoryLedger>()->record("non-LTE solver workspace", (t_matrix.capacity() - capacity) * sizeof(double));
+        double* matrix = t_matrix.data();
+        auto element = [matrix, stride](int row, int column) -> double& { return matrix[row * stride + column]; };
 
         // add the terms for the radiational transitions
         for (int k = 0; k != _numLines; ++k)
@@ -420,8 +458,8 @@ UpdateStatus NonLTELineGasMix::updateSpecificState(MaterialState* state, const A
             int low = _indexLowRad[k];
 
             // add the Einstein Aul coefficients (spontaneous emission)
-            matrix[up][up] -= _einsteinA[k];
-            matrix[low][up] += _einsteinA[k];
+            element(up, up) -= _einsteinA[k];
+            element(low, up) += _einsteinA[k];
 
             // calculate the mean intensity of the radiation field convolved over the normalized line profile g:
             //   J_convolved = \int J_lambda(lambda) g(lambda) d lambda  /  \int g(lambda) d lambda
@@ -431,8 +469,9 @@ UpdateStatus NonLTELineGasMix::updateSpecificState(MaterialState* state, const A
             double sigma = sigmaForLine(center, state->temperature(), _mass);
             double lambdamin = center - PROFILE_RANGE * sigma;
             double lambdamax = center + PROFILE_RANGE * sigma;
-            int ellmin = std::lower_bound(begin(_lambdav), end(_lambdav), lambdamin) - begin(_lambdav);
-            int ellmax = std::upper_bound(begin(_lambdav), end(_lambdav), lambdamax) - begin(_lambdav);
+            auto centerIt = begin(_lambdav) + _ellCenter[k];
+            int ellmin = std::lower_bound(begin(_lambdav), centerIt, lambdamin) - begin(_lambdav);
+            int ellmax = std::upper_bound(centerIt, end(_lambdav), lambdamax) - begin(_lambdav);
             double gsum = 0.;
             double Jsum = 0.;
             for (int ell = ellmin; ell != ellmax; ++ell)
@@ -468,12 +507,12 @@ UpdateStatus NonLTELineGasMix::updateSpecificState(MaterialState* state, const A
             if (storeMeanIntensities()) state->setMeanIntensity(k, J);
 
             // add the Einstein Bul coefficients (stimulated emission)
-            matrix[up][up] -= _einsteinBul[k] * J;
-            matrix[low][up] += _einsteinBul[k] * J;
+            element(up, up) -= _einsteinBul[k] * J;
+            element(low, up) += _einsteinBul[k] * J;
 
             // add the Einstein Blu coefficients (absorption)
-            matrix[low][low] -= _einsteinBlu[k] * J;
-            matrix[up][low] += _einsteinBlu[k] * J;
+            element(low, low) -= _einsteinBlu[k] * J;
+            element(up, low) += _einsteinBlu[k] * J;
         }
 
         // add the terms for the collisional transitions
@@ -481,35 +520,52 @@ UpdateStatus NonLTELineGasMix::updateSpecificState(MaterialState* state, const A
         for (int c = 0; c != _numColPartners; ++c)
         {
             const auto& partner = _colPartner[c];
+            double n = state->colPartnerDensity(c);
+
+            // locate the temperature in the grid and determine the log-log interpolation fraction; this is
+            // equivalent to NR::clampedValue<NR::interpolateLogLog> but shares the work among all transitions
+            int numT = partner.T.size();
+            int i = NR::locate(partner.T, T);
+            bool inside = i >= 0 && i < numT - 1;
+            double fraction = inside ? log(T / partner.T[i]) / partner.logTRatio[i] : 0.;
 
             for (int t = 0; t != partner.numColTrans; ++t)
             {
                 int up = partner.indexUpCol[t];
                 int low = partner.indexLowCol[t];
-                double weightRatio = _weight[up] / _weight[low];
-                double energyDiff = _energy[up] - _energy[low];
-                double Kconversion = weightRatio * exp(-energyDiff / Constants::k() / T);
+                double Kconversion = partner.weightRatio[t] * exp(-partner.energyDiffOnK[t] / T);
+
                 // determine Kul by interpolation from the temperature-dependent table
-                double Kul = NR::clampedValue<NR::interpolateLogLog>(T, partner.T, partner.Kul[t]);
+                const Array& Kulv = partner.Kul[t];
+                double Kul = 0.;
+                if (!inside)
+                    Kul = i < 0 ? Kulv[0] : Kulv[numT - 1];
+                else if (Kulv[i] > 0 && Kulv[i + 1] > 0)
+                    Kul = Kulv[i] * exp(fraction * partner.logKulRatio[t][i]);
+                else if (T == partner.T[i])
+                    Kul = Kulv[i];
+                else if (T == partner.T[i + 1])
+                    Kul = Kulv[i + 1];
 
                 // determine Klu from Kul
                 double Klu = Kul * Kconversion;
 
                 // add the coefficients after multiplication by the partner number density
-                double n = state->colPartnerDensity(c);
-                matrix[up][up] -= Kul * n;
-                matrix[low][low] -= Klu * n;
-                matrix[up][low] += Klu * n;
-                matrix[low][up] += Kul * n;
+                element(up, up) -= Kul * n;
+                element(low, low) -= Klu * n;
+                element(up, low) += Klu * n;
+                element(low, up) += Kul * n;
             }
         }
 
         // replace the last row of the matrix by the normalization of the number density
-        for (int p = 0; p != _numLevels; ++p) matrix[_numLevels - 1][p] = 1.;
-        matrix[_numLevels - 1][_numLevels] = state->numberDensity();
+        for (int p = 0; p != _numLevels; ++p) element(_numLevels - 1, p) = 1.;
+        element(_numLevels - 1, _numLevels) = state->numberDensity();
 
         // solve the set of equations represented by the matrix
-        Array solution = solveMatrixEquation(matrix);
+        if (t_solution.size() != static_cast<size_t>(_numLevels)) t_solution.resize(_numLevels);
+        Array& solution = t_solution;
+        solveMatrixEquation(t_matrix, solution);
 
         // update the level populations, keeping track of the amount of change
         double change = 0.;
@@ -566,6 +622,15 @@ bool NonLTELineGasMix::isSpecificStateConverged(int numCells, int /*numUpdated*/
 
 ////////////////////////////////////////////////////////////////////
 
+vector<int> NonLTELineGasMix::acceleratedSpecificStateVariables() const
+{
+    vector<int> indices;
+    for (int p = 0; p != _numLevels; ++p) indices.push_back(_indexFirstLevelPopulation + p);
+    return indices;
+}
+
+////////////////////////////////////////////////////////////////////
+
 double NonLTELineGasMix::mass() const
 {
     return _mass;
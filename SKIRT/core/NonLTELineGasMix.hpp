@@ -446,7 +446,14 @@ public:
     /** Based on the specified radiation field and the input model properties found in the given
         material state, this function determines the level populations for the supported
         transitions and stores these results back in the given material state. The function returns
-        the update status as described for the UpdateStatus class. */
+        the update status as described for the UpdateStatus class.
+
+        Because this function is called for every cell in every iteration, it avoids per-cell
+        memory allocation by solving the statistical equilibrium equations in a flat matrix held in
+        a workspace that is allocated once for each execution thread. The line profile integration
+        starts from the precalculated wavelength index of the line center, and the collisional
+        coefficients are interpolated using logarithmic ratios precalculated during setup, so that
+        the temperature bracket is located only once per collisional partner. */
     UpdateStatus updateSpecificState(MaterialState* state, const Array& Jv) const override;
 
     /** This function returns true if the state of the medium component corresponding to this
@@ -456,6 +463,12 @@ public:
     bool isSpecificStateConverged(int numCells, int numUpdated, int numNotConverged, MaterialState* currentAggregate,
                                   MaterialState* previousAggregate) const override;
 
+    /** This function returns the indices of the custom specific state variables holding the level
+        populations, so that these can be extrapolated by the Ng acceleration scheme if so requested
+        by the user. Because the extrapolation coefficients sum to unity, the extrapolated level
+        populations remain consistent with the total number density of the species. */
+    vector<int> acceleratedSpecificStateVariables() const override;
+
     //======== Low-level material properties =======
 
 public:
@@ -539,12 +552,16 @@ private:
     // collisional transitions
     struct ColPartner  // data structure holding information on a collisional partner
     {
-        string name;              // human readable species name
-        Array T;                  // the temperature grid points
-        int numColTrans{0};       // the number of collisional transitions -- index t
-        vector<int> indexUpCol;   // the upper energy level index for each collisional transition
-        vector<int> indexLowCol;  // the lower energy level index for each collisional transition
-        vector<Array> Kul;        // the coefficient for each collisional transition and for each temperature
+        string name;                   // human readable species name
+        Array T;                       // the temperature grid points
+        int numColTrans{0};            // the number of collisional transitions -- index t
+        vector<int> indexUpCol;        // the upper energy level index for each collisional transition
+        vector<int> indexLowCol;       // the lower energy level index for each collisional transition
+        vector<Array> Kul;             // the coefficient for each collisional transition and for each temperature
+        Array logTRatio;               // precalculated log(T[i+1]/T[i]) for each temperature interval
+        vector<Array> logKulRatio;     // precalculated log(Kul[i+1]/Kul[i]) for each transition (or zero if undefined)
+        vector<double> weightRatio;    // the weight ratio between upper and lower level for each transition
+        vector<double> energyDiffOnK;  // the energy difference divided by Boltzmann constant for each transition
     };
     int _numColPartners{0};          // the number of collisional interaction partners -- index c
     vector<ColPartner> _colPartner;  // the data for each collisional partner
@@ -553,6 +570,7 @@ private:
     int _numWavelengths{0};  // the number of wavelength bins -- index ell
     Array _lambdav;          // characteristic wavelengths
     Array _dlambdav;         // wavelength bin widths
+    vector<int> _ellCenter;  // index of the first wavelength not below the line center for each transition
 
     // imported initial level populations (technical expert option)
     vector<Array> _initLevelPops;  // initial level populations for each cell -- indices m, p
@@ -18,6 +18,7 @@ void NormalizedSource::setupSelfBefore()
 
     auto config = find<Configuration>();
     _oligochromatic = config->oligochromatic();
+    _numWavelengths = config->numWavelengthsPerPacket();
 
     // cast the SED to a version that supports specific luminosities if possible
     _contsed = dynamic_cast<ContSED*>(_sed);
@@ -54,6 +55,13 @@ Range NormalizedSource::wavelengthRange() const
 
 //////////////////////////////////////////////////////////////////////
 
+bool NormalizedSource::supportsPolychromaticPackets() const
+{
+    return !hasVelocity();
+}
+
+//////////////////////////////////////////////////////////////////////
+
 double NormalizedSource::luminosity() const
 {
     return _normalization->luminosityForSED(_sed);
@@ -72,16 +80,16 @@ double NormalizedSource::specificLuminosity(double wavelength) const
 
 void NormalizedSource::launch(PhotonPacket* pp, size_t historyIndex, double L) const
 {
-    // generate a random wavelength from the SED and/or from the bias distribution
-    double lambda, w;
-    if (!_xi)
-    {
+    // generate a random wavelength from the SED and/or from the bias distribution,
+    // and return the compensating weight factor
+    auto generateWavelength = [this](double& lambda) {
         // no biasing -- simply use the intrinsic spectral distribution
-        lambda = _sed->generateWavelength();
-        w = 1.;
-    }
-    else
-    {
+        if (!_xi)
+        {
+            lambda = _sed->generateWavelength();
+            return 1.;
+        }
+
         // biasing -- use one or the other distribution
         if (random()->uniform() > _xi)
             lambda = _sed->generateWavelength();
@@ -90,23 +98,29 @@ void NormalizedSource::launch(PhotonPacket* pp, size_t historyIndex, double L) c
 
         // calculate the compensating weight factor
         double s = _contsed->specificLuminosity(lambda);
-        if (!s)
-        {
-            // if the wavelength can't occur in the intrinsic distribution,
-            // the weight factor is zero regardless of the probability in the bias distribution
-            // (handling this separately also avoids NaNs in the pathological case s=b=0)
-            w = 0.;
-        }
-        else
-        {
-            // regular composite bias weight
-            double b = _biasDistribution->probability(lambda);
-            w = s / ((1 - _xi) * s + _xi * b);
-        }
-    }
 
-    // cause the subclass to launch the photon packet
-    launchNormalized(pp, historyIndex, lambda, L * w);
+        // if the wavelength can't occur in the intrinsic distribution,
+        // the weight factor is zero regardless of the probability in the bias distribution
+        // (handling this separately also avoids NaNs in the pathological case s=b=0)
+        if (!s) return 0.;
+
+        // regular composite bias weight
+        double b = _biasDistribution->probability(lambda);
+        return s / ((1 - _xi) * s + _xi * b);
+    };
+
+    // cause the subclass to launch the photon packet,
+    // dividing the luminosity contribution over all wavelengths carried by the packet
+    double lambda;
+    double w = generateWavelength(lambda);
+    launchNormalized(pp, historyIndex, lambda, L * w / _numWavelengths);
+
+    // add the companion wavelengths for a polychromatic photon packet
+    for (int k = 1; k < _numWavelengths; ++k)
+    {
+        w = generateWavelength(lambda);
+        pp->addCompanion(lambda, L * w / _numWavelengths);
+    }
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -54,6 +54,10 @@ public:
         This function implements the SourceWavelengthRangeInterface interface. */
     Range wavelengthRange() const override;
 
+    /** This function returns true if the source has no velocity, because the companion
+        wavelengths of polychromatic photon packets are not Doppler-shifted. */
+    bool supportsPolychromaticPackets() const override;
+
     /** This function returns the luminosity \f$L\f$ (i.e. radiative power) of the source
         integrated over the wavelength range of primary sources (configured for the source system
         as a whole) and across its complete spatial domain. */
@@ -69,7 +73,10 @@ public:
     /** This function causes the photon packet \em pp to be launched from the source using the
          given history index and luminosity contribution. In this abstract class, the function
          handles the wavelength sampling and normalization, relying on the subclass to determine
-         the position and propagation direction of the emission from the geometry of the source. */
+         the position and propagation direction of the emission from the geometry of the source.
+         When launching polychromatic photon packets, the function samples the companion
+         wavelengths independently from the same distribution as the reference wavelength, and
+         divides the luminosity contribution evenly over all wavelengths. */
     void launch(PhotonPacket* pp, size_t historyIndex, double L) const override;
 
     //============== Functions to be implemented in each subclass =============
@@ -85,6 +92,7 @@ public:
 private:
     // wavelength information initialized during setup
     bool _oligochromatic{false};                         // true if the simulation is oligochromatic
+    int _numWavelengths{1};                              // the number of wavelengths per photon packet
     double _xi{0.};                                      // the wavelength bias fraction
     WavelengthDistribution* _biasDistribution{nullptr};  // the wavelength bias distribution
     ContSED* _contsed{nullptr};                          // cast of SED to ContSED or nullptr if line spectrum
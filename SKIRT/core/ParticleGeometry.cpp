@@ -24,6 +24,8 @@ Snapshot* ParticleGeometry::createAndOpenSnapshot()
 
     // set the smoothing kernel
     snapshot->setSmoothingKernel(smoothingKernel());
+    snapshot->setSearchMethod(searchMethod() == SearchMethod::Hierarchy ? BoxSearch::Method::Hierarchy
+                                                                        : BoxSearch::Method::Grid);
     return snapshot;
 }
 
@@ -37,15 +37,33 @@
     mass of the particle. If the \em importTemperature option is enabled, the next column specifies
     a temperature. If this temperature is higher than the maximum configured temperature, the
     particle is ignored. If the \em importTemperature option is disabled, or the maximum
-    temperature value is set to zero, the particle is never ignored. */
+    temperature value is set to zero, the particle is never ignored.
+
+    The \em searchMethod option selects the data structure used for locating the particles that
+    overlap a given position when calculating the density; see the BoxSearch class for more
+    information. The default block grid performs well for moderately clustered particle
+    distributions. For strongly clustered distributions, the bounding volume hierarchy is usually
+    much faster because it adapts to the local particle density. */
 class ParticleGeometry : public ImportedGeometry
 {
+    /** The enumeration type indicating the method for locating the particles that overlap a given
+        position or path. */
+    ENUM_DEF(SearchMethod, Grid, Hierarchy)
+        ENUM_VAL(SearchMethod, Grid, "a grid of blocks, each listing the overlapping particles")
+        ENUM_VAL(SearchMethod, Hierarchy, "a bounding volume hierarchy (better for strongly clustered particles)")
+    ENUM_END()
+
     ITEM_CONCRETE(ParticleGeometry, ImportedGeometry, "a geometry imported from smoothed particle data")
 
         PROPERTY_ITEM(smoothingKernel, SmoothingKernel, "the kernel for interpolating the smoothed particles")
         ATTRIBUTE_DEFAULT_VALUE(smoothingKernel, "CubicSplineSmoothingKernel")
         ATTRIBUTE_DISPLAYED_IF(smoothingKernel, "Level2")
 
+        PROPERTY_ENUM(searchMethod, SearchMethod,
+                      "the method for locating the particles overlapping a position or path")
+        ATTRIBUTE_DEFAULT_VALUE(searchMethod, "Grid")
+        ATTRIBUTE_DISPLAYED_IF(searchMethod, "Level3")
+
     ITEM_END()
 
     //============= Construction - Setup - Destruction =============
@@ -28,8 +28,12 @@ Snapshot* ParticleMedium::createAndOpenSnapshot()
         case MassType::Number: _particleSnapshot->importNumber(); break;
     }
 
-    // set the smoothing kernel
+    // set the smoothing kernel; with the hierarchy search method, obtain cell masses by integrating the kernel
+    // even if the cumulative kernel resource is not installed
     _particleSnapshot->setSmoothingKernel(smoothingKernel());
+    if (searchMethod() == SearchMethod::Hierarchy) smoothingKernel()->requireMassInBox();
+    _particleSnapshot->setSearchMethod(searchMethod() == SearchMethod::Hierarchy ? BoxSearch::Method::Hierarchy
+                                                                                 : BoxSearch::Method::Grid);
 
     return _particleSnapshot;
 }
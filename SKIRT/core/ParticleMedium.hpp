@@ -57,7 +57,23 @@ class ParticleSnapshot;
 
     Finally, if the \em importVariableMixParams option is enabled, the remaining columns specify
     the parameters used by the configured material mix family to select a particular material mix
-    for the particle. */
+    for the particle.
+
+    The \em searchMethod option selects the data structure used for locating the particles that
+    overlap a given position or path, for example when sampling the density in the cells of the
+    spatial grid; see the BoxSearch class for more information. The default block grid performs well
+    for moderately clustered particle distributions. With the bounding volume hierarchy, the cost
+    of a query depends on the local particle density rather than on the most crowded region of the
+    domain. This option is recommended for strongly clustered particle distributions such as
+    zoom-in simulations. Moreover, with the hierarchy, the mass inside a spatial cell is always
+    obtained by integrating the smoothing kernel over the cell (see the MassInBoxInterface) rather
+    than by sampling the density at random positions in the cell. If the tabulated cumulative kernel
+    is not installed as a resource, it is calculated in memory by numerical integration during
+    setup (see SmoothingKernel::requireMassInBox()). Because the hierarchy stores the aggregate
+    particle mass for each of its nodes, only the particles straddling the cell boundary require a
+    kernel integration. This substantially accelerates the construction of density-driven spatial
+    grids and the assignment of densities to their cells. With the block grid, the cell masses are
+    obtained by kernel integration only if the cumulative kernel resource is installed. */
 class ParticleMedium : public ImportedMedium, public MassInBoxInterface
 {
     /** The enumeration type indicating the type of mass quantity to be imported. */
@@ -66,12 +82,24 @@ class ParticleMedium : public ImportedMedium, public MassInBoxInterface
         ENUM_VAL(MassType, Number, "number (volume-integrated)")
     ENUM_END()
 
+    /** The enumeration type indicating the method for locating the particles that overlap a given
+        position or path. */
+    ENUM_DEF(SearchMethod, Grid, Hierarchy)
+        ENUM_VAL(SearchMethod, Grid, "a grid of blocks, each listing the overlapping particles")
+        ENUM_VAL(SearchMethod, Hierarchy, "a bounding volume hierarchy (better for strongly clustered particles)")
+    ENUM_END()
+
     ITEM_CONCRETE(ParticleMedium, ImportedMedium, "a transfer medium imported from smoothed particle data")
 
         PROPERTY_ITEM(smoothingKernel, SmoothingKernel, "the kernel for interpolating the smoothed particles")
         ATTRIBUTE_DEFAULT_VALUE(smoothingKernel, "CubicSplineSmoothingKernel")
         ATTRIBUTE_DISPLAYED_IF(smoothingKernel, "Level2")
 
+        PROPERTY_ENUM(searchMethod, SearchMethod,
+                      "the method for locating the particles overlapping a position or path")
+        ATTRIBUTE_DEFAULT_VALUE(searchMethod, "Grid")
+        ATTRIBUTE_DISPLAYED_IF(searchMethod, "Level3")
+
         PROPERTY_ENUM(massType, MassType, "the type of mass quantity to be imported")
         ATTRIBUTE_DEFAULT_VALUE(massType, "Mass")
 
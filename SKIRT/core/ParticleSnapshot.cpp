@@ -7,6 +7,8 @@
 #include "EntityCollection.hpp"
 #include "Log.hpp"
 #include "NR.hpp"
+#include "Parallel.hpp"
+#include "ParallelFactory.hpp"
 #include "Random.hpp"
 #include "SmoothingKernel.hpp"
 #include "StringUtils.hpp"
@@ -172,16 +174,35 @@ void ParticleSnapshot::readAndClose()
     // if needed, construct a search structure for the particles
     if (hasMassDensityPolicy() || needGetEntities())
     {
-        log()->info("Constructing search grid for " + std::to_string(_pv.size()) + " particles...");
+        bool hierarchy = _searchMethod == BoxSearch::Method::Hierarchy;
+        log()->info((hierarchy ? "Constructing bounding volume hierarchy for " : "Constructing search grid for ")
+                    + std::to_string(_pv.size()) + " particles...");
         auto bounds = [this](int m) { return _pv[m].bounds(); };
         auto intersects = [this](int m, const Box& box) { return box.intersects(_pv[m].center(), _pv[m].radius()); };
-        _search.loadEntities(_pv.size(), bounds, intersects);
-
-        int nb = _search.numBlocks();
-        log()->info("  Number of blocks in grid: " + std::to_string(nb * nb * nb) + " (" + std::to_string(nb) + "^3)");
-        log()->info("  Smallest number of particles per block: " + std::to_string(_search.minEntitiesPerBlock()));
-        log()->info("  Largest  number of particles per block: " + std::to_string(_search.maxEntitiesPerBlock()));
-        log()->info("  Average  number of particles per block: "
+        auto parallel = log()->find<ParallelFactory>()->parallelDuplicated();
+        _search.loadEntities(_pv.size(), bounds, intersects, _searchMethod,
+                             [parallel](size_t numTasks, std::function<void(size_t, size_t)> target) {
+                                 parallel->call(numTasks, target);
+                             });
+        if (hasMassDensityPolicy()) _search.loadWeights([this](int m) { return _pv[m].mass(); });
+
+        string unit = hierarchy ? "leaf" : "block";
+        if (hierarchy)
+        {
+            log()->info("  Number of nodes in hierarchy: " + std::to_string(_search.numNodes()) + " in "
+                        + std::to_string(_search.numLevels()) + " levels");
+        }
+        else
+        {
+            int nb = _search.numBlocks();
+            log()->info("  Number of blocks in grid: " + std::to_string(nb * nb * nb) + " (" + std::to_string(nb)
+                        + "^3)");
+        }
+        log()->info("  Smallest number of particles per " + unit + ": "
+                    + std::to_string(_search.minEntitiesPerBlock()));
+        log()->info("  Largest  number of particles per " + unit + ": "
+                    + std::to_string(_search.maxEntitiesPerBlock()));
+        log()->info("  Average  number of particles per " + unit + ": "
                     + StringUtils::toString(_search.avgEntitiesPerBlock(), 'f', 1));
     }
 }
@@ -195,13 +216,20 @@ void ParticleSnapshot::setSmoothingKernel(const SmoothingKernel* kernel)
 
 ////////////////////////////////////////////////////////////////////
 
+void ParticleSnapshot::setSearchMethod(BoxSearch::Method method)
+{
+    _searchMethod = method;
+}
+
+////////////////////////////////////////////////////////////////////
+
 Box ParticleSnapshot::extent() const
 {
     // if there are no particles, return an empty box
     if (_propv.empty()) return Box();
 
     // if there is a search structure, ask it to return the extent (it is already calculated)
-    if (_search.numBlocks()) return _search.extent();
+    if (_search.numEntities()) return _search.extent();
 
     // otherwise find the spatial range of the particles assuming a finite support kernel
     double xmin = +std::numeric_limits<double>::infinity();
@@ -260,17 +288,15 @@ double ParticleSnapshot::density(Position bfr) const
 
 double ParticleSnapshot::massInBox(const Box& box) const
 {
-    double sum = 0.;
-    for (int m : _search.entitiesFor(box))
-    {
+    // the search structure adds the full mass of particles with a bounding box inside the query box,
+    // so that we need to integrate the smoothing kernel only for particles straddling the box boundary
+    double sum = _search.accumulate(box, [this, &box](int m) {
         // avoid mass outside sphere due to rounding errors
-        if (box.intersects(_pv[m].center(), _pv[m].radius()))
-        {
-            Vec rmin = (box.rmin() - _pv[m].center()) / _pv[m].radius();
-            Vec rmax = (box.rmax() - _pv[m].center()) / _pv[m].radius();
-            sum += _kernel->massInBox(Box(rmin, rmax)) * _pv[m].mass();
-        }
-    }
+        if (!box.intersects(_pv[m].center(), _pv[m].radius())) return 0.;
+        Vec rmin = (box.rmin() - _pv[m].center()) / _pv[m].radius();
+        Vec rmax = (box.rmax() - _pv[m].center()) / _pv[m].radius();
+        return _kernel->massInBox(Box(rmin, rmax)) * _pv[m].mass();
+    });
     return sum > 0. ? sum : 0.;  // guard against negative mass
 }
 
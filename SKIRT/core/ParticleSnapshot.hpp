@@ -56,6 +56,12 @@ public:
         smoothing kernel results in undefined behavior. */
     void setSmoothingKernel(const SmoothingKernel* kernel);
 
+    /** This function sets the method used by the search structure for locating the particles
+        overlapping a given position or path; see the BoxSearch class for more information. This
+        function should be called during configuration. The default is the BoxSearch::Method::Grid
+        method. */
+    void setSearchMethod(BoxSearch::Method method);
+
     //=========== Interrogation ==========
 
 public:
@@ -138,6 +144,7 @@ public:
 private:
     // data members initialized during configuration
     const SmoothingKernel* _kernel{nullptr};
+    BoxSearch::Method _searchMethod{BoxSearch::Method::Grid};
 
     // data members initialized when reading the input file
     vector<Array> _propv;  // particle properties as imported
@@ -23,6 +23,8 @@ Snapshot* ParticleSource::createAndOpenSnapshot()
 
     // set the smoothing kernel
     snapshot->setSmoothingKernel(smoothingKernel());
+    snapshot->setSearchMethod(searchMethod() == SearchMethod::Hierarchy ? BoxSearch::Method::Hierarchy
+                                                                        : BoxSearch::Method::Grid);
     return snapshot;
 }
 
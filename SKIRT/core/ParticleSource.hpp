@@ -43,15 +43,31 @@
     and scale the appropriate %SED. For example for the Bruzual-Charlot %SED family, the remaining
     columns provide the initial mass, the metallicity, and the age of the stellar population
     represented by the particle. Refer to the documentation of the configured type of SEDFamily for
-    information about the expected parameters and their default units. */
+    information about the expected parameters and their default units.
+
+    The \em searchMethod option selects the data structure used for locating the particles that
+    overlap a given position or path, which is needed only when the simulation includes input
+    model probes; see the BoxSearch class for more information. */
 class ParticleSource : public ImportedSource
 {
+    /** The enumeration type indicating the method for locating the particles that overlap a given
+        position or path. */
+    ENUM_DEF(SearchMethod, Grid, Hierarchy)
+        ENUM_VAL(SearchMethod, Grid, "a grid of blocks, each listing the overlapping particles")
+        ENUM_VAL(SearchMethod, Hierarchy, "a bounding volume hierarchy (better for strongly clustered particles)")
+    ENUM_END()
+
     ITEM_CONCRETE(ParticleSource, ImportedSource, "a primary source imported from smoothed particle data")
 
         PROPERTY_ITEM(smoothingKernel, SmoothingKernel, "the kernel for interpolating the smoothed particles")
         ATTRIBUTE_DEFAULT_VALUE(smoothingKernel, "CubicSplineSmoothingKernel")
         ATTRIBUTE_DISPLAYED_IF(smoothingKernel, "Level2")
 
+        PROPERTY_ENUM(searchMethod, SearchMethod,
+                      "the method for locating the particles overlapping a position or path")
+        ATTRIBUTE_DEFAULT_VALUE(searchMethod, "Grid")
+        ATTRIBUTE_DISPLAYED_IF(searchMethod, "Level3")
+
     ITEM_END()
 
     //============= Construction - Setup - Destruction =============
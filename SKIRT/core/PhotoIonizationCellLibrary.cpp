@@ -0,0 +1,160 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "PhotoIonizationCellLibrary.hpp"
+#include "MemoryLedger.hpp"
+#include "StringUtils.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the category under which the library registers its memory with the memory ledger
+    const string ledgerCategory = "photoionization cell library";
+
+    // the number of shards over which the library bins are distributed
+    const size_t numShards = 64;
+
+    // return the approximate number of bytes occupied by the specified library bin
+    size_t entryBytes(const PhotoIonizationCellLibrary::Key& key, const PhotoIonizationCellLibrary::Entry* entry)
+    {
+        size_t numValues = entry->parameters.size() + entry->ionFracDiags.size() + entry->ionFracAggs.size()
+                           + entry->opacityAbs.size() + entry->opacitySca.size() + entry->opacityExt.size();
+        return sizeof(PhotoIonizationCellLibrary::Entry) + numValues * sizeof(double) + key.size() * sizeof(int64_t);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+PhotoIonizationCellLibrary::PhotoIonizationCellLibrary(double resolution, const vector<string>& parameterNames,
+                                                       MemoryLedger* ledger)
+    : _resolution(resolution), _names(parameterNames), _ledger(ledger), _shards(numShards)
+{
+    for (auto& shard : _shards)
+    {
+        shard.sumDeviation.resize(parameterNames.size());
+        shard.maxDeviation.resize(parameterNames.size());
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PhotoIonizationCellLibrary::quantize(const Array& parameters, Key& key) const
+{
+    size_t n = parameters.size();
+    key.resize(n);
+    for (size_t i = 0; i != n; ++i)
+    {
+        double value = parameters[i];
+        key[i] = std::isfinite(value) ? static_cast<int64_t>(std::floor(value / _resolution))
+                                      : std::numeric_limits<int64_t>::min();
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+PhotoIonizationCellLibrary::Shard& PhotoIonizationCellLibrary::shard(const Key& key)
+{
+    // combine the bin indices with the FNV-1a hash function
+    uint64_t hash = 14695981039346656037ULL;
+    for (int64_t index : key)
+    {
+        hash ^= static_cast<uint64_t>(index);
+        hash *= 1099511628211ULL;
+    }
+    return _shards[hash % numShards];
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const PhotoIonizationCellLibrary::Entry> PhotoIonizationCellLibrary::find(const Key& key,
+                                                                                          const Array& parameters)
+{
+    Shard& shard = this->shard(key);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) return nullptr;
+
+    // record the deviation from the representative for each parameter
+    const Array& reference = it->second->parameters;
+    for (size_t i = 0; i != _names.size(); ++i)
+    {
+        double deviation = std::abs(parameters[i] - reference[i]);
+        if (std::isfinite(deviation))
+        {
+            shard.sumDeviation[i] += deviation;
+            shard.maxDeviation[i] = max(shard.maxDeviation[i], deviation);
+        }
+    }
+    shard.numMembers++;
+    return it->second;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PhotoIonizationCellLibrary::insert(const Key& key, std::shared_ptr<const Entry> entry)
+{
+    size_t bytes = entryBytes(key, entry.get());
+    Shard& shard = this->shard(key);
+    {
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        if (!shard.entries.emplace(key, entry).second) return;
+        shard.allocatedBytes += bytes;
+    }
+    _ledger->record(ledgerCategory, bytes);
+}
+
+////////////////////////////////////////////////////////////////////
+
+string PhotoIonizationCellLibrary::statistics() const
+{
+    // combine the statistics for all shards
+    size_t numEntries = 0;
+    size_t allocatedBytes = 0;
+    size_t numMembers = 0;
+    Array sumDeviation(_names.size());
+    Array maxDeviation(_names.size());
+    for (const auto& shard : _shards)
+    {
+        numEntries += shard.entries.size();
+        allocatedBytes += shard.allocatedBytes;
+        numMembers += shard.numMembers;
+        sumDeviation += shard.sumDeviation;
+        for (size_t i = 0; i != _names.size(); ++i) maxDeviation[i] = max(maxDeviation[i], shard.maxDeviation[i]);
+    }
+
+    size_t numCells = numEntries + numMembers;
+    string result = std::to_string(numEntries) + " representative cells solved ("
+                    + StringUtils::toMemSizeString(allocatedBytes) + "), " + std::to_string(numMembers)
+                    + " member cells copied ("
+                    + StringUtils::toString(numCells ? 100. * numMembers / numCells : 0., 'f', 1)
+                    + "%); member deviation mean/max (dex):";
+    for (size_t i = 0; i != _names.size(); ++i)
+    {
+        double mean = numMembers ? sumDeviation[i] / numMembers : 0.;
+        result += " " + _names[i] + " " + StringUtils::toString(mean, 'f', 3) + "/"
+                  + StringUtils::toString(maxDeviation[i], 'f', 3);
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PhotoIonizationCellLibrary::clear()
+{
+    size_t allocatedBytes = 0;
+    for (auto& shard : _shards)
+    {
+        allocatedBytes += shard.allocatedBytes;
+        shard.allocatedBytes = 0;
+        shard.entries.clear();
+        shard.numMembers = 0;
+        shard.sumDeviation = 0.;
+        shard.maxDeviation = 0.;
+    }
+    if (allocatedBytes) _ledger->release(ledgerCategory, allocatedBytes);
+}
+
+////////////////////////////////////////////////////////////////////
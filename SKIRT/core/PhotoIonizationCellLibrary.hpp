@@ -0,0 +1,123 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef PHOTOIONIZATIONCELLLIBRARY_HPP
+#define PHOTOIONIZATIONCELLLIBRARY_HPP
+
+#include "Array.hpp"
+#include <map>
+#include <mutex>
+class MemoryLedger;
+
+////////////////////////////////////////////////////////////////////
+
+/** PhotoIonizationCellLibrary is a helper class for DiffuseIonizedGasMix that allows spatial cells
+    with similar physical conditions to share the outcome of a single photoionization calculation
+    during a given dynamic medium state update cycle. A single library instance is shared between
+    all parallel execution threads in a process.
+
+    The conditions in a cell are described by a number of parameters expressed as decimal
+    logarithms, such as the ionization parameter, the hydrogen number density, the metallicity,
+    and the spectral shape ratios of the ionizing radiation field. The library quantizes these
+    parameters on a regular grid with a given bin width (in dex). The first cell that is handled in
+    a given bin serves as the representative for that bin: its state is calculated in full and
+    stored in the library. Subsequent cells falling in the same bin (the members) copy the stored
+    state, appropriately rescaled by the caller.
+
+    Because the representative of a bin is the first cell handled by any of the execution threads
+    in the process, the state assigned to member cells depends, within the accuracy implied by the
+    bin width, on the order in which the parallel threads process the cells. In other words,
+    simulations using the library are not bit-for-bit reproducible between runs with multiple
+    threads. Also, each process has its own library and thus its own representatives for the cells
+    it handles, so that the results depend on the number of processes as well. To allow assessing
+    the impact of the approximation, the library keeps track of the mean and maximum absolute
+    deviation (in dex) between the parameters of the member cells and those of their
+    representative.
+
+    To avoid serializing the parallel update, the bins are distributed over a number of shards
+    based on a hash of the bin key, each with its own map, statistics and mutex, so that threads
+    handling cells in different bins rarely contend for the same lock. The library should be
+    cleared through the clear() function at the start of each update cycle.
+
+    The memory occupied by the stored entries is registered with the simulation's MemoryLedger
+    under the "photoionization cell library" category as entries are inserted, and released when
+    the library is cleared. */
+class PhotoIonizationCellLibrary
+{
+public:
+    /** An instance of this structure holds the state calculated for a representative cell. The
+        \em parameters array holds the representative's (logarithmic) parameter values; the
+        meaning of the other fields is defined by the caller. */
+    struct Entry
+    {
+        Array parameters;
+        double nH{0.};
+        double T{0.};
+        double h0{0.};
+        double he0{0.};
+        Array ionFracDiags;
+        Array ionFracAggs;
+        Array opacityAbs, opacitySca, opacityExt;
+    };
+
+    /** The type of the key identifying a library bin. */
+    using Key = vector<int64_t>;
+
+    /** The constructor initializes a library with the specified bin width (in dex) for parameters
+        with the specified names, registering its memory with the specified memory ledger. The
+        names are used only for reporting statistics. */
+    PhotoIonizationCellLibrary(double resolution, const vector<string>& parameterNames, MemoryLedger* ledger);
+
+    /** This function quantizes the specified parameter values and stores the resulting bin key
+        into \em key. Non-finite parameter values are assigned to a separate bin. */
+    void quantize(const Array& parameters, Key& key) const;
+
+    /** This function returns the entry for the bin with the specified key, or a null pointer if
+        the bin has no entry yet. If an entry is found, the deviation between the specified
+        parameter values and those of the representative is recorded. This function is
+        thread-safe. */
+    std::shared_ptr<const Entry> find(const Key& key, const Array& parameters);
+
+    /** This function stores the specified entry for the bin with the specified key, unless another
+        thread stored an entry for that bin in the meantime. This function is thread-safe. */
+    void insert(const Key& key, std::shared_ptr<const Entry> entry);
+
+    /** This function returns a human-readable summary of the library statistics gathered since the
+        library was most recently cleared. It should be called in serial mode. */
+    string statistics() const;
+
+    /** This function clears the library and the statistics, and releases the memory occupied by
+        the stored entries from the memory ledger. It should be called in serial mode at the start
+        of each update cycle. */
+    void clear();
+
+private:
+    /** An instance of this structure holds the bins assigned to a given shard of the library, and
+        the statistics for the members of these bins, all protected by the mutex. */
+    struct Shard
+    {
+        std::mutex mutex;
+        std::map<Key, std::shared_ptr<const Entry>> entries;
+        size_t allocatedBytes{0};
+        size_t numMembers{0};
+        Array sumDeviation;
+        Array maxDeviation;
+    };
+
+    /** This function returns the shard holding the bin with the specified key. */
+    Shard& shard(const Key& key);
+
+    // configuration
+    double _resolution;
+    vector<string> _names;
+    MemoryLedger* _ledger;
+
+    // the library itself and statistics, distributed over shards
+    vector<Shard> _shards;
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
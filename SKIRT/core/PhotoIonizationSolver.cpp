@@ -36,12 +36,15 @@ namespace
     constexpr double zetaCR = 2.0e-16;                             // CR ionization rate [s^-1]
     constexpr double crHeatPerIonization = 35.0 * 1.60217663e-12;  // 35 eV [erg]
 
-    // temperature bisection parameters
+    // temperature root-finding parameters
     constexpr double Tmin = 300.;
     constexpr double Tmax = 1e9;
     constexpr int maxTIterations = 100;
     constexpr double Ttolerance = 1e-3;  // relative tolerance on T
 
+    // rate coefficient table: log10(T) grid covering the bisection range with the given spacing
+    constexpr double rateTableDLogT = 0.002;
+
     // number of ionization stages per element (including fully ionized)
     // H: HI, HII (2); He: HeI, HeII, HeIII (3); C: CI-CVII (7); N: NI-NVIII (8);
     // O: OI-OIX (9); Ne: NeI-NeIX (9); Mg: MgI-MgXI (11); Si: SiI-SiXIII (13);
@@ -121,6 +124,12 @@ void PhotoIonizationSolver::initialize(const Array& lambdav, const Array& dlambd
         _energy[i] = E_J / Constants::Qelectron();                  // J -> eV
     }
 
+    // precompute the integration kernels for the photoionization and photoheating rates
+    buildKernels();
+
+    // precompute the rate coefficient table
+    buildRateTable();
+
     // load metal cooling table if path provided
     if (coolingTable) loadCoolingTable();
 
@@ -139,6 +148,17 @@ int PhotoIonizationSolver::totalEffectiveStages() const
 
 //////////////////////////////////////////////////////////////////////
 
+size_t PhotoIonizationSolver::allocatedBytes() const
+{
+    size_t numDoubles = _lambda.size() + _dlambda.size() + _energy.size() + _energyErg.size() + _rateKernel.size()
+                        + _heatKernel.size() + _rateTable.size() + _coolLogT.size() + _coolLogNe.size()
+                        + _coolData.size();
+    size_t numInts = _kernelBegin.size() + _kernelEnd.size() + _stabIdxForIon.size();
+    return numDoubles * sizeof(double) + numInts * sizeof(int);
+}
+
+//////////////////////////////////////////////////////////////////////
+
 void PhotoIonizationSolver::setMaxIonizationEnergy(double maxEV)
 {
     for (int e = 0; e < nElements; e++)
@@ -190,11 +210,8 @@ void PhotoIonizationSolver::initializeIonFractions(double ionFracs[]) const
 
 //////////////////////////////////////////////////////////////////////
 
-void PhotoIonizationSolver::computePhotoionizationRates(const Array& Jv, double gamma[]) const
+void PhotoIonizationSolver::buildKernels()
 {
-    // initialize to zero
-    for (int ion = 0; ion < VernerCrossSections::numIons; ion++) gamma[ion] = 0.;
-
     // integrate 4*pi * J_lambda * sigma(E) / (h*nu) * dlambda for each ion
     // J_lambda [W m^-3 sr^-1], convert to J_nu [erg s^-1 cm^-2 Hz^-1 sr^-1]:
     //   J_nu = J_lambda * lambda^2 / c  [W m^-2 Hz^-1 sr^-1]
@@ -208,41 +225,89 @@ void PhotoIonizationSolver::computePhotoionizationRates(const Array& Jv, double
     // So gamma = 4pi * sum { J_lambda * dlambda * lambda * sigma / (hc) }
     // units: [W/m^3/sr] * [m] * [m] * [cm^2] / [J*m] = [1/s] * [cm^2/m^2]
     // need to convert cm^2 to m^2: factor 1e-4, or equivalently divide by 1e4
+    //
+    // heating = sum over ions of n_ion * integral{ 4pi * J_nu * sigma(nu) * (h*nu - IP) / (h*nu) dnu }
+    // = sum over ions of n_ion * integral{ 4pi * J_lambda * sigma(E) * (E - IP) / E * dlambda * lambda / (hc) }
+    // same unit conversion as photoionization rates, but weighted by (E - IP) in erg
+    //
+    // the weights depend only on the wavelength grid, so they are stored as ion-by-wavelength matrices
 
     double hc_SI = Constants::h() * Constants::c();  // h*c in J*m
+    int numIons = VernerCrossSections::numIons;
 
-    for (int i = 0; i < _numBins; i++)
-    {
-        double E_eV = _energy[i];
-        double lam = _lambda[i];
-        double dl = _dlambda[i];
-        double Jlam = Jv[i];  // W m^-3 sr^-1
-        if (Jlam <= 0.) continue;
-
-        // common factor: 4pi * J_lambda * dlambda * lambda / (hc) [s^-1 per cm^2 -> need * 1e-4 for m^2]
-        double factor = fourPi * Jlam * dl * lam / hc_SI * 1e-4;
+    _rateKernel.assign(static_cast<size_t>(numIons) * _numBins, 0.);
+    _heatKernel.assign(static_cast<size_t>(numIons) * _numBins, 0.);
+    _kernelBegin.assign(numIons, 0);
+    _kernelEnd.assign(numIons, 0);
 
-        for (int ion = 0; ion < VernerCrossSections::numIons; ion++)
+    for (int ion = 0; ion < numIons; ion++)
+    {
+        double IP = VernerCrossSections::ionizationPotential(ion);
+        double* rateRow = _rateKernel.data() + static_cast<size_t>(ion) * _numBins;
+        double* heatRow = _heatKernel.data() + static_cast<size_t>(ion) * _numBins;
+        int begin = _numBins;
+        int end = 0;
+        for (int i = 0; i < _numBins; i++)
         {
+            double E_eV = _energy[i];
             double sig = VernerCrossSections::sigma(ion, E_eV);
-            if (sig > 0.) gamma[ion] += factor * sig;
+            if (sig <= 0.) continue;
+
+            // common factor: 4pi * dlambda * lambda / (hc) [s^-1 per cm^2 -> need * 1e-4 for m^2]
+            double factor = fourPi * _dlambda[i] * _lambda[i] / hc_SI * 1e-4;
+            rateRow[i] = factor * sig;
+            if (E_eV > IP) heatRow[i] = factor * sig * (E_eV - IP) * eV_erg;
+            begin = std::min(begin, i);
+            end = i + 1;
         }
+        _kernelBegin[ion] = std::min(begin, end);
+        _kernelEnd[ion] = end;
     }
 }
 
 //////////////////////////////////////////////////////////////////////
 
-double PhotoIonizationSolver::computeHeatingRate(const Array& Jv, const double ionFracs[], double nH, double yHe,
-                                                 const double metalAbundances[8], double ne, const int effNS[]) const
+namespace
 {
-    (void)ne;  // reserved for future Compton heating term
+    // returns the dot product of the specified kernel row with the positive part of the radiation field,
+    // limited to the specified bin range; bins with nonpositive J_lambda do not contribute
+    inline double integrateKernelRow(const double* row, const Array& Jv, int begin, int end)
+    {
+        double sum = 0.;
+        for (int i = begin; i < end; i++) sum += row[i] * std::max(Jv[i], 0.);
+        return sum;
+    }
+}
 
-    // heating = sum over ions of n_ion * integral{ 4pi * J_nu * sigma(nu) * (h*nu - IP) / (h*nu) dnu }
-    // = sum over ions of n_ion * integral{ 4pi * J_lambda * sigma(E) * (E - IP) / E * dlambda * lambda / (hc) }
-    // same unit conversion as photoionization rates, but weighted by (E - IP) in erg
+//////////////////////////////////////////////////////////////////////
 
-    double hc_SI = Constants::h() * Constants::c();
-    double heating = 0.;
+void PhotoIonizationSolver::computePhotoionizationRates(const Array& Jv, double gamma[]) const
+{
+    for (int ion = 0; ion < VernerCrossSections::numIons; ion++)
+    {
+        const double* row = _rateKernel.data() + static_cast<size_t>(ion) * _numBins;
+        gamma[ion] = integrateKernelRow(row, Jv, _kernelBegin[ion], _kernelEnd[ion]);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void PhotoIonizationSolver::computeHeatingIntegrals(const Array& Jv, double heatPerIon[]) const
+{
+    for (int ion = 0; ion < VernerCrossSections::numIons; ion++)
+    {
+        const double* row = _heatKernel.data() + static_cast<size_t>(ion) * _numBins;
+        heatPerIon[ion] = integrateKernelRow(row, Jv, _kernelBegin[ion], _kernelEnd[ion]);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+double PhotoIonizationSolver::computeHeatingRate(const double heatPerIon[], const double ionFracs[], double nH,
+                                                 double yHe, const double metalAbundances[8], double ne,
+                                                 const int effNS[]) const
+{
+    (void)ne;  // reserved for future Compton heating term
 
     // precompute number densities for each ion with XS
     double nIon[VernerCrossSections::numIons];
@@ -263,26 +328,9 @@ double PhotoIonizationSolver::computeHeatingRate(const Array& Jv, const double i
         for (int s = 0; s < nxs; s++) nIon[voff + s] = nElem * ionFracs[off + s];
     }
 
-    for (int i = 0; i < _numBins; i++)
-    {
-        double E_eV = _energy[i];
-        double lam = _lambda[i];
-        double dl = _dlambda[i];
-        double Jlam = Jv[i];
-        if (Jlam <= 0.) continue;
-
-        double baseFactor = fourPi * Jlam * dl * lam / hc_SI * 1e-4;
-
-        for (int ion = 0; ion < VernerCrossSections::numIons; ion++)
-        {
-            double sig = VernerCrossSections::sigma(ion, E_eV);
-            if (sig <= 0.) continue;
-            double IP = VernerCrossSections::ionizationPotential(ion);
-            if (E_eV <= IP) continue;
-            double excessErg = (E_eV - IP) * eV_erg;
-            heating += nIon[ion] * baseFactor * sig * excessErg;
-        }
-    }
+    // weight the per-ion heating integrals by the ion number densities
+    double heating = 0.;
+    for (int ion = 0; ion < VernerCrossSections::numIons; ion++) heating += nIon[ion] * heatPerIon[ion];
 
     // Cosmic-ray background heating: Gamma_CR = scale * zeta_CR * 35 eV * nHI
     if (_cosmicRayHeating)
@@ -632,10 +680,93 @@ double PhotoIonizationSolver::computeCoolingRate(double T, const double ionFracs
 
 //////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // column indices in a row of rate coefficients: H and He rates followed by 6 rates per Verner ion index
+    enum RateColumn { rAlphaHII, rBetaHI, rAlphaHeII, rBetaHeI, rXiHeII, rAlphaHeIII, rBetaHeII, rXiHeIII, rFirstIon };
+    enum IonRateColumn { rBeta, rAlpha, rXiHI, rChiHII, rXiHeI, rChiHeII, rNumPerIon };
+
+    // evaluates the rate coefficients for temperature T from the analytic fitting formulas
+    void evaluateRateCoefficients(double T, double rates[])
+    {
+        rates[rAlphaHII] = PhotoIonizationRates::alphaBHII(T);
+        rates[rBetaHI] = PhotoIonizationRates::betaHI(T);
+        rates[rAlphaHeII] = PhotoIonizationRates::alphaBHeII(T) + PhotoIonizationRates::alphaDRHeII(T);
+        rates[rBetaHeI] = PhotoIonizationRates::betaHeI(T);
+        rates[rXiHeII] = PhotoIonizationRates::xiHIHeII(T);
+        rates[rAlphaHeIII] = PhotoIonizationRates::alphaBHeIII(T);
+        rates[rBetaHeII] = PhotoIonizationRates::betaHeII(T);
+        rates[rXiHeIII] = PhotoIonizationRates::xiHIHeIII(T);
+        for (int vi = 0; vi < VernerCrossSections::numIons; vi++)
+        {
+            double* ionRates = rates + rFirstIon + rNumPerIon * vi;
+            ionRates[rBeta] = PhotoIonizationRates::beta(vi, T);
+            ionRates[rAlpha] = PhotoIonizationRates::alphaTotal(vi, T);
+            ionRates[rXiHI] = PhotoIonizationRates::xiHI(vi + 1, T);
+            ionRates[rChiHII] = PhotoIonizationRates::chiHII(vi, T);
+            ionRates[rXiHeI] = PhotoIonizationRates::xiHeI(vi + 1, T);
+            ionRates[rChiHeII] = PhotoIonizationRates::chiHeII(vi, T);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void PhotoIonizationSolver::buildRateTable()
+{
+    static_assert(numRateCoefficients == rFirstIon + rNumPerIon * VernerCrossSections::numIons,
+                  "Inconsistent number of rate coefficients");
+
+    // store the natural logarithm of each coefficient; vanishing coefficients are stored as -infinity
+    _rateLogTmin = std::log10(Tmin);
+    _rateInvDLogT = 1. / rateTableDLogT;
+    _rateNT = static_cast<int>(std::ceil((std::log10(Tmax) - _rateLogTmin) * _rateInvDLogT)) + 1;
+    _rateTable.resize(static_cast<size_t>(_rateNT) * numRateCoefficients);
+    for (int iT = 0; iT < _rateNT; iT++)
+    {
+        double* row = _rateTable.data() + static_cast<size_t>(iT) * numRateCoefficients;
+        evaluateRateCoefficients(std::pow(10., _rateLogTmin + iT * rateTableDLogT), row);
+        for (int k = 0; k < numRateCoefficients; k++) row[k] = row[k] > 0. ? std::log(row[k]) : -INFINITY;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void PhotoIonizationSolver::rateCoefficients(double T, double rates[]) const
+{
+    // use the analytic formulas outside of the tabulated range
+    double x = (std::log10(T) - _rateLogTmin) * _rateInvDLogT;
+    if (!(x >= 0.) || x > _rateNT - 1)
+    {
+        evaluateRateCoefficients(T, rates);
+        return;
+    }
+
+    // interpolate log-log between the two bracketing rows; if one of the bracketing coefficients vanishes,
+    // interpolate linearly instead so that the result is zero when both vanish
+    int iT = std::min(static_cast<int>(x), _rateNT - 2);
+    double w = x - iT;
+    const double* lo = _rateTable.data() + static_cast<size_t>(iT) * numRateCoefficients;
+    const double* hi = lo + numRateCoefficients;
+    for (int k = 0; k < numRateCoefficients; k++)
+    {
+        if (std::isfinite(lo[k]) && std::isfinite(hi[k]))
+            rates[k] = std::exp(lo[k] + w * (hi[k] - lo[k]));
+        else
+            rates[k] = (1. - w) * std::exp(lo[k]) + w * std::exp(hi[k]);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
 double PhotoIonizationSolver::solveIonizationBalance(double T, double ne, const double gamma[], double nH, double yHe,
                                                      const double metalAbundances[8], double ionFracs[],
                                                      const int effNS[]) const
 {
+    // obtain the rate coefficients for this temperature, which remains fixed during the iteration
+    double rates[numRateCoefficients];
+    rateCoefficients(T, rates);
+
     // iterate until electron density converges; start fully ionized (xe=1)
     double xe = 1.;
     ne = nH;
@@ -644,8 +775,8 @@ double PhotoIonizationSolver::solveIonizationBalance(double T, double ne, const
     for (int iter = 0; iter < maxNeIterations; iter++)
     {
         // -- Hydrogen --
-        double aHII = PhotoIonizationRates::alphaBHII(T);
-        double bHI = PhotoIonizationRates::betaHI(T);
+        double aHII = rates[rAlphaHII];
+        double bHI = rates[rBetaHI];
         double gHI = gamma[0];
         double cHI = (bHI + gHI / ne) / aHII;
         double xHI = 1. / (1. + cHI);
@@ -657,14 +788,14 @@ double PhotoIonizationSolver::solveIonizationBalance(double T, double ne, const
         double HIIe = xHII / xe;  // n_HII / n_e (per H density)
 
         // -- Helium --
-        double aHeII = PhotoIonizationRates::alphaBHeII(T) + PhotoIonizationRates::alphaDRHeII(T);
-        double bHeI = PhotoIonizationRates::betaHeI(T);
+        double aHeII = rates[rAlphaHeII];
+        double bHeI = rates[rBetaHeI];
         double gHeI = gamma[1];
-        double eHeII = PhotoIonizationRates::xiHIHeII(T);
-        double aHeIII = PhotoIonizationRates::alphaBHeIII(T);
-        double bHeII = PhotoIonizationRates::betaHeII(T);
+        double eHeII = rates[rXiHeII];
+        double aHeIII = rates[rAlphaHeIII];
+        double bHeII = rates[rBetaHeII];
         double gHeII = gamma[2];
-        double eHeIII = PhotoIonizationRates::xiHIHeIII(T);
+        double eHeIII = rates[rXiHeIII];
 
         double cHeI = safediv(bHeI + gHeI / ne, aHeII + eHeII * HIe);
         double cHeII = safediv(bHeII + gHeII / ne, aHeIII + eHeIII * HIe);
@@ -695,17 +826,18 @@ double PhotoIonizationSolver::solveIonizationBalance(double T, double ne, const
             for (int s = nxs - 1; s >= 0; s--)
             {
                 int vi = voff + s;  // Verner index for this ion stage
+                const double* ionRates = rates + rFirstIon + rNumPerIon * vi;
                 double photoRate = gamma[vi];
-                double betaRate = PhotoIonizationRates::beta(vi, T);
-                double alphaRate = PhotoIonizationRates::alphaTotal(vi, T);  // recomb into stage s
+                double betaRate = ionRates[rBeta];
+                double alphaRate = ionRates[rAlpha];  // recomb into stage s
 
                 // charge exchange with H
-                double xiHIRate = PhotoIonizationRates::xiHI(vi + 1, T);  // ion(s+1) + HI -> ion(s) + HII
-                double chiHIIRate = PhotoIonizationRates::chiHII(vi, T);  // ion(s) + HII -> ion(s+1) + HI
+                double xiHIRate = ionRates[rXiHI];      // ion(s+1) + HI -> ion(s) + HII
+                double chiHIIRate = ionRates[rChiHII];  // ion(s) + HII -> ion(s+1) + HI
 
                 // charge exchange with He
-                double xiHeIRate = PhotoIonizationRates::xiHeI(vi + 1, T);  // ion(s+1) + HeI -> ion(s) + HeII
-                double chiHeIIRate = PhotoIonizationRates::chiHeII(vi, T);  // ion(s) + HeII -> ion(s+1) + HeI
+                double xiHeIRate = ionRates[rXiHeI];      // ion(s+1) + HeI -> ion(s) + HeII
+                double chiHeIIRate = ionRates[rChiHeII];  // ion(s) + HeII -> ion(s+1) + HeI
 
                 c[s] = safediv(betaRate + chiHIIRate * HIIe + chiHeIIRate * HeIIe + photoRate / ne,
                                alphaRate + xiHIRate * HIe + xiHeIRate * HeIe);
@@ -769,77 +901,116 @@ PhotoIonizationSolver::CellResult PhotoIonizationSolver::solve(const Array& Jv,
         initializeIonFractions(result.ionFracs);
     }
 
-    // compute photoionization rates from J_nu
+    // compute photoionization rates and per-ion heating integrals from J_nu
     double gamma[VernerCrossSections::numIons];
     computePhotoionizationRates(Jv, gamma);
+    double heatPerIon[VernerCrossSections::numIons];
+    computeHeatingIntegrals(Jv, heatPerIon);
 
     // initial electron density: always start fully ionized (xe=1)
     double ne = nH;
 
-    // temperature bisection: find T where heating(T) = cooling(T)
+    // allowed temperature range
     double Tlo = Tmin;
     double Thi = Tmax;
 
-    // temperature damping: clamp bisection range to [Tprior/factor, Tprior*factor]
+    // temperature damping: clamp allowed range to [Tprior/factor, Tprior*factor]
     if (TdampFactor > 1. && Tprior > Tmin)
     {
         Tlo = std::max(Tlo, Tprior / TdampFactor);
         Thi = std::min(Thi, Tprior * TdampFactor);
     }
 
+    // solves the ionization balance at the given temperature, stores the heating and cooling rates,
+    // and returns the normalized residual (heat - cool) / (heat + cool), which is positive if the temperature
+    // needs to be higher; if both rates vanish, the residual is negative so that the temperature is lowered
+    double heat = 0.;
+    double cool = 0.;
+    auto residual = [&](double T) {
+        ne = solveIonizationBalance(T, ne, gamma, nH, yHe, metalAbundances, result.ionFracs, _nStagesEff);
+        heat = computeHeatingRate(heatPerIon, result.ionFracs, nH, yHe, metalAbundances, ne, _nStagesEff);
+        cool = computeCoolingRate(T, result.ionFracs, nH, yHe, metalAbundances, ne, _nStagesEff);
+        return (heat + cool) > 0. ? (heat - cool) / (heat + cool) : -1.;
+    };
+
+    // stores the state for the given temperature into the result and returns it
+    auto finish = [&](double T) {
+        result.Teq = T;
+        result.ne = ne;
+        result.heatingRate = heat;
+        result.coolingRate = cool;
+        return result;
+    };
+
+    // evaluate the residual at the prior temperature
     double T = std::max(Tlo, std::min(Tprior, Thi));
-    double Tprev = T;
+    double f = residual(T);
+    if (f == 0.) return finish(T);
 
-    for (int iter = 0; iter < maxTIterations; iter++)
+    // adaptive damping: tighten allowed T range as cell approaches equilibrium
+    if (TdampFactor > 1. && Tprior > Tmin)
     {
-        // solve ionization balance at current T
-        ne = solveIonizationBalance(T, ne, gamma, nH, yHe, metalAbundances, result.ionFracs, _nStagesEff);
+        double adaptiveFactor = std::abs(f) * (TdampFactor - 1.) + 1.;
+        Tlo = std::max(Tlo, Tprior / adaptiveFactor);
+        Thi = std::min(Thi, Tprior * adaptiveFactor);
+    }
 
-        // compute heating and cooling
-        double heat = computeHeatingRate(Jv, result.ionFracs, nH, yHe, metalAbundances, ne, _nStagesEff);
-        double cool = computeCoolingRate(T, result.ionFracs, nH, yHe, metalAbundances, ne, _nStagesEff);
+    // phase 1: warm-started bracketing; step away from the prior temperature in the direction indicated by the
+    // residual, squaring the step factor after each step, until the residual changes sign or the edge of the
+    // allowed range is reached (in which case the edge temperature is returned, as for plain bisection)
+    double Ta = T, fa = f;  // the most recent temperature and residual
+    double Tb = T, fb = f;  // the temperature and residual on the other side of the root, once found
+    double factor = 1.25;
+    int iter = 1;
+    for (; iter < maxTIterations; iter++)
+    {
+        double Tedge = fa > 0. ? Thi : Tlo;
+        if (std::abs(Tedge - Ta) <= Ttolerance * Ta) return finish(Ta);
+        Tb = fa > 0. ? std::min(Thi, Ta * factor) : std::max(Tlo, Ta / factor);
+        fb = residual(Tb);
+        if (fb == 0.) return finish(Tb);
+        if ((fa > 0.) != (fb > 0.)) break;
+        Ta = Tb;
+        fa = fb;
+        factor *= factor;
+    }
 
-        // adaptive damping: tighten allowed T range as cell approaches equilibrium
-        if (iter == 0 && TdampFactor > 1. && Tprior > Tmin && (heat + cool) > 0.)
+    // phase 2: Illinois variant of regula falsi on the residual as a function of log T within the bracket,
+    // safeguarded by a bisection step whenever the interpolated point does not lie well inside the bracket
+    double ua = std::log(Ta), ub = std::log(Tb);
+    int side = 0;  // which endpoint was retained in the previous step: -1 for a, +1 for b, 0 for none
+    T = Tb;
+    for (++iter; iter < maxTIterations; iter++)
+    {
+        double u = (ua * fb - ub * fa) / (fb - fa);
+        double margin = 0.01 * std::abs(ub - ua);
+        if (!(u > std::min(ua, ub) + margin && u < std::max(ua, ub) - margin)) u = 0.5 * (ua + ub);
+
+        double Tprev = T;
+        T = std::exp(u);
+        f = residual(T);
+        if (f == 0. || std::abs(T - Tprev) < Ttolerance * T || std::abs(ub - ua) < Ttolerance) return finish(T);
+
+        // replace the endpoint with the same residual sign; if the same endpoint is retained twice in a row,
+        // halve its residual to avoid the slow one-sided convergence of plain regula falsi
+        if ((f > 0.) == (fb > 0.))
         {
-            double fractionalImbalance = std::abs(heat - cool) / (heat + cool);
-            double adaptiveFactor = fractionalImbalance * (TdampFactor - 1.) + 1.;
-            Tlo = std::max(Tlo, Tprior / adaptiveFactor);
-            Thi = std::min(Thi, Tprior * adaptiveFactor);
+            ub = u;
+            fb = f;
+            if (side == -1) fa *= 0.5;
+            side = -1;
         }
-
-        // check convergence: relative T change (skip first two iterations to let bracket establish)
-        if (iter > 1 && std::abs(T - Tprev) < Ttolerance * T)
+        else
         {
-            result.Teq = T;
-            result.ne = ne;
-            result.heatingRate = heat;
-            result.coolingRate = cool;
-            return result;
+            ua = u;
+            fa = f;
+            if (side == +1) fb *= 0.5;
+            side = +1;
         }
-
-        // bisect: if heating > cooling, temperature needs to be higher (more cooling)
-        // if cooling > heating, temperature needs to be lower (less cooling)
-        if (heat > cool)
-            Tlo = T;
-        else
-            Thi = T;
-
-        // first step: jump to bracket edge to establish root-straddling bracket quickly
-        Tprev = T;
-        if (iter == 0)
-            T = (heat > cool) ? Thi : Tlo;
-        else
-            // geometric bisection for wide brackets (>5 dex), linear otherwise
-            T = (Thi > 1e5 * Tlo) ? std::sqrt(Tlo * Thi) : 0.5 * (Tlo + Thi);
     }
 
     // if not converged, return best estimate
-    result.Teq = T;
-    result.ne = ne;
-    result.heatingRate = computeHeatingRate(Jv, result.ionFracs, nH, yHe, metalAbundances, ne, _nStagesEff);
-    result.coolingRate = computeCoolingRate(T, result.ionFracs, nH, yHe, metalAbundances, ne, _nStagesEff);
-    return result;
+    return finish(T);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -863,9 +1034,11 @@ PhotoIonizationSolver::CellResult PhotoIonizationSolver::solveIonizationAtFixedT
         initializeIonFractions(result.ionFracs);
     }
 
-    // compute photoionization rates from J_lambda (included even in CIE mode)
+    // compute photoionization rates and per-ion heating integrals from J_lambda (included even in CIE mode)
     double gamma[VernerCrossSections::numIons];
     computePhotoionizationRates(Jv, gamma);
+    double heatPerIon[VernerCrossSections::numIons];
+    computeHeatingIntegrals(Jv, heatPerIon);
 
     // initial electron density: always start fully ionized (xe=1)
     double ne = nH;
@@ -876,7 +1049,7 @@ PhotoIonizationSolver::CellResult PhotoIonizationSolver::solveIonizationAtFixedT
     // compute heating and cooling for diagnostics
     result.Teq = T;
     result.ne = ne;
-    result.heatingRate = computeHeatingRate(Jv, result.ionFracs, nH, yHe, metalAbundances, ne, effNS);
+    result.heatingRate = computeHeatingRate(heatPerIon, result.ionFracs, nH, yHe, metalAbundances, ne, effNS);
     result.coolingRate = computeCoolingRate(T, result.ionFracs, nH, yHe, metalAbundances, ne, effNS);
     return result;
 }
@@ -20,7 +20,8 @@
 
     The solver implements:
     - Ionization balance via the Katz, Weinberg & Hernquist (1996) recursion
-    - Temperature from explicit heating = cooling equilibrium (bisection)
+    - Temperature from explicit heating = cooling equilibrium (warm-started bracketing followed by
+      a safeguarded Illinois root finder)
     - Heating from full J_lambda integration (no 5-bin compression)
     - Cooling from analytic H/He channels plus pre-tabulated metal line cooling
     - Opacity computed analytically from ion fractions and Verner+ cross-sections
@@ -73,7 +74,15 @@ public:
 
     //======== Main solve interface =======
 
-    /** Solves the ionization balance and thermal equilibrium for a single cell.
+    /** Solves the ionization balance and thermal equilibrium for a single cell. The equilibrium
+        temperature is the root of the normalized residual (heating - cooling) / (heating +
+        cooling) as a function of log T. Starting from the prior temperature, the solver steps
+        outward in the direction indicated by the residual with geometrically growing steps until
+        the residual changes sign, and then refines the root within this bracket using the Illinois
+        variant of regula falsi, falling back to bisection when an interpolated step would not lie
+        well inside the bracket. As a result, the solver returns the equilibrium closest to the
+        prior temperature. If no sign change occurs within the allowed temperature range, the
+        temperature at the edge of the range is returned.
         \param Jv mean intensity J_lambda at each wavelength bin [W m^-3 sr^-1]
         \param nH hydrogen number density [cm^-3]
         \param yHe helium abundance by number relative to H
@@ -131,17 +140,37 @@ public:
     /** Returns the number of wavelength bins in the solver's grid. */
     int numBins() const { return _numBins; }
 
+    /** Returns the number of bytes allocated by the solver for its precomputed integration kernels,
+        rate coefficient table and (optional) metal cooling table. */
+    size_t allocatedBytes() const;
+
     /** Computes photoionization rates [s^-1] for all ions by integrating 4*pi*J_nu*sigma(nu)/(h*nu)
-        over the wavelength grid. Results stored in gamma[]. */
+        over the wavelength grid. Results stored in gamma[]. The integration is performed as a
+        product of the precomputed rate kernel matrix with the radiation field vector, restricted
+        for each ion to the wavelength bins above its ionization threshold. */
     void computePhotoionizationRates(const Array& Jv, double gamma[]) const;
 
 private:
     //======== Internal methods =======
 
-    /** Computes the photoheating rate [erg s^-1 cm^-3] from the radiation field and ion fractions.
-        Integrates 4*pi*J_nu*sigma(nu)*(h*nu - IP)/(h*nu) over the wavelength grid, weighted by
-        ion number densities n_ion. The effNS[] array specifies effective stages per element. */
-    double computeHeatingRate(const Array& Jv, const double ionFracs[], double nH, double yHe,
+    /** Builds the rate and heating kernel matrices for the wavelength grid set by initialize().
+        For each ion and wavelength bin, the rate kernel holds the weight 4*pi*sigma*lambda*dlambda/(hc),
+        so that the photoionization rate is the dot product of the kernel row with J_lambda, and
+        the heating kernel holds the same weight multiplied by the excess energy (h*nu - IP). The
+        nonzero range of each row is recorded so that the integrations can skip bins below the
+        ionization threshold. */
+    void buildKernels();
+
+    /** Computes the photoheating rate per ion [erg s^-1] for all ions by integrating
+        4*pi*J_nu*sigma(nu)*(h*nu - IP)/(h*nu) over the wavelength grid, using the precomputed
+        heating kernel matrix. Results stored in heatPerIon[]. Because these integrals do not
+        depend on the ionization state, they are computed once per cell. */
+    void computeHeatingIntegrals(const Array& Jv, double heatPerIon[]) const;
+
+    /** Computes the photoheating rate [erg s^-1 cm^-3] from the per-ion heating integrals
+        calculated by computeHeatingIntegrals() and the ion fractions, weighted by ion number
+        densities n_ion. The effNS[] array specifies effective stages per element. */
+    double computeHeatingRate(const double heatPerIon[], const double ionFracs[], double nH, double yHe,
                               const double metalAbundances[8], double ne, const int effNS[]) const;
 
     /** Computes the total cooling rate [erg s^-1 cm^-3] from analytic H/He cooling channels
@@ -150,10 +179,23 @@ private:
     double computeCoolingRate(double T, const double ionFracs[], double nH, double yHe, const double metalAbundances[8],
                               double ne, const int effNS[]) const;
 
+    /** Tabulates the recombination, collisional ionization and charge exchange rate coefficients
+        used by solveIonizationBalance() on a fine logarithmic temperature grid, so that they can
+        be obtained for all ions through a single interpolation per temperature. */
+    void buildRateTable();
+
+    /** Stores the rate coefficients used by solveIonizationBalance() for temperature T into the
+        rates[] array, which must have room for numRateCoefficients values. Within the range of the
+        tabulated temperature grid, the coefficients are interpolated log-log from the table;
+        outside of this range, they are evaluated from the analytic fitting formulas. */
+    void rateCoefficients(double T, double rates[]) const;
+
     /** Solves the ionization balance for all species at temperature T and electron density ne,
         given photoionization rates gamma[]. Uses the Katz+ (1996) recursion for metals and
         iterative solution for H/He. Updates ionFracs[] and returns the new electron density.
-        The effNS[] array specifies effective stages per element. */
+        The effNS[] array specifies effective stages per element. Because the temperature is
+        fixed, the rate coefficients are obtained only once, before the electron density
+        iteration. */
     double solveIonizationBalance(double T, double ne, const double gamma[], double nH, double yHe,
                                   const double metalAbundances[8], double ionFracs[], const int effNS[]) const;
 
@@ -174,6 +216,23 @@ private:
     std::vector<double> _energy;     ///< photon energy per bin [eV]
     std::vector<double> _energyErg;  ///< photon energy per bin [erg]
 
+    //======== Precomputed integration kernels =======
+
+    std::vector<double> _rateKernel;  ///< photoionization rate weights [ion][bin] flattened
+    std::vector<double> _heatKernel;  ///< photoheating weights [ion][bin] flattened [erg]
+    std::vector<int> _kernelBegin;    ///< first bin with nonzero weight for each ion
+    std::vector<int> _kernelEnd;      ///< one past the last bin with nonzero weight for each ion
+
+    //======== Tabulated rate coefficients =======
+
+    /** Number of rate coefficients per temperature: 8 for H and He, and 6 per Verner ion index. */
+    static constexpr int numRateCoefficients = 8 + 6 * 74;
+
+    int _rateNT = 0;                 ///< number of points in the log T grid
+    double _rateLogTmin = 0.;        ///< log10(T/K) of the first grid point
+    double _rateInvDLogT = 0.;       ///< inverse of the log10(T/K) grid spacing
+    std::vector<double> _rateTable;  ///< ln(rate coefficient) [iT][coefficient] flattened
+
     //======== Effective stage counts (may be capped by maxIonizationEnergy) =======
 
     int _nStagesEff[numElements] = {2, 3,  7,  8, 9,
@@ -51,7 +51,38 @@
     these cases, the path length stretching mechanism will automatically be disabled during setup.
     As a result, these simulations will lack the potential optimization brought by the path length
     technique. In particulatar, penetrating regions of high optical depth may require many
-    scattering events with correspondingly longer running times. */
+    scattering events with correspondingly longer running times.
+
+    <b>Polychromatic photon packets</b>
+
+    By default, each photon packet carries a single wavelength, so that each wavelength sample
+    requires its own trip through the spatial grid. If the \em numWavelengthsPerPacket option is
+    set to a value \f$K>1\f$, each photon packet launched by a primary source carries \f$K\f$
+    wavelengths sampled independently from the source's spectral distribution (including the
+    configured wavelength bias), sharing the same launch position and direction. The luminosity of
+    the photon packet is divided evenly over these wavelengths. The first wavelength serves as the
+    reference wavelength; the others are called companion wavelengths.
+
+    The random walk of a polychromatic photon packet is determined using the reference wavelength.
+    The weight of each companion wavelength is adjusted after each interaction to compensate for
+    the difference between the probability of the actual interaction location and scattering angle
+    at the companion wavelength and the probability used for sampling them. The geometric path
+    information and the per-medium column densities obtained from a single traversal of the
+    spatial grid are reused to calculate the optical depths for all wavelengths, both for the
+    random walk, for storing the radiation field, and for the peel-off towards the instruments.
+    For panchromatic simulations with many wavelengths, this reduces the number of path
+    traversals by roughly a factor of \f$K\f$ for a given number of wavelength samples. On the
+    other hand, the companion weights may show a large dispersion when the optical properties at
+    the reference wavelength differ strongly from those at a companion wavelength, which
+    increases the noise for a given number of wavelength samples.
+
+    Polychromatic photon packets are supported only for the primary emission in simulations with
+    forced scattering, without explicit absorption, with dust media that have spatially constant
+    cross sections and do not support polarization, without kinematics (i.e. without moving
+    sources or media and without Hubble expansion), and with primary sources that have a single
+    SED or are imported from snapshot data. If any of these conditions is not met, the option is
+    automatically disabled during setup. Photon packets emitted by secondary sources are always
+    monochromatic. */
 class PhotonPacketOptions : public SimulationItem
 {
     ITEM_CONCRETE(PhotonPacketOptions, SimulationItem, "a set of options related to the photon packet lifecycle")
@@ -87,6 +118,13 @@ class PhotonPacketOptions : public SimulationItem
         ATTRIBUTE_RELEVANT_IF(pathLengthBias, "(ForceScattering)&(!Lya)")
         ATTRIBUTE_DISPLAYED_IF(pathLengthBias, "Level3")
 
+        PROPERTY_INT(numWavelengthsPerPacket, "the number of wavelengths carried by each primary photon packet")
+        ATTRIBUTE_MIN_VALUE(numWavelengthsPerPacket, "1")
+        ATTRIBUTE_MAX_VALUE(numWavelengthsPerPacket, "10000")
+        ATTRIBUTE_DEFAULT_VALUE(numWavelengthsPerPacket, "1")
+        ATTRIBUTE_RELEVANT_IF(numWavelengthsPerPacket, "ForceScattering&Panchromatic&(!Lya)")
+        ATTRIBUTE_DISPLAYED_IF(numWavelengthsPerPacket, "Level3")
+
     ITEM_END()
 };
 
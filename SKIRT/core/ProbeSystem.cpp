@@ -4,33 +4,50 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "ProbeSystem.hpp"
+#include "Tracer.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
 void ProbeSystem::probeSetup()
 {
-    for (auto probe : probes()) probe->probeSetup();
+    for (auto probe : probes())
+    {
+        Tracer trace("probe " + probe->probeName());
+        probe->probeSetup();
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
 
 void ProbeSystem::probeRun()
 {
-    for (auto probe : probes()) probe->probeRun();
+    for (auto probe : probes())
+    {
+        Tracer trace("probe " + probe->probeName());
+        probe->probeRun();
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
 
 void ProbeSystem::probePrimary(int iter)
 {
-    for (auto probe : probes()) probe->probePrimary(iter);
+    for (auto probe : probes())
+    {
+        Tracer trace("probe " + probe->probeName());
+        probe->probePrimary(iter);
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
 
 void ProbeSystem::probeSecondary(int iter)
 {
-    for (auto probe : probes()) probe->probeSecondary(iter);
+    for (auto probe : probes())
+    {
+        Tracer trace("probe " + probe->probeName());
+        probe->probeSecondary(iter);
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
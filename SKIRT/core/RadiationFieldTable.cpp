@@ -0,0 +1,150 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "RadiationFieldTable.hpp"
+#include "LockFree.hpp"
+#include "ProcessManager.hpp"
+#include <algorithm>
+#include <istream>
+#include <ostream>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // maximum number of single-precision values converted to double precision for a single communication
+    const size_t maxChunkSize = 1 << 22;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RadiationFieldTable::resize(size_t numCells, size_t numWavelengths, bool singlePrecision, double scale)
+{
+    _numCells = numCells;
+    _numWavelengths = numWavelengths;
+    _singlePrecision = singlePrecision;
+    _scale = singlePrecision && scale > 0. ? scale : 1.;
+    if (_singlePrecision)
+    {
+        _doubles.resize(0);
+        _floats.assign(size(), 0.f);
+    }
+    else
+    {
+        _floats.clear();
+        _floats.shrink_to_fit();
+        _doubles.resize(size());
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+size_t RadiationFieldTable::requiredBytes(size_t numCells, size_t numWavelengths, bool singlePrecision)
+{
+    return numCells * numWavelengths * (singlePrecision ? sizeof(float) : sizeof(double));
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RadiationFieldTable::setToZero()
+{
+    if (_singlePrecision)
+        std::fill(_floats.begin(), _floats.end(), 0.f);
+    else
+        _doubles = 0.;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RadiationFieldTable::add(size_t m, size_t ell, double value)
+{
+    size_t i = m * _numWavelengths + ell;
+    if (_singlePrecision)
+        LockFree::add(_floats[i], value / _scale);
+    else
+        LockFree::add(_doubles[i], value);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RadiationFieldTable::sumToAll()
+{
+    if (!ProcessManager::isMultiProc()) return;
+
+    if (_singlePrecision)
+    {
+        // communicate the values in chunks to limit the size of the temporary double-precision buffer
+        size_t numValues = _floats.size();
+        Array buffer;
+        for (size_t first = 0; first < numValues; first += maxChunkSize)
+        {
+            size_t chunkSize = min(maxChunkSize, numValues - first);
+            if (buffer.size() != chunkSize) buffer.resize(chunkSize);
+            for (size_t i = 0; i != chunkSize; ++i) buffer[i] = _floats[first + i];
+            ProcessManager::sumToAll(buffer);
+            for (size_t i = 0; i != chunkSize; ++i) _floats[first + i] = static_cast<float>(buffer[i]);
+        }
+    }
+    else
+    {
+        ProcessManager::sumToAll(_doubles);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RadiationFieldTable::write(std::ostream& out) const
+{
+    uint64_t dimensions[2] = {_numCells, _numWavelengths};
+    out.write(reinterpret_cast<const char*>(dimensions), sizeof(dimensions));
+
+    if (_singlePrecision)
+    {
+        // convert the values in chunks to limit the size of the temporary double-precision buffer
+        size_t numValues = _floats.size();
+        Array buffer;
+        for (size_t first = 0; first < numValues; first += maxChunkSize)
+        {
+            size_t chunkSize = min(maxChunkSize, numValues - first);
+            if (buffer.size() != chunkSize) buffer.resize(chunkSize);
+            for (size_t i = 0; i != chunkSize; ++i) buffer[i] = _floats[first + i] * _scale;
+            out.write(reinterpret_cast<const char*>(begin(buffer)), chunkSize * sizeof(double));
+        }
+    }
+    else
+    {
+        out.write(reinterpret_cast<const char*>(begin(_doubles)), _doubles.size() * sizeof(double));
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool RadiationFieldTable::read(std::istream& in)
+{
+    uint64_t dimensions[2] = {0, 0};
+    in.read(reinterpret_cast<char*>(dimensions), sizeof(dimensions));
+    if (!in || dimensions[0] != _numCells || dimensions[1] != _numWavelengths) return false;
+
+    if (_singlePrecision)
+    {
+        // convert the values in chunks to limit the size of the temporary double-precision buffer
+        size_t numValues = _floats.size();
+        Array buffer;
+        for (size_t first = 0; first < numValues && in; first += maxChunkSize)
+        {
+            size_t chunkSize = min(maxChunkSize, numValues - first);
+            if (buffer.size() != chunkSize) buffer.resize(chunkSize);
+            in.read(reinterpret_cast<char*>(begin(buffer)), chunkSize * sizeof(double));
+            for (size_t i = 0; i != chunkSize; ++i) _floats[first + i] = static_cast<float>(buffer[i] / _scale);
+        }
+    }
+    else
+    {
+        in.read(reinterpret_cast<char*>(begin(_doubles)), _doubles.size() * sizeof(double));
+    }
+    return static_cast<bool>(in);
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,101 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef RADIATIONFIELDTABLE_HPP
+#define RADIATIONFIELDTABLE_HPP
+
+#include "Array.hpp"
+#include <iosfwd>
+
+////////////////////////////////////////////////////////////////////
+
+/** An instance of the RadiationFieldTable class holds the radiation field accumulated by photon
+    packets in each spatial cell and for each bin of the radiation field wavelength grid, i.e. a
+    two-dimensional table of values indexed on cell index \f$m\f$ and wavelength bin index
+    \f$\ell\f$. The values can be stored in double precision (the default) or, to reduce the memory
+    footprint by a factor of two, in single precision. The latter mode is selected by the medium
+    system when the double-precision table does not fit within the per-process memory budget.
+
+    The values accumulated by the medium system are luminosities multiplied by path lengths in SI
+    units, which for typical models easily exceed the largest representable single-precision value
+    (about \f$3.4\times 10^{38}\f$). In single precision mode, the table therefore stores each value
+    divided by a fixed scale factor specified when the table is allocated, for example the total
+    luminosity of the primary sources multiplied by the diagonal of the spatial grid. The scale
+    factor is applied transparently by all functions of this class.
+
+    The single-precision mode limits the relative precision of each stored value to about
+    \f$10^{-7}\f$. Accumulation errors become significant only when the contribution of an
+    individual photon packet is many orders of magnitude smaller than the accumulated value, which
+    happens only for extremely large numbers of photon packets. Also, the values are always
+    returned and accumulated using double-precision arithmetic, and they are communicated between
+    processes as double-precision values. */
+class RadiationFieldTable
+{
+public:
+    /** This function (re)allocates the table for the specified number of spatial cells and
+        wavelength bins, in single or double precision depending on the value of the third
+        argument, and sets all values to zero. In single precision mode, the values are stored
+        divided by the specified scale factor, which should be chosen so that the scaled values
+        remain well within the single-precision range. The scale factor is ignored in double
+        precision mode. */
+    void resize(size_t numCells, size_t numWavelengths, bool singlePrecision, double scale);
+
+    /** This function returns the number of bytes needed to store a table of the specified size in
+        the specified precision mode. */
+    static size_t requiredBytes(size_t numCells, size_t numWavelengths, bool singlePrecision);
+
+    /** This function returns the total number of values in the table. */
+    size_t size() const { return _numCells * _numWavelengths; }
+
+    /** This function returns true if the values are stored in single precision. */
+    bool isSinglePrecision() const { return _singlePrecision; }
+
+    /** This function returns the number of bytes allocated for the table. */
+    size_t allocatedBytes() const { return requiredBytes(_numCells, _numWavelengths, _singlePrecision); }
+
+    /** This function sets all values in the table to zero. */
+    void setToZero();
+
+    /** This function returns the value for the specified cell and wavelength bin. */
+    double operator()(size_t m, size_t ell) const
+    {
+        size_t i = m * _numWavelengths + ell;
+        return _singlePrecision ? _floats[i] * _scale : _doubles[i];
+    }
+
+    /** This function adds the specified value to the value for the specified cell and wavelength
+        bin in a thread-safe manner. */
+    void add(size_t m, size_t ell, double value);
+
+    /** This function adds the values of the table element-wise across the different processes, and
+        stores the resulting sums in the table on each process. All processes must call this
+        function for the communication to proceed. */
+    void sumToAll();
+
+    /** This function writes the dimensions and the values of the table to the specified output
+        stream, which must have been opened in binary mode. The values are always written in double
+        precision, regardless of the precision mode of the table. */
+    void write(std::ostream& out) const;
+
+    /** This function reads the dimensions and the values of the table from the specified input
+        stream, which must have been opened in binary mode, in the format written by the write()
+        function. The values are converted to the precision mode of the table as needed. If the
+        stored dimensions differ from those of the table, or if the stream cannot be read, the
+        function returns false and the contents of the table are undefined. Otherwise the function
+        returns true. */
+    bool read(std::istream& in);
+
+private:
+    size_t _numCells{0};
+    size_t _numWavelengths{0};
+    bool _singlePrecision{false};
+    double _scale{1.};      // scale factor dividing the values in single precision mode
+    Array _doubles;         // values in double precision mode
+    vector<float> _floats;  // values in single precision mode, divided by the scale factor
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -9,6 +9,7 @@
 #include "Position.hpp"
 #include "SpecialFunctions.hpp"
 #include <random>
+#include <sstream>
 #include <stack>
 
 //////////////////////////////////////////////////////////////////////
@@ -45,6 +46,25 @@ namespace
 
         // get uniform deviate
         double get() { return _distribution(_generator); }
+
+        // get the complete generator state in textual form
+        string getState() const
+        {
+            std::ostringstream out;
+            out << _generator;
+            return out.str();
+        }
+
+        // restore the generator state from the textual form; return false if the text is invalid
+        bool setState(const string& state)
+        {
+            std::istringstream in(state);
+            std::mt19937_64 generator;
+            in >> generator;
+            if (in.fail()) return false;
+            _generator = generator;
+            return true;
+        }
     };
 
     // allocate a random generator for each thread, constructed when the thread is created
@@ -221,3 +241,17 @@ void Random::pop()
 }
 
 //////////////////////////////////////////////////////////////////////
+
+string Random::generatorState() const
+{
+    return _rng.getState();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+bool Random::setGeneratorState(string state)
+{
+    return _rng.setState(state);
+}
+
+//////////////////////////////////////////////////////////////////////
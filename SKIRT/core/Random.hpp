@@ -182,6 +182,20 @@ public:
         thread. If the stack does not contain a random number generator, the behavior of this
         function is undefined. */
     void pop();
+
+    //=================== Saving and restoring the generator state ===================
+
+public:
+    /** This function returns the complete state of the active random number generator for the
+        current thread in a textual representation. This allows a checkpoint to record the
+        position of the parent thread in its pseudo-random sequence. */
+    string generatorState() const;
+
+    /** This function restores the state of the active random number generator for the current
+        thread from the specified textual representation, which must have been obtained through the
+        generatorState() function. If the representation is invalid, the function returns false
+        and leaves the generator unchanged. Otherwise the function returns true. */
+    bool setGeneratorState(string state);
 };
 
 //////////////////////////////////////////////////////////////////////
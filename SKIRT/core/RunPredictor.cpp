@@ -0,0 +1,85 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "RunPredictor.hpp"
+#include "Log.hpp"
+#include "ParallelFactory.hpp"
+#include "ProcessManager.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+#include "TextOutFile.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+void RunPredictor::start()
+{
+    _started = std::chrono::steady_clock::now();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RunPredictor::record(string phase, double minFactor, double maxFactor, double communicatedBytes)
+{
+    using namespace std::chrono;
+    double seconds = duration_cast<duration<double>>(steady_clock::now() - _started).count();
+    _phases.push_back({phase, seconds, minFactor, maxFactor, communicatedBytes, System::peakMemoryUsage()});
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RunPredictor::write(const SimulationItem* item) const
+{
+    int numThreads = item->find<ParallelFactory>()->maxThreadCount();
+    int numProcs = ProcessManager::size();
+
+    // accumulate the totals
+    Phase total{"complete run", 0., 0., 0., 0., 0};
+    double minSeconds = 0., maxSeconds = 0., minBytes = 0., maxBytes = 0.;
+    for (const auto& phase : _phases)
+    {
+        total.seconds += phase.seconds;
+        total.bytes += phase.bytes;
+        total.peakMemory = max(total.peakMemory, phase.peakMemory);
+        minSeconds += phase.seconds * phase.minFactor;
+        maxSeconds += phase.seconds * phase.maxFactor;
+        minBytes += phase.bytes * phase.minFactor;
+        maxBytes += phase.bytes * phase.maxFactor;
+    }
+
+    // write the text file, listing the phase names in the header
+    TextOutFile out(item, "prediction", "run prediction");
+    out.writeLine("# Pilot run using " + std::to_string(numThreads) + " threads in " + std::to_string(numProcs)
+                  + " processes; predictions assume the same configuration");
+    out.writeLine("# Phase 0: " + total.name);
+    for (size_t k = 0; k != _phases.size(); ++k)
+        out.writeLine("# Phase " + std::to_string(k + 1) + ": " + _phases[k].name);
+    out.addColumn("phase index", "", 'd');
+    out.addColumn("pilot wall time", "s", 'e', 4);
+    out.addColumn("predicted wall time for minimum number of iterations", "s", 'e', 4);
+    out.addColumn("predicted wall time for maximum number of iterations", "s", 'e', 4);
+    out.addColumn("predicted data volume reduced across processes for minimum number of iterations", "bytes", 'e', 4);
+    out.addColumn("predicted data volume reduced across processes for maximum number of iterations", "bytes", 'e', 4);
+    out.addColumn("peak memory usage per process", "bytes", 'e', 4);
+    out.writeRow(0, total.seconds, minSeconds, maxSeconds, minBytes, maxBytes, total.peakMemory);
+    for (size_t k = 0; k != _phases.size(); ++k)
+    {
+        const auto& phase = _phases[k];
+        out.writeRow(k + 1, phase.seconds, phase.seconds * phase.minFactor, phase.seconds * phase.maxFactor,
+                     phase.bytes * phase.minFactor, phase.bytes * phase.maxFactor, phase.peakMemory);
+    }
+    out.close();
+
+    // log a summary
+    auto log = item->find<Log>();
+    log->info("Predicted wall time for the full run: " + StringUtils::toString(minSeconds, 'g', 3) + " s to "
+              + StringUtils::toString(maxSeconds, 'g', 3) + " s using " + std::to_string(numThreads) + " threads in "
+              + std::to_string(numProcs) + " processes");
+    log->info("Predicted peak memory usage per process: " + StringUtils::toMemSizeString(total.peakMemory));
+    if (numProcs > 1)
+        log->info("Predicted data volume reduced across processes: " + StringUtils::toMemSizeString(minBytes)
+                  + " to " + StringUtils::toMemSizeString(maxBytes));
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,72 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef RUNPREDICTOR_HPP
+#define RUNPREDICTOR_HPP
+
+#include "Basics.hpp"
+#include <chrono>
+class SimulationItem;
+
+////////////////////////////////////////////////////////////////////
+
+/** RunPredictor is a helper class for MonteCarloSimulation that extrapolates the resource usage of
+    a full simulation run from a pilot run performed in prediction mode (see
+    Configuration::setPredictionMode()). In prediction mode, the simulation performs its regular
+    setup and then launches a reduced number of photon packets through each emission segment,
+    performing at most a single iteration for each dynamic medium state iteration loop.
+
+    The simulation times each of the phases in the pilot run by calling the start() and record()
+    functions around the phase. For each phase, the caller specifies the factors by which the pilot
+    wall time must be multiplied to obtain the wall time of the corresponding phase in the full
+    run. Because the number of iterations needed for convergence cannot be known in advance, each
+    phase has two such factors, one corresponding to the minimum and one to the maximum number of
+    iterations configured for the full run. For example, the factor for a photon packet segment is
+    the ratio of the number of packets launched in the full run to the number launched in the
+    pilot run, multiplied by the number of iterations if applicable; the factor for a dynamic
+    medium state update is the number of iterations; and the factor for setup or final output is
+    unity. Similarly, the caller can specify the volume of data that is reduced across processes
+    during the phase in the pilot run, which is extrapolated using the same factors. The peak
+    memory usage of the process is sampled at the end of each phase; because memory usage
+    generally does not depend on the number of photon packets, it is reported without
+    extrapolation.
+
+    The predicted wall times assume the same number of execution threads and processes as used
+    for the pilot run. The packet segments and dynamic medium state updates usually scale nearly
+    inversely with the total number of execution threads, so that these predictions can easily be
+    rescaled for other configurations. */
+class RunPredictor
+{
+public:
+    /** This function marks the start of a new phase. */
+    void start();
+
+    /** This function records the phase started by the most recent call to start(), with the
+        specified name, the specified multiplication factors for the minimum and maximum number of
+        iterations in the full run, and the specified data volume (in bytes) reduced across
+        processes during the phase in the pilot run. */
+    void record(string phase, double minFactor, double maxFactor, double communicatedBytes = 0.);
+
+    /** This function writes a text file containing the pilot and predicted wall time, data volume
+        and peak memory usage for each of the recorded phases and for the complete run, and logs a
+        summary of the predictions. It should be called after the pilot run has completed. */
+    void write(const SimulationItem* item) const;
+
+private:
+    struct Phase
+    {
+        string name;
+        double seconds;
+        double minFactor, maxFactor;
+        double bytes;
+        size_t peakMemory;
+    };
+    vector<Phase> _phases;
+    std::chrono::steady_clock::time_point _started;
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -4,6 +4,7 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "SecondarySource.hpp"
+#include "MemoryLedger.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
@@ -17,3 +18,21 @@ SecondarySource::SecondarySource(SimulationItem* parent)
 }
 
 ////////////////////////////////////////////////////////////////////
+
+void SecondarySource::releaseCaches()
+{
+    size_t bytes = 0;
+    for (const auto& release : _cacheReleasers) bytes += release();
+    _cacheReleasers.clear();
+    if (bytes) find<MemoryLedger>()->release("per-thread caches", bytes);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SecondarySource::registerCache(std::function<size_t()> release) const
+{
+    std::unique_lock<std::mutex> lock(_cacheMutex);
+    _cacheReleasers.push_back(std::move(release));
+}
+
+////////////////////////////////////////////////////////////////////
@@ -7,6 +7,8 @@
 #define SECONDARYSOURCE_HPP
 
 #include "SimulationItem.hpp"
+#include <functional>
+#include <mutex>
 class PhotonPacket;
 
 //////////////////////////////////////////////////////////////////////
@@ -45,6 +47,25 @@ public:
     /** This function causes the photon packet \em pp to be launched for this source from one of
         the cells in the spatial grid using the given history index and luminosity. */
     virtual void launch(PhotonPacket* pp, size_t historyIndex, double L) const = 0;
+
+    /** This function frees the memory held by the per-thread caches registered with this source
+        through the registerCache() function, and releases the corresponding allocations from the
+        simulation's MemoryLedger. It should be called from serial code after the last secondary
+        emission segment, when no photon packets are being launched. */
+    void releaseCaches();
+
+    /** This function should be called by the implementation of a subclass, from the execution
+        thread using the cache, when a per-thread cache registers its memory with the simulation's MemoryLedger under the
+        "per-thread caches" category for the first time. The releaseCaches() function invokes the
+        specified function, which should free the memory held by the cache and return the number
+        of bytes registered by the cache, or zero if the cache has already been released. */
+    void registerCache(std::function<size_t()> release) const;
+
+    //======================== Data Members ========================
+
+private:
+    mutable std::mutex _cacheMutex;                          // the mutex guarding the list of caches
+    mutable vector<std::function<size_t()>> _cacheReleasers;  // the release function for each registered cache
 };
 
 ////////////////////////////////////////////////////////////////
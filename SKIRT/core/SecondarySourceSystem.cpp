@@ -14,6 +14,7 @@
 #include "NR.hpp"
 #include "PhotonPacket.hpp"
 #include "ProbePhotonPacketInterface.hpp"
+#include "Tracer.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
@@ -83,6 +84,7 @@ int SecondarySourceSystem::numSources() const
 
 bool SecondarySourceSystem::prepareForLaunch(size_t numPackets)
 {
+    Tracer trace("prepare secondary sources for launch");
     // obtain the luminosity for each source
     int Ns = _sources.size();
     _Lv.resize(Ns);
@@ -142,3 +144,10 @@ void SecondarySourceSystem::launch(PhotonPacket* pp, size_t historyIndex) const
 }
 
 ////////////////////////////////////////////////////////////////////
+
+void SecondarySourceSystem::releaseCaches()
+{
+    for (auto source : _sources) source->releaseCaches();
+}
+
+////////////////////////////////////////////////////////////////////
@@ -213,6 +213,11 @@ public:
         (re-)initialized so that it is ready to start its lifecycle. */
     void launch(PhotonPacket* pp, size_t historyIndex) const;
 
+    /** This function tells all sources to free the memory held by their per-thread caches and to
+        release it from the simulation's MemoryLedger. It should be called from serial code after
+        the last secondary emission segment. */
+    void releaseCaches();
+
     //======================== Data Members ========================
 
 private:
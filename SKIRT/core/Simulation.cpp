@@ -6,6 +6,7 @@
 #include "Simulation.hpp"
 #include "ProcessManager.hpp"
 #include "TimeLogger.hpp"
+#include <chrono>
 
 ////////////////////////////////////////////////////////////////////
 
@@ -31,9 +32,14 @@ void Simulation::setupAndRun()
     _log->setup();
     TimeLogger logger(_log, "simulation " + _paths->outputPrefix() + processInfo);
 
-    // setup and run the simulation
+    // setup and run the simulation, recording the wall time spent in each phase
+    using namespace std::chrono;
+    auto started = steady_clock::now();
     setupSimulation();
+    auto setupDone = steady_clock::now();
+    _setupWallTime = duration_cast<duration<double>>(setupDone - started).count();
     runSimulation();
+    _runWallTime = duration_cast<duration<double>>(steady_clock::now() - setupDone).count();
 
     // repeat any warnings and errors that have been issued during this simulation
     if (ProcessManager::isRoot())
@@ -81,3 +87,24 @@ ParallelFactory* Simulation::parallelFactory() const
 }
 
 ////////////////////////////////////////////////////////////////////
+
+MemoryLedger* Simulation::memoryLedger() const
+{
+    return _ledger;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double Simulation::setupWallTime() const
+{
+    return _setupWallTime;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double Simulation::runWallTime() const
+{
+    return _runWallTime;
+}
+
+////////////////////////////////////////////////////////////////////
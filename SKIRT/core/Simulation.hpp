@@ -8,6 +8,7 @@
 
 #include "ConsoleLog.hpp"
 #include "FilePaths.hpp"
+#include "MemoryLedger.hpp"
 #include "ParallelFactory.hpp"
 #include "Random.hpp"
 #include "SimulationItem.hpp"
@@ -19,18 +20,19 @@
     simulation and sits at the top of a run-time simulation hierarchy (i.e. it has no parent). A
     Simulation instance holds a number of essential simulation-wide property instances. Some of
     these (a random number generator and a system of units) are discoverable and hence fully
-    user-configurable. The other properties (a file paths object, a logging mechanism, and a
-    parallel factory) are not discoverable. When a Simulation instance is constructed, a default
-    instance is created for each of these properties. A reference to these property instances can
-    be retrieved through the corresponding getter, and in some cases, the property can be further
-    configured under program control (e.g., to set the input and output file paths for the
-    simulation).
+    user-configurable. The other properties (a file paths object, a logging mechanism, a parallel
+    factory, and a memory ledger) are not discoverable. When a Simulation instance is constructed,
+    a default instance is created for each of these properties. A reference to these property
+    instances can be retrieved through the corresponding getter, and in some cases, the property
+    can be further configured under program control (e.g., to set the input and output file paths
+    for the simulation).
 
     Specifically, when a Simulation instance is constructed, the \em log property is set to an
     instance of the ConsoleLog class; the \em filePaths property is set to an instance of the
-    FilePaths class with default paths and no filename prefix; and the \em parallelFactory property
-    is set to an instance of the ParallelFactory class with the default maximum number of parallel
-    threads. */
+    FilePaths class with default paths and no filename prefix; the \em parallelFactory property is
+    set to an instance of the ParallelFactory class with the default maximum number of parallel
+    threads; and the \em memoryLedger property is set to an instance of the MemoryLedger class
+    without a memory budget. */
 class Simulation : public SimulationItem
 {
     /** The enumeration type indicating the user experience level:
@@ -92,6 +94,17 @@ public:
     /** Returns the logging mechanism for this simulation hierarchy. */
     ParallelFactory* parallelFactory() const;
 
+    /** Returns the memory ledger for this simulation hierarchy. */
+    MemoryLedger* memoryLedger() const;
+
+    /** Returns the wall time in seconds spent setting up the simulation during the most recent
+        invocation of setupAndRun(), or zero if the simulation has not yet been set up. */
+    double setupWallTime() const;
+
+    /** Returns the wall time in seconds spent running the simulation during the most recent
+        invocation of setupAndRun(), or zero if the simulation has not yet completed. */
+    double runWallTime() const;
+
     //======================== Data Members ========================
 
 private:
@@ -99,6 +112,11 @@ private:
     Log* _log{new ConsoleLog(this)};
     FilePaths* _paths{new FilePaths(this)};
     ParallelFactory* _factory{new ParallelFactory(this)};
+    MemoryLedger* _ledger{new MemoryLedger(this)};
+
+    // wall times recorded by setupAndRun()
+    double _setupWallTime{0.};
+    double _runWallTime{0.};
 };
 
 ////////////////////////////////////////////////////////////////////
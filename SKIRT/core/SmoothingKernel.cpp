@@ -18,7 +18,72 @@ void SmoothingKernel::setupSelfBefore()
     _random = find<Random>();
 
     // open the cumulative kernel table used in massInBox()
-    if (hasMassInBox()) _cumkernel.open(this, type(), "X(1),Y(1),Z(1)", "Phi(1)", false);
+    if (FilePaths::hasResource(type() + ".stab"))
+    {
+        _cumkernel.open(this, type(), "X(1),Y(1),Z(1)", "Phi(1)", false);
+        _numCumPoints = _cumkernel.axisSize<0>();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void SmoothingKernel::requireMassInBox()
+{
+    // tabulate the cumulative kernel only if it is not yet available
+    if (!_numCumPoints) tabulateCumulativeKernel();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void SmoothingKernel::tabulateCumulativeKernel()
+{
+    const size_t numBins = 64;  // number of table intervals along each axis
+    const size_t numSub = 4;    // number of integration points along each axis within a table interval
+    const size_t n = numBins + 1;
+    _numCumPoints = n;
+    _cumtable.resize(n * n * n);
+    auto index = [n](size_t i, size_t j, size_t k) { return (i * n + j) * n + k; };
+
+    // integrate the kernel density over each table bin, skipping bins entirely outside the unit sphere,
+    // and store the result at the table point with the upper indices of the bin
+    double d = 1. / (numBins * numSub);
+    for (size_t i = 0; i != numBins; ++i)
+        for (size_t j = 0; j != numBins; ++j)
+            for (size_t k = 0; k != numBins; ++k)
+            {
+                if (i * i + j * j + k * k >= numBins * numBins) continue;
+                double sum = 0.;
+                for (size_t a = 0; a != numSub; ++a)
+                {
+                    double x = (i * numSub + a + 0.5) * d;
+                    for (size_t b = 0; b != numSub; ++b)
+                    {
+                        double y = (j * numSub + b + 0.5) * d;
+                        for (size_t c = 0; c != numSub; ++c)
+                        {
+                            double z = (k * numSub + c + 0.5) * d;
+                            double u = sqrt(x * x + y * y + z * z);
+                            if (u < 1.) sum += density(u);
+                        }
+                    }
+                }
+                _cumtable[index(i + 1, j + 1, k + 1)] = sum * d * d * d;
+            }
+
+    // accumulate the bin values along each of the axes
+    for (size_t i = 1; i != n; ++i)
+        for (size_t j = 0; j != n; ++j)
+            for (size_t k = 0; k != n; ++k) _cumtable[index(i, j, k)] += _cumtable[index(i - 1, j, k)];
+    for (size_t i = 0; i != n; ++i)
+        for (size_t j = 1; j != n; ++j)
+            for (size_t k = 0; k != n; ++k) _cumtable[index(i, j, k)] += _cumtable[index(i, j - 1, k)];
+    for (size_t i = 0; i != n; ++i)
+        for (size_t j = 0; j != n; ++j)
+            for (size_t k = 1; k != n; ++k) _cumtable[index(i, j, k)] += _cumtable[index(i, j, k - 1)];
+
+    // normalize the table so that the complete octant holds exactly one eighth of the kernel mass
+    double total = _cumtable[index(numBins, numBins, numBins)];
+    if (total > 0.) _cumtable *= 0.125 / total;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -35,7 +100,7 @@ double SmoothingKernel::massInBox(const Box& box) const
         // we could simply do: return _cumkernel(X, Y, Z);
         // however, this would cost a binary search along each axis, so we perform the interpolation here,
         // assuming that the three axes have range [0..1] with the same number of equidistant points
-        size_t num = _cumkernel.axisSize<0>() - 1;
+        size_t num = _numCumPoints - 1;
         X *= num;
         Y *= num;
         Z *= num;
@@ -49,14 +114,14 @@ double SmoothingKernel::massInBox(const Box& box) const
         double ty = Y - j0;
         double tz = Z - k0;
 
-        double v000 = _cumkernel.valueAtIndices(i0, j0, k0);
-        double v100 = _cumkernel.valueAtIndices(i1, j0, k0);
-        double v010 = _cumkernel.valueAtIndices(i0, j1, k0);
-        double v110 = _cumkernel.valueAtIndices(i1, j1, k0);
-        double v001 = _cumkernel.valueAtIndices(i0, j0, k1);
-        double v101 = _cumkernel.valueAtIndices(i1, j0, k1);
-        double v011 = _cumkernel.valueAtIndices(i0, j1, k1);
-        double v111 = _cumkernel.valueAtIndices(i1, j1, k1);
+        double v000 = cumulativeKernel(i0, j0, k0);
+        double v100 = cumulativeKernel(i1, j0, k0);
+        double v010 = cumulativeKernel(i0, j1, k0);
+        double v110 = cumulativeKernel(i1, j1, k0);
+        double v001 = cumulativeKernel(i0, j0, k1);
+        double v101 = cumulativeKernel(i1, j0, k1);
+        double v011 = cumulativeKernel(i0, j1, k1);
+        double v111 = cumulativeKernel(i1, j1, k1);
         double v00 = (1.0 - tx) * v000 + tx * v100;
         double v10 = (1.0 - tx) * v010 + tx * v110;
         double v01 = (1.0 - tx) * v001 + tx * v101;
@@ -86,7 +151,7 @@ double SmoothingKernel::massInBox(const Box& box) const
 
 bool SmoothingKernel::hasMassInBox() const
 {
-    return FilePaths::hasResource(type() + ".stab");
+    return _cumtable.size() || FilePaths::hasResource(type() + ".stab");
 }
 
 //////////////////////////////////////////////////////////////////////
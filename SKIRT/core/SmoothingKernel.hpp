@@ -6,6 +6,7 @@
 #ifndef SMOOTHINGKERNEL_HPP
 #define SMOOTHINGKERNEL_HPP
 
+#include "Array.hpp"
 #include "SimulationItem.hpp"
 #include "StoredTable.hpp"
 class Random;
@@ -58,15 +59,43 @@ public:
 
         The implementation in this base class uses the technique described by Baes et al. 2026 in
         prep, reducing the calculation to eight interpolations in the tabulated cumulative kernel
-        provided as a stored table resource with the same name as the final derived class. Derived
-        classes can override the function to provide another implementation if desired. */
+        provided as a stored table resource with the same name as the final derived class, or, if
+        that resource is not available and requireMassInBox() has been called, tabulated in memory.
+        Derived classes can override the function to provide another implementation if desired. */
     virtual double massInBox(const Box& box) const;
 
     /** This function returns true if this smoothing kernel offers the massInBox() feature. The
         implementation in this base class returns true if the cumulative kernel resource file is
-        available, and false if not. Derived classes can override the function if desired. */
+        available or if the cumulative kernel has been tabulated in memory by requireMassInBox(),
+        and false otherwise. Derived classes can override the function if desired. */
     virtual bool hasMassInBox() const;
 
+    /** This function ensures that the massInBox() feature is available, even if the cumulative
+        kernel resource file is not installed. In the latter case, the function tabulates the
+        cumulative kernel in memory by numerical integration of the kernel density, which requires
+        about 2 MB of memory. The resulting table approximates the
+        resource table to within the accuracy of the integration. This function should be called
+        during setup, after this smoothing kernel has been set up, by clients that opt in to
+        obtaining masses through massInBox(). */
+    void requireMassInBox();
+
+private:
+    /** This function tabulates the cumulative kernel \f$\Phi(X,Y,Z)\f$, i.e. the portion of the
+        kernel mass inside the box \f$[0,X]\times[0,Y]\times[0,Z]\f$, on a regular grid of points
+        in the unit cube, in the same format as the stored table resource. The integration is
+        performed numerically using the midpoint rule on a grid that is four times finer than the
+        table, and the result is normalized so that \f$\Phi(1,1,1)=1/8\f$. */
+    void tabulateCumulativeKernel();
+
+    /** This function returns the value of the cumulative kernel at the table point with the
+        specified indices, obtained from the stored table resource or from the table tabulated
+        during setup. */
+    double cumulativeKernel(size_t i, size_t j, size_t k) const
+    {
+        return _cumtable.size() ? _cumtable[(i * _numCumPoints + j) * _numCumPoints + k]
+                                : _cumkernel.valueAtIndices(i, j, k);
+    }
+
 protected:
     /** This function returns the simulation's random generator as a service to subclasses. */
     Random* random() const { return _random; }
@@ -77,8 +106,10 @@ private:
     // data member initialized during setup
     Random* _random{nullptr};
 
-    // the tabulated cumulative kernel used in massInBox()
+    // the tabulated cumulative kernel used in massInBox(), as a stored table resource or tabulated in memory
     StoredTable<3> _cumkernel;
+    Array _cumtable;          // the cumulative kernel tabulated in memory, or empty if the resource is used
+    size_t _numCumPoints{0};  // the number of table points along each axis
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -41,6 +41,17 @@ void Source::informAvailableWavelengthRange(Range available, string itemType)
 
 //////////////////////////////////////////////////////////////////////
 
+bool Source::supportsPolychromaticPackets() const
+{
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////
+
 void Source::prepareForLaunch(double /*sourceBias*/, size_t /*firstIndex*/, size_t /*numIndices*/) {}
 
 //////////////////////////////////////////////////////////////////////
+
+void Source::finishLaunch() {}
+
+//////////////////////////////////////////////////////////////////////
@@ -103,6 +103,13 @@ public:
         It may be called before setup of the receiving source has completed. */
     virtual bool hasVelocity() const = 0;
 
+    /** This function returns true if this source supports launching polychromatic photon packets,
+        i.e. photon packets that carry companion wavelengths in addition to their reference
+        wavelength (see PhotonPacketOptions), and false otherwise. It may be called before setup of
+        the receiving source has completed. The default implementation in this base class returns
+        false. */
+    virtual bool supportsPolychromaticPackets() const;
+
     /** This function returns the luminosity \f$L\f$ (i.e. radiative power) of the source
         integrated over the wavelength range of primary sources (configured for the source system
         as a whole) and across its complete spatial domain. */
@@ -127,6 +134,11 @@ public:
         (re-)initialized so that it is ready to start its lifecycle. */
     virtual void launch(PhotonPacket* pp, size_t historyIndex, double L) const = 0;
 
+    /** This function may perform some wrap-up after launching photon packets, such as logging
+        statistics gathered during the launches. It is called in serial mode after each segment of
+        photon packet launches. The default implementation of this function does nothing. */
+    virtual void finishLaunch();
+
     //======================== Other Functions =======================
 
 protected:
@@ -8,6 +8,15 @@
 #include "NR.hpp"
 #include "PhotonPacket.hpp"
 #include "ProbePhotonPacketInterface.hpp"
+#include "Tracer.hpp"
+
+//////////////////////////////////////////////////////////////////////
+
+void SourceSystem::setupSelfBefore()
+{
+    SimulationItem::setupSelfBefore();
+    _memoryMark = find<MemoryLedger>()->mark();
+}
 
 //////////////////////////////////////////////////////////////////////
 
@@ -15,6 +24,9 @@ void SourceSystem::setupSelfAfter()
 {
     SimulationItem::setupSelfAfter();
 
+    // register the memory allocated by the sources
+    find<MemoryLedger>()->recordSince("sources", _memoryMark);
+
     // skip preparations if there are no sources
     int Ns = _sources.size();
     if (!Ns) return;
@@ -74,6 +86,7 @@ double SourceSystem::luminosity() const
 
 void SourceSystem::prepareForLaunch(size_t numPackets)
 {
+    Tracer trace("prepare primary sources for launch");
     if (!_L) throw FATALERROR("Cannot launch primary source photon packets when total luminosity is zero");
 
     // determine the first history index for each source
@@ -113,3 +126,10 @@ void SourceSystem::launch(PhotonPacket* pp, size_t historyIndex) const
 }
 
 //////////////////////////////////////////////////////////////////////
+
+void SourceSystem::finishLaunch()
+{
+    for (auto source : _sources) source->finishLaunch();
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -7,6 +7,7 @@
 #define SOURCESYSTEM_HPP
 
 #include "Array.hpp"
+#include "MemoryLedger.hpp"
 #include "SimulationItem.hpp"
 #include "Source.hpp"
 class PhotonPacket;
@@ -98,7 +99,13 @@ class SourceSystem : public SimulationItem
     //============= Construction - Setup - Destruction =============
 
 protected:
-    /** This function obtains the bolometric luminosity of each source for later use. */
+    /** This function remembers the memory usage of the process before the sources are set up, so
+        that the memory allocated by the sources (e.g., for imported snapshots) can be registered
+        with the simulation's MemoryLedger. */
+    void setupSelfBefore() override;
+
+    /** This function registers the memory allocated by the sources with the simulation's
+        MemoryLedger, and obtains the bolometric luminosity of each source for later use. */
     void setupSelfAfter() override;
 
 public:
@@ -133,13 +140,18 @@ public:
         (re-)initialized so that it is ready to start its lifecycle. */
     void launch(PhotonPacket* pp, size_t historyIndex) const;
 
+    /** This function notifies each of the sources in the source system that a segment of photon
+        packet launches has finished. It should be called in serial mode. */
+    void finishLaunch();
+
     //======================== Data Members ========================
 
 private:
     // intialized during setup
-    double _L{0};  // the total bolometric luminosity of all sources (absolute number)
-    Array _Lv;     // the relative bolometric luminosity of each source (normalized to unity)
-    Array _Wv;     // the relative launch weight for each source (normalized to unity)
+    MemoryLedger::Mark _memoryMark;  // the memory usage before setting up the sources
+    double _L{0};                    // the total bolometric luminosity of all sources (absolute number)
+    Array _Lv;                       // the relative bolometric luminosity of each source (normalized to unity)
+    Array _Wv;                       // the relative launch weight for each source (normalized to unity)
     vector<ProbePhotonPacketInterface*> _callbackv;  // interfaces to be invoked for each packet launch
 
     // intialized by prepareForLaunch()
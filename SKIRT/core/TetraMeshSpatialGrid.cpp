@@ -13,6 +13,8 @@
 #include "StringUtils.hpp"
 #include "TextInFile.hpp"
 #include "tetgen.h"
+#include <limits>
+#include <numeric>
 
 //////////////////////////////////////////////////////////////////////
 
@@ -48,185 +50,55 @@ namespace
         if (face % 2 == 0) std::swap(cv[0], cv[2]);
         return cv;
     }
-}
-
-//////////////////////////////////////////////////////////////////////
 
-TetraMeshSpatialGrid::Tetra::Tetra(const vector<Vec>& vertices, const FourIndices& vertexIndices,
-                                   const FourFaces& faces)
-    : _vertices(vertices), _vertexIndices(vertexIndices), _faces(faces)
-{
-    double xmin = DBL_MAX;
-    double ymin = DBL_MAX;
-    double zmin = DBL_MAX;
-    double xmax = -DBL_MAX;
-    double ymax = -DBL_MAX;
-    double zmax = -DBL_MAX;
-    for (int vi : _vertexIndices)
+    // spread the lower 21 bits of the given value so that there are two zero bits between each of them
+    inline uint64_t spreadBits(uint64_t v)
     {
-        const Vec& vertex = vertices[vi];
-
-        xmin = min(xmin, vertex.x());
-        ymin = min(ymin, vertex.y());
-        zmin = min(zmin, vertex.z());
-        xmax = max(xmax, vertex.x());
-        ymax = max(ymax, vertex.y());
-        zmax = max(zmax, vertex.z());
-
-        _centroid += vertex;
+        v &= 0x1fffff;
+        v = (v | v << 32) & 0x1f00000000ffff;
+        v = (v | v << 16) & 0x1f0000ff0000ff;
+        v = (v | v << 8) & 0x100f00f00f00f00f;
+        v = (v | v << 4) & 0x10c30c30c30c30c3;
+        v = (v | v << 2) & 0x1249249249249249;
+        return v;
     }
-    // set bounding box
-    _extent = Box(xmin, ymin, zmin, xmax, ymax, zmax);
-
-    // average position of all vertices
-    _centroid /= 4;
-}
-
-//////////////////////////////////////////////////////////////////////
 
-int TetraMeshSpatialGrid::Tetra::findEnteringFace(const Vec& pos, const Direction& dir) const
-{
-    int enteringFace = -1;
-    // clockwise and cclockwise adjacent faces when checking edge v1->v2
-    static constexpr int etable[6][2] = {{3, 2}, {1, 3}, {2, 1}, {3, 0}, {0, 2}, {1, 0}};  // must be static
-    int e = 0;
-    // loop over all 6 edges because of rare cases where ray is inside edge and only 1 non-zero Plücker product
-    for (int t1 = 0; t1 < 3; t1++)
+    // return the Morton code (the index along a Z-order space-filling curve) for the given position in the box
+    uint64_t mortonCode(const Box& box, Vec r)
     {
-        for (int t2 = t1 + 1; t2 < 4; t2++)
-        {
-            Vec moment12 = Vec::cross(dir, pos - vertex(t1));
-            double prod12 = Vec::dot(moment12, edge(t1, t2));
-            if (prod12 != 0.)
-            {
-                enteringFace = prod12 < 0 ? etable[e][0] : etable[e][1];
-                break;
-            }
-            e++;
-        }
-        if (enteringFace != -1) break;
+        const double scale = 0x1fffff;  // 21 bits per coordinate
+        auto bits = [scale](double value, double lo, double width) {
+            return static_cast<uint64_t>(max(0., min(scale, scale * (value - lo) / width)));
+        };
+        return spreadBits(bits(r.x(), box.xmin(), box.xwidth())) << 2
+               | spreadBits(bits(r.y(), box.ymin(), box.ywidth())) << 1
+               | spreadBits(bits(r.z(), box.zmin(), box.zwidth()));
     }
-    return enteringFace;
-}
 
-//////////////////////////////////////////////////////////////////////
-
-bool TetraMeshSpatialGrid::Tetra::contains(const Position& bfr) const
-{
-    if (!_extent.contains(bfr)) return false;
-
-    // Use the same vertex for the first 3 faces
-    Vec v = vertex(3);  // vertex 3 is on faces 0,1,2
-
-    for (int f = 0; f <= 2; f++)
+    // generate three random barycentric coordinates for uniformly sampling inside a tetrahedron, and return
+    // the fourth coordinate so that the sum equals 1, i.e. r=1-s-t-u
+    // Source: Generating Random Points in a Tetrahedron: DOI 10.1080/10867651.2000.10487528
+    double generateBarycentric(double& s, double& t, double& u)
     {
-        const Face& face = _faces[f];
-
-        // if bfr->v is opposite direction as the outward pointing normal, the point is outside
-        if (Vec::dot(v - bfr, face._normal) < 0) return false;
-    }
-
-    // Check face 3
-    const Face& face = _faces[3];
-    v = vertex(0);  // any vertex that is not vertex 3
-
-    if (Vec::dot(v - bfr, face._normal) < 0.) return false;
-
-    return true;
-}
-
-//////////////////////////////////////////////////////////////////////
-
-double TetraMeshSpatialGrid::Tetra::generateBarycentric(double& s, double& t, double& u) const
-{
-    if (s + t > 1.)  // cut'n fold the cube into a prism
-    {
-        s = 1. - s;
-        t = 1. - t;
-    }
-    if (t + u > 1.)  // cut'n fold the prism into a tetrahedron
-    {
-        double tmp = u;
-        u = 1. - s - t;
-        t = 1. - tmp;
-    }
-    else if (s + t + u > 1.)
-    {
-        double tmp = u;
-        u = s + t + u - 1.;
-        s = 1. - t - tmp;
-    }
-    return 1. - u - t - s;
-}
-
-//////////////////////////////////////////////////////////////////////
-
-Position TetraMeshSpatialGrid::Tetra::generatePosition(Random* random) const
-{
-    double s = random->uniform();
-    double t = random->uniform();
-    double u = random->uniform();
-
-    double r = generateBarycentric(s, t, u);
-
-    return Position(r * vertex(0) + u * vertex(1) + t * vertex(2) + s * vertex(3));
-}
-
-//////////////////////////////////////////////////////////////////////
-
-Vec TetraMeshSpatialGrid::Tetra::vertex(int t) const
-{
-    return _vertices[_vertexIndices[t]];
-}
-
-//////////////////////////////////////////////////////////////////////
-
-Vec TetraMeshSpatialGrid::Tetra::edge(int t1, int t2) const
-{
-    return vertex(t2) - vertex(t1);
-}
-
-//////////////////////////////////////////////////////////////////////
-
-double TetraMeshSpatialGrid::Tetra::volume() const
-{
-    return 1. / 6. * abs(Vec::dot(Vec::cross(edge(0, 1), edge(0, 2)), edge(0, 3)));
-}
-
-//////////////////////////////////////////////////////////////////////
-
-double TetraMeshSpatialGrid::Tetra::diagonal() const
-{
-    double sum = 0.;
-    for (int i = 0; i < 3; ++i)
-    {
-        for (int j = i + 1; j < 4; ++j)
+        if (s + t > 1.)  // cut'n fold the cube into a prism
         {
-            sum += edge(i, j).norm2();
+            s = 1. - s;
+            t = 1. - t;
         }
+        if (t + u > 1.)  // cut'n fold the prism into a tetrahedron
+        {
+            double tmp = u;
+            u = 1. - s - t;
+            t = 1. - tmp;
+        }
+        else if (s + t + u > 1.)
+        {
+            double tmp = u;
+            u = s + t + u - 1.;
+            s = 1. - t - tmp;
+        }
+        return 1. - u - t - s;
     }
-    return sqrt(sum / 6.);
-}
-
-//////////////////////////////////////////////////////////////////////
-
-const TetraMeshSpatialGrid::FourFaces& TetraMeshSpatialGrid::Tetra::faces() const
-{
-    return _faces;
-}
-
-//////////////////////////////////////////////////////////////////////
-
-const Vec& TetraMeshSpatialGrid::Tetra::centroid() const
-{
-    return _centroid;
-}
-
-//////////////////////////////////////////////////////////////////////
-
-const Box& TetraMeshSpatialGrid::Tetra::extent() const
-{
-    return _extent;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -454,6 +326,7 @@ void TetraMeshSpatialGrid::refineDelaunay(tetgenio& in, tetgenio& out)
 void TetraMeshSpatialGrid::storeTetrahedra(const tetgenio& final, bool storeVertices)
 {
     _numCells = final.numberoftetrahedra;
+    if (_numCells > std::numeric_limits<int>::max() / 4) throw FATALERROR("Too many tetrahedra in the mesh");
 
     // replace old vertices
     if (storeVertices)
@@ -471,49 +344,68 @@ void TetraMeshSpatialGrid::storeTetrahedra(const tetgenio& final, bool storeVert
         }
     }
 
-    _tetrahedra.reserve(_numCells);  // no default constructor for Tetra
+    // determine the order of the tetrahedra along a space-filling curve through their centroids
+    // (order[m] is the index in the tetgen output of the tetrahedron with new index m, and index[i] is the inverse)
+    vector<uint64_t> codes(_numCells);
     for (int i = 0; i < _numCells; i++)
     {
+        Vec centroid;
+        for (int c = 0; c < 4; c++) centroid += _vertices[final.tetrahedronlist[4 * i + c]];
+        codes[i] = mortonCode(extent(), centroid / 4.);
+    }
+    vector<int> order(_numCells);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&codes](int i1, int i2) { return codes[i1] < codes[i2]; });
+    vector<int> index(_numCells);
+    for (int m = 0; m < _numCells; m++) index[order[m]] = m;
+
+    // store the vertex indices and the compact traversal data in the new order
+    _tetraVertices.resize(_numCells);
+    _planes.resize(16 * static_cast<size_t>(_numCells));
+    _neighbors.resize(4 * static_cast<size_t>(_numCells));
+    for (int m = 0; m < _numCells; m++)
+    {
+        int i = order[m];
+
         // vertices
-        FourIndices vertexIndices;
-        for (int c = 0; c < 4; c++)
-        {
-            vertexIndices[c] = final.tetrahedronlist[4 * i + c];
-        }
+        FourIndices& vertexIndices = _tetraVertices[m];
+        for (int c = 0; c < 4; c++) vertexIndices[c] = final.tetrahedronlist[4 * i + c];
 
         // faces
-        FourFaces faces;
+        double* planes = &_planes[16 * static_cast<size_t>(m)];
         for (int f = 0; f < 4; f++)
         {
             // -1 if no neighbor
             int ntetra = final.neighborlist[4 * i + f];
 
             // find which face is shared with neighbor
-            int nface = -1;
+            int neighbor = -1;
             if (ntetra != -1)
             {
                 for (int fn = 0; fn < 4; fn++)
                 {
                     if (final.neighborlist[4 * ntetra + fn] == i)
                     {
-                        nface = fn;
+                        neighbor = 4 * index[ntetra] + fn;
                         break;
                     }
                 }
             }
+            _neighbors[4 * static_cast<size_t>(m) + f] = neighbor;
 
-            // compute outward facing normal of face
+            // compute outward facing normal of face and the corresponding plane offset
             auto cv = clockwiseVertices(f);
-            Vec v0 = _vertices[vertexIndices[cv[0]]];
+            const Vec& v0 = _vertices[vertexIndices[cv[0]]];
             Vec e12 = _vertices[vertexIndices[cv[1]]] - v0;
             Vec e13 = _vertices[vertexIndices[cv[2]]] - v0;
             Vec normal = Vec::cross(e12, e13);
             normal /= normal.norm();
 
-            faces[f] = Face(ntetra, nface, normal);
+            planes[f] = normal.x();
+            planes[4 + f] = normal.y();
+            planes[8 + f] = normal.z();
+            planes[12 + f] = Vec::dot(normal, v0);
         }
-
-        _tetrahedra.emplace_back(_vertices, vertexIndices, faces);
     }
 
     // compile statistics
@@ -522,7 +414,7 @@ void TetraMeshSpatialGrid::storeTetrahedra(const tetgenio& final, bool storeVert
     double totalVol2 = 0.;
     for (int m = 0; m < _numCells; m++)
     {
-        double vol = _tetrahedra[m].volume();
+        double vol = volume(m);
         totalVol2 += vol * vol;
         minVol = min(minVol, vol);
         maxVol = max(maxVol, vol);
@@ -547,17 +439,81 @@ void TetraMeshSpatialGrid::storeTetrahedra(const tetgenio& final, bool storeVert
 
 void TetraMeshSpatialGrid::buildSearch()
 {
-    _log->info("Constructing search grid for " + std::to_string(_tetrahedra.size()) + " tetrahedra...");
-    auto bounds = [this](int m) { return _tetrahedra[m].extent(); };
-    auto intersects = [this](int m, const Box& box) { return box.intersects(_tetrahedra[m].extent()); };
-    _search.loadEntities(_tetrahedra.size(), bounds, intersects);
-
-    int nb = _search.numBlocks();
-    _log->info("  Number of blocks in grid: " + std::to_string(nb * nb * nb) + " (" + std::to_string(nb) + "^3)");
-    _log->info("  Smallest number of tetrahedra per block: " + std::to_string(_search.minEntitiesPerBlock()));
-    _log->info("  Largest  number of tetrahedra per block: " + std::to_string(_search.maxEntitiesPerBlock()));
-    _log->info("  Average  number of tetrahedra per block: "
-               + StringUtils::toString(_search.avgEntitiesPerBlock(), 'f', 1));
+    // use a number of blocks comparable to the number of tetrahedra divided by the number of tetrahedra
+    // around a vertex, so that the walk from the hint tetrahedron for a block usually takes just a few steps
+    _numHintBlocks = max(1, min(256, static_cast<int>(std::cbrt(_numCells / 16.))));
+    int n = _numHintBlocks;
+    _log->info("Constructing search grid with " + std::to_string(n * n * n) + " blocks (" + std::to_string(n)
+               + "^3) for " + std::to_string(_numCells) + " tetrahedra...");
+
+    // locate the tetrahedron containing the center of each block, walking from the hint for the previous block
+    _hints.resize(static_cast<size_t>(n) * n * n);
+    int hint = 0;
+    for (int i = 0; i != n; ++i)
+    {
+        for (int j = 0; j != n; ++j)
+        {
+            for (int k = 0; k != n; ++k)
+            {
+                Position center(extent().fracPos((i + 0.5) / n, (j + 0.5) / n, (k + 0.5) / n));
+                int m = walk(center, hint);
+                if (m >= 0) hint = m;
+                _hints[(static_cast<size_t>(i) * n + j) * n + k] = hint;
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+Box TetraMeshSpatialGrid::tetraExtent(int m) const
+{
+    Box box(vertex(m, 0), vertex(m, 0));
+    for (int t = 1; t < 4; t++) box.extend(Box(vertex(m, t), vertex(m, t)));
+    return box;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+int TetraMeshSpatialGrid::walk(Position bfr, int m) const
+{
+    // with a Delaunay tetrahedralization, the walk is guaranteed to terminate; as a safety net against
+    // numerical issues, we nevertheless limit the number of steps to the number of tetrahedra
+    for (int step = 0; step != _numCells; ++step)
+    {
+        // find the face plane for which the position lies furthest outside, if any
+        const double* planes = &_planes[16 * static_cast<size_t>(m)];
+        int exitFace = -1;
+        double maxExcess = 0.;
+        for (int f = 0; f < 4; f++)
+        {
+            double excess = planes[f] * bfr.x() + planes[4 + f] * bfr.y() + planes[8 + f] * bfr.z() - planes[12 + f];
+            if (excess > maxExcess)
+            {
+                maxExcess = excess;
+                exitFace = f;
+            }
+        }
+
+        // if the position is not outside any of the faces, we found the tetrahedron
+        if (exitFace < 0) return m;
+
+        // otherwise, move to the neighbor across that face, unless we are leaving the convex hull
+        int neighbor = _neighbors[4 * static_cast<size_t>(m) + exitFace];
+        if (neighbor < 0) return -1;
+        m = neighbor >> 2;
+    }
+
+    // revert to testing all tetrahedra
+    for (m = 0; m < _numCells; m++)
+    {
+        const double* planes = &_planes[16 * static_cast<size_t>(m)];
+        bool inside = true;
+        for (int f = 0; f < 4 && inside; f++)
+            inside = planes[f] * bfr.x() + planes[4 + f] * bfr.y() + planes[8 + f] * bfr.z() <= planes[12 + f];
+        if (inside) return m;
+    }
+    return -1;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -571,39 +527,55 @@ int TetraMeshSpatialGrid::numCells() const
 
 double TetraMeshSpatialGrid::volume(int m) const
 {
-    return _tetrahedra[m].volume();
+    const Vec& v0 = vertex(m, 0);
+    return 1. / 6. * abs(Vec::dot(Vec::cross(vertex(m, 1) - v0, vertex(m, 2) - v0), vertex(m, 3) - v0));
 }
 
 //////////////////////////////////////////////////////////////////////
 
 double TetraMeshSpatialGrid::diagonal(int m) const
 {
-    return _tetrahedra[m].diagonal();
+    double sum = 0.;
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = i + 1; j < 4; ++j)
+        {
+            sum += (vertex(m, j) - vertex(m, i)).norm2();
+        }
+    }
+    return sqrt(sum / 6.);
 }
 
 //////////////////////////////////////////////////////////////////////
 
 int TetraMeshSpatialGrid::cellIndex(Position bfr) const
 {
-    for (int m : _search.entitiesFor(bfr))
-    {
-        if (_tetrahedra[m].contains(bfr)) return m;
-    }
-    return -1;
+    if (!contains(bfr)) return -1;
+
+    int i, j, k;
+    int n = _numHintBlocks;
+    extent().cellIndices(i, j, k, bfr, n, n, n);
+    return walk(bfr, _hints[(static_cast<size_t>(i) * n + j) * n + k]);
 }
 
 //////////////////////////////////////////////////////////////////////
 
 Position TetraMeshSpatialGrid::centralPositionInCell(int m) const
 {
-    return Position(_tetrahedra[m].centroid());
+    return Position((vertex(m, 0) + vertex(m, 1) + vertex(m, 2) + vertex(m, 3)) / 4.);
 }
 
 //////////////////////////////////////////////////////////////////////
 
 Position TetraMeshSpatialGrid::randomPositionInCell(int m) const
 {
-    return _tetrahedra[m].generatePosition(random());
+    double s = random()->uniform();
+    double t = random()->uniform();
+    double u = random()->uniform();
+
+    double r = generateBarycentric(s, t, u);
+
+    return Position(r * vertex(m, 0) + u * vertex(m, 1) + t * vertex(m, 2) + s * vertex(m, 3));
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -622,14 +594,13 @@ void TetraMeshSpatialGrid::writeGridPlotFiles(const SimulationItem* probe) const
     int numDone = 0;
     for (int i = 0; i < _numCells; i++)
     {
-        const Tetra& tetra = _tetrahedra[i];
         vector<double> coords(12);
         vector<int> indices(16);
 
         // write each face as a polygon
         for (int v = 0; v < 4; v++)
         {
-            Vec vertex = tetra.vertex(v);
+            const Vec& vertex = this->vertex(i, v);
             coords[3 * v + 0] = vertex.x();
             coords[3 * v + 1] = vertex.y();
             coords[3 * v + 2] = vertex.z();
@@ -642,7 +613,7 @@ void TetraMeshSpatialGrid::writeGridPlotFiles(const SimulationItem* probe) const
             indices[4 * v + 3] = faceIndices[2];
         }
 
-        const Box& extent = tetra.extent();
+        Box extent = tetraExtent(i);
         if (extent.zmin() <= 0 && extent.zmax() >= 0) plotxy.writePolyhedron(coords, indices);
         if (extent.ymin() <= 0 && extent.ymax() >= 0) plotxz.writePolyhedron(coords, indices);
         if (extent.xmin() <= 0 && extent.xmax() >= 0) plotyz.writePolyhedron(coords, indices);
@@ -690,75 +661,35 @@ public:
             // loop in case no exit point was found (which should happen only rarely)
             while (true)
             {
-                const Tetra tetra = _grid->_tetrahedra[_mr];
-                const FourFaces& faces = tetra.faces();
                 Position pos = r();
                 Direction dir = k();
-
-                int leavingFace = -1;
-                double ds = DBL_MAX;
-
-                // find entering face using a single Plücker product
-                if (_enteringFace == -1) _enteringFace = tetra.findEnteringFace(pos, dir);
-
-                // the translated Plücker moment in the local coordinate system
-                Vec moment = Vec::cross(dir, pos - tetra.vertex(_enteringFace));
-
-                // clockwise vertices around entering face
-                auto cv = clockwiseVertices(_enteringFace);
-
-                // determine orientations for use in the decision tree
-                double prod0 = Vec::dot(moment, tetra.edge(cv[0], _enteringFace));
-                int clock0 = prod0 < 0;
-                // if clockwise move clockwise else move counterclockwise
-                int i = clock0 ? 1 : 2;
-                double prodi = Vec::dot(moment, tetra.edge(cv[i], _enteringFace));
-                int cclocki = prodi >= 0;
-
-                // use plane intersection algorithm if Plücker products are ambiguous
-                // this is actually more strict than the algorithm described by Maria (2017)
-                // but these edge cases are incredibly rare and can cause issues
-                if (prod0 == 0. || prodi == 0.)
+                double rx = pos.x(), ry = pos.y(), rz = pos.z();
+                double kx = dir.x(), ky = dir.y(), kz = dir.z();
+
+                // calculate the distance along the ray to each of the four face planes in a form that allows
+                // the compiler to use vector instructions; ignore faces that the ray is not moving towards
+                const double* planes = &_grid->_planes[16 * static_cast<size_t>(_mr)];
+                double sv[4];
+                for (int f = 0; f < 4; f++)
                 {
-                    for (int face : cv)
-                    {
-                        const Vec& n = faces[face]._normal;
-                        double ndotk = Vec::dot(n, dir);
-                        if (ndotk > 0)
-                        {
-                            const Vec& v = tetra.vertex(_enteringFace);
-                            double dq = Vec::dot(n, v - pos) / ndotk;
-                            if (dq < ds)
-                            {
-                                ds = dq;
-                                leavingFace = face;
-                            }
-                        }
-                    }
-                }
-                // use Maria (2017) algorithm otherwise
-                else
-                {
-                    // decision table for clock0 and cclocki
-                    // 1 1 -> 2
-                    // 0 0 -> 1
-                    // 1 0 -> 0
-                    // 0 1 -> 0
-                    static constexpr int dtable[2][2] = {{1, 0}, {0, 2}};  // must be static
-                    leavingFace = cv[dtable[clock0][cclocki]];
-                    // plane intersection to leaving face
-                    const Vec& n = faces[leavingFace]._normal;
-                    const Vec& v = tetra.vertex(_enteringFace);
-                    double ndotk = Vec::dot(n, dir);
-                    ds = Vec::dot(n, v - pos) / ndotk;
+                    double ndotk = planes[f] * kx + planes[4 + f] * ky + planes[8 + f] * kz;
+                    double ndotr = planes[f] * rx + planes[4 + f] * ry + planes[8 + f] * rz;
+                    sv[f] = ndotk > 0. ? (planes[12 + f] - ndotr) / ndotk : DBL_MAX;
                 }
 
+                // ignore the entering face, if known, and select the face with the smallest distance
+                if (_enteringFace >= 0) sv[_enteringFace] = DBL_MAX;
+                int leavingFace = 0;
+                for (int f = 1; f < 4; f++)
+                    if (sv[f] < sv[leavingFace]) leavingFace = f;
+                double ds = sv[leavingFace];
+
                 // if no exit point was found, advance the current point by a small distance,
                 // recalculate the cell index, and return to the start of the loop
-                if (leavingFace == -1 || ds < _grid->_eps)
+                if (ds == DBL_MAX || ds < _grid->_eps)
                 {
                     propagater(_grid->_eps);
-                    _mr = _grid->cellIndex(r());
+                    _mr = _grid->walk(r(), _mr);
 
                     if (_mr < 0)
                     {
@@ -775,16 +706,17 @@ public:
                 {
                     propagater(ds);
                     setSegment(_mr, ds);
-                    _mr = faces[leavingFace]._ntetra;
+                    int neighbor = _grid->_neighbors[4 * static_cast<size_t>(_mr) + leavingFace];
 
-                    if (_mr < 0)
+                    if (neighbor < 0)
                     {
                         setState(State::Outside);
                         return false;
                     }
                     else
                     {
-                        _enteringFace = faces[leavingFace]._nface;
+                        _mr = neighbor >> 2;
+                        _enteringFace = neighbor & 3;
                         return true;
                     }
                 }
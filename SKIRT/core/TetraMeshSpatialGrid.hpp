@@ -6,7 +6,6 @@
 #ifndef TETRAMESHSPATIALGRID_HPP
 #define TETRAMESHSPATIALGRID_HPP
 
-#include "BoxSearch.hpp"
 #include "BoxSpatialGrid.hpp"
 #include "PathSegmentGenerator.hpp"
 #include <array>
@@ -102,84 +101,9 @@ protected:
     //==================== Private data types ====================
 
 private:
-    /** Private struct that represents a face of a tetrahedron, storing all relevant
-        information for photon traversal. */
-    struct Face
-    {
-        int _ntetra;  // cell index of neighbouring tetrahedron
-        int _nface;   // index of the equivalent face in the neighbouring tetrahedron [0, 3]
-        Vec _normal;  // outward facing normal
-
-        Face() : _ntetra(0), _nface(0) {}
-
-        Face(int ntetra, int nface, Vec normal) : _ntetra(ntetra), _nface(nface), _normal(normal) {}
-    };
-
     /** Alias for a fixed array of 4 integer indices. */
     using FourIndices = std::array<int, 4>;
 
-    /** Alias for a fixed array of 4 Faces. */
-    using FourFaces = std::array<Face, 4>;
-
-    /** Private class that represents a tetrahedron, storing all relevant information to fully
-        describe its geometry and allow photon traversal through it. */
-    class Tetra
-    {
-    private:
-        const vector<Vec>& _vertices;  // reference to all vertices, could be passed as arg but this is more convenient
-        Box _extent;                   // bounding box of the tetrahedron
-        Vec _centroid;                 // barycenter of the tetrahedron
-        FourIndices _vertexIndices;    // indices of the vertices in the global vertex list
-        FourFaces _faces;              // faces of the tetrahedron, see struct Face
-
-    public:
-        /** This constructor initializes the tetrahedron by setting its fields and calculating the
-            bounding box and centroid. */
-        Tetra(const vector<Vec>& vertices, const FourIndices& vertexIndices, const FourFaces& faces);
-
-        /** This function finds a face that is not the leaving face which can act as the entering
-            face in the traversal algorithm. */
-        int findEnteringFace(const Vec& pos, const Direction& dir) const;
-
-        /** This function checks if the given position is contained inside the tetrahedron.
-            It first checks if the position is inside the bounding box of the tetrahedron. */
-        bool contains(const Position& bfr) const;
-
-        /** This function generates three random barycentric coordinates for uniformly sampling
-            inside this tetrahedron. The fourth coordinate is calculated by ensuring their sum
-            equals 1, i.e. r=1-s-t-u.
-            Source: Generating Random Points in a Tetrahedron: DOI 10.1080/10867651.2000.10487528 */
-        double generateBarycentric(double& s, double& t, double& u) const;
-
-        /** This function generates a random position inside the tetrahedron by generating random
-             barycentric coordinates and using the vertices of the tetrahedron. */
-        Position generatePosition(Random* random) const;
-
-        /** This function returns the vertex with index \f$t\f$ of the tetrahedron, where
-            \f$t \in \{0, 1, 2, 3\}\f$. */
-        Vec vertex(int t) const;
-
-        /** This function returns the edge from vertex \f$t1\f$ to \f$t2\f$ of the tetrahedron,
-            where \f$t1, t2 \in \{0, 1, 2, 3\}\f$. */
-        Vec edge(int t1, int t2) const;
-
-        /** This function calculates and returns the volume of the tetrahedron. */
-        double volume() const;
-
-        /** This function calculates and returns the approximate diagonal of the tetrahedron.
-            It calculates the square root of the average of the squared edge lengths. */
-        double diagonal() const;
-
-        /** This function returns a reference to an array of the faces of the tetrahedron. */
-        const FourFaces& faces() const;
-
-        /** This function returns the centroid of the tetrahedron. */
-        const Vec& centroid() const;
-
-        /** This function returns the extent of the tetrahedron. */
-        const Box& extent() const;
-    };
-
     //==================== Private construction ====================
 
 private:
@@ -207,13 +131,36 @@ private:
     /** This private function stores the tetrahedra and vertices from the \em final tetgenio container
         into the \em TetraMeshSpatialGrid members. The input is the tetgenio reference with the final
         tetrahedralization. The \em storeVertices parameter indicates whether to overwrite the vertices
-        with those from the tetgenio container. This function also logs some cell statistics after
-        it finishes transferring the data. */
+        with those from the tetgenio container. The tetrahedra are renumbered in the order of a
+        space-filling curve (Morton order) through their centroids, so that tetrahedra that are close
+        to each other in space are usually also close to each other in memory. The function then
+        builds the compact data structure used for traversal and point location, and logs some cell
+        statistics. */
     void storeTetrahedra(const tetgenio& final, bool storeVertices);
 
-    /** This private function builds the search data structure for the tetrahedral mesh. */
+    /** This private function builds the coarse grid of hint tetrahedra used as starting points for
+        locating the tetrahedron containing a given position. */
     void buildSearch();
 
+    //==================== Private interrogation ====================
+
+private:
+    /** This private function returns the vertex with index \f$t\f$ of the tetrahedron with index
+        \f$m\f$, where \f$t \in \{0, 1, 2, 3\}\f$. */
+    const Vec& vertex(int m, int t) const { return _vertices[_tetraVertices[m][t]]; }
+
+    /** This private function returns the bounding box of the tetrahedron with index \f$m\f$. */
+    Box tetraExtent(int m) const;
+
+    /** This private function returns the index of the tetrahedron containing the position
+        \f${\bf{r}}\f$, walking through the mesh starting from the tetrahedron with index \f$m\f$.
+        In each step, the walk crosses the face of the current tetrahedron for which the position
+        lies furthest outside of the face plane, until the position lies inside (or on the boundary
+        of) the current tetrahedron. If the walk leaves the convex hull, the function returns -1. In
+        the unlikely event that the walk does not terminate within a reasonable number of steps,
+        the function reverts to testing all tetrahedra. */
+    int walk(Position bfr, int m) const;
+
     //======================= Interrogation =======================
 
 public:
@@ -228,8 +175,9 @@ public:
     double diagonal(int m) const override;
 
     /** This function returns the index of the cell that contains the position \f${\bf{r}}\f$. It
-        uses a search data structure to accelerate the search. If no cell is found to contain this
-        position, the function returns -1. */
+        walks through the mesh starting from the hint tetrahedron recorded for the block of the
+        coarse search grid containing the position. If no cell is found to contain this position,
+        the function returns -1. */
     int cellIndex(Position bfr) const override;
 
     /** This function returns the centroid of the tetrahedron with index \f$m\f$. */
@@ -242,51 +190,35 @@ public:
 
 public:
     /** This function creates and returns ownership of a path segment generator suitable for the
-        tetrahedral spatial grid, implemented as a private \em PathSegmentGenerator subclass. The
-        algorithm for constructing the path is taken from Maria et al. (2017).
-
-        The algorithm uses Plücker coordinates to identify the exit face of a ray inside a given
-        tetrahedron. Plücker coordinates are a set of six values that describe a directed line in 3D space:
-        \f[\mathbf{\pi}_R = \{\mathbf{k} : \mathbf{k} \times \mathbf{r}\} = \{\mathbf{U}_R : \mathbf{V}_R\}\f]
-        where \f$\mathbf{r}\f$ is a position along the ray, and \f$\mathbf{k}\f$ is the ray's direction.
-        The Plücker product is defined as:
-        \f[\mathbf{\pi}_R \odot \mathbf{\pi}_S = \mathbf{U}_R \cdot \mathbf{V}_S + \mathbf{U}_S \cdot \mathbf{V}_R\f]
-        This product determines the relative orientation between two rays:
-        \f[\mathbf{\pi}_R \odot \mathbf{\pi}_S = \begin{cases}
-        > 0 & \iff S \text{ goes counterclockwise around } R\\
-        < 0 & \iff S \text{ goes clockwise around } R\\
-        = 0 & \iff S \text{ intersects or is parallel to } R \end{cases} \f]
-        A ray exits a tetrahedron through a particular face if the Plücker products with all three
-        clockwise-ordered edges of that face are negative. The algorithm in Maria et al. (2017) optimizes
-        this by requiring only two Plücker products to be evaluated. Our implementation is described below.
-
-        In the first step, the function checks whether the start point is inside the domain. If so, the current
-        point is simply initialized to the start point. If not, the function computes the path segment to the
-        first intersection with one of the domain walls and moves the current point inside the domain. Next,
-        the function determines the cell index of the tetrahedron containing the current point. If none is
-        found, the path is terminated. Before the traversal algorithm can commence, a non-leaving face must
-        be identified. This face acts as the entry face for the ray. Note that this face does not necessarily
-        have to be the actual entry face. This task is handled by the \em findEnteringFace function of the
-        \em Tetra class.
-
-        Next, the traversal algorithm begins. The entering face is labeled as face 0, with its opposing vertex
-        labeled as vertex 0. We start by evaluating the Plücker product of the ray with the edge \f$1 \to 0\f$.
-        Based on whether this product is positive or negative, the next Plücker product to evaluate is determined.
-        If the product is negative (i.e., clockwise orientation), we evaluate the product with the edge in the
-        clockwise direction viewed from vertex 0. The same applies for a positive product. The exit face is
-        determined using the decision tree described in Maria et al. (2017). The distance traveled through the
-        cell is calculated using a simple line-plane intersection:
-        \f[s_i = \frac{\mathbf{n} \cdot (\mathbf{v} - \mathbf{r})}{\mathbf{n} \cdot \mathbf{k}}\f]
-        where \f$\mathbf{n}\f$ is the outward-pointing normal of the face, \f$\mathbf{v}\f$ is any vertex on
-        the exit face, and \f$\mathbf{r}\f$ is the current position.
-
-        Although the algorithm described in Maria et al. (2017) works even if one of the Plücker products is zero,
-        we revert to a plane intersection algorithm in such cases. This approach is similar to the one used in the
-        \em VoronoiMeshSnapshot class, where the closest intersection distance with all faces is found.
-
-        The algorithm continues until the exit face lies on the convex hull boundary. At this point, the path is
-        terminated. If the exit face is not found, which should only rarely happen due to computational
-        inaccuracies, the current point is advanced by a small distance, and the cell index is recalculated. */
+        tetrahedral spatial grid, implemented as a private \em PathSegmentGenerator subclass.
+
+        In the first step, the function checks whether the start point is inside the domain. If so,
+        the current point is simply initialized to the start point. If not, the function computes
+        the path segment to the first intersection with one of the domain walls and moves the
+        current point inside the domain. Next, the function determines the cell index of the
+        tetrahedron containing the current point. If none is found, the path is terminated.
+
+        Next, the traversal algorithm begins. For each of the four faces of the current
+        tetrahedron, the algorithm calculates the distance from the current position along the ray
+        to the face plane using a simple line-plane intersection:
+        \f[s_i = \frac{d_i - \mathbf{n}_i \cdot \mathbf{r}}{\mathbf{n}_i \cdot \mathbf{k}}\f]
+        where \f$\mathbf{n}_i\f$ is the outward-pointing normal of the face, \f$d_i\f$ is the
+        corresponding plane offset, \f$\mathbf{r}\f$ is the current position, and
+        \f$\mathbf{k}\f$ is the direction of the ray. Faces with \f$\mathbf{n}_i \cdot
+        \mathbf{k} \le 0\f$, and the face through which the ray entered the tetrahedron, are
+        ignored. The exit face is the face with the smallest distance. Because the face data are
+        stored as a structure of arrays in a contiguous block for each tetrahedron, the compiler
+        can evaluate the four tests in parallel using vector instructions, and each step touches
+        only a few cache lines. This approach is similar to the one used in the \em
+        VoronoiMeshSnapshot class, and replaces the Plücker coordinate decision tree of Maria et
+        al. (2017), which requires fewer arithmetic operations but more (and less predictable)
+        memory accesses and branches.
+
+        The algorithm continues until the exit face lies on the convex hull boundary. At this point,
+        the path is terminated. If the exit face is not found, which should only rarely happen due
+        to computational inaccuracies, the current point is advanced by a small distance, and the
+        cell index is recalculated by walking through the mesh starting from the current
+        tetrahedron. */
     std::unique_ptr<PathSegmentGenerator> createPathSegmentGenerator() const override;
 
     //===================== Output =====================
@@ -304,13 +236,22 @@ private:
     double _eps{0.};  // small fraction of extent
 
     // data members describing the tetrahedralization
-    int _numCells{0};     // total number of tetrahedra
-    int _numVertices{0};  // total number of vertices
-    vector<Tetra> _tetrahedra;
-    vector<Vec> _vertices;
-
-    // smart grid that organizes the tetrahedra into blocks
-    BoxSearch _search;  // search structure for locating cells
+    int _numCells{0};                    // total number of tetrahedra
+    int _numVertices{0};                 // total number of vertices
+    vector<Vec> _vertices;               // vertex positions
+    vector<FourIndices> _tetraVertices;  // indices of the four vertices of each tetrahedron, indexed on m
+
+    // compact data used for traversal and point location, with a contiguous block for each tetrahedron
+    // - the outward unit normal n of face f (the face opposite vertex f) and the offset d so that n.r = d in the
+    //   face plane, stored as a structure of arrays: nx, ny, nz and d at _planes[16*m + 4*c + f] for c = 0,1,2,3
+    // - the index of the neighbouring tetrahedron across face f times 4, plus the index of the same face in the
+    //   neighbour, or -1 if the face lies on the convex hull, stored at _neighbors[4*m + f]
+    vector<double> _planes;
+    vector<int> _neighbors;
+
+    // coarse grid of hint tetrahedra for point location, indexed on (i*n+j)*n+k with n = _numHintBlocks
+    int _numHintBlocks{0};
+    vector<int> _hints;
 
     // allow our path segment generator to access our private data members
     class MySegmentGenerator;
@@ -4,15 +4,19 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "TimeLogger.hpp"
+#include "HardwareCounters.hpp"
 #include "Log.hpp"
 #include "StringUtils.hpp"
+#include "Tracer.hpp"
 #include <exception>
 
 ////////////////////////////////////////////////////////////////////
 
 TimeLogger::TimeLogger(Log* log, string scope) : _log(log), _scope(scope), _started(std::chrono::steady_clock::now())
 {
+    Tracer::begin(scope);
     if (log) log->info("Starting " + scope + "...");
+    if (log && HardwareCounters::isEnabled()) _counters.reset(new HardwareCounters);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -32,6 +36,9 @@ TimeLogger::~TimeLogger()
 {
     using namespace std::chrono;
 
+    // end the corresponding trace scope, if any
+    Tracer::end();
+
     // If no Log instance was passed, we don't have to calculate the elapsed time
     if (!_log) return;
 
@@ -67,6 +74,13 @@ TimeLogger::~TimeLogger()
     }
 
     _log->success("Finished " + _scope + " in " + elapsed + ".");
+
+    // if hardware counters are enabled, log a summary of the hardware events during the scope
+    if (_counters)
+    {
+        double seconds = duration_cast<duration<double>>(steady_clock::now() - _started).count();
+        for (const string& line : _counters->report(seconds)) _log->info("  " + line);
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
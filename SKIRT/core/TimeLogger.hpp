@@ -8,6 +8,7 @@
 
 #include "Basics.hpp"
 #include <chrono>
+class HardwareCounters;
 class Log;
 
 ////////////////////////////////////////////////////////////////////
@@ -18,7 +19,12 @@ class Log;
     respectively. Typical use is to construct an instance at the beginning of a scope; the finish
     message is automatically generated by the destructor when the instance goes out of scope.
     Nested pairs of start/finish messages can easily be obtained by using TimeLogger in different
-    scopes. */
+    scopes.
+
+    If hardware performance counter measurement has been enabled (see the HardwareCounters class),
+    the TimeLogger also counts hardware events such as retired instructions, cycles, cache misses
+    and branch misses for all threads during the execution of the scope, and logs a summary of
+    these counts following the finish message. */
 class TimeLogger
 {
 public:
@@ -37,6 +43,7 @@ private:
     Log* _log;
     string _scope;
     std::chrono::steady_clock::time_point _started;
+    std::unique_ptr<HardwareCounters> _counters;  // constructed only if hardware counters are enabled
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -0,0 +1,129 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "VoigtSamplingTable.hpp"
+#include "NR.hpp"
+#include "Random.hpp"
+#include "VoigtProfile.hpp"
+#include <mutex>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    constexpr double zetaMin = -4.5;    // smallest tabulated value of log10(a)
+    constexpr double deltaZeta = 0.1;   // spacing of the tabulated values of log10(a)
+    constexpr int numZeta = 31;         // number of tabulated values of log10(a)
+    constexpr double deltaX = 0.05;     // spacing of the tabulated values of x
+    constexpr int numX = 161;           // number of tabulated values of x, starting at zero
+    constexpr double wMin = -12.5;      // smallest grid point for w = u - x
+    constexpr int numW = 681;           // number of uniformly spaced grid points for w
+    constexpr double deltaW = 0.025;    // spacing of the uniform grid points for w
+    constexpr double wSpike = 0.25;     // limit of the geometric grid points around w = 0
+    constexpr double numPerDex = 25.;   // number of geometric grid points per dex
+    constexpr int numGuide = 256;       // number of guide intervals for each cumulative distribution
+
+    // returns the grid for w = u - x for the given Voigt parameter
+    Array offsetGrid(double a)
+    {
+        vector<double> wv;
+        for (int i = 0; i != numW; ++i)
+        {
+            double w = wMin + i * deltaW;
+            if (abs(w) > wSpike - 0.5 * deltaW) wv.push_back(w);
+        }
+        wv.push_back(0.);
+        for (int m = 0;; ++m)
+        {
+            double w = 0.1 * a * pow(10., m / numPerDex);
+            if (w > wSpike - 0.5 * deltaW) break;
+            wv.push_back(w);
+            wv.push_back(-w);
+        }
+        std::sort(wv.begin(), wv.end());
+        Array result;
+        NR::assign(result, wv);
+        return result;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void VoigtSamplingTable::initialize()
+{
+    _tablev.resize(numZeta);
+    for (int k = 0; k != numZeta; ++k)
+    {
+        double a = pow(10., zetaMin + k * deltaZeta);
+        Array wv = offsetGrid(a);
+        size_t n = wv.size();
+
+        // the integral of the Lorentzian factor over each bin does not depend on x
+        Array Lv(n - 1);
+        for (size_t i = 0; i != n - 1; ++i) Lv[i] = (atan(wv[i + 1] / a) - atan(wv[i] / a)) / a;
+
+        // calculate the normalized cumulative distribution of w for each x
+        _tablev[k].initialize(wv, numX, numGuide);
+        Array Gv(n);
+        Array Pv(n);
+        for (int j = 0; j != numX; ++j)
+        {
+            double x = j * deltaX;
+            for (size_t i = 0; i != n; ++i) Gv[i] = exp(-(x + wv[i]) * (x + wv[i]));
+            for (size_t i = 0; i != n - 1; ++i) Pv[i + 1] = Pv[i] + 0.5 * (Gv[i] + Gv[i + 1]) * Lv[i];
+            Pv /= Pv[n - 1];
+            _tablev[k].setRow(j, Pv);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+const VoigtSamplingTable& VoigtSamplingTable::shared()
+{
+    static VoigtSamplingTable table;
+    static std::once_flag initialized;
+    std::call_once(initialized, []() { table.initialize(); });
+    return table;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double VoigtSamplingTable::sample(double a, double x, Random* random) const
+{
+    // make x positive and remember the orginal sign
+    double sign = 1.;
+    if (x < 0.)
+    {
+        sign = -1.;
+        x = -x;
+    }
+
+    // fall back to the rejection technique outside of the tabulated range
+    double fz = (log10(a) - zetaMin) / deltaZeta;
+    double fx = x / deltaX;
+    if (!(fz >= 0. && fz <= numZeta - 1) || fx >= numX - 1) return VoigtProfile::sample(a, sign * x, random);
+
+    // select one of the neighboring table points along each axis
+    int k = static_cast<int>(fz);
+    if (k < numZeta - 1 && random->uniform() < fz - k) ++k;
+    int j = static_cast<int>(fx);
+    if (random->uniform() < fx - j) ++j;
+
+    // draw the offset from the resonance frequency
+    double u = x + _tablev[k].generate(j, random->uniform());
+    return u * sign;
+}
+
+////////////////////////////////////////////////////////////////////
+
+size_t VoigtSamplingTable::allocatedBytes() const
+{
+    size_t bytes = 0;
+    for (const auto& table : _tablev) bytes += table.allocatedBytes();
+    return bytes;
+}
+
+////////////////////////////////////////////////////////////////////
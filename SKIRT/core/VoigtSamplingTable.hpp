@@ -0,0 +1,83 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef VOIGTSAMPLINGTABLE_HPP
+#define VOIGTSAMPLINGTABLE_HPP
+
+#include "InverseCdfTable.hpp"
+class Random;
+
+////////////////////////////////////////////////////////////////////
+
+/** VoigtSamplingTable is a utility class for sampling random values from the probability
+    distribution \f[ P(u) \propto \frac{\mathrm{e}^{-u^2}}{(u-x)^2+a^2} \f] using precomputed
+    tables rather than the rejection technique implemented by the VoigtProfile::sample() function.
+    For a given Voigt parameter \f$a\f$ and dimensionless frequency \f$x\f$, the cost of drawing a
+    sample from the tables is independent of the parameter values, whereas the number of attempts
+    needed by the rejection technique increases substantially in the wings of the line.
+
+    <b>Table layout</b>
+
+    Because \f$P(-u|-x)=P(u|x)\f$, the tables cover only positive frequencies. They are indexed on
+    \f$\zeta=\log_{10}a\f$, with 31 points spaced by 0.1 in the range \f$-4.5\le\zeta\le-1.5\f$,
+    and on \f$x\f$, with 161 points spaced by 0.05 in the range \f$0\le x\le 8\f$. The former range
+    corresponds to gas temperatures from about 2 K to about 2 million K. Each table entry holds the
+    cumulative distribution of the offset \f$w=u-x\f$ discretized on a grid that is the same for
+    all frequencies with a given \f$\zeta\f$. This grid combines points that are spaced
+    geometrically around the Lorentzian spike at \f$w=0\f$, starting at \f$a/10\f$, with points
+    that are spaced uniformly by 0.025 over the Gaussian bulk of the distribution. The probability
+    mass in each grid bin is obtained by integrating the Lorentzian factor analytically and
+    averaging the Gaussian factor over the bin borders. The grid covers the range
+    \f$|u|\lesssim4.5\f$ for all tabulated frequencies, beyond which the Gaussian factor drops
+    below \f$10^{-8}\f$. The tables occupy about 38 MB of memory.
+
+    <b>Sampling</b>
+
+    Given values of \f$a\f$ and \f$x\f$ inside the tabulated range, the sample() function selects
+    one of the two neighboring table points along each axis with a probability proportional to
+    linear interpolation, draws an offset \f$w\f$ from the selected cumulative distribution using
+    an InverseCdfTable instance, and returns \f$u=x+w\f$ for the actual value of \f$x\f$. Because
+    the offsets are tabulated relative to the resonance frequency, the location of the Lorentzian
+    spike is reproduced exactly. The stochastic interpolation between neighboring frequencies
+    broadens the Gaussian bulk by a variance of at most \f$(0.05)^2/4\f$. The interpolation
+    between neighboring Voigt parameters replaces the distribution for the actual value of \f$a\f$
+    by a mixture of the distributions for the neighboring table points. This bias scales with the
+    square of the spacing in \f$\zeta\f$; for the spacing used here, the maximum difference
+    between the cumulative distributions of the mixture and of the exact distribution (i.e. the
+    Kolmogorov-Smirnov distance) is below 0.001 across the tabulated range, which is comparable to
+    the sampling noise for a million random values. For values of \f$a\f$
+    outside of the tabulated range and for \f$|x|\ge8\f$, the function falls back to the
+    VoigtProfile::sample() function. */
+class VoigtSamplingTable
+{
+public:
+    /** The default constructor creates an empty table. The initialize() function must be called
+        before the table can be used. */
+    VoigtSamplingTable() {}
+
+    /** This function calculates the tables as described in the class header. */
+    void initialize();
+
+    /** This function returns a reference to a table instance shared by all clients in the
+        process. Because the tables do not depend on any simulation parameters, a single instance
+        can serve all medium components in all simulations. The shared instance is calculated in a
+        thread-safe manner the first time this function is called, and is never released. */
+    static const VoigtSamplingTable& shared();
+
+    /** This function returns a random value from the probability distribution \f$P(u)\f$ defined
+        in the class header for the specified parameters \f$a\f$ and \f$x\f$, using the specified
+        random generator. */
+    double sample(double a, double x, Random* random) const;
+
+    /** This function returns the amount of memory allocated by the tables, in bytes. */
+    size_t allocatedBytes() const;
+
+private:
+    vector<InverseCdfTable> _tablev;  // the cumulative distributions of w, indexed on zeta and x
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
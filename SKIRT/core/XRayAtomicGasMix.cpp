@@ -9,10 +9,14 @@
 #include "Constants.hpp"
 #include "DipolePhaseFunction.hpp"
 #include "FatalError.hpp"
+#include "InverseCdfTable.hpp"
+#include "Log.hpp"
 #include "MaterialState.hpp"
+#include "MemoryLedger.hpp"
 #include "NR.hpp"
 #include "Random.hpp"
 #include "Range.hpp"
+#include "StringUtils.hpp"
 #include "TextInFile.hpp"
 
 ////////////////////////////////////////////////////////////////////
@@ -359,6 +363,65 @@ namespace
         return NR::clampedValue<NR::interpolateLogLog>(q, qv, fv);
     }
 
+    // number of points per dex in the scaled energy grid used for tabulating scattering angle distributions
+    constexpr double numEnergiesPerDex = 50.;
+
+    // this class holds the normalized cumulative distribution of the scattering angle cosine for each atom
+    // at each point of a logarithmic scaled energy grid covering the simulation's wavelength range,
+    // and samples a random cosine for a given scaled energy from the distribution for one of the two neighboring
+    // grid points, selected with a probability equal to its linear interpolation weight in log energy; this is
+    // equivalent to sampling from the distribution interpolated linearly in log energy between the grid points
+    class CosineTable
+    {
+    private:
+        InverseCdfTable _table;  // indexed on energy grid point and atom
+        double _logxmin{0.};     // logarithm of the scaled energy at the first grid point
+        int _numX{0};            // the number of grid points
+
+    public:
+        // tabulate the distributions, given the cosine grid and a function returning the (unnormalized)
+        // scattering angle pdf for a given scaled energy, atomic number and theta index (in the range [1,numTheta[);
+        // log and register the amount of memory allocated for the table using the given description
+        template<typename Functor>
+        void initialize(const SimulationItem* item, const Array& costhetav, Functor pdf, string description)
+        {
+            // determine the scaled energy range; the scaled energy is inversely proportional to the wavelength
+            Range range = item->find<Configuration>()->simulationWavelengthRange();
+            range.intersect(nonZeroRange);
+            if (range.empty()) range = nonZeroRange;
+            _logxmin = log10(scaledEnergy(range.max()));
+            double logxmax = log10(scaledEnergy(range.min()));
+            _numX = 1 + static_cast<int>(std::ceil((logxmax - _logxmin) * numEnergiesPerDex));
+
+            // tabulate the cumulative distributions
+            _table.initialize(costhetav, _numX * numAtoms);
+            Array thetaXv;
+            for (int k = 0; k != _numX; ++k)
+            {
+                double x = pow(10., _logxmin + k / numEnergiesPerDex);
+                for (size_t Z = 1; Z <= numAtoms; ++Z)
+                {
+                    NR::cdf(thetaXv, maxTheta, [&pdf, x, Z](int t) { return pdf(x, Z, t + 1); });
+                    _table.setRow(k * numAtoms + Z - 1, thetaXv);
+                }
+            }
+            item->find<Log>()->info("XRayAtomicGasMix allocated "
+                                    + StringUtils::toMemSizeString(_table.allocatedBytes()) + " of memory for "
+                                    + description + " scattering angle distributions");
+            item->find<MemoryLedger>()->record("scattering angle tables", _table.allocatedBytes());
+        }
+
+        // return a random cosine sampled from the distribution for the given scaled energy and atomic number
+        double generate(Random* random, double x, int Z) const
+        {
+            double fk = (log10(x) - _logxmin) * numEnergiesPerDex;
+            fk = std::max(0., std::min(fk, static_cast<double>(_numX - 1)));
+            int k = static_cast<int>(fk);
+            if (k < _numX - 1 && random->uniform() < fk - k) ++k;
+            return _table.generate(k * numAtoms + Z - 1, random->uniform());
+        }
+    };
+
     // this helper implements bound-electron Compton scattering
     class BoundComptonHelper : public XRayAtomicGasMix::ScatteringHelper
     {
@@ -378,6 +441,7 @@ namespace
         Array _sinthetav = Array(numTheta);
         Array _sin2thetav = Array(numTheta);
         Array _sintheta2v = Array(numTheta);
+        CosineTable _costable;
 
         // cache
         Random* _random{nullptr};
@@ -413,8 +477,8 @@ namespace
                 _cumCPv.push_back(Pv);
             }
 
-            // construct a theta grid and precalculate values used in generateCosineFromPhaseFunction()
-            // to accelerate construction of the cumulative phase function distribution
+            // construct a theta grid and precalculate values used to construct the cumulative phase function
+            // distributions
             for (size_t t = 0; t != numTheta; ++t)
             {
                 double theta = t * deltaTheta;
@@ -424,6 +488,17 @@ namespace
                 _sintheta2v[t] = sin(0.5 * theta);
             }
 
+            // tabulate the cumulative phase function distributions used in generateCosineFromPhaseFunction()
+            _costable.initialize(
+                item, _costhetav,
+                [this](double x, int Z, int t) {
+                    double C = comptonFactor(x, _costhetav[t]);
+                    double phase = C * C * C + C - C * C * _sin2thetav[t];
+                    double incoherent = interpolateQ(x, _sintheta2v[t], _SFv[0], _SFv[Z]);
+                    return phase * incoherent * _sinthetav[t];
+                },
+                "bound-Compton");
+
             // cache random nr generator
             _random = item->find<Random>();
         }
@@ -451,18 +526,8 @@ namespace
 
         double generateCosineFromPhaseFunction(double x, double Z) const
         {
-            // construct the normalized cumulative phase function distribution for this x
-            Array thetaXv;
-            NR::cdf(thetaXv, maxTheta, [this, x, Z](int t) {
-                t += 1;
-                double C = comptonFactor(x, _costhetav[t]);
-                double phase = C * C * C + C - C * C * _sin2thetav[t];
-                double incoherent = interpolateQ(x, _sintheta2v[t], _SFv[0], _SFv[Z]);
-                return phase * incoherent * _sinthetav[t];
-            });
-
-            // draw a random cosine from this distribution
-            return _random->cdfLinLin(_costhetav, thetaXv);
+            // draw a random cosine from the tabulated distribution for the nearest scaled energy
+            return _costable.generate(_random, x, Z);
         }
 
         // sample a target electron momentum from the distribution with the given maximum
@@ -566,6 +631,7 @@ namespace
         Array _cos2thetav = Array(numTheta);
         Array _sinthetav = Array(numTheta);
         Array _sintheta2v = Array(numTheta);
+        CosineTable _costable;
 
     public:
         SmoothRayleighHelper(SimulationItem* item)
@@ -582,8 +648,8 @@ namespace
             _random = item->find<Random>();
             _dpf.initialize(_random);
 
-            // construct a theta grid and precalculate values used in generateCosineFromPhaseFunction()
-            // to accelerate construction of the cumulative phase function distribution
+            // construct a theta grid and precalculate values used to construct the cumulative phase function
+            // distributions
             for (size_t t = 0; t != numTheta; ++t)
             {
                 double theta = t * deltaTheta;
@@ -592,6 +658,16 @@ namespace
                 _sinthetav[t] = sin(theta);
                 _sintheta2v[t] = sin(0.5 * theta);
             }
+
+            // tabulate the cumulative phase function distributions used in generateCosineFromPhaseFunction()
+            _costable.initialize(
+                item, _costhetav,
+                [this](double x, int Z, int t) {
+                    double phase = 1. + _cos2thetav[t];
+                    double form = interpolateQ(x, _sintheta2v[t], _FFv[0], _FFv[Z]);
+                    return phase * form * form * _sinthetav[t];
+                },
+                "smooth Rayleigh");
         }
 
         double sectionSca(double lambda, int Z) const override
@@ -617,17 +693,8 @@ namespace
 
         double generateCosineFromPhaseFunction(double x, double Z) const
         {
-            // construct the normalized cumulative phase function distribution for this x
-            Array thetaXv;
-            NR::cdf(thetaXv, maxTheta, [this, x, Z](int t) {
-                t += 1;
-                double phase = 1. + _cos2thetav[t];
-                double form = interpolateQ(x, _sintheta2v[t], _FFv[0], _FFv[Z]);
-                return phase * form * form * _sinthetav[t];
-            });
-
-            // draw a random cosine from this distribution
-            return _random->cdfLinLin(_costhetav, thetaXv);
+            // draw a random cosine from the tabulated distribution for the nearest scaled energy
+            return _costable.generate(_random, x, Z);
         }
 
     public:
@@ -207,6 +207,14 @@
     as before, and tabulated real and imaginary anomalous scattering functions \f$F'_Z(E)\f$ and
     \f$F''_Z(E)\f$.
 
+    For bound-electron Compton scattering and smooth Rayleigh scattering, the cumulative
+    distributions of the scattering angle are precalculated for each element on a logarithmic
+    energy grid with 50 points per dex covering the simulation's wavelength range. A random
+    scattering angle is then drawn from the distribution for the nearest grid point at a cost that
+    is independent of the resolution of the scattering angle grid. For anomalous Rayleigh
+    scattering, the distribution is constructed for the exact photon energy during each scattering
+    event, because the anomalous scattering functions vary sharply near the absorption edges.
+
     <b>Electron scattering - photon energy shift</b>
 
     Rayleigh scattering is elastic, meaning that the photon energy (wavelength) does not change
@@ -10,6 +10,7 @@
 #include "FatalError.hpp"
 #include "FileLog.hpp"
 #include "FilePaths.hpp"
+#include "HardwareCounters.hpp"
 #include "MonteCarloSimulation.hpp"
 #include "Parallel.hpp"
 #include "ParallelFactory.hpp"
@@ -20,6 +21,7 @@
 #include "StringUtils.hpp"
 #include "System.hpp"
 #include "TimeLogger.hpp"
+#include "Tracer.hpp"
 #include "XmlHierarchyCreator.hpp"
 #include "XmlHierarchyWriter.hpp"
 
@@ -28,7 +30,7 @@
 namespace
 {
     // the allowed options list, in the format consumed by the CommandLineArguments constructor
-    static const char* allowedOptions = "-t* -s* -d -b -v -m -e -k -i* -o* -r -x";
+    static const char* allowedOptions = "-t* -s* -d -b -v -m -l* -e -p* -c -n -w -k -i* -o* -r -x";
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -202,6 +204,16 @@ int SkirtCommandLineHandler::doBatch()
             if (ProcessManager::isMultiProc())
                 throw FATALERROR("Cannot run multiple simulations in parallel when there are multiple MPI processes");
 
+            // prevent multiple simulations to be launched in parallel while execution tracing is requested,
+            // because the tracer records the events for the process as a whole
+            if (_args.isPresent("-c"))
+                throw FATALERROR("Cannot run multiple simulations in parallel when execution tracing is requested");
+
+            // prevent multiple simulations to be launched in parallel while event counting is requested,
+            // because the event counters are shared by all simulations in the process
+            if (_args.isPresent("-n"))
+                throw FATALERROR("Cannot run multiple simulations in parallel when event counting is requested");
+
             // perform a simulation for each ski file
             TimeLogger logger(&_console, "a set of " + std::to_string(numSkiFiles) + " simulations, "
                                              + std::to_string(_parallelSims) + " in parallel");
@@ -338,6 +350,13 @@ void SkirtCommandLineHandler::doSimulation(size_t index)
         simulation->log()->setMemoryLogging(_args.isPresent("-m"));
         if (_parallelSims > 1 || _args.isPresent("-b")) simulation->log()->setLowestLevel(Log::Level::Success);
 
+        //  - the memory budget
+        if (_args.isPresent("-l"))
+        {
+            if (_args.doubleValue("-l") <= 0.) throw FATALERROR("Memory budget must be positive");
+            simulation->memoryLedger()->setBudget(static_cast<size_t>(_args.doubleValue("-l") * (1 << 30)));
+        }
+
         // output a ski file reflecting this simulation for later reference
         if (ProcessManager::isRoot())
         {
@@ -353,6 +372,17 @@ void SkirtCommandLineHandler::doSimulation(size_t index)
             simulation->config()->setEmulationMode();
         }
 
+        // put the simulation in prediction mode if requested
+        if (_args.isPresent("-p"))
+        {
+            if (_args.isPresent("-e")) throw FATALERROR("Emulation mode and prediction mode cannot be combined");
+            if (_args.doubleValue("-p") < 1.) throw FATALERROR("Number of pilot packets must be at least one");
+            simulation->config()->setPredictionMode(_args.doubleValue("-p"));
+        }
+
+        // put the simulation in event counting mode if requested
+        if (_args.isPresent("-n")) simulation->config()->setEventCountingMode();
+
         // issue welcome message to the simulation log file
         log->setup();
         log->info(_producerInfo);
@@ -365,6 +395,13 @@ void SkirtCommandLineHandler::doSimulation(size_t index)
         if (ProcessManager::isMultiProc() && _args.isPresent("-v") && !_args.isPresent("-e"))
             ProcessManager::setLogger([log](string message) { log->info(message); });
 
+        // enable execution tracing if requested
+        if (_args.isPresent("-c")) Tracer::enable();
+
+        // enable hardware performance counters if requested and available
+        if (_args.isPresent("-w") && !HardwareCounters::enable())
+            log->warning("Hardware performance counters are not available on this system; ignoring the -w option");
+
         // run the simulation and catch and properly report any exceptions to the simulation log file
         try
         {
@@ -385,6 +422,18 @@ void SkirtCommandLineHandler::doSimulation(size_t index)
         // clear verbose MPI logging
         ProcessManager::clearLogger();
 
+        // write the execution trace for this process if requested
+        if (_args.isPresent("-c"))
+        {
+            Tracer::disable();
+            string name = ProcessManager::isRoot()
+                              ? "trace.json"
+                              : "traceP" + StringUtils::padLeft(std::to_string(ProcessManager::rank()), 3, '0') + ".json";
+            string filepath = simulation->filePaths()->output(name);
+            Tracer::write(filepath, ProcessManager::rank());
+            log->info("Execution trace written to " + filepath);
+        }
+
         // if this is the only or first simulation in the run, report memory statistics in the simulation's log file
         if (_parallelSims == 1 && index == 0) reportPeakMemory(_args.isPresent("-v") ? simulation->log() : log);
     }
@@ -433,7 +482,7 @@ void SkirtCommandLineHandler::printHelp()
     _console.warning("To run a simulation with default options:  skirt <ski-filename>");
     _console.warning("");
     _console.warning("  skirt [-t <threads>] [-s <simulations>] [-d]");
-    _console.warning("        [-b] [-v] [-m] [-e]");
+    _console.warning("        [-b] [-v] [-m] [-l <gigabytes>] [-e] [-p <packets>] [-c] [-n] [-w]");
     _console.warning("        [-k] [-i <dirpath>] [-o <dirpath>]");
     _console.warning("        [-r] {<filepath>}*");
     _console.warning("");
@@ -443,7 +492,12 @@ void SkirtCommandLineHandler::printHelp()
     _console.warning("  -b : force brief console logging");
     _console.warning("  -v : force verbose logging for multiple processes");
     _console.warning("  -m : state the amount of used memory at the start of each log message");
+    _console.warning("  -l <gigabytes> : the memory budget for each process");
     _console.warning("  -e : run the simulation in emulation mode to get an estimate of the memory consumption");
+    _console.warning("  -p <packets> : run a pilot with the given number of packets to predict resource usage");
+    _console.warning("  -c : write an execution trace in Chrome trace event format");
+    _console.warning("  -n : count photon packet life cycle events and write statistics for each segment");
+    _console.warning("  -w : log hardware performance counters for each simulation phase (Linux only)");
     _console.warning("  -k : make the input/output paths relative to the ski file being processed");
     _console.warning("  -i <dirpath> : the relative or absolute path for simulation input files");
     _console.warning("  -o <dirpath> : the relative or absolute path for simulation output files");
@@ -21,7 +21,7 @@ simulations in the ski files specified on the command line according to the foll
 
 \verbatim
  skirt [-t <threads>] [-s <simulations>] [-d]
-       [-b] [-v] [-m] [-e]
+       [-b] [-v] [-m] [-l <gigabytes>] [-e] [-p <packets>] [-c] [-n] [-w]
        [-k] [-i <dirpath>] [-o <dirpath>]
        [-r] {<filepath>}*
 \endverbatim
@@ -46,9 +46,42 @@ simulations in the ski files specified on the command line according to the foll
 
 - The -m option causes information on current memory usage to be included in each log message.
 
+- The -l option specifies a memory budget in gigabytes for each process. The simulation registers its major
+  allocations with a memory ledger, and logs a breakdown of the allocated memory at the end of setup and at peak usage.
+  If a budget is specified, the simulation selects more compact operating modes where available (such as storing the
+  radiation field in single precision or disabling SED caches) to remain within the budget. If the resident memory of
+  the process nevertheless exceeds the budget during setup or before an emission segment, the simulation aborts with
+  an error message listing the memory breakdown.
+
 - The -e option activates emulation mode, which can be used to estimate the amount of memory used by
   a given simulation without actually performing the simulation.
 
+- The -p option activates prediction mode, which can be used to estimate the run time, memory usage and
+  communication volume of a given simulation. The simulation performs its regular setup and then launches the
+  specified number of pilot photon packets in the primary emission segment (with the packet numbers for the other
+  segments scaled accordingly), performing a single iteration for each dynamic medium state iteration loop. The
+  measured resource usage for each phase is extrapolated to the full simulation and written to a text file in the
+  output directory. The -p option cannot be combined with the -e option.
+
+- The -c option causes each process to record the begin and end times of the major execution phases, dynamic medium
+  state updates, source preparation, probes, parallel work in each thread, and collective MPI operations, and to
+  write the resulting trace to a JSON file in the output directory after the simulation completes. The file uses the
+  Chrome trace event format and can be inspected with tools such as Perfetto (https://ui.perfetto.dev). Because the
+  trace is recorded for the process as a whole, the -c option cannot be combined with multiple parallel simulations
+  (see the -s option).
+
+- The -n option causes the simulation to count events in the photon packet life cycle, such as path segments,
+  scattering events, peel-offs and terminations, and to write a table with these statistics for each photon
+  packet segment to a text file in the output directory. The overhead of event counting is small but nonzero.
+  Because the event counters are shared by all simulations in the process, the -n option cannot be combined with
+  multiple parallel simulations (see the -s option).
+
+- The -w option causes the hardware performance counters of the processor (instructions, cycles, cache misses and
+  branch misses) to be measured for all threads during each simulation phase logged with start and finish messages.
+  A summary including the number of instructions per cycle, the cache and branch miss rates, and an estimate of the
+  memory bandwidth is logged after each finish message. This option is supported only on Linux systems that allow
+  user processes to access the performance counters; otherwise a warning is issued and the option is ignored.
+
 - The -k option causes the simulation input/output paths to be relative to the ski file being processed, rather than
   to the current directory. This is useful, for example, when processing multiple ski files organized in a nested
   directory hierarchy (see the -r option).
@@ -5,10 +5,12 @@
 
 #include "ProcessManager.hpp"
 #include "FatalError.hpp"
+#include "Tracer.hpp"
 #include <array>
 
 #ifdef BUILD_WITH_MPI
 #    include <mpi.h>
+#    include <algorithm>
 #    include <chrono>
 #    include <thread>
 #endif
@@ -27,6 +29,11 @@ namespace
     // (slightly under 2GB when data type is double)
     // because some MPI implementations dislike larger messages
     const size_t maxMessageSize = 250 * 1000 * 1000;
+
+    // Multi-array reductions are performed in blocks of the following size (8 MB when data type is double)
+    // with at most the following number of non-blocking reductions in flight at the same time
+    const size_t reductionBlockSize = 1024 * 1024;
+    const int maxPendingReductions = 8;
 }
 #endif
 
@@ -184,6 +191,7 @@ void ProcessManager::wait()
 #ifdef BUILD_WITH_MPI
     if (isMultiProc())
     {
+        Tracer trace("MPI wait");
         if (_logger) _logger("MPI BEGIN: wait");
         MPI_Barrier(MPI_COMM_WORLD);
         if (_logger) _logger("MPI END: wait");
@@ -198,6 +206,7 @@ void ProcessManager::sumToAll(Array& arr)
 #ifdef BUILD_WITH_MPI
     if (isMultiProc())
     {
+        Tracer trace("MPI sum to all");
         if (_logger) _logger("MPI BEGIN: sum to all of size " + std::to_string(arr.size()));
         double* data = begin(arr);
         size_t remaining = arr.size();
@@ -225,6 +234,7 @@ void ProcessManager::sumToRoot(Array& arr, bool wait)
 #ifdef BUILD_WITH_MPI
     if (isMultiProc())
     {
+        Tracer trace("MPI sum to root");
         if (_logger) _logger("MPI BEGIN: sum to root of size " + std::to_string(arr.size()));
         double* data = begin(arr);
         size_t remaining = arr.size();
@@ -256,12 +266,80 @@ void ProcessManager::sumToRoot(Array& arr, bool wait)
 
 //////////////////////////////////////////////////////////////////////
 
+void ProcessManager::sumToRoot(const vector<Array*>& arrays)
+{
+#ifdef BUILD_WITH_MPI
+    if (isMultiProc())
+    {
+        Tracer trace("MPI sum arrays to root");
+
+        // split all arrays into blocks and determine which blocks have nonzero values in this process
+        vector<std::pair<double*, int>> blocks;
+        vector<int> nonzero;
+        for (Array* arr : arrays)
+        {
+            double* data = begin(*arr);
+            size_t remaining = arr->size();
+            while (remaining)
+            {
+                size_t count = std::min(remaining, reductionBlockSize);
+                blocks.emplace_back(data, static_cast<int>(count));
+                nonzero.push_back(std::any_of(data, data + count, [](double value) { return value != 0.; }));
+                data += count;
+                remaining -= count;
+            }
+        }
+        if (_logger)
+            _logger("MPI BEGIN: sum to root of " + std::to_string(arrays.size()) + " arrays in "
+                    + std::to_string(blocks.size()) + " blocks");
+
+        // determine which blocks have nonzero values in any process
+        if (!nonzero.empty())
+            MPI_Allreduce(MPI_IN_PLACE, nonzero.data(), nonzero.size(), MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+        // reduce the nonzero blocks, keeping a limited number of non-blocking reductions in flight;
+        // blocks that are zero in all processes are already correct on the root process
+        vector<MPI_Request> requests(maxPendingReductions, MPI_REQUEST_NULL);
+        int numPending = 0;
+        size_t numReduced = 0;
+        for (size_t b = 0; b != blocks.size(); ++b)
+        {
+            if (!nonzero[b]) continue;
+
+            // find a free request slot, waiting for a pending reduction to complete if needed
+            int slot = numPending;
+            if (numPending == maxPendingReductions)
+                MPI_Waitany(maxPendingReductions, requests.data(), &slot, MPI_STATUS_IGNORE);
+            else
+                numPending++;
+
+            double* data = blocks[b].first;
+            int count = blocks[b].second;
+            if (isRoot())
+                MPI_Ireduce(MPI_IN_PLACE, data, count, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD, &requests[slot]);
+            else
+                MPI_Ireduce(data, data, count, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD, &requests[slot]);
+            numReduced++;
+        }
+        MPI_Waitall(maxPendingReductions, requests.data(), MPI_STATUSES_IGNORE);
+
+        if (_logger)
+            _logger("MPI END: sum to root; skipped " + std::to_string(blocks.size() - numReduced) + " zero blocks");
+    }
+#else
+    (void)arrays;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////
+
 void ProcessManager::broadcastAllToAll(std::function<void(vector<double>&)> producer,
                                        std::function<void(const vector<double>&)> consumer)
 {
 #ifdef BUILD_WITH_MPI
     if (isMultiProc())
     {
+        Tracer trace("MPI broadcast all to all");
         if (_logger) _logger("MPI BEGIN: broadcast all to all");
 
         // allocate room for data to be sent and received
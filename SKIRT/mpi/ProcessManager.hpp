@@ -150,6 +150,23 @@ public:
         called from instruments. */
     static void sumToRoot(Array& arr, bool wait = false);
 
+    /** This function adds the floating point values of each of the specified arrays element-wise
+        across the different processes, and stores the resulting sums in the same arrays on the root
+        process, just like calling the sumToRoot() function for each of the arrays in turn. The
+        arrays on the other processes are left untouched. All processes must call this function
+        with the same number of arrays and the same array sizes for the communication to proceed.
+        If there is only one process, the function does nothing.
+
+        This function is intended for reducing the potentially very large data sets recorded by
+        instruments. Rather than reducing each array with a sequence of blocking operations, the
+        data in all arrays is split into blocks of a fixed size. The processes first determine which
+        blocks contain nonzero values in at least one process; blocks that are zero in all
+        processes (e.g., for sparse contribution types) are not communicated at all. The remaining
+        blocks are reduced using non-blocking operations, keeping a limited number of them in
+        flight at the same time so that the transfer of one block can overlap with the reduction
+        of the next. */
+    static void sumToRoot(const vector<Array*>& arrays);
+
     /** This function broadcasts a separate sequence of floating point values from each process to
         the other processes. The chunk of data to be sent by the calling process must be generated
         by the provided call-back function \em producer. Similarly, the chunks of data reveived by
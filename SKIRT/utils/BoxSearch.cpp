@@ -5,6 +5,7 @@
 
 #include "BoxSearch.hpp"
 #include "NR.hpp"
+#include <algorithm>
 
 ////////////////////////////////////////////////////////////////////
 
@@ -60,37 +61,317 @@ namespace
         }
         grid[gridsize] = std::numeric_limits<double>::infinity();
     }
+
+    // parameters for constructing the bounding volume hierarchy
+    const int maxLeafSize = 8;          // nodes with more entities are always split, if possible
+    const int numBins = 16;             // the number of bins for determining candidate split positions
+    const double traversalCost = 2.;    // the cost of traversing a node relative to testing an entity
+    const int maxLevels = 64;           // the maximum number of levels in the tree (limits the traversal stack)
+    const int minParallelSize = 16384;  // subtrees with fewer entities are constructed by a single thread
+
+    // returns the component of the given vector along the specified axis 0->x, 1->y, 2->z
+    inline double component(Vec v, int axis)
+    {
+        return axis == 0 ? v.x() : (axis == 1 ? v.y() : v.z());
+    }
+
+    // returns half of the surface area of the given box
+    inline double halfArea(const Box& box)
+    {
+        Vec w = box.widths();
+        return w.x() * w.y() + w.y() * w.z() + w.z() * w.x();
+    }
+
+    // returns the largest float that is smaller than or equal to the given double
+    inline float roundDown(double value)
+    {
+        float result = static_cast<float>(value);
+        return result > value ? std::nextafter(result, -std::numeric_limits<float>::infinity()) : result;
+    }
+
+    // returns the smallest float that is larger than or equal to the given double
+    inline float roundUp(double value)
+    {
+        float result = static_cast<float>(value);
+        return result < value ? std::nextafter(result, std::numeric_limits<float>::infinity()) : result;
+    }
+
+    // intersects the slab between the given coordinates with the ray starting at r with direction k and
+    // inverse direction ik along a given axis, narrowing the interval [smin,smax] of ray distances inside
+    // the box; returns false if the interval becomes empty, and true otherwise; rays touching the slab are
+    // considered to intersect it, so that the test is conservative
+    inline bool slab(double cmin, double cmax, double r, double k, double ik, double& smin, double& smax)
+    {
+        if (k == 0.) return r >= cmin && r <= cmax;
+        double s1 = (cmin - r) * ik;
+        double s2 = (cmax - r) * ik;
+        if (s1 > s2) std::swap(s1, s2);
+        if (s1 > smin) smin = s1;
+        if (s2 < smax) smax = s2;
+        return smin <= smax;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+inline void BoxSearch::CompactBox::set(const Box& box)
+{
+    xmin = roundDown(box.xmin());
+    ymin = roundDown(box.ymin());
+    zmin = roundDown(box.zmin());
+    xmax = roundUp(box.xmax());
+    ymax = roundUp(box.ymax());
+    zmax = roundUp(box.zmax());
+}
+
+////////////////////////////////////////////////////////////////////
+
+inline bool BoxSearch::CompactBox::contains(Vec r) const
+{
+    return r.x() >= xmin && r.x() <= xmax && r.y() >= ymin && r.y() <= ymax && r.z() >= zmin && r.z() <= zmax;
 }
 
 ////////////////////////////////////////////////////////////////////
 
+inline bool BoxSearch::CompactBox::intersects(const Box& box) const
+{
+    return box.xmin() <= xmax && xmin <= box.xmax() && box.ymin() <= ymax && ymin <= box.ymax()
+           && box.zmin() <= zmax && zmin <= box.zmax();
+}
+
+////////////////////////////////////////////////////////////////////
+
+inline bool BoxSearch::CompactBox::intersects(Vec r, Vec k, Vec ik) const
+{
+    double smin = 0.;
+    double smax = std::numeric_limits<double>::infinity();
+    return slab(xmin, xmax, r.x(), k.x(), ik.x(), smin, smax) && slab(ymin, ymax, r.y(), k.y(), ik.y(), smin, smax)
+           && slab(zmin, zmax, r.z(), k.z(), ik.z(), smin, smax);
+}
+
+////////////////////////////////////////////////////////////////////
+
+inline bool BoxSearch::CompactBox::inside(const Box& box) const
+{
+    return box.xmin() <= xmin && xmax <= box.xmax() && box.ymin() <= ymin && ymax <= box.ymax()
+           && box.zmin() <= zmin && zmax <= box.zmax();
+}
+
+////////////////////////////////////////////////////////////////////
+
+// This private class constructs the bounding volume hierarchy, starting from the entity bounding boxes.
+// The nodes are added to a node vector that is passed as an argument, and the entity indices in the
+// order vector are rearranged so that each leaf node references a consecutive range of entities.
+// Subtrees covering disjoint entity ranges can be constructed concurrently in separate node vectors.
+class BoxSearch::HierarchyBuilder
+{
+public:
+    // a subtree whose construction has been deferred so that it can be performed in parallel
+    struct Task
+    {
+        int node;   // the index of the subtree's root node in the top-level node vector
+        int begin;  // the range of entities held by the subtree in the order vector
+        int end;
+        int level;  // the level of the subtree's root node
+    };
+
+    HierarchyBuilder(const vector<Box>& boxv, vector<int>& order) : _boxv(boxv), _order(order)
+    {
+        _centerv.reserve(boxv.size());
+        for (const Box& box : boxv) _centerv.push_back(box.center());
+    }
+
+    // constructs the subtree for the entities in the given range of the order vector, storing the root node
+    // at the given (existing) index in the node vector; if a task vector is specified, the construction of
+    // subtrees with a small number of entities is deferred by adding them to the task vector;
+    // returns the number of levels in the constructed tree, counted from the top of the complete tree
+    int build(vector<Node>& nodes, int n, int begin, int end, int level, vector<Task>* tasks)
+    {
+        int count = end - begin;
+        if (tasks && count < minParallelSize)
+        {
+            tasks->push_back({n, begin, end, level});
+            return 0;
+        }
+
+        // determine the bounding box of the entities and of their centers
+        Box box = _boxv[_order[begin]];
+        Box cbox(_centerv[_order[begin]], _centerv[_order[begin]]);
+        for (int i = begin + 1; i != end; ++i)
+        {
+            box.extend(_boxv[_order[i]]);
+            cbox.extend(Box(_centerv[_order[i]], _centerv[_order[i]]));
+        }
+        nodes[n].box.set(box);
+
+        // create a leaf node if the entities should not or cannot be split
+        int split = level + 1 < maxLevels ? partition(box, cbox, begin, end) : begin;
+        if (split == begin)
+        {
+            nodes[n].first = begin;
+            nodes[n].count = count;
+            return level + 1;
+        }
+
+        // otherwise create two adjacent child nodes and recursively construct their subtrees
+        int child = nodes.size();
+        nodes.resize(child + 2);
+        nodes[n].first = child;
+        nodes[n].count = 0;
+        int leftLevels = build(nodes, child, begin, split, level + 1, tasks);
+        int rightLevels = build(nodes, child + 1, split, end, level + 1, tasks);
+        return max(leftLevels, rightLevels);
+    }
+
+private:
+    // determines the best split for the entities in the given range according to the surface area heuristic,
+    // and partitions the range accordingly; returns the index of the first entity in the second part of the
+    // range, or the index of the first entity in the range if the entities should not or cannot be split
+    int partition(const Box& box, const Box& cbox, int begin, int end)
+    {
+        int count = end - begin;
+        if (count < 2) return begin;
+
+        // select the axis with the largest spread of entity centers
+        Vec widths = cbox.widths();
+        int axis = widths.x() >= widths.y() ? (widths.x() >= widths.z() ? 0 : 2) : (widths.y() >= widths.z() ? 1 : 2);
+        double cmin = component(cbox.rmin(), axis);
+        double width = component(widths, axis);
+        if (!(width > 0.)) return begin;
+
+        // bin the entities on their center position along the selected axis
+        auto binIndex = [this, axis, cmin, width](int m) {
+            return min(numBins - 1, static_cast<int>(numBins * (component(_centerv[m], axis) - cmin) / width));
+        };
+        int counts[numBins] = {0};
+        Box bins[numBins];
+        for (int i = begin; i != end; ++i)
+        {
+            int m = _order[i];
+            int b = binIndex(m);
+            if (counts[b]++)
+                bins[b].extend(_boxv[m]);
+            else
+                bins[b] = _boxv[m];
+        }
+
+        // accumulate the bounding box areas for the entities on the right of each candidate split
+        double rightAreas[numBins];
+        Box right;
+        bool rightFilled = false;
+        for (int b = numBins - 1; b > 0; --b)
+        {
+            if (counts[b])
+            {
+                if (rightFilled)
+                    right.extend(bins[b]);
+                else
+                    right = bins[b];
+                rightFilled = true;
+            }
+            rightAreas[b] = halfArea(right);
+        }
+
+        // determine the candidate split with the lowest estimated cost
+        double area = halfArea(box);
+        double bestCost = std::numeric_limits<double>::infinity();
+        int bestBin = -1;
+        Box left;
+        int numLeft = 0;
+        for (int b = 0; b < numBins - 1; ++b)
+        {
+            if (counts[b])
+            {
+                if (numLeft)
+                    left.extend(bins[b]);
+                else
+                    left = bins[b];
+                numLeft += counts[b];
+            }
+            int numRight = count - numLeft;
+            if (numLeft && numRight)
+            {
+                double weight = halfArea(left) * numLeft + rightAreas[b + 1] * numRight;
+                double cost = traversalCost + (area > 0. ? weight / area : max(numLeft, numRight));
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestBin = b;
+                }
+            }
+        }
+
+        // keep the entities together if splitting does not pay off
+        if (bestBin < 0 || (count <= maxLeafSize && bestCost >= count)) return begin;
+
+        // partition the entities according to the selected split
+        auto mid = std::partition(_order.begin() + begin, _order.begin() + end,
+                                  [binIndex, bestBin](int m) { return binIndex(m) <= bestBin; });
+        return mid - _order.begin();
+    }
+
+    const vector<Box>& _boxv;  // the entity bounding boxes, indexed on entity index
+    vector<Vec> _centerv;      // the entity bounding box centers, indexed on entity index
+    vector<int>& _order;       // the entity indices in the order referenced by the leaf nodes
+};
+
+////////////////////////////////////////////////////////////////////
+
 BoxSearch::BoxSearch() {}
 
 ////////////////////////////////////////////////////////////////////
 
 void BoxSearch::loadEntities(int numEntities, std::function<Box(int)> bounds,
-                             std::function<bool(int, const Box&)> intersects)
+                             std::function<bool(int, const Box&)> intersects, Method method, ParallelCall parallel)
 {
+    // remove any pre-existing search structure
+    _method = method;
+    _numEntities = 0;
+    _extent = Box();
+    _numBlocks = 0;
+    _listv.clear();
+    _nodes.clear();
+    _order.clear();
+    _orderBoxes.clear();
+    _numLevels = 0;
+    _nodeWeights.clear();
+    _orderWeights.clear();
+    _minEntitiesPerBlock = 0;
+    _maxEntitiesPerBlock = 0;
+    _avgEntitiesPerBlock = 0;
+
     // abort if there are no entities
-    if (numEntities <= 0)
-    {
-        _extent = Box();
-        _numBlocks = 0;
-        _minEntitiesPerBlock = 0;
-        _maxEntitiesPerBlock = 0;
-        _avgEntitiesPerBlock = 0;
-        return;
-    }
+    if (numEntities <= 0) return;
+    _numEntities = numEntities;
 
     // cache the bounding boxes because we need them a few times
-    vector<Box> boxv;
-    boxv.reserve(numEntities);
-    for (int m = 0; m != numEntities; ++m) boxv.emplace_back(bounds(m));
+    vector<Box> boxv(numEntities);
+    auto getBounds = [&boxv, &bounds](size_t firstIndex, size_t numIndices) {
+        for (size_t m = firstIndex; m != firstIndex + numIndices; ++m) boxv[m] = bounds(m);
+    };
+    if (parallel)
+        parallel(numEntities, getBounds);
+    else
+        getBounds(0, numEntities);
 
     // calculate the extent of the search domain
     _extent = boxv[0];
     for (const auto& box : boxv) _extent.extend(box);
 
+    // construct the search structure for the requested method
+    switch (method)
+    {
+        case Method::Grid: loadGrid(boxv, intersects); break;
+        case Method::Hierarchy: loadHierarchy(boxv, parallel); break;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void BoxSearch::loadGrid(const vector<Box>& boxv, std::function<bool(int, const Box&)> intersects)
+{
+    int numEntities = boxv.size();
+
     // determine the number of blocks in each spatial direction
     _numBlocks = max(10, static_cast<int>(std::cbrt(numEntities)));
 
@@ -100,7 +381,6 @@ void BoxSearch::loadEntities(int numEntities, std::function<Box(int)> bounds,
     makegrid(_zgrid, boxv, 3, _numBlocks, _extent.zmin(), _extent.zmax());
 
     // construct an empty entity list for each of the nb*nb*nb blocks
-    _listv.clear();  // remove any pre-existing lists
     _listv.resize(_numBlocks * _numBlocks * _numBlocks);
 
     // add each entity to the list for every block that its bounding box overlaps
@@ -143,6 +423,113 @@ void BoxSearch::loadEntities(int numEntities, std::function<Box(int)> bounds,
 
 ////////////////////////////////////////////////////////////////////
 
+void BoxSearch::loadHierarchy(const vector<Box>& boxv, ParallelCall parallel)
+{
+    int numEntities = boxv.size();
+
+    // initialize the entity order and create the root node
+    _order.resize(numEntities);
+    for (int m = 0; m != numEntities; ++m) _order[m] = m;
+    _nodes.resize(1);
+    HierarchyBuilder builder(boxv, _order);
+
+    if (parallel)
+    {
+        // construct the top levels of the tree, deferring the construction of smaller subtrees
+        vector<HierarchyBuilder::Task> tasks;
+        _numLevels = builder.build(_nodes, 0, 0, numEntities, 0, &tasks);
+
+        // construct the deferred subtrees in parallel, each in its own node vector
+        int numTasks = tasks.size();
+        vector<vector<Node>> subtrees(numTasks);
+        vector<int> subtreeLevels(numTasks);
+        parallel(numTasks, [&builder, &tasks, &subtrees, &subtreeLevels](size_t firstIndex, size_t numIndices) {
+            for (size_t t = firstIndex; t != firstIndex + numIndices; ++t)
+            {
+                const auto& task = tasks[t];
+                subtrees[t].resize(1);
+                subtreeLevels[t] = builder.build(subtrees[t], 0, task.begin, task.end, task.level, nullptr);
+            }
+        });
+
+        // append the subtrees to the top-level tree, replacing each placeholder by the subtree's root node,
+        // and adjusting the child node indices (the root's children are at index 1 in the subtree vector)
+        for (int t = 0; t != numTasks; ++t)
+        {
+            int offset = _nodes.size() - 1;
+            const auto& subtree = subtrees[t];
+            for (size_t i = 0; i != subtree.size(); ++i)
+            {
+                Node node = subtree[i];
+                if (!node.count) node.first += offset;
+                if (i)
+                    _nodes.push_back(node);
+                else
+                    _nodes[tasks[t].node] = node;
+            }
+            _numLevels = max(_numLevels, subtreeLevels[t]);
+            vector<Node>().swap(subtrees[t]);
+        }
+    }
+    else
+    {
+        _numLevels = builder.build(_nodes, 0, 0, numEntities, 0, nullptr);
+    }
+
+    // store the entity bounding boxes in leaf order for fast access during queries
+    _orderBoxes.resize(numEntities);
+    for (int i = 0; i != numEntities; ++i) _orderBoxes[i].set(boxv[_order[i]]);
+
+    // calculate statistics
+    _minEntitiesPerBlock = numEntities;
+    _maxEntitiesPerBlock = 0;
+    int numLeaves = 0;
+    for (const auto& node : _nodes)
+    {
+        if (node.count)
+        {
+            _minEntitiesPerBlock = min(_minEntitiesPerBlock, node.count);
+            _maxEntitiesPerBlock = max(_maxEntitiesPerBlock, node.count);
+            numLeaves++;
+        }
+    }
+    _avgEntitiesPerBlock = static_cast<double>(numEntities) / numLeaves;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void BoxSearch::loadWeights(std::function<double(int)> weight)
+{
+    if (_nodes.empty())
+    {
+        // for the Grid method, the weights are never used
+        _nodeWeights.clear();
+        _orderWeights.clear();
+        return;
+    }
+
+    // get the entity weights in leaf node order
+    _orderWeights.resize(_numEntities);
+    for (int i = 0; i != _numEntities; ++i) _orderWeights[i] = weight(_order[i]);
+
+    // calculate the aggregate weight for each node, processing the nodes in reverse order;
+    // this works because child nodes are always stored after their parent node
+    int numNodes = _nodes.size();
+    _nodeWeights.resize(numNodes);
+    for (int n = numNodes - 1; n >= 0; --n)
+    {
+        const Node& node = _nodes[n];
+        double sum = 0.;
+        if (node.count)
+            for (int i = node.first; i != node.first + node.count; ++i) sum += _orderWeights[i];
+        else
+            sum = _nodeWeights[node.first] + _nodeWeights[node.first + 1];
+        _nodeWeights[n] = sum;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 const Box& BoxSearch::extent() const
 {
     return _extent;
@@ -150,6 +537,20 @@ const Box& BoxSearch::extent() const
 
 ////////////////////////////////////////////////////////////////////
 
+BoxSearch::Method BoxSearch::method() const
+{
+    return _method;
+}
+
+////////////////////////////////////////////////////////////////////
+
+int BoxSearch::numEntities() const
+{
+    return _numEntities;
+}
+
+////////////////////////////////////////////////////////////////////
+
 int BoxSearch::numBlocks() const
 {
     return _numBlocks;
@@ -157,6 +558,20 @@ int BoxSearch::numBlocks() const
 
 ////////////////////////////////////////////////////////////////////
 
+int BoxSearch::numNodes() const
+{
+    return _nodes.size();
+}
+
+////////////////////////////////////////////////////////////////////
+
+int BoxSearch::numLevels() const
+{
+    return _numLevels;
+}
+
+////////////////////////////////////////////////////////////////////
+
 int BoxSearch::minEntitiesPerBlock() const
 {
     return _minEntitiesPerBlock;
@@ -200,10 +615,33 @@ int BoxSearch::blockIndex(Vec bfr) const
 
 BoxSearch::EntityGeneratorForPosition BoxSearch::entitiesFor(Vec bfr) const
 {
-    if (_numBlocks)
-        return _listv[blockIndex(bfr)];
-    else
-        return _empty;
+    if (_numBlocks) return _listv[blockIndex(bfr)];
+    if (_nodes.empty()) return _empty;
+
+    // traverse the hierarchy, descending only into nodes that contain the position
+    thread_local vector<int> entities;
+    entities.clear();
+    int stack[maxLevels];
+    int top = 0;
+    int n = 0;
+    while (true)
+    {
+        const Node& node = _nodes[n];
+        if (node.box.contains(bfr))
+        {
+            if (!node.count)
+            {
+                stack[top++] = node.first + 1;
+                n = node.first;
+                continue;
+            }
+            for (int i = node.first; i != node.first + node.count; ++i)
+                if (_orderBoxes[i].contains(bfr)) entities.push_back(_order[i]);
+        }
+        if (!top) break;
+        n = stack[--top];
+    }
+    return entities;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -235,14 +673,40 @@ BoxSearch::EntityGeneratorForBox BoxSearch::entitiesFor(const Box& box) const
                     if (block.intersects(box))
                     {
                         // add all entities overlapping that block to the output list
-                        for (int m : _listv[blockIndex(i, j, k)])
-                        {
-                            entities.insert(m);
-                        }
+                        const auto& list = _listv[blockIndex(i, j, k)];
+                        entities.insert(entities.end(), list.begin(), list.end());
                     }
                 }
             }
         }
+
+        // remove duplicates
+        std::sort(entities.begin(), entities.end());
+        entities.erase(std::unique(entities.begin(), entities.end()), entities.end());
+    }
+    else if (!_nodes.empty())
+    {
+        // traverse the hierarchy, descending only into nodes that overlap the query box
+        int stack[maxLevels];
+        int top = 0;
+        int n = 0;
+        while (true)
+        {
+            const Node& node = _nodes[n];
+            if (node.box.intersects(box))
+            {
+                if (!node.count)
+                {
+                    stack[top++] = node.first + 1;
+                    n = node.first;
+                    continue;
+                }
+                for (int i = node.first; i != node.first + node.count; ++i)
+                    if (_orderBoxes[i].intersects(box)) entities.push_back(_order[i]);
+            }
+            if (!top) break;
+            n = stack[--top];
+        }
     }
     return entities;
 }
@@ -283,15 +747,90 @@ BoxSearch::EntityGeneratorForRay BoxSearch::entitiesFor(Vec bfr, Vec bfk) const
                         if (block.intersects(bfr, bfk, smin, smax))
                         {
                             // add all entities overlapping that block to the output list
-                            for (int m : _listv[blockIndex(i, j, k)])
-                            {
-                                entities.insert(m);
-                            }
+                            const auto& list = _listv[blockIndex(i, j, k)];
+                            entities.insert(entities.end(), list.begin(), list.end());
                         }
                     }
+
+            // remove duplicates
+            std::sort(entities.begin(), entities.end());
+            entities.erase(std::unique(entities.begin(), entities.end()), entities.end());
+        }
+    }
+    else if (!_nodes.empty())
+    {
+        // traverse the hierarchy, descending only into nodes that overlap the ray
+        Vec bfik(1. / bfk.x(), 1. / bfk.y(), 1. / bfk.z());
+        int stack[maxLevels];
+        int top = 0;
+        int n = 0;
+        while (true)
+        {
+            const Node& node = _nodes[n];
+            if (node.box.intersects(bfr, bfk, bfik))
+            {
+                if (!node.count)
+                {
+                    stack[top++] = node.first + 1;
+                    n = node.first;
+                    continue;
+                }
+                for (int i = node.first; i != node.first + node.count; ++i)
+                    if (_orderBoxes[i].intersects(bfr, bfk, bfik)) entities.push_back(_order[i]);
+            }
+            if (!top) break;
+            n = stack[--top];
         }
     }
     return entities;
 }
 
 ////////////////////////////////////////////////////////////////////
+
+double BoxSearch::accumulate(const Box& box, std::function<double(int)> partial) const
+{
+    double sum = 0.;
+
+    if (_numBlocks)
+    {
+        for (int m : entitiesFor(box)) sum += partial(m);
+    }
+    else if (!_nodes.empty())
+    {
+        // traverse the hierarchy, adding the aggregate weight of nodes inside the query box
+        // and descending only into nodes that straddle the query box boundary
+        int stack[maxLevels];
+        int top = 0;
+        int n = 0;
+        while (true)
+        {
+            const Node& node = _nodes[n];
+            if (node.box.inside(box))
+            {
+                sum += _nodeWeights[n];
+            }
+            else if (node.box.intersects(box))
+            {
+                if (!node.count)
+                {
+                    stack[top++] = node.first + 1;
+                    n = node.first;
+                    continue;
+                }
+                for (int i = node.first; i != node.first + node.count; ++i)
+                {
+                    const CompactBox& entityBox = _orderBoxes[i];
+                    if (entityBox.inside(box))
+                        sum += _orderWeights[i];
+                    else if (entityBox.intersects(box))
+                        sum += partial(_order[i]);
+                }
+            }
+            if (!top) break;
+            n = stack[--top];
+        }
+    }
+    return sum;
+}
+
+////////////////////////////////////////////////////////////////////
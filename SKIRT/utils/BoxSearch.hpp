@@ -9,7 +9,6 @@
 #include "Array.hpp"
 #include "Box.hpp"
 #include <functional>
-#include <unordered_set>
 
 //////////////////////////////////////////////////////////////////////
 
@@ -21,40 +20,89 @@
     The spatial objects held by a BoxSearch instance are called entities. They are identified by a
     unique index \f$m\f$ ranging from 0 to \f$M-1\f$, where \f$M\f$ is the number of managed
     entities. All entities are handed to the BoxSearch instance in one go, so that they can be
-    "bulk-loaded" into the search structure.
-
-    The current implementation proceeds as follows. First, a regular Cartesian grid is contructed
-    that partitions 3D space into \f$N_b^3\f$ blocks, where \f$N_b\f$ depends on the number of
-    entities. Each block is then assigned a list of indices for all entities that possibly
-    intersect with the block. In an attempt to balance the list lengths, the block separation
-    points in each coordinate direction are chosen so that the entity bounding box centers are
-    approximately evently distributed over the blocks in that direction. Locating the block
-    containing a given query position then boils down to three binary searches (one in each
-    direction). */
+    "bulk-loaded" into the search structure. The client selects one of two search methods when
+    loading the entities.
+
+    <b>Block grid</b>
+
+    With the Grid method, a regular Cartesian grid is contructed that partitions 3D space into
+    \f$N_b^3\f$ blocks, where \f$N_b\f$ depends on the number of entities. Each block is then
+    assigned a list of indices for all entities that possibly intersect with the block. In an
+    attempt to balance the list lengths, the block separation points in each coordinate direction
+    are chosen so that the entity bounding box centers are approximately evently distributed over
+    the blocks in that direction. Locating the block containing a given query position then boils
+    down to three binary searches (one in each direction). Because the balancing is performed
+    separately for each coordinate direction, strongly clustered entity distributions may cause
+    some blocks to hold a very large number of entities, and the cost of a query is determined by
+    the length of the list for the block being hit.
+
+    <b>Bounding volume hierarchy</b>
+
+    With the Hierarchy method, the entities are organized in a binary tree of nested axis-aligned
+    bounding boxes. Each leaf node holds a small number of entities, and each nonleaf node holds
+    the bounding box of all entities in its two child nodes. The tree is constructed top-down. At
+    each level, the entities are split along the coordinate axis with the largest spread of
+    bounding box centers, at the position that minimizes the surface area heuristic (SAH), i.e.
+    the expected cost of a random query estimated from the surface areas of the bounding boxes of
+    the two resulting child nodes. The split positions are selected from a small number of
+    candidates by binning the bounding box centers. Subtrees below a given size are constructed in
+    parallel, if a parallel execution function is provided by the client. The nodes are stored in
+    a single flattened array, with the two children of each nonleaf node in adjacent positions.
+
+    A query traverses the tree starting at the root node, descending only into the nodes with a
+    bounding box that overlaps the query position, box or ray, and tests the bounding box of each
+    entity in the leaf nodes being reached. As a result, the cost of a query depends on the local
+    entity density rather than on the most crowded part of the domain, and the returned sequences
+    include only the entities with a bounding box that actually overlaps the query. */
 class BoxSearch
 {
     // ------- Constructing and loading -------
 
 public:
+    /** This enumeration lists the supported search methods; see the class header for a
+        description. */
+    enum class Method { Grid, Hierarchy };
+
+    /** This type declares the signature of a function that executes a given target function for
+        each of the indices from zero to \em numTasks-1 in index chunks, possibly in parallel, in
+        the same way as the Parallel::call() function. */
+    using ParallelCall = std::function<void(size_t numTasks, std::function<void(size_t, size_t)> target)>;
+
     /** The constructor creates a trivial BoxSearch instance holding no entities. Any queries
         will come up empty. */
     BoxSearch();
 
     /** This function loads the specified number of entities \f$M\f$ into the search structure,
-        using the information returned by the provided callback functions. Any entities held
-        prevously are removed and replaced by the new ones.
+        using the information returned by the provided callback functions and the specified search
+        method. Any entities held prevously are removed and replaced by the new ones.
 
         The \em bounds callback function returns the bounding box of the entity with the given
         index. The \em intersects callback function returns true if the entity with the given index
         possibly intersects the specified box, and false otherwise. A relaxed intersection test
         such as testing against the bounding box is allowed but a stricter intersection test will
-        result in more efficient retrieval queries.
+        result in more efficient retrieval queries. The \em intersects callback function is used
+        only by the Grid method.
 
         The callback functions are invoked one or more times for indices \f$m\f$ ranging from 0 to
         \f$M-1\f$, in arbitrary order. For given values of their argument(s), the callback
-        functions must always return the same value. */
+        functions must always return the same value. If the \em parallel argument is specified,
+        the callback functions may be invoked from multiple execution threads at the same time.
+
+        The \em parallel argument, if specified, is used by the Hierarchy method to construct the
+        bounding volume hierarchy in parallel. The specified function must execute all tasks within
+        the current process (i.e., the tasks must not be distributed over multiple processes). */
     void loadEntities(int numEntities, std::function<Box(int m)> bounds,
-                      std::function<bool(int m, const Box& box)> intersects);
+                      std::function<bool(int m, const Box& box)> intersects, Method method = Method::Grid,
+                      ParallelCall parallel = nullptr);
+
+    /** This function assigns a weight (e.g., a mass) to each of the entities currently loaded
+        into the search structure, using the information returned by the provided callback
+        function, for use by the accumulate() function. The \em weight callback function returns
+        the weight of the entity with the given index; it is invoked exactly once for each index
+        \f$m\f$ ranging from 0 to \f$M-1\f$. For the Hierarchy method, the function also
+        calculates the aggregate weight of the entities held by each node of the bounding volume
+        hierarchy. Any weights assigned previously are replaced. */
+    void loadWeights(std::function<double(int m)> weight);
 
     // ------- Getting properties and statistics -------
 
@@ -63,17 +111,37 @@ public:
         bounding boxes. */
     const Box& extent() const;
 
+    /** This function returns the search method used for the currently loaded entities. */
+    Method method() const;
+
+    /** This function returns the number of entities loaded into the search structure. */
+    int numEntities() const;
+
     /** This function returns the number of blocks in the search structure for each spatial
-        dimension, or zero if no entities have been loaded. */
+        dimension for the Grid method, or zero if no entities have been loaded or the Hierarchy
+        method is being used. */
     int numBlocks() const;
 
-    /** This function returns the smallest number of entity references in a search block. */
+    /** This function returns the number of nodes in the bounding volume hierarchy for the
+        Hierarchy method, or zero if no entities have been loaded or the Grid method is being
+        used. */
+    int numNodes() const;
+
+    /** This function returns the number of levels in the bounding volume hierarchy for the
+        Hierarchy method, or zero if no entities have been loaded or the Grid method is being
+        used. */
+    int numLevels() const;
+
+    /** This function returns the smallest number of entity references in a search block (Grid
+        method) or in a leaf node (Hierarchy method). */
     int minEntitiesPerBlock() const;
 
-    /** This function returns the largest number of entity references in a search block. */
+    /** This function returns the largest number of entity references in a search block (Grid
+        method) or in a leaf node (Hierarchy method). */
     int maxEntitiesPerBlock() const;
 
-    /** This function returns the average number of entity references in a search block. */
+    /** This function returns the average number of entity references in a search block (Grid
+        method) or in a leaf node (Hierarchy method). */
     double avgEntitiesPerBlock() const;
 
     // ------- Private helper functions -------
@@ -87,29 +155,85 @@ private:
         the given position. */
     int blockIndex(Vec bfr) const;
 
+    /** This function loads the entities with the specified bounding boxes into the search
+        structure for the Grid method. */
+    void loadGrid(const vector<Box>& boxv, std::function<bool(int m, const Box& box)> intersects);
+
+    /** This function loads the entities with the specified bounding boxes into the search
+        structure for the Hierarchy method. */
+    void loadHierarchy(const vector<Box>& boxv, ParallelCall parallel);
+
     // ------- Private helper classes -------
 
 private:
     /** This typedef defines the generator return type of the entitiesFor function for a position.
         It represents an iterable sequence of integers. We use a private typedef to hide the actual
-        type, which in the current implementation is simply a reference to a standard vector. */
+        type, which in the current implementation is simply a reference to a standard vector. For
+        the Hierarchy method, the vector is held in thread-local storage and is overwritten by the
+        next query for a position from the same thread. */
     using EntityGeneratorForPosition = const vector<int>&;
 
     /** This typedef defines the generator return type of the entitiesFor function for a box.
         It represents an iterable sequence of integers. We use a private typedef to hide the actual
-        type, which in the current implementation is simply a copy of a standard unordered set. */
-    using EntityGeneratorForBox = std::unordered_set<int>;
+        type, which in the current implementation is simply a copy of a standard vector. */
+    using EntityGeneratorForBox = vector<int>;
 
     /** This typedef defines the generator return type of the entitiesFor function for a ray.
         It represents an iterable sequence of integers. We use a private typedef to hide the actual
-        type, which in the current implementation is simply a copy of a standard unordered set. */
-    using EntityGeneratorForRay = std::unordered_set<int>;
+        type, which in the current implementation is simply a copy of a standard vector. */
+    using EntityGeneratorForRay = vector<int>;
+
+    /** This private structure holds an axis-aligned bounding box in single precision. The
+        coordinates are rounded outward, so that the compact box always encloses the original box.
+        Compared to the Box class, this halves the memory footprint of the bounding volume
+        hierarchy and the memory bandwidth consumed by a query. Because of the rounding, a query
+        may return some additional entities, but it never omits an entity. The member functions
+        are defined in the implementation file. */
+    struct CompactBox
+    {
+        float xmin, ymin, zmin, xmax, ymax, zmax;
+
+        /** This function sets the compact box to enclose the specified box. */
+        void set(const Box& box);
+
+        /** This function returns true if the compact box contains the specified position. */
+        bool contains(Vec r) const;
+
+        /** This function returns true if the compact box overlaps the specified box. */
+        bool intersects(const Box& box) const;
+
+        /** This function returns true if the compact box is intersected by the ray with starting
+            position \f$\bf{r}\f$, direction \f$\bf{k}\f$, and inverse direction \f$\bf{k}^{-1}\f$
+            (i.e. the inverse of each of the direction's components). Rays touching the box are
+            considered to intersect it. */
+        bool intersects(Vec r, Vec k, Vec ik) const;
+
+        /** This function returns true if the compact box lies inside the specified box. */
+        bool inside(const Box& box) const;
+    };
+
+    /** This private structure represents a node in the bounding volume hierarchy. For a leaf node,
+        \em count is the number of entities held by the node, and \em first is the index in the
+        _order vector of the first of these entities. For a nonleaf node, \em count is zero, and
+        \em first is the index in the _nodes vector of the first of its two adjacent child nodes. */
+    struct Node
+    {
+        CompactBox box;  // the bounding box of all entities held by the node and its descendants
+        int first;       // the index of the first entity (leaf node) or of the first child node (nonleaf node)
+        int count;       // the number of entities (leaf node) or zero (nonleaf node)
+    };
+
+    /** This private class implements the construction of the bounding volume hierarchy. It is
+        defined in the implementation file. */
+    class HierarchyBuilder;
 
     // ------- Querying -------
 
 public:
     /** This function returns an iterable sequence of indices \f$m\f$ of all entities that may
-        overlap the specified position, sorted in increasing order. The sequence may be empty.
+        overlap the specified position. The sequence may be empty. For the Grid method, the indices
+        are sorted in increasing order; for the Hierarchy method, they are listed in arbitrary but
+        reproducible order.
 
         The function guarantees that the sequence includes all entities whose bounding box overlaps
         the position. On the other hand, the sequence may contain entities whose bounding box does
@@ -134,16 +258,45 @@ public:
         not overlap the ray. */
     EntityGeneratorForRay entitiesFor(Vec bfr, Vec bfk) const;
 
+    /** This function returns the sum over all entities of the portion of the entity's weight
+        that resides inside the specified axis-aligned box. The weights must have been assigned
+        with the loadWeights() function. The \em partial callback function returns the portion of
+        the weight of the entity with the given index that resides inside the query box. It is
+        invoked only for entities whose bounding box overlaps the query box but does not lie
+        entirely inside it, and it must return zero for entities that do not actually overlap the
+        query box.
+
+        For the Grid method, the function simply invokes the \em partial callback function for
+        each of the entities returned by entitiesFor() for the query box. For the Hierarchy method,
+        the function adds the aggregate weight of each node and the weight of each entity with a
+        bounding box that lies entirely inside the query box without further ado, so that the
+        \em partial callback function is invoked only for the entities that straddle the query
+        box boundary. As a result, the cost of the query for a large box depends on the number of
+        entities near its boundary rather than on the total number of entities inside it. */
+    double accumulate(const Box& box, std::function<double(int m)> partial) const;
+
     // ------- Data members -------
 
 private:
-    // search structure
+    // common
+    Method _method{Method::Grid};  // the search method
+    int _numEntities{0};           // the number of loaded entities
     Box _extent;                   // the extent of the search domain, i.e. the union of all bounding boxes
+
+    // search structure for the grid method
     int _numBlocks{0};             // the number of grid blocks nb in each direction
     Array _xgrid, _ygrid, _zgrid;  // the nb+1 grid separation points for each spatial direction
     vector<vector<int>> _listv;    // the nb*nb*nb lists of indices for entities overlapping each block
     vector<int> _empty;            // vector that stays empty, used for returning empty generator
 
+    // search structure for the hierarchy method
+    vector<Node> _nodes;             // the flattened tree nodes; the root node is at index 0
+    vector<int> _order;              // the entity indices in the order referenced by the leaf nodes
+    vector<CompactBox> _orderBoxes;  // the entity bounding boxes in the same order
+    int _numLevels{0};               // the number of levels in the tree
+    vector<double> _nodeWeights;     // the aggregate entity weight for each node
+    vector<double> _orderWeights;    // the entity weights in the order referenced by the leaf nodes
+
     // statistics
     int _minEntitiesPerBlock{0};
     int _maxEntitiesPerBlock{0};
@@ -0,0 +1,71 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "EventCounters.hpp"
+#include <mutex>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // global state; the mutex protects the list of counter sets, which is modified only when a thread registers
+    std::mutex _mutex;
+    size_t _numCounters{EventCounters::NumCounters};
+    vector<std::unique_ptr<vector<size_t>>> _threadCounters;
+}
+
+////////////////////////////////////////////////////////////////////
+
+std::atomic<bool> EventCounters::_enabled{false};
+std::atomic<int> EventCounters::_generation{0};
+thread_local size_t* EventCounters::t_counters = nullptr;
+thread_local int EventCounters::t_generation = -1;
+
+////////////////////////////////////////////////////////////////////
+
+void EventCounters::enable(int numInstruments)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _threadCounters.clear();
+    _numCounters = NumCounters + max(numInstruments, 0);
+    _generation++;
+    _enabled = true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void EventCounters::disable()
+{
+    _enabled = false;
+}
+
+////////////////////////////////////////////////////////////////////
+
+vector<size_t> EventCounters::collect()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    vector<size_t> result(_numCounters);
+    for (const auto& counters : _threadCounters)
+    {
+        for (size_t i = 0; i != _numCounters; ++i)
+        {
+            result[i] += (*counters)[i];
+            (*counters)[i] = 0;
+        }
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void EventCounters::registerThread()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _threadCounters.emplace_back(new vector<size_t>(_numCounters));
+    t_counters = _threadCounters.back()->data();
+    t_generation = _generation.load();
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,98 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef EVENTCOUNTERS_HPP
+#define EVENTCOUNTERS_HPP
+
+#include "Basics.hpp"
+#include <atomic>
+
+////////////////////////////////////////////////////////////////////
+
+/** This class offers a set of counters for events occurring in the hot paths of the photon packet
+    life cycle, such as the generation of path segments, scattering events, peel-offs, optical
+    depth calculations, and retries in lock-free operations. The counters provide quantitative
+    insight into where the photon packets spend their effort, which can help to select an
+    appropriate spatial grid and appropriate biasing parameters for a given model.
+
+    Event counting is disabled by default, in which case the overhead of each counted event is
+    limited to checking a global flag. After counting has been enabled by calling the static
+    enable() function, each call to the static count() or countPeelOff() functions increments the
+    corresponding counter in the calling thread. Each thread keeps its own set of counters, so that
+    counting requires no locking or atomic operations. The static collect() function sums the
+    counters over all threads and resets them to zero. It should be called only while no other
+    threads are counting events, for example, after all photon packets in a segment have been
+    processed.
+
+    The class distinguishes a fixed set of counters, identified by the Counter enumeration, and a
+    variable number of peel-off counters, one for each instrument in the simulation. */
+class EventCounters
+{
+public:
+    /** This enumeration lists the fixed event counters. */
+    enum Counter : int {
+        PhotonPackets,        // photon packets launched with nonzero luminosity
+        Paths,                // paths traversed through the spatial grid
+        PathSegments,         // path segments generated by the spatial grid
+        Scatterings,          // scattering events
+        ExtinctionCalls,      // calls to MediumSystem::getExtinctionOpticalDepth() for a photon packet
+        ExtinctionEarlyOuts,  // such calls that return early because the packet contribution vanishes
+        TerminatedByWeight,   // photon packets terminated because their weight dropped below a threshold
+        LockFreeRetries,      // retries in the compare-and-swap loop of LockFree::add()
+        NumCounters
+    };
+
+    /** This function resets all counters to zero and enables event counting, providing a peel-off
+        counter for each of the specified number of instruments. It should be called while no
+        other threads are counting events. */
+    static void enable(int numInstruments);
+
+    /** This function disables event counting. */
+    static void disable();
+
+    /** This function returns true if event counting is enabled. */
+    static bool isEnabled() { return _enabled.load(std::memory_order_relaxed); }
+
+    /** If event counting is enabled, this function increments the specified counter in the
+        calling thread by the specified amount. */
+    static void count(Counter counter, size_t amount = 1)
+    {
+        if (isEnabled()) counters()[counter] += amount;
+    }
+
+    /** If event counting is enabled, this function increments the peel-off counter for the
+        instrument with the specified zero-based index in the calling thread. */
+    static void countPeelOff(int instrumentIndex)
+    {
+        if (isEnabled()) counters()[NumCounters + instrumentIndex]++;
+    }
+
+    /** This function returns the sum of the counters over all threads, and resets the counters to
+        zero. The returned list contains the fixed counters in the order of the Counter enumeration,
+        followed by the peel-off counter for each instrument. It should be called while no other
+        threads are counting events. */
+    static vector<size_t> collect();
+
+private:
+    /** This function returns a pointer to the counters for the calling thread, registering a new
+        set of counters if needed. */
+    static size_t* counters()
+    {
+        if (t_generation != _generation.load(std::memory_order_relaxed)) registerThread();
+        return t_counters;
+    }
+
+    /** This function registers a new set of counters for the calling thread. */
+    static void registerThread();
+
+    static std::atomic<bool> _enabled;
+    static std::atomic<int> _generation;
+    static thread_local size_t* t_counters;
+    static thread_local int t_generation;
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,189 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "HardwareCounters.hpp"
+#include "StringUtils.hpp"
+#include <atomic>
+#include <cstring>
+
+#ifdef __linux__
+#    include <dirent.h>            // for listing the threads in the process
+#    include <linux/perf_event.h>  // for the perf_event_open structures and constants
+#    include <sys/syscall.h>       // for invoking the perf_event_open system call
+#    include <unistd.h>            // for reading and closing file descriptors
+#endif
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // flag indicating whether measurement has been enabled
+    std::atomic<bool> _enabled{false};
+
+    // indices of the hardware events in the list of counters for each thread
+    enum Event { Cycles = 0, Instructions, CacheReferences, CacheMisses, Branches, BranchMisses, NumEvents };
+
+    // the assumed number of bytes transferred from memory for each cache miss (the typical cache line size)
+    const double bytesPerCacheMiss = 64.;
+
+#ifdef __linux__
+    // the perf_event configuration for each of the hardware events, in the order of the Event enumeration
+    const uint64_t _eventConfig[NumEvents] = {PERF_COUNT_HW_CPU_CYCLES,          PERF_COUNT_HW_INSTRUCTIONS,
+                                              PERF_COUNT_HW_CACHE_REFERENCES,    PERF_COUNT_HW_CACHE_MISSES,
+                                              PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES};
+
+    // opens a counter for the specified event and thread, and returns the file descriptor or -1 on failure
+    int openCounter(int event, pid_t tid)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = _eventConfig[event];
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, tid, -1, -1, 0));
+    }
+
+    // returns the value of the counter with the specified file descriptor, scaled for multiplexing
+    double readCounter(int fd)
+    {
+        uint64_t values[3];  // value, time enabled, time running
+        if (fd < 0 || read(fd, values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)) || !values[2])
+            return 0.;
+        return static_cast<double>(values[0]) * static_cast<double>(values[1]) / static_cast<double>(values[2]);
+    }
+
+    // returns the identifiers of the threads in the current process
+    vector<pid_t> threadIdentifiers()
+    {
+        vector<pid_t> result;
+        DIR* dir = opendir("/proc/self/task");
+        if (dir)
+        {
+            while (dirent* entry = readdir(dir))
+            {
+                if (entry->d_name[0] != '.') result.push_back(static_cast<pid_t>(atoi(entry->d_name)));
+            }
+            closedir(dir);
+        }
+        return result;
+    }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool HardwareCounters::enable()
+{
+#ifdef __linux__
+    // verify that we can open a counter for the calling thread
+    int fd = openCounter(Cycles, 0);
+    if (fd >= 0)
+    {
+        close(fd);
+        _enabled = true;
+    }
+#endif
+    return _enabled;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool HardwareCounters::isEnabled()
+{
+    return _enabled;
+}
+
+////////////////////////////////////////////////////////////////////
+
+HardwareCounters::HardwareCounters()
+{
+#ifdef __linux__
+    if (isEnabled())
+    {
+        for (pid_t tid : threadIdentifiers())
+        {
+            vector<int> fds(NumEvents);
+            for (int event = 0; event != NumEvents; ++event) fds[event] = openCounter(event, tid);
+
+            // skip threads for which the cycle counter cannot be opened (e.g., because the thread has exited)
+            if (fds[Cycles] >= 0)
+                _fds.push_back(fds);
+            else
+                for (int fd : fds)
+                    if (fd >= 0) close(fd);
+        }
+    }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+
+HardwareCounters::~HardwareCounters()
+{
+#ifdef __linux__
+    for (const auto& fds : _fds)
+        for (int fd : fds)
+            if (fd >= 0) close(fd);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool HardwareCounters::isActive() const
+{
+    return !_fds.empty();
+}
+
+////////////////////////////////////////////////////////////////////
+
+vector<string> HardwareCounters::report(double seconds) const
+{
+    vector<string> lines;
+#ifdef __linux__
+    if (!isActive()) return lines;
+
+    // read the counters for each thread and accumulate the totals
+    vector<vector<double>> values;
+    vector<double> totals(NumEvents);
+    for (const auto& fds : _fds)
+    {
+        vector<double> threadValues(NumEvents);
+        for (int event = 0; event != NumEvents; ++event)
+        {
+            threadValues[event] = readCounter(fds[event]);
+            totals[event] += threadValues[event];
+        }
+        values.push_back(threadValues);
+    }
+
+    // compose the lines for the totals
+    auto ratio = [](double numerator, double denominator) { return denominator > 0. ? numerator / denominator : 0.; };
+    lines.push_back("Hardware counters: " + StringUtils::toString(totals[Instructions], 'e', 2)
+                    + " instructions in " + StringUtils::toString(totals[Cycles], 'e', 2) + " cycles (IPC "
+                    + StringUtils::toString(ratio(totals[Instructions], totals[Cycles]), 'f', 2) + ") for "
+                    + std::to_string(_fds.size()) + " threads");
+    double bandwidth = ratio(bytesPerCacheMiss * totals[CacheMisses], seconds);
+    lines.push_back("Cache misses: "
+                    + StringUtils::toString(100. * ratio(totals[CacheMisses], totals[CacheReferences]), 'f', 1)
+                    + "% of " + StringUtils::toString(totals[CacheReferences], 'e', 2) + " references (~"
+                    + StringUtils::toMemSizeString(static_cast<size_t>(bandwidth)) + "/s from memory); branch misses: "
+                    + StringUtils::toString(100. * ratio(totals[BranchMisses], totals[Branches]), 'f', 2) + "%");
+
+    // compose the line listing the IPC for threads that performed at least 1% of the work of the busiest thread
+    double maxCycles = 0.;
+    for (const auto& threadValues : values) maxCycles = max(maxCycles, threadValues[Cycles]);
+    string line = "IPC per busy thread:";
+    for (const auto& threadValues : values)
+        if (threadValues[Cycles] > 0.01 * maxCycles)
+            line += " " + StringUtils::toString(ratio(threadValues[Instructions], threadValues[Cycles]), 'f', 2);
+    lines.push_back(line);
+#endif
+    return lines;
+}
+
+////////////////////////////////////////////////////////////////////
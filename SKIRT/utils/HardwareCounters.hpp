@@ -0,0 +1,75 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef HARDWARECOUNTERS_HPP
+#define HARDWARECOUNTERS_HPP
+
+#include "Basics.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+/** An instance of the HardwareCounters class measures hardware performance events, such as
+    retired instructions, cycles, cache misses and branch misses, for all execution threads of the
+    current process during its lifetime. This allows determining, for example, whether a
+    simulation phase is limited by memory latency (low number of instructions per cycle, high cache
+    miss rate) or by computation (high number of instructions per cycle).
+
+    The implementation relies on the \c perf_event_open system call, which is available only on
+    Linux. Moreover, depending on the system configuration (e.g., the value of
+    /proc/sys/kernel/perf_event_paranoid or the virtualization environment), hardware performance
+    counters may not be accessible to regular user processes. Measurement is therefore disabled by
+    default, and must be explicitly enabled by calling the static enable() function, which returns
+    false if hardware performance counters turn out to be unavailable. In that case, and if
+    measurement has not been enabled, constructing a HardwareCounters instance has no effect.
+
+    When measurement is enabled, the constructor opens a set of counters for each thread that
+    exists in the process at that time. Threads created during the lifetime of the instance are
+    not included. Only events occurring in user space are counted. If the hardware cannot schedule
+    all counters simultaneously, the kernel multiplexes them and the reported values are scaled
+    accordingly. */
+class HardwareCounters
+{
+public:
+    /** This function enables hardware performance counter measurement, if available. It returns
+        true if hardware performance counters are available, and false otherwise. In the latter
+        case, measurement remains disabled. */
+    static bool enable();
+
+    /** This function returns true if hardware performance counter measurement is enabled. */
+    static bool isEnabled();
+
+    /** If measurement is enabled, the constructor starts counting hardware events for all threads
+        currently existing in the process. */
+    HardwareCounters();
+
+    /** The destructor releases the resources associated with the counters. */
+    ~HardwareCounters();
+
+    /** The copy constructor is deleted because instances own operating system resources. */
+    HardwareCounters(const HardwareCounters&) = delete;
+
+    /** The assignment operator is deleted because instances own operating system resources. */
+    HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+    /** This function returns true if this instance is actually counting hardware events. */
+    bool isActive() const;
+
+    /** This function reads the counters and returns a number of human-readable text lines
+        summarizing the hardware events counted since construction for all threads combined,
+        including the number of instructions per cycle (IPC), the cache and branch miss rates, and
+        an estimate of the memory bandwidth based on the number of cache misses during the
+        specified elapsed wall time (in seconds). A final line lists the IPC for each thread that
+        performed a significant amount of work. If the instance is not active, the function returns
+        an empty list. */
+    vector<string> report(double seconds) const;
+
+private:
+    // the file descriptors of the opened counters, indexed on thread and event
+    vector<vector<int>> _fds;
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,47 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "InverseCdfTable.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+void InverseCdfTable::initialize(const Array& xv, int numRows, int numGuide)
+{
+    _xv = xv;
+    _numPoints = xv.size();
+    _numRows = numRows;
+    _numGuide = numGuide > 0 ? numGuide : _numPoints - 1;
+    _Pv.resize(static_cast<size_t>(_numRows) * _numPoints);
+    _guidev.assign(static_cast<size_t>(_numRows) * _numGuide, 0);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void InverseCdfTable::setRow(int row, const Array& Pv)
+{
+    // copy the cdf values
+    double* target = &_Pv[static_cast<size_t>(row) * _numPoints];
+    for (int i = 0; i != _numPoints; ++i) target[i] = Pv[i];
+
+    // for each guide interval, store the index of the bin containing the lower interval border,
+    // i.e. the index of the last grid point with a cdf value not exceeding that border
+    int* guide = &_guidev[static_cast<size_t>(row) * _numGuide];
+    int i = 0;
+    for (int g = 0; g != _numGuide; ++g)
+    {
+        double border = static_cast<double>(g) / _numGuide;
+        while (i < _numPoints - 2 && Pv[i + 1] <= border) ++i;
+        guide[g] = i;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+size_t InverseCdfTable::allocatedBytes() const
+{
+    return (_xv.size() + _Pv.size()) * sizeof(double) + _guidev.size() * sizeof(int);
+}
+
+////////////////////////////////////////////////////////////////////
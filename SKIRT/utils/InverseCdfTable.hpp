@@ -0,0 +1,85 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef INVERSECDFTABLE_HPP
+#define INVERSECDFTABLE_HPP
+
+#include "Array.hpp"
+#include "NR.hpp"
+
+//////////////////////////////////////////////////////////////////////
+
+/** InverseCdfTable is a utility class for efficiently drawing random numbers from a set of
+    tabulated probability distributions that are discretized on the same grid \f$x_i\f$ with
+    \f$N\f$ points. For example, the table may hold the cumulative distribution of the scattering
+    angle for each wavelength index in the wavelength grid of a material mix. Each distribution
+    is identified by a zero-based row index.
+
+    For each row, the client provides the normalized cumulative distribution function (cdf)
+    \f$P_i\f$ sampled at the grid points, i.e. an array of \f$N\f$ values increasing from zero to
+    one. The generate() function then solves the equation \f${\cal{X}}=P(x)\f$ for a given uniform
+    deviate \f$\cal{X}\f$ assuming piece-wise linear behavior of the cdf, producing exactly the
+    same result as the Random::cdfLinLin() function.
+
+    Rather than performing a binary search over the cdf, however, the table uses a precalculated
+    guide table. The unit interval is divided into \f$M\f$ equal-probability intervals, and for
+    each of these intervals the guide table lists the index of the grid bin containing the lower
+    border of the interval. Locating the bin that contains a given deviate then boils down to
+    looking up the guide table entry for the corresponding interval and advancing through the
+    usually very small number of grid bins that overlap that interval. With the default value
+    \f$M=N-1\f$, the expected cost of generating a random number is independent of the number
+    of grid points. */
+class InverseCdfTable
+{
+public:
+    /** The default constructor creates an empty table. The initialize() function must be called
+        before the table can be used. */
+    InverseCdfTable() {}
+
+    /** This function allocates the table for the specified number of rows on the specified grid,
+        and for the specified number of guide intervals per row. If the number of guide intervals
+        is zero (the default), it is set to the number of grid bins. The grid must have at least
+        two points. Because the generated values are interpolated linearly between grid points, the
+        grid may be sorted in ascending or descending order. The cdf for each of the rows must be
+        subsequently set by calling the setRow() function. Any information held previously is
+        discarded. */
+    void initialize(const Array& xv, int numRows, int numGuide = 0);
+
+    /** This function sets the normalized cumulative distribution for the row with the specified
+        index, and calculates the corresponding guide table entries. The specified array must have
+        the same number of elements as the grid, and its values must increase from zero to one.
+        This function may be called for different rows from multiple execution threads at the same
+        time. */
+    void setRow(int row, const Array& Pv);
+
+    /** This function returns the number of rows in the table. */
+    int numRows() const { return _numRows; }
+
+    /** This function returns a random number drawn from the distribution held by the row with the
+        specified index, given a uniform deviate \f${\cal{X}}\f$ in the range \f$[0,1)\f$. */
+    double generate(int row, double X) const
+    {
+        const double* Pv = &_Pv[static_cast<size_t>(row) * _numPoints];
+        int g = std::min(static_cast<int>(X * _numGuide), _numGuide - 1);
+        int i = _guidev[static_cast<size_t>(row) * _numGuide + g];
+        while (i < _numPoints - 2 && Pv[i + 1] <= X) ++i;
+        return NR::interpolateLinLin(X, Pv[i], Pv[i + 1], _xv[i], _xv[i + 1]);
+    }
+
+    /** This function returns the amount of memory allocated by the table, in bytes. */
+    size_t allocatedBytes() const;
+
+private:
+    Array _xv;            // the grid points, indexed on i
+    int _numPoints{0};    // the number of grid points N
+    int _numRows{0};      // the number of rows
+    int _numGuide{0};     // the number of guide intervals M per row
+    Array _Pv;            // the cdf values, indexed on row and i
+    vector<int> _guidev;  // the guide table entries, indexed on row and g
+};
+
+//////////////////////////////////////////////////////////////////////
+
+#endif
@@ -7,6 +7,7 @@
 #define LOCKFREE_HPP
 
 #include "Basics.hpp"
+#include "EventCounters.hpp"
 #include <atomic>
 
 ////////////////////////////////////////////////////////////////////
@@ -33,6 +34,21 @@ namespace LockFree
         // - if the value of the target location did change, make a new local copy and try again
         while (!atom->compare_exchange_weak(old, old + value))
         {
+            EventCounters::count(EventCounters::LockFreeRetries);
+        }
+    }
+
+    /** This function adds the specified double value (which can be an expression) to the
+        specified single-precision target variable in a thread-safe manner, using the same
+        compare and swap (CAS) loop as the double-precision version of this function. The sum is
+        calculated in double precision and then rounded to single precision. */
+    inline void add(float& target, double value)
+    {
+        auto atom = reinterpret_cast<std::atomic<float>*>(&target);
+        float old = *atom;
+        while (!atom->compare_exchange_weak(old, static_cast<float>(old + value)))
+        {
+            EventCounters::count(EventCounters::LockFreeRetries);
         }
     }
 }
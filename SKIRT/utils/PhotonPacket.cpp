@@ -37,6 +37,7 @@ void PhotonPacket::launch(size_t historyIndex, double lambda, double L, Position
         setUnpolarized();
     _hasObservedOpticalDepth = false;
     _scatteringInfo.clear();
+    _companionv.clear();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -75,7 +76,13 @@ void PhotonPacket::launchEmissionPeelOff(const PhotonPacket* pp, Direction bfk)
     setPosition(pp->position());
     setDirection(bfk);
     if (pp->_bvi) _lambda = shiftedEmissionWavelength(_lambda0, bfk, pp->_bvi->velocity());
-    if (pp->_adi) applyBias(pp->_adi->probabilityForDirection(bfk));
+    _companionv = pp->_companionv;
+    if (pp->_adi)
+    {
+        double w = pp->_adi->probabilityForDirection(bfk);
+        applyBias(w);
+        for (auto& companion : _companionv) companion.W *= w;
+    }
     if (pp->_ppi)
         setPolarized(pp->_ppi->polarizationForDirection(bfk));
     else
@@ -100,6 +107,23 @@ void PhotonPacket::launchScatteringPeelOff(const PhotonPacket* pp, Direction bfk
     setUnpolarized();
     _hasObservedOpticalDepth = false;
     _scatteringInfo.clear();
+    _companionv = pp->_companionv;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void PhotonPacket::addCompanion(double lambda, double L)
+{
+    _companionv.push_back({lambda, L * lambda, 0.});
+}
+
+////////////////////////////////////////////////////////////////////
+
+double PhotonPacket::totalLuminosity() const
+{
+    double L = luminosity();
+    for (const auto& companion : _companionv) L += companion.W / companion.lambda;
+    return L;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -88,7 +88,7 @@ public:
         The emission origin is set to an invalid value, which should be overridden by calling the
         setPrimaryOrigin() or the setSecondaryOrigin() function. The number of scattering events is
         set to zero. The current path is invalidated, and all information about the previous life
-        cycle is lost. */
+        cycle is lost, including any companion wavelengths. */
     void launch(size_t historyIndex, double lambda, double L, Position bfr, Direction bfk,
                 VelocityInterface* bvi = nullptr, AngularDistributionInterface* adi = nullptr,
                 PolarizationProfileInterface* ppi = nullptr);
@@ -130,7 +130,9 @@ public:
         ensuring consistent arrival times in TimeInstrument observers.
 
         The current path of the peel off photon packet is invalidated, and all information about
-        its previous life cycle is lost. The base photon packet remains unchanged. */
+        its previous life cycle is lost. The base photon packet remains unchanged. The companion
+        wavelengths of a polychromatic base photon packet are copied to the peel off photon packet,
+        including the bias for the probability of the peel-off propagation direction. */
     void launchEmissionPeelOff(const PhotonPacket* pp, Direction bfk);
 
     /** This function initializes a peel off photon packet being sent to an instrument for a
@@ -147,7 +149,10 @@ public:
         The peel off photon packet is initialized to an unpolarized state; the polarization state
         should be properly updated after the launch through the StokesVector class functions. The
         current path of the peel off photon packet is invalidated, and all information about its
-        previous life cycle is lost. The base photon packet remains unchanged. */
+        previous life cycle is lost. The base photon packet remains unchanged.
+
+        The companion wavelengths of a polychromatic base photon packet are copied to the peel off
+        photon packet without change; the weight bias applies only to the reference wavelength. */
     void launchScatteringPeelOff(const PhotonPacket* pp, Direction bfk, Vec bfv, double lambda, double w);
 
     /** This function causes the propagation of the photon packet over a physical distance \f$s\f$.
@@ -163,9 +168,49 @@ public:
         unchanged; it should be properly updated through the StokesVector class functions. */
     void scatter(Direction bfk, Vec bfv, double lambda);
 
-    /** This function applies the given weight bias given as a multiplication factor. */
+    /** This function applies the given weight bias given as a multiplication factor. For a
+        polychromatic photon packet, the bias applies only to the reference wavelength; the weights
+        for the companion wavelengths must be adjusted separately through the applyCompanionBias()
+        function. */
     void applyBias(double w);
 
+    // ------- Polychromatic photon packets -------
+
+public:
+    /** This function adds a companion wavelength to the photon packet, turning it into a
+        polychromatic photon packet. The arguments specify the wavelength of the companion photons
+        and the source luminosity represented by them. It should be called just after launch.
+
+        A polychromatic photon packet carries a number of companion wavelengths, each with its own
+        weight, in addition to its regular wavelength, which serves as the reference wavelength.
+        All wavelengths share the position, propagation direction and polarization state of the
+        photon packet. The photon cycle machinery determines the random walk of the photon packet
+        using the reference wavelength, and adjusts the companion weights to compensate for the
+        difference between the actual and the sampled probabilities. Companion wavelengths are
+        never Doppler-shifted, so polychromatic photon packets can be used only in simulations
+        without kinematics. */
+    void addCompanion(double lambda, double L);
+
+    /** This function returns the number of companion wavelengths carried by the photon packet, or
+        zero for a regular monochromatic photon packet. */
+    int numCompanions() const { return _companionv.size(); }
+
+    /** This function returns the wavelength of the companion with the specified index. */
+    double companionWavelength(int k) const { return _companionv[k].lambda; }
+
+    /** This function returns the luminosity represented by the companion with the specified index.
+        */
+    double companionLuminosity(int k) const { return _companionv[k].W / _companionv[k].lambda; }
+
+    /** This function applies the given weight bias given as a multiplication factor to the
+        companion with the specified index. */
+    void applyCompanionBias(int k, double w) { _companionv[k].W *= w; }
+
+    /** This function returns the luminosity of the photon packet summed over the reference
+        wavelength and all companion wavelengths. For a monochromatic photon packet, it returns the
+        same value as the luminosity() function. */
+    double totalLuminosity() const;
+
     // ------- Getting trivial properties -------
 
 public:
@@ -266,6 +311,16 @@ public:
         direction can avoid recalculating the optical depth. */
     double observedOpticalDepth() const { return _observedOpticalDepth; }
 
+    /** This function stores the most recently "observed" optical depth for the companion with the
+        specified index. For a polychromatic photon packet, the optical depths for all companions
+        should be stored before calling setObservedOpticalDepth() for the reference wavelength. */
+    void setCompanionObservedOpticalDepth(int k, double tau) { _companionv[k].tau = tau; }
+
+    /** If hasObservedOpticalDepth() returns true, this function returns the most recently stored
+        "observed" optical depth for the companion with the specified index. Otherwise, it returns
+        some meaningless value. */
+    double companionObservedOpticalDepth(int k) const { return _companionv[k].tau; }
+
     // ------- Caching scattering info -------
 
 public:
@@ -361,6 +416,15 @@ private:
     // scattering information
     int _h{0};  // the index of the medium component currently participating in a scattering operation
     vector<ScatteringInfo> _scatteringInfo;  // list of scattering information records
+
+    // companion wavelengths for polychromatic photon packets
+    struct Companion
+    {
+        double lambda;  // wavelength relative to the model coordinate system
+        double W;       // weight, defined as L*lambda
+        double tau;     // observed optical depth
+    };
+    vector<Companion> _companionv;  // list of companions, empty for monochromatic photon packets
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -0,0 +1,181 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "Tracer.hpp"
+#include "FatalError.hpp"
+#include "System.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // a completed scope, with times in microseconds since the system clock epoch
+    struct Event
+    {
+        string name;
+        double start;
+        double duration;
+    };
+
+    // the ring buffer and the stack of open scopes for a single thread
+    struct Buffer
+    {
+        int threadIndex{0};
+        vector<Event> events;                    // ring buffer with fixed capacity
+        size_t next{0};                          // index in the ring buffer for the next event
+        size_t count{0};                         // number of valid events in the ring buffer
+        vector<std::pair<string, double>> open;  // scopes that have been started but not yet ended
+    };
+
+    // global state; the mutex protects the list of buffers, which is modified only when a thread registers
+    std::atomic<bool> _enabled{false};
+    size_t _capacity{0};
+    std::mutex _mutex;
+    vector<std::unique_ptr<Buffer>> _buffers;
+    std::atomic<int> _generation{0};  // incremented each time tracing is enabled, invalidating the buffers
+
+    // the buffer for the current thread, valid only if the thread's generation matches the global one
+    thread_local Buffer* t_buffer = nullptr;
+    thread_local int t_generation = -1;
+
+    // returns the current time in microseconds since the system clock epoch
+    double now()
+    {
+        using namespace std::chrono;
+        return duration_cast<duration<double, std::micro>>(system_clock::now().time_since_epoch()).count();
+    }
+
+    // returns the buffer for the current thread, registering a new buffer if needed
+    Buffer* buffer()
+    {
+        int generation = _generation.load();
+        if (t_generation != generation)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _buffers.emplace_back(new Buffer);
+            t_buffer = _buffers.back().get();
+            t_buffer->threadIndex = _buffers.size() - 1;
+            t_buffer->events.resize(_capacity);
+            t_generation = generation;
+        }
+        return t_buffer;
+    }
+
+    // returns the specified string with JSON special characters escaped
+    string escape(const string& text)
+    {
+        string result;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\') result += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20) result += c;
+        }
+        return result;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+Tracer::Tracer(string name)
+{
+    begin(name);
+}
+
+////////////////////////////////////////////////////////////////////
+
+Tracer::~Tracer()
+{
+    end();
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Tracer::enable(size_t capacityPerThread)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _buffers.clear();
+    _capacity = max(capacityPerThread, size_t(1));
+    _generation++;
+    _enabled = true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Tracer::disable()
+{
+    _enabled = false;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool Tracer::isEnabled()
+{
+    return _enabled.load(std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Tracer::begin(string name)
+{
+    if (!isEnabled()) return;
+    buffer()->open.emplace_back(name, now());
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Tracer::end()
+{
+    if (!isEnabled()) return;
+    Buffer* b = buffer();
+
+    // ignore unbalanced calls, e.g. for scopes started before tracing was enabled
+    if (b->open.empty()) return;
+
+    // move the most recently started scope to the ring buffer
+    Event& event = b->events[b->next];
+    event.name = std::move(b->open.back().first);
+    event.start = b->open.back().second;
+    event.duration = now() - event.start;
+    b->open.pop_back();
+    b->next = (b->next + 1) % _capacity;
+    b->count = min(b->count + 1, _capacity);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void Tracer::write(string filepath, int processIndex)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    std::ofstream out = System::ofstream(filepath);
+    if (!out) throw FATALERROR("Could not open the trace file " + filepath);
+    out.precision(15);
+
+    string pid = std::to_string(processIndex);
+    out << "{\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"args\":{\"name\":\"process " << pid
+        << "\"}}";
+    for (const auto& b : _buffers)
+    {
+        string tid = std::to_string(b->threadIndex);
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid
+            << ",\"args\":{\"name\":\"thread " << tid << "\"}}";
+
+        // output the events in chronological order, starting with the oldest event in the ring buffer
+        size_t first = (b->next + _capacity - b->count) % _capacity;
+        for (size_t k = 0; k != b->count; ++k)
+        {
+            const Event& event = b->events[(first + k) % _capacity];
+            out << ",\n{\"name\":\"" << escape(event.name) << "\",\"ph\":\"X\",\"ts\":" << event.start
+                << ",\"dur\":" << event.duration << ",\"pid\":" << pid << ",\"tid\":" << tid << "}";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+////////////////////////////////////////////////////////////////////
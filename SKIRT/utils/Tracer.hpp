@@ -0,0 +1,82 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef TRACER_HPP
+#define TRACER_HPP
+
+#include "Basics.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+/**
+This class records a trace of the execution of selected code scopes in each execution thread,
+which can be exported in the Chrome trace event format and inspected with tools such as
+chrome://tracing or Perfetto. In contrast to StopWatch, which accumulates timings for a few
+global timers, the trace preserves the individual begin and end times of each scope execution in
+each thread, so that load imbalance between threads and processes, serial phases, and waits for
+communication between processes can be easily identified.
+
+Tracing is disabled by default, in which case the overhead of each traced scope is limited to
+checking a global flag. After tracing has been enabled by calling the static enable() function,
+each call to the static begin() function marks the start of a scope in the calling thread, and
+each call to the static end() function marks the end of the most recently started scope in the
+calling thread. Each thread stores its completed scopes in its own ring buffer with a fixed
+capacity, so that recording requires no locking; if a buffer overflows, the oldest events are
+overwritten. The static write() function writes the recorded events for all threads to a JSON
+file. Because the events are time-stamped with the system clock, the files written by different
+processes can be combined on a common time axis.
+
+Rather than explicitly invoking the static begin() and end() functions, an instance of the Tracer
+class can be used to ensure correct nesting: the constructor calls begin() and the destructor
+calls end(). For example, to trace the execution of a complete scope, regardless of the scope's
+exit point, construct a Tracer instance at the start of the scope:
+
+\code
+{
+    Tracer trace("my scope");
+    ...
+}
+\endcode
+
+Tracing is intended for relatively coarse-grained scopes (such as simulation phases, updates, or
+chunks of parallel work), not for the life cycle of individual photon packets. */
+class Tracer
+{
+public:
+    /** The constructor calls the static begin() function with the specified scope name. */
+    explicit Tracer(string name);
+
+    /** The destructor calls the static end() function. */
+    ~Tracer();
+
+    /** This function discards any previously recorded events and enables tracing, using a ring
+        buffer with the specified capacity (number of events) for each thread. It should be called
+        while no traced scopes are active. */
+    static void enable(size_t capacityPerThread = 100000);
+
+    /** This function disables tracing. Recorded events are preserved so that they can still be
+        written. */
+    static void disable();
+
+    /** This function returns true if tracing is enabled. */
+    static bool isEnabled();
+
+    /** If tracing is enabled, this function marks the start of a scope with the specified name in
+        the calling thread. */
+    static void begin(string name);
+
+    /** If tracing is enabled, this function marks the end of the most recently started scope in the
+        calling thread, and records the completed scope in the thread's ring buffer. */
+    static void end();
+
+    /** This function writes the events recorded by all threads to the specified file in the
+        Chrome trace event JSON format, using the specified process index (usually the MPI rank)
+        to identify the process. It should be called while no traced scopes are active. */
+    static void write(string filepath, int processIndex);
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -425,23 +425,27 @@ string System::prompt(string message)
 
 ////////////////////////////////////////////////////////////////////
 
-std::ifstream System::ifstream(string path)
+std::ifstream System::ifstream(string path, bool binary)
 {
+    auto mode = std::ios_base::in;
+    if (binary) mode |= std::ios_base::binary;
 #ifdef _WIN64
-    return std::ifstream(toUTF16(path).get());
+    return std::ifstream(toUTF16(path).get(), mode);
 #else
-    return std::ifstream(path);
+    return std::ifstream(path, mode);
 #endif
 }
 
 ////////////////////////////////////////////////////////////////////
 
-std::ofstream System::ofstream(string path, bool append)
+std::ofstream System::ofstream(string path, bool append, bool binary)
 {
+    auto mode = append ? std::ios_base::app : std::ios_base::out;
+    if (binary) mode |= std::ios_base::binary;
 #ifdef _WIN64
-    return std::ofstream(toUTF16(path).get(), append ? std::ios_base::app : std::ios_base::out);
+    return std::ofstream(toUTF16(path).get(), mode);
 #else
-    return std::ofstream(path, append ? std::ios_base::app : std::ios_base::out);
+    return std::ofstream(path, mode);
 #endif
 }
 
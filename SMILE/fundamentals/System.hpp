@@ -102,15 +102,19 @@ public:
 
     // ================== File System ==================
 
-    /** This function returns an input file stream opened on the specified file path. On Windows
-        the function replaces forward slashes in the file path by backward slashes. */
-    static std::ifstream ifstream(string path);
+    /** This function returns an input file stream opened on the specified file path. By default
+        the stream is opened in text mode. If the \em binary flag is specified and is true, the
+        stream is opened in binary mode so that no line ending conversions are performed. On
+        Windows the function replaces forward slashes in the file path by backward slashes. */
+    static std::ifstream ifstream(string path, bool binary = false);
 
     /** This function returns an output file stream opened on the specified file path. If a file
         already exists at the specified path, by default it is overwritten. However, if the \em
-        append flag is specified and is true, new output will be appended to the existing file. On
+        append flag is specified and is true, new output will be appended to the existing file. By
+        default the stream is opened in text mode. If the \em binary flag is specified and is true,
+        the stream is opened in binary mode so that no line ending conversions are performed. On
         Windows the function replaces forward slashes in the file path by backward slashes. */
-    static std::ofstream ofstream(string path, bool append = false);
+    static std::ofstream ofstream(string path, bool append = false, bool binary = false);
 
     /** This function returns true if the specified path refers to an existing regular file. On
         Windows the function replaces forward slashes in the path by backward slashes. */